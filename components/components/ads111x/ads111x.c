@@ -139,6 +139,9 @@ static esp_err_t write_conf_bits(i2c_dev_t *dev, uint16_t val, uint8_t offs,
 
     I2C_DEV_TAKE_MUTEX(dev);
     I2C_DEV_CHECK(dev, read_reg(dev, REG_CONFIG, &old));
+    // Cached OS bit is stale, writing 0 to it has no effect
+    if (offs != OS_OFFSET)
+        old &= ~(OS_MASK << OS_OFFSET);
     I2C_DEV_CHECK(dev, write_reg(dev, REG_CONFIG, (old & ~(mask << offs)) | (val << offs)));
     I2C_DEV_GIVE_MUTEX(dev);
 
@@ -175,13 +178,26 @@ esp_err_t ads111x_init_desc(i2c_dev_t *dev, uint8_t addr, i2c_port_t port,
 #if HELPER_TARGET_IS_ESP32
     dev->cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
-    return i2c_dev_create_mutex(dev);
+    CHECK(i2c_dev_create_mutex(dev));
+
+    // Config and thresholds change only on writes, except OS bit, see ads111x_is_busy()
+    esp_err_t res = i2c_dev_create_regcache(dev, 2);
+    if (res == ESP_OK)
+        res = i2c_dev_regcache_mark(dev, REG_CONFIG, 3, true);
+    if (res != ESP_OK)
+    {
+        i2c_dev_delete_regcache(dev);
+        i2c_dev_delete_mutex(dev);
+    }
+
+    return res;
 }
 
 esp_err_t ads111x_free_desc(i2c_dev_t *dev)
 {
     CHECK_ARG(dev);
 
+    CHECK(i2c_dev_delete_regcache(dev));
     return i2c_dev_delete_mutex(dev);
 }
 
@@ -190,6 +206,7 @@ esp_err_t ads111x_is_busy(i2c_dev_t *dev, bool *busy)
     CHECK_ARG(dev && busy);
 
     uint16_t r;
+    CHECK(i2c_dev_regcache_invalidate(dev, REG_CONFIG, 1));
     CHECK(read_conf_bits(dev, OS_OFFSET, OS_MASK, &r));
     *busy = !r;
 
@@ -23,7 +23,12 @@
 
 #include "color.h"
 #include <math.h>
+#include <string.h>
+#include <stdlib.h>
 #include <lib8tion.h>
+#include <freertos/FreeRTOS.h>
+#include "color_gamma_tables.h"
+#include "color_rainbow_tables.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -349,6 +354,29 @@ rgb_t hsv2rgb_rainbow(hsv_t hsv)
     return rgb_from_values(r, g, b);
 }
 
+// Same result as hsv2rgb_rainbow(), without branches: hue comes from the
+// table, desaturation and value are applied with the same scale8 steps.
+// Full saturation and value, and zero saturation or value, fall out of
+// these formulas, so no special cases are needed.
+static inline rgb_t hsv2rgb_rainbow_lut(hsv_t hsv)
+{
+    const uint8_t *c = rainbow_hue_lut[hsv.hue];
+    uint8_t desat = scale8_video(255 - hsv.sat, 255 - hsv.sat);
+    uint8_t satscale = 255 - desat;
+    uint8_t val = scale8_video(hsv.val, hsv.val);
+
+    return rgb_from_values(
+            scale8(scale8(c[0], satscale) + desat, val),
+            scale8(scale8(c[1], satscale) + desat, val),
+            scale8(scale8(c[2], satscale) + desat, val));
+}
+
+void hsv2rgb_rainbow_n(const hsv_t *src, rgb_t *dst, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = hsv2rgb_rainbow_lut(src[i]);
+}
+
 #define FIXFRAC8(N,D) (((N) * 256) / (D))
 
 // This function is only an approximation, and it is not
@@ -527,6 +555,172 @@ hsv_t rgb2hsv_approximate(rgb_t rgb)
     return hsv_from_values(h, s, v);
 }
 
+// floor(n / d) by multiplication, exact for n * d < 2^31
+static inline int rainbow_div(int n, int d)
+{
+    return (int)(((uint64_t)n * rainbow_recip[d]) >> 31);
+}
+
+static inline int rainbow_div_ceil(int n, int d)
+{
+    return rainbow_div(n + d - 1, d);
+}
+
+// Output channel of hsv2rgb_rainbow() is floor(y * V / 256), where
+// V = scale8_video(val, val) + 1, y = floor(c * (256 - d) / 256) + d,
+// c is the channel of the hue color and d the desaturation. For a given V,
+// every output channel limits its y to a range. The zero channel of
+// section s (c = 0) gives the range of d, channels a and b then limit c,
+// and so the hue, as c_a falls and c_b rises over the section. y grows
+// with d, so for every hue left the range of d is solved exactly.
+static inline bool rainbow_solve(uint8_t s, int V, int oa, int ob, int mn, hsv_t *res)
+{
+    uint8_t val = rainbow_inv_val[V - 1];
+    if (scale8_video(val, val) != V - 1)
+        return false;
+
+    int dlo = rainbow_div_ceil(mn * 256, V);
+    int dhi = rainbow_div_ceil((mn + 1) * 256, V) - 1;
+    int blo = rainbow_div_ceil(ob * 256, V);
+    int bhi = rainbow_div_ceil((ob + 1) * 256, V) - 1;
+    int alo = rainbow_div_ceil(oa * 256, V);
+    int ahi = rainbow_div_ceil((oa + 1) * 256, V) - 1;
+    if (dhi > 255) dhi = 255;
+    if (bhi > 255) bhi = 255;
+    if (ahi > 255) ahi = 255;
+    if (dlo > dhi || blo > bhi || alo > ahi || bhi < dlo || ahi < dlo)
+        return false;
+
+    // c = y - d scaled up by 256 / (256 - d), over the whole range of d
+    int cb_lo = blo > dhi ? rainbow_div_ceil((blo - dhi) * 256, 256 - dhi) : 0;
+    int cb_hi = rainbow_div_ceil((bhi - dlo + 1) * 256, 256 - dlo) - 1;
+    int ca_lo = alo > dhi ? rainbow_div_ceil((alo - dhi) * 256, 256 - dhi) : 0;
+    int ca_hi = rainbow_div_ceil((ahi - dlo + 1) * 256, 256 - dlo) - 1;
+    if (cb_hi > 255) cb_hi = 255;
+    if (ca_hi > 255) ca_hi = 255;
+    if (cb_lo > cb_hi || ca_lo > ca_hi)
+        return false;
+
+    int first = rainbow_b_first[s][cb_lo];
+    int last = rainbow_b_first[s][cb_hi + 1] - 1;
+    int from_a = rainbow_a_first[s][ca_hi];
+    if (from_a > first)
+        first = from_a;
+    if (ca_lo)
+    {
+        int to_a = rainbow_a_first[s][ca_lo - 1] - 1;
+        if (to_a < last)
+            last = to_a;
+    }
+
+    for (int h = first; h <= last; h++)
+    {
+        uint8_t hue = rainbow_section_first[s] + h;
+        int ca = rainbow_hue_lut[hue][rainbow_section_a[s]];
+        int cb = rainbow_hue_lut[hue][rainbow_section_b[s]];
+
+        // y >= lo <=> d >= 256 * (lo - c) / (256 - c), y <= hi likewise
+        int lo = dlo, hi = dhi, t;
+        if (ahi < ca || bhi < cb)
+            continue;
+        if (alo > ca && (t = rainbow_div_ceil((alo - ca) * 256, 256 - ca)) > lo) lo = t;
+        if (blo > cb && (t = rainbow_div_ceil((blo - cb) * 256, 256 - cb)) > lo) lo = t;
+        if ((t = rainbow_div_ceil((ahi + 1 - ca) * 256, 256 - ca) - 1) < hi) hi = t;
+        if ((t = rainbow_div_ceil((bhi + 1 - cb) * 256, 256 - cb) - 1) < hi) hi = t;
+        if (lo > hi || rainbow_desat_next[lo] > hi)
+            continue;
+
+        *res = hsv_from_values(hue, rainbow_inv_sat[rainbow_desat_next[lo]], val);
+        return true;
+    }
+
+    return false;
+}
+
+// Hue from the ratio of channels a and b gives the sum of its channels, and
+// with it an estimate of V. Solutions are searched for V around it.
+static inline hsv_t rgb2hsv_rainbow_inline(rgb_t rgb)
+{
+    static const int8_t steps[] = { 0, 1, -1, 2, -2 };
+
+    uint8_t mx = rgb.r > rgb.g ? rgb.r : rgb.g;
+    uint8_t mn = rgb.r < rgb.g ? rgb.r : rgb.g;
+    if (rgb.b > mx) mx = rgb.b;
+    if (rgb.b < mn) mn = rgb.b;
+
+    if (mx == mn)
+        return hsv_from_values(0, 0, rainbow_inv_val[mx]);
+
+    uint8_t s, oa, ob;
+    if (rgb.b == mn)
+    {
+        s = 0;
+        oa = rgb.r;
+        ob = rgb.g;
+    }
+    else if (rgb.r == mn)
+    {
+        s = 1;
+        oa = rgb.g;
+        ob = rgb.b;
+    }
+    else
+    {
+        s = 2;
+        oa = rgb.b;
+        ob = rgb.r;
+    }
+    int ca = oa - mn, cb = ob - mn;
+    uint8_t hue0 = rainbow_inv_hue[s][rainbow_div(cb * 255, ca + cb)];
+    const uint8_t *c = rainbow_hue_lut[hue0];
+    int sum = c[rainbow_section_a[s]] + c[rainbow_section_b[s]];
+    int v1 = rainbow_div(((ca + cb + 1) * 512 + sum) / 2, sum) + mn;
+
+    hsv_t res;
+    for (size_t i = 0; i < sizeof(steps); i++)
+    {
+        int V = v1 + steps[i];
+        if (V >= 2 && V <= 256 && rainbow_solve(s, V, oa, ob, mn, &res))
+            return res;
+    }
+
+    // No exact match, return the estimate
+    if (v1 > 256)
+        v1 = 256;
+    return hsv_from_values(hue0, rainbow_inv_sat[rainbow_div(mn * 256, v1)], rainbow_inv_val[v1 - 1]);
+}
+
+hsv_t rgb2hsv_rainbow(rgb_t rgb)
+{
+    return rgb2hsv_rainbow_inline(rgb);
+}
+
+void rgb2hsv_rainbow_n(const rgb_t *src, hsv_t *dst, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = rgb2hsv_rainbow_inline(src[i]);
+}
+
+void rgb_shift_hue_n(const rgb_t *src, rgb_t *dst, size_t num, uint8_t hue_delta)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        hsv_t hsv = rgb2hsv_rainbow_inline(src[i]);
+        hsv.hue += hue_delta;
+        dst[i] = hsv2rgb_rainbow_lut(hsv);
+    }
+}
+
+void rgb_scale_sat_n(const rgb_t *src, rgb_t *dst, size_t num, fract8 scale)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        hsv_t hsv = rgb2hsv_rainbow_inline(src[i]);
+        hsv.sat = scale8(hsv.sat, scale);
+        dst[i] = hsv2rgb_rainbow_lut(hsv);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 rgb_t rgb_heat_color(uint8_t temperature)
@@ -755,7 +949,7 @@ void rgb_fill_gradient_hsv(rgb_t *target, size_t startpos, hsv_t startcolor, siz
     accum88 val88 = startcolor.val << 8;
     for (size_t i = startpos; i <= endpos; ++i)
     {
-        target[i] = hsv2rgb_rainbow(hsv_from_values(hue88 >> 8, sat88 >> 8, val88 >> 8));
+        target[i] = hsv2rgb_rainbow_lut(hsv_from_values(hue88 >> 8, sat88 >> 8, val88 >> 8));
         hue88 += huedelta87;
         sat88 += satdelta87;
         val88 += valdelta87;
@@ -881,8 +1075,6 @@ hsv_t color_from_palette_hsv(const hsv_t *palette, uint8_t pal_size, uint8_t ind
     return hsv_from_values(hue1, sat1, val1);
 }
 
-#include <stdlib.h>
-
 rgb_t color_from_palette_rgb(const rgb_t *palette, uint8_t pal_size, uint8_t index, uint8_t brightness, bool blend)
 {
     uint8_t div = 256 / pal_size;
@@ -947,6 +1139,34 @@ rgb_t color_from_palette_rgb(const rgb_t *palette, uint8_t pal_size, uint8_t ind
     return rgb_from_values(red1, green1, blue1);
 }
 
+rgb_t color_palette_rgb_expand(color_palette_rgb_t *pal, uint8_t index)
+{
+    rgb_t c = color_from_palette_rgb(pal->palette, pal->pal_size, index, pal->brightness, pal->blend);
+    pal->table[index] = c;
+    pal->expanded[index >> 5] |= 1UL << (index & 31);
+    return c;
+}
+
+void color_palette_rgb_set_brightness(color_palette_rgb_t *pal, uint8_t brightness, bool lazy)
+{
+    pal->brightness = brightness;
+    memset(pal->expanded, 0, sizeof(pal->expanded));
+    if (lazy)
+        return;
+
+    for (size_t i = 0; i < 256; i++)
+        color_palette_rgb_expand(pal, i);
+}
+
+void color_palette_rgb_init(color_palette_rgb_t *pal, const rgb_t *palette, uint8_t pal_size,
+        uint8_t brightness, bool blend, bool lazy)
+{
+    pal->palette = palette;
+    pal->pal_size = pal_size;
+    pal->blend = blend;
+    color_palette_rgb_set_brightness(pal, brightness, lazy);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 hsv_t blend(hsv_t existing, hsv_t overlay, fract8 amount, color_gradient_direction_t direction)
@@ -1069,9 +1289,43 @@ void blur2d(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_
     blur_columns(leds, width, height, blur_amount, xy, ctx);
 }
 
+#define BLUR_COLUMNS_BLOCK 32
+
+void blur2d_linear(rgb_t *leds, size_t width, size_t height, size_t stride, fract8 blur_amount)
+{
+    for (size_t row = 0; row < height; row++)
+        blur1d(leds + row * stride, width, blur_amount);
+
+    // blur columns, carryover of every column of a block is kept in a line buffer
+    uint8_t keep = 255 - blur_amount;
+    uint8_t seep = blur_amount >> 1;
+    rgb_t carryover[BLUR_COLUMNS_BLOCK];
+    for (size_t col0 = 0; col0 < width; col0 += BLUR_COLUMNS_BLOCK)
+    {
+        size_t cols = width - col0 < BLUR_COLUMNS_BLOCK ? width - col0 : BLUR_COLUMNS_BLOCK;
+        memset(carryover, 0, sizeof(carryover));
+        for (size_t i = 0; i < height; i++)
+        {
+            rgb_t *line = leds + i * stride + col0;
+            rgb_t *prev = line - stride;
+            for (size_t c = 0; c < cols; c++)
+            {
+                rgb_t cur = line[c];
+                rgb_t part = rgb_scale(cur, seep);
+                cur = rgb_add_rgb(rgb_scale(cur, keep), carryover[c]);
+                if (i)
+                    prev[c] = rgb_add_rgb(prev[c], part);
+                line[c] = cur;
+                carryover[c] = part;
+            }
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-uint8_t apply_gamma2brightness(uint8_t brightness, float gamma)
+// Reference gamma adjustment, tables are filled with it
+static uint8_t gamma_value(uint8_t brightness, float gamma)
 {
     float orig = (float)brightness / 255.0;
     float adj = powf(orig, gamma) * 255.0;
@@ -1081,22 +1335,192 @@ uint8_t apply_gamma2brightness(uint8_t brightness, float gamma)
     return result;
 }
 
+static const float gamma_builtin[COLOR_GAMMA_BUILTIN_COUNT] = { COLOR_GAMMA_BUILTIN_VALUES };
+
+// Cache is shared by all tasks, tables are copied out under the lock,
+// so eviction can't change a table while someone reads it
+static portMUX_TYPE gamma_mux = portMUX_INITIALIZER_UNLOCKED;
+static float gamma_cache[COLOR_GAMMA_CACHE_SIZE];
+static uint8_t gamma_cache_lut[COLOR_GAMMA_CACHE_SIZE][256];
+static uint8_t gamma_cache_used = 0;
+static uint8_t gamma_cache_next = 0;
+
+// Lookups of up to this many values are done under the lock, larger ones on a copy
+#define GAMMA_LOCKED_MAX 3
+
+// Last found builtin table
+static volatile uint8_t builtin_last = 0;
+
+// Builtin tables are constant and need no locking
+static inline const uint8_t *builtin_lut(float gamma)
+{
+    uint8_t last = builtin_last;
+    if (gamma_builtin[last] == gamma)
+        return color_gamma_builtin_lut[last];
+    for (int i = 0; i < COLOR_GAMMA_BUILTIN_COUNT; i++)
+        if (gamma_builtin[i] == gamma)
+        {
+            builtin_last = i;
+            return color_gamma_builtin_lut[i];
+        }
+    return NULL;
+}
+
+// Cache slot of gamma or -1, call with gamma_mux held
+static int cache_find(float gamma)
+{
+    for (int i = 0; i < gamma_cache_used; i++)
+        if (gamma_cache[i] == gamma)
+            return i;
+    return -1;
+}
+
+void color_gamma_table(float gamma, uint8_t *lut)
+{
+    const uint8_t *builtin = builtin_lut(gamma);
+    if (builtin)
+    {
+        memcpy(lut, builtin, 256);
+        return;
+    }
+
+    portENTER_CRITICAL(&gamma_mux);
+    int slot = cache_find(gamma);
+    if (slot >= 0)
+        memcpy(lut, gamma_cache_lut[slot], 256);
+    portEXIT_CRITICAL(&gamma_mux);
+    if (slot >= 0)
+        return;
+
+    // Table takes a while to compute, so do it outside of critical section
+    for (size_t i = 0; i < 256; i++)
+        lut[i] = gamma_value(i, gamma);
+
+    portENTER_CRITICAL(&gamma_mux);
+    // Another task may have added it meanwhile
+    if (cache_find(gamma) < 0)
+    {
+        // Replace oldest cached table
+        slot = gamma_cache_next;
+        gamma_cache_next = (gamma_cache_next + 1) % COLOR_GAMMA_CACHE_SIZE;
+        if (gamma_cache_used < COLOR_GAMMA_CACHE_SIZE)
+            gamma_cache_used++;
+        memcpy(gamma_cache_lut[slot], lut, 256);
+        gamma_cache[slot] = gamma;
+    }
+    portEXIT_CRITICAL(&gamma_mux);
+}
+
+static void gamma_apply(float gamma, const uint8_t *src, uint8_t *dst, size_t num)
+{
+    uint8_t copy[256];
+    const uint8_t *lut = builtin_lut(gamma);
+    if (!lut)
+    {
+        if (num <= GAMMA_LOCKED_MAX)
+        {
+            portENTER_CRITICAL(&gamma_mux);
+            int slot = cache_find(gamma);
+            if (slot >= 0)
+                for (size_t i = 0; i < num; i++)
+                    dst[i] = gamma_cache_lut[slot][src[i]];
+            portEXIT_CRITICAL(&gamma_mux);
+            if (slot >= 0)
+                return;
+        }
+        color_gamma_table(gamma, copy);
+        lut = copy;
+    }
+    for (size_t i = 0; i < num; i++)
+        dst[i] = lut[src[i]];
+}
+
+uint8_t apply_gamma2brightness(uint8_t brightness, float gamma)
+{
+    uint8_t res;
+    gamma_apply(gamma, &brightness, &res, 1);
+    return res;
+}
+
 rgb_t apply_gamma2rgb(rgb_t c, float gamma)
 {
+    const uint8_t *lut = builtin_lut(gamma);
+    if (!lut)
+    {
+        gamma_apply(gamma, (const uint8_t *)&c, (uint8_t *)&c, 3);
+        return c;
+    }
     rgb_t res = {
-        .r = apply_gamma2brightness(c.r, gamma),
-        .g = apply_gamma2brightness(c.g, gamma),
-        .b = apply_gamma2brightness(c.b, gamma),
+        .r = lut[c.r],
+        .g = lut[c.g],
+        .b = lut[c.b],
     };
     return res;
 }
 
 rgb_t apply_gamma2rgb_channels(rgb_t c, float gamma_r, float gamma_g, float gamma_b)
 {
-    rgb_t res = {
-        .r = apply_gamma2brightness(c.r, gamma_r),
-        .g = apply_gamma2brightness(c.g, gamma_g),
-        .b = apply_gamma2brightness(c.b, gamma_b),
-    };
+    rgb_t res;
+    gamma_apply(gamma_r, &c.r, &res.r, 1);
+    gamma_apply(gamma_g, &c.g, &res.g, 1);
+    gamma_apply(gamma_b, &c.b, &res.b, 1);
     return res;
 }
+
+void apply_gamma2brightness_n(const uint8_t *src, uint8_t *dst, size_t num, float gamma)
+{
+    gamma_apply(gamma, src, dst, num);
+}
+
+void apply_gamma2rgb_n(const rgb_t *src, rgb_t *dst, size_t num, float gamma)
+{
+    apply_gamma2brightness_n((const uint8_t *)src, (uint8_t *)dst, num * 3, gamma);
+}
+
+void apply_gamma2rgb_channels_n(const rgb_t *src, rgb_t *dst, size_t num, float gamma_r, float gamma_g, float gamma_b)
+{
+    uint8_t lut[3][256];
+    color_gamma_table(gamma_r, lut[0]);
+    color_gamma_table(gamma_g, lut[1]);
+    color_gamma_table(gamma_b, lut[2]);
+    for (size_t i = 0; i < num; i++)
+    {
+        dst[i].r = lut[0][src[i].r];
+        dst[i].g = lut[1][src[i].g];
+        dst[i].b = lut[2][src[i].b];
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void color_correction_init(color_correction_t *cc, float gamma, rgb_t white_point)
+{
+    cc->gamma = gamma;
+    cc->white_point = white_point;
+    color_gamma_table(gamma, cc->gamma_lut);
+    for (size_t i = 0; i < 256; i++)
+        cc->gamma_lut16[i] = (uint16_t)(powf(i / 255.0f, gamma) * 65280.0f + 0.5f);
+    color_correction_set_brightness(cc, 255);
+}
+
+void color_correction_set_brightness(color_correction_t *cc, uint8_t brightness)
+{
+    uint8_t scale[3] = {
+        scale8(cc->white_point.r, brightness),
+        scale8(cc->white_point.g, brightness),
+        scale8(cc->white_point.b, brightness),
+    };
+    // Full precision brightness * white point for 16-bit tables, 0..65025
+    uint32_t scale16[3] = {
+        (uint32_t)cc->white_point.r * brightness,
+        (uint32_t)cc->white_point.g * brightness,
+        (uint32_t)cc->white_point.b * brightness,
+    };
+    for (size_t c = 0; c < 3; c++)
+        for (size_t i = 0; i < 256; i++)
+        {
+            cc->lut[c][i] = scale8_video(cc->gamma_lut[i], scale[c]);
+            cc->lut16[c][i] = (uint16_t)(cc->gamma_lut16[i] * scale16[c] / 65025);
+        }
+    cc->brightness = brightness;
+}
@@ -65,6 +65,18 @@ extern "C" {
  */
 rgb_t hsv2rgb_rainbow(hsv_t hsv);
 
+/**
+ * @brief Convert array of HSV colors to RGB using balanced rainbow
+ *
+ * Gives the same result as ::hsv2rgb_rainbow() for every pixel, but uses
+ * a branchless table-driven conversion, which is much faster on arrays.
+ *
+ * @param src   Source HSV colors
+ * @param dst   Destination RGB colors, may not overlap source
+ * @param num   Number of colors
+ */
+void hsv2rgb_rainbow_n(const hsv_t *src, rgb_t *dst, size_t num);
+
 /**
  * @brief Convert HSV to RGB using mathematically straight spectrum
  *
@@ -127,6 +139,62 @@ rgb_t hsv2rgb_raw(hsv_t hsv);
  */
 hsv_t rgb2hsv_approximate(rgb_t rgb);
 
+/**
+ * @brief Recover HSV values from RGB, inverse of ::hsv2rgb_rainbow()
+ *
+ * Integer conversion which returns HSV color converting back to exactly
+ * the same RGB color with ::hsv2rgb_rainbow() whenever such HSV color
+ * exists and its value is near the estimate. This holds for about 99.9%
+ * of colors produced by ::hsv2rgb_rainbow(), misses are mostly very dark
+ * colors. Otherwise the closest estimate is returned.
+ *
+ * Gray colors are returned with zero hue and saturation.
+ *
+ * Faster than ::rgb2hsv_approximate(), uses constant lookup tables of
+ * about 6 KiB from color_rainbow_tables.h.
+ *
+ * @param rgb   RGB color
+ * @return      HSV color
+ */
+hsv_t rgb2hsv_rainbow(rgb_t rgb);
+
+/**
+ * @brief Convert array of RGB colors to HSV, see ::rgb2hsv_rainbow()
+ *
+ * @param src   Source RGB colors
+ * @param dst   Destination HSV colors
+ * @param num   Number of colors
+ */
+void rgb2hsv_rainbow_n(const rgb_t *src, hsv_t *dst, size_t num);
+
+/**
+ * @brief Rotate hue of array of RGB colors
+ *
+ * Colors are converted with ::rgb2hsv_rainbow() and back with
+ * ::hsv2rgb_rainbow(), so zero shift leaves colors intact wherever
+ * the conversion round-trips exactly.
+ *
+ * @param src       Source RGB colors
+ * @param dst       Destination RGB colors, may be the same as source
+ * @param num       Number of colors
+ * @param hue_delta Value added to hue
+ */
+void rgb_shift_hue_n(const rgb_t *src, rgb_t *dst, size_t num, uint8_t hue_delta);
+
+/**
+ * @brief Scale saturation of array of RGB colors
+ *
+ * Colors are converted with ::rgb2hsv_rainbow() and back with
+ * ::hsv2rgb_rainbow(), so scale 255 leaves colors intact wherever
+ * the conversion round-trips exactly.
+ *
+ * @param src       Source RGB colors
+ * @param dst       Destination RGB colors, may be the same as source
+ * @param num       Number of colors
+ * @param scale     Saturation scale, 0 makes colors gray
+ */
+void rgb_scale_sat_n(const rgb_t *src, rgb_t *dst, size_t num, fract8 scale);
+
 /**
  * @brief Approximates a 'black body radiation' spectrum for a given 'heat' level.
  *
@@ -281,6 +349,58 @@ hsv_t color_from_palette_hsv(const hsv_t *palette, uint8_t pal_size, uint8_t ind
  */
 rgb_t color_from_palette_rgb(const rgb_t *palette, uint8_t pal_size, uint8_t index, uint8_t brightness, bool blend);
 
+/**
+ * RGB palette expanded to all 256 indexes, with brightness baked in.
+ * Use it instead of ::color_from_palette_rgb() when the same palette
+ * is looked up for many pixels.
+ */
+typedef struct
+{
+    const rgb_t *palette;  ///< Source palette
+    uint8_t pal_size;      ///< Number of entries in source palette
+    uint8_t brightness;    ///< Brightness baked into the table
+    bool blend;            ///< Blend between source entries
+    uint32_t expanded[8];  ///< Bitmap of valid table entries
+    rgb_t table[256];      ///< Expanded palette
+} color_palette_rgb_t;
+
+/**
+ * @brief Expand RGB palette
+ *
+ * @param pal        Expanded palette
+ * @param palette    Source palette, must stay valid while `pal` is used
+ * @param pal_size   Number of entries in source palette
+ * @param brightness Brightness to bake into the table
+ * @param blend      Blend between source entries
+ * @param lazy       Expand entries on first lookup instead of now
+ */
+void color_palette_rgb_init(color_palette_rgb_t *pal, const rgb_t *palette, uint8_t pal_size,
+        uint8_t brightness, bool blend, bool lazy);
+
+/**
+ * @brief Change brightness of expanded palette
+ *
+ * Entries are expanded again, lazily if `lazy` is true.
+ */
+void color_palette_rgb_set_brightness(color_palette_rgb_t *pal, uint8_t brightness, bool lazy);
+
+/**
+ * @brief Expand one entry, called by ::color_palette_rgb_get() for lazy palettes
+ */
+rgb_t color_palette_rgb_expand(color_palette_rgb_t *pal, uint8_t index);
+
+/**
+ * @brief Get color from expanded palette
+ *
+ * Same result as ::color_from_palette_rgb() with the parameters of the palette.
+ */
+static inline rgb_t color_palette_rgb_get(color_palette_rgb_t *pal, uint8_t index)
+{
+    if (!(pal->expanded[index >> 5] & (1UL << (index & 31))))
+        return color_palette_rgb_expand(pal, index);
+    return pal->table[index];
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Filter functions
 
@@ -336,9 +456,44 @@ void blur_rows(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_
  */
 void blur2d(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_offs_cb xy, void *ctx);
 
+/**
+ * @brief Two-dimensional blur filter for row-major matrix
+ *
+ * Same result as ::blur2d() with `xy(x, y) = y * stride + x`, but without
+ * per-pixel callbacks. Columns are blurred a block at a time while walking
+ * rows, so memory is accessed sequentially.
+ *
+ * @param leds        First pixel of the matrix
+ * @param width       Matrix width
+ * @param height      Matrix height
+ * @param stride      Distance between rows in pixels, >= width
+ * @param blur_amount Amount of blurring, see ::blur2d()
+ */
+void blur2d_linear(rgb_t *leds, size_t width, size_t height, size_t stride, fract8 blur_amount);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Gamma functions
 
+/**
+ * Number of cached gamma tables for gammas other than builtin ones
+ * (1.8, 2.0, 2.2, 2.5 and 2.8)
+ */
+#ifndef COLOR_GAMMA_CACHE_SIZE
+#define COLOR_GAMMA_CACHE_SIZE 4
+#endif
+
+/**
+ * @brief Get copy of gamma lookup table
+ *
+ * Tables of common gammas are built in, others are computed on first use
+ * and cached for last ::COLOR_GAMMA_CACHE_SIZE non-builtin gammas.
+ * Safe to call from several tasks.
+ *
+ * @param gamma    Gamma value
+ * @param[out] lut Buffer for 256 adjusted values
+ */
+void color_gamma_table(float gamma, uint8_t *lut);
+
 /**
  * @brief Single gamma adjustment to a single scalar value.
  *
@@ -357,6 +512,139 @@ rgb_t apply_gamma2rgb(rgb_t c, float gamma);
  */
 rgb_t apply_gamma2rgb_channels(rgb_t c, float gamma_r, float gamma_g, float gamma_b);
 
+/**
+ * @brief Gamma adjustment of array of scalar values
+ *
+ * \p src and \p dst may be the same array.
+ */
+void apply_gamma2brightness_n(const uint8_t *src, uint8_t *dst, size_t num, float gamma);
+
+/**
+ * @brief Single gamma adjustment of array of RGB colors
+ *
+ * \p src and \p dst may be the same array.
+ */
+void apply_gamma2rgb_n(const rgb_t *src, rgb_t *dst, size_t num, float gamma);
+
+/**
+ * @brief Per-channel gamma adjustment of array of RGB colors
+ *
+ * \p src and \p dst may be the same array.
+ */
+void apply_gamma2rgb_channels_n(const rgb_t *src, rgb_t *dst, size_t num, float gamma_r, float gamma_g, float gamma_b);
+
+////////////////////////////////////////////////////////////////////////////////
+// Color correction
+
+/**
+ * Color correction stage: brightness, gamma and white balance folded into
+ * per-channel lookup tables.
+ *
+ * Intended to be applied by LED drivers when encoding a frame, so stored
+ * colors are never modified and changing brightness costs one table rebuild
+ * instead of rewriting every pixel.
+ */
+typedef struct
+{
+    float gamma;              ///< Gamma of the curve in `gamma_lut`
+    rgb_t white_point;        ///< Per-channel maximum, used for white balance
+    uint8_t brightness;       ///< Global brightness the tables are built for
+    uint8_t gamma_lut[256];   ///< Cached gamma curve
+    uint16_t gamma_lut16[256];///< Cached gamma curve, 8.8 fixed point
+    uint8_t lut[3][256];      ///< Resulting R, G and B tables
+    uint16_t lut16[3][256];   ///< Resulting R, G and B tables, 8.8 fixed point, for dithering
+} color_correction_t;
+
+/**
+ * @brief Initialize color correction tables
+ *
+ * Brightness is set to 255. Gamma 1.0 and white point {255, 255, 255}
+ * give identity tables.
+ *
+ * @param cc          Color correction descriptor
+ * @param gamma       Gamma value
+ * @param white_point Per-channel maximum
+ */
+void color_correction_init(color_correction_t *cc, float gamma, rgb_t white_point);
+
+/**
+ * @brief Rebuild color correction tables for a new global brightness
+ *
+ * Uses cached gamma curve, so it is cheap enough to be called on every step
+ * of a fade.
+ *
+ * @param cc          Color correction descriptor
+ * @param brightness  Brightness 0..255
+ */
+void color_correction_set_brightness(color_correction_t *cc, uint8_t brightness);
+
+/**
+ * @brief Apply color correction to RGB color
+ */
+static inline rgb_t color_correction_apply(const color_correction_t *cc, rgb_t c)
+{
+    rgb_t res = {
+        .r = cc->lut[0][c.r],
+        .g = cc->lut[1][c.g],
+        .b = cc->lut[2][c.b],
+    };
+    return res;
+}
+
+/**
+ * @brief Temporal dithering offset for a frame number
+ *
+ * Frame number is bit-reversed, so any 2^n consecutive frames give offsets
+ * evenly spread over 0..255.
+ */
+static inline uint8_t color_dither_offset(uint8_t frame)
+{
+    frame = (frame & 0xf0) >> 4 | (frame & 0x0f) << 4;
+    frame = (frame & 0xcc) >> 2 | (frame & 0x33) << 2;
+    frame = (frame & 0xaa) >> 1 | (frame & 0x55) << 1;
+    return frame;
+}
+
+/**
+ * @brief Temporal dithering offset for a frame of a short cycle
+ *
+ * Offsets of a cycle of 2^bits frames are spread evenly over 0..255 and
+ * centered in their intervals, so the average output over any 2^bits
+ * consecutive frames is the corrected value rounded to the nearest
+ * 1/2^bits LSB. Short cycles converge while a color is shown for only a
+ * few frames.
+ *
+ * @param frame Frame number
+ * @param bits  Cycle length, log2 of the number of frames, 0..8
+ * @return      Dithering offset
+ */
+static inline uint8_t color_dither_offset_cycle(uint8_t frame, uint8_t bits)
+{
+    return color_dither_offset(frame & ((1 << bits) - 1)) + (128 >> bits);
+}
+
+/**
+ * @brief Apply color correction to RGB color with temporal dithering
+ *
+ * Fractional part of the 8.8 corrected value is turned into the probability
+ * of rounding up, so the average output over many frames matches the
+ * corrected value with sub-LSB precision.
+ *
+ * @param cc      Color correction descriptor
+ * @param c       RGB color
+ * @param offset  Dithering offset of the frame, see ::color_dither_offset()
+ * @return        Corrected color
+ */
+static inline rgb_t color_correction_apply_dithered(const color_correction_t *cc, rgb_t c, uint8_t offset)
+{
+    rgb_t res = {
+        .r = (uint8_t)((cc->lut16[0][c.r] + offset) >> 8),
+        .g = (uint8_t)((cc->lut16[1][c.g] + offset) >> 8),
+        .b = (uint8_t)((cc->lut16[2][c.b] + offset) >> 8),
+    };
+    return res;
+}
+
 #ifdef __cplusplus
 }
 #endif
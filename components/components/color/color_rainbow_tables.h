@@ -0,0 +1,357 @@
+/**
+ * @file color_rainbow_tables.h
+ *
+ * Tables of hsv2rgb_rainbow() and rgb2hsv_rainbow(), generated by gen_rainbow_tables.py
+ */
+#ifndef __COLOR_RAINBOW_TABLES_H__
+#define __COLOR_RAINBOW_TABLES_H__
+
+#include <stdint.h>
+
+// hsv2rgb_rainbow() of every hue at full saturation and value
+static const uint8_t rainbow_hue_lut[256][3] = {
+    {255, 0, 0}, {253, 2, 0}, {250, 5, 0}, {247, 8, 0}, {245, 10, 0}, {242, 13, 0}, {239, 16, 0}, {237, 18, 0},
+    {234, 21, 0}, {231, 24, 0}, {229, 26, 0}, {226, 29, 0}, {223, 32, 0}, {221, 34, 0}, {218, 37, 0}, {215, 40, 0},
+    {212, 43, 0}, {210, 45, 0}, {207, 48, 0}, {204, 51, 0}, {202, 53, 0}, {199, 56, 0}, {196, 59, 0}, {194, 61, 0},
+    {191, 64, 0}, {188, 67, 0}, {186, 69, 0}, {183, 72, 0}, {180, 75, 0}, {178, 77, 0}, {175, 80, 0}, {172, 83, 0},
+    {171, 85, 0}, {171, 87, 0}, {171, 90, 0}, {171, 93, 0}, {171, 95, 0}, {171, 98, 0}, {171, 101, 0}, {171, 103, 0},
+    {171, 106, 0}, {171, 109, 0}, {171, 111, 0}, {171, 114, 0}, {171, 117, 0}, {171, 119, 0}, {171, 122, 0}, {171, 125, 0},
+    {171, 128, 0}, {171, 130, 0}, {171, 133, 0}, {171, 136, 0}, {171, 138, 0}, {171, 141, 0}, {171, 144, 0}, {171, 146, 0},
+    {171, 149, 0}, {171, 152, 0}, {171, 154, 0}, {171, 157, 0}, {171, 160, 0}, {171, 162, 0}, {171, 165, 0}, {171, 168, 0},
+    {171, 170, 0}, {166, 172, 0}, {161, 175, 0}, {155, 178, 0}, {150, 180, 0}, {145, 183, 0}, {139, 186, 0}, {134, 188, 0},
+    {129, 191, 0}, {123, 194, 0}, {118, 196, 0}, {113, 199, 0}, {107, 202, 0}, {102, 204, 0}, {97, 207, 0}, {91, 210, 0},
+    {86, 213, 0}, {81, 215, 0}, {75, 218, 0}, {70, 221, 0}, {65, 223, 0}, {59, 226, 0}, {54, 229, 0}, {49, 231, 0},
+    {43, 234, 0}, {38, 237, 0}, {33, 239, 0}, {27, 242, 0}, {22, 245, 0}, {17, 247, 0}, {11, 250, 0}, {6, 253, 0},
+    {0, 255, 0}, {0, 253, 2}, {0, 250, 5}, {0, 247, 8}, {0, 245, 10}, {0, 242, 13}, {0, 239, 16}, {0, 237, 18},
+    {0, 234, 21}, {0, 231, 24}, {0, 229, 26}, {0, 226, 29}, {0, 223, 32}, {0, 221, 34}, {0, 218, 37}, {0, 215, 40},
+    {0, 212, 43}, {0, 210, 45}, {0, 207, 48}, {0, 204, 51}, {0, 202, 53}, {0, 199, 56}, {0, 196, 59}, {0, 194, 61},
+    {0, 191, 64}, {0, 188, 67}, {0, 186, 69}, {0, 183, 72}, {0, 180, 75}, {0, 178, 77}, {0, 175, 80}, {0, 172, 83},
+    {0, 171, 85}, {0, 166, 90}, {0, 161, 95}, {0, 155, 101}, {0, 150, 106}, {0, 145, 111}, {0, 139, 117}, {0, 134, 122},
+    {0, 129, 127}, {0, 123, 133}, {0, 118, 138}, {0, 113, 143}, {0, 107, 149}, {0, 102, 154}, {0, 97, 159}, {0, 91, 165},
+    {0, 86, 170}, {0, 81, 175}, {0, 75, 181}, {0, 70, 186}, {0, 65, 191}, {0, 59, 197}, {0, 54, 202}, {0, 49, 207},
+    {0, 43, 213}, {0, 38, 218}, {0, 33, 223}, {0, 27, 229}, {0, 22, 234}, {0, 17, 239}, {0, 11, 245}, {0, 6, 250},
+    {0, 0, 255}, {2, 0, 253}, {5, 0, 250}, {8, 0, 247}, {10, 0, 245}, {13, 0, 242}, {16, 0, 239}, {18, 0, 237},
+    {21, 0, 234}, {24, 0, 231}, {26, 0, 229}, {29, 0, 226}, {32, 0, 223}, {34, 0, 221}, {37, 0, 218}, {40, 0, 215},
+    {43, 0, 212}, {45, 0, 210}, {48, 0, 207}, {51, 0, 204}, {53, 0, 202}, {56, 0, 199}, {59, 0, 196}, {61, 0, 194},
+    {64, 0, 191}, {67, 0, 188}, {69, 0, 186}, {72, 0, 183}, {75, 0, 180}, {77, 0, 178}, {80, 0, 175}, {83, 0, 172},
+    {85, 0, 171}, {87, 0, 169}, {90, 0, 166}, {93, 0, 163}, {95, 0, 161}, {98, 0, 158}, {101, 0, 155}, {103, 0, 153},
+    {106, 0, 150}, {109, 0, 147}, {111, 0, 145}, {114, 0, 142}, {117, 0, 139}, {119, 0, 137}, {122, 0, 134}, {125, 0, 131},
+    {128, 0, 128}, {130, 0, 126}, {133, 0, 123}, {136, 0, 120}, {138, 0, 118}, {141, 0, 115}, {144, 0, 112}, {146, 0, 110},
+    {149, 0, 107}, {152, 0, 104}, {154, 0, 102}, {157, 0, 99}, {160, 0, 96}, {162, 0, 94}, {165, 0, 91}, {168, 0, 88},
+    {170, 0, 85}, {172, 0, 83}, {175, 0, 80}, {178, 0, 77}, {180, 0, 75}, {183, 0, 72}, {186, 0, 69}, {188, 0, 67},
+    {191, 0, 64}, {194, 0, 61}, {196, 0, 59}, {199, 0, 56}, {202, 0, 53}, {204, 0, 51}, {207, 0, 48}, {210, 0, 45},
+    {213, 0, 42}, {215, 0, 40}, {218, 0, 37}, {221, 0, 34}, {223, 0, 32}, {226, 0, 29}, {229, 0, 26}, {231, 0, 24},
+    {234, 0, 21}, {237, 0, 18}, {239, 0, 16}, {242, 0, 13}, {245, 0, 10}, {247, 0, 8}, {250, 0, 5}, {253, 0, 2},
+};
+
+// Rainbow sections, see rgb2hsv_rainbow()
+static const uint16_t rainbow_section_first[4] = { 0, 96, 160, 256 };
+static const uint8_t rainbow_section_a[3] = { 0, 1, 2 };
+static const uint8_t rainbow_section_b[3] = { 1, 2, 0 };
+
+// val whose scale8_video(val, val) is nearest to index
+static const uint8_t rainbow_inv_val[256] = {
+      0,   1,  16,  23,  28,  32,  36,  40,  43,  46,  48,  51,  54,  56,  58,  60,
+     62,  64,  66,  68,  70,  72,  74,  76,  77,  79,  80,  82,  84,  85,  87,  88,
+     90,  91,  92,  94,  95,  96,  98,  99, 100, 102, 103, 104, 105, 107, 108, 109,
+    110, 111, 112, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126,
+    127, 128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142,
+    143, 143, 144, 145, 146, 147, 148, 149, 150, 150, 151, 152, 153, 154, 155, 155,
+    156, 157, 158, 159, 159, 160, 161, 162, 163, 163, 164, 165, 166, 167, 167, 168,
+    169, 170, 170, 171, 172, 173, 173, 174, 175, 175, 176, 177, 178, 178, 179, 180,
+    181, 181, 182, 183, 183, 184, 185, 185, 186, 187, 187, 188, 189, 189, 190, 191,
+    191, 192, 193, 193, 194, 195, 195, 196, 197, 197, 198, 199, 199, 200, 201, 201,
+    202, 203, 203, 204, 204, 205, 206, 206, 207, 207, 208, 209, 209, 210, 211, 211,
+    212, 212, 213, 214, 214, 215, 215, 216, 217, 217, 218, 218, 219, 219, 220, 221,
+    221, 222, 222, 223, 223, 224, 225, 225, 226, 226, 227, 227, 228, 229, 229, 230,
+    230, 231, 231, 232, 232, 233, 234, 234, 235, 235, 236, 236, 237, 237, 238, 238,
+    239, 239, 240, 241, 241, 242, 242, 243, 243, 244, 244, 245, 245, 246, 246, 247,
+    247, 248, 248, 249, 249, 250, 250, 251, 251, 252, 252, 253, 253, 254, 254, 255,
+};
+
+// sat whose desaturation scale8_video(255 - sat, 255 - sat) is nearest to index
+static const uint8_t rainbow_inv_sat[256] = {
+    255, 240, 233, 228, 224, 220, 216, 213, 210, 208, 205, 202, 200, 198, 196, 194,
+    192, 190, 188, 186, 184, 182, 180, 179, 177, 176, 174, 172, 171, 169, 168, 166,
+    165, 164, 162, 161, 160, 158, 157, 156, 154, 153, 152, 151, 149, 148, 147, 146,
+    145, 144, 142, 141, 140, 139, 138, 137, 136, 135, 134, 133, 132, 131, 130, 129,
+    128, 127, 126, 125, 124, 123, 122, 121, 120, 119, 118, 117, 116, 115, 114, 113,
+    112, 111, 111, 110, 109, 108, 107, 106, 105, 104, 104, 103, 102, 101, 100,  99,
+     99,  98,  97,  96,  95,  95,  94,  93,  92,  91,  91,  90,  89,  88,  87,  87,
+     86,  85,  84,  84,  83,  82,  81,  81,  80,  79,  79,  78,  77,  76,  76,  75,
+     74,  73,  73,  72,  71,  71,  70,  69,  69,  68,  67,  67,  66,  65,  65,  64,
+     63,  63,  62,  61,  61,  60,  59,  59,  58,  57,  57,  56,  55,  55,  54,  53,
+     53,  52,  51,  51,  50,  50,  49,  48,  48,  47,  47,  46,  45,  45,  44,  43,
+     43,  42,  42,  41,  40,  40,  39,  39,  38,  37,  37,  36,  36,  35,  35,  34,
+     33,  33,  32,  32,  31,  31,  30,  29,  29,  28,  28,  27,  27,  26,  25,  25,
+     24,  24,  23,  23,  22,  22,  21,  20,  20,  19,  19,  18,  18,  17,  17,  16,
+     16,  15,  15,  14,  13,  13,  12,  12,  11,  11,  10,  10,   9,   9,   8,   8,
+      7,   7,   6,   6,   5,   5,   4,   4,   3,   3,   2,   2,   1,   1,   0,   0,
+};
+
+// Smallest desaturation of some sat not below index
+static const uint8_t rainbow_desat_next[256] = {
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+     16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,
+     32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+     48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,
+     64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+     80,  82,  82,  83,  84,  85,  86,  87,  88,  90,  90,  91,  92,  93,  94,  96,
+     96,  97,  98,  99, 101, 101, 102, 103, 104, 106, 106, 107, 108, 109, 111, 111,
+    112, 113, 115, 115, 116, 117, 119, 119, 120, 122, 122, 123, 124, 126, 126, 127,
+    128, 130, 130, 131, 133, 133, 134, 136, 136, 137, 139, 139, 140, 142, 142, 143,
+    145, 145, 146, 148, 148, 149, 151, 151, 152, 154, 154, 155, 157, 157, 158, 160,
+    160, 161, 163, 163, 165, 165, 166, 168, 168, 170, 170, 171, 173, 173, 174, 176,
+    176, 178, 178, 179, 181, 181, 183, 183, 184, 186, 186, 188, 188, 190, 190, 191,
+    193, 193, 195, 195, 197, 197, 198, 200, 200, 202, 202, 204, 204, 205, 207, 207,
+    209, 209, 211, 211, 213, 213, 214, 216, 216, 218, 218, 220, 220, 222, 222, 224,
+    224, 226, 226, 227, 229, 229, 231, 231, 233, 233, 235, 235, 237, 237, 239, 239,
+    241, 241, 243, 243, 245, 245, 247, 247, 249, 249, 251, 251, 253, 253, 255, 255,
+};
+
+// Hue nearest to ratio b * 255 / (a + b) of two nonzero channels, per section
+static const uint8_t rainbow_inv_hue[3][256] = {
+    {
+          0,   0,   1,   1,   2,   2,   2,   3,   3,   3,   4,   4,   5,   5,   5,   6,
+          6,   6,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+         12,  12,  13,  13,  14,  14,  14,  15,  15,  15,  16,  16,  16,  17,  17,  18,
+         18,  18,  19,  19,  19,  20,  20,  21,  21,  21,  22,  22,  22,  23,  23,  24,
+         24,  24,  25,  25,  25,  26,  26,  27,  27,  27,  28,  28,  28,  29,  29,  30,
+         30,  30,  31,  31,  32,  33,  33,  34,  34,  35,  35,  36,  37,  37,  38,  39,
+         39,  40,  40,  41,  42,  42,  43,  44,  45,  45,  46,  47,  47,  48,  49,  50,
+         51,  52,  52,  53,  54,  55,  56,  56,  57,  57,  59,  60,  61,  62,  63,  64,
+         64,  65,  65,  66,  66,  66,  66,  67,  67,  67,  68,  68,  68,  69,  69,  69,
+         70,  70,  70,  71,  71,  71,  71,  72,  72,  72,  72,  73,  73,  73,  74,  74,
+         74,  75,  75,  75,  75,  76,  76,  76,  76,  77,  77,  77,  78,  78,  78,  78,
+         79,  79,  79,  79,  80,  80,  80,  80,  81,  81,  81,  81,  82,  82,  82,  82,
+         83,  83,  83,  83,  84,  84,  84,  84,  85,  85,  85,  85,  85,  86,  86,  86,
+         86,  87,  87,  87,  87,  88,  88,  88,  88,  88,  89,  89,  89,  89,  90,  90,
+         90,  90,  90,  91,  91,  91,  91,  91,  92,  92,  92,  92,  93,  93,  93,  93,
+         93,  93,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  95,  95,  95,  95,
+    },
+    {
+         96,  96,  97,  97,  98,  98,  98,  99,  99,  99, 100, 100, 101, 101, 101, 102,
+        102, 102, 103, 103, 104, 104, 104, 105, 105, 105, 106, 106, 107, 107, 107, 108,
+        108, 108, 109, 109, 110, 110, 110, 111, 111, 111, 112, 112, 112, 113, 113, 114,
+        114, 114, 115, 115, 115, 116, 116, 117, 117, 117, 118, 118, 118, 119, 119, 120,
+        120, 120, 121, 121, 121, 122, 122, 123, 123, 123, 124, 124, 124, 125, 125, 126,
+        126, 126, 127, 127, 128, 128, 128, 129, 129, 129, 129, 129, 130, 130, 130, 130,
+        130, 130, 131, 131, 131, 131, 131, 132, 132, 132, 132, 132, 133, 133, 133, 133,
+        133, 133, 134, 134, 134, 134, 134, 135, 135, 135, 135, 135, 136, 136, 136, 136,
+        136, 136, 137, 137, 137, 137, 137, 138, 138, 138, 138, 138, 139, 139, 139, 139,
+        139, 139, 140, 140, 140, 140, 140, 141, 141, 141, 141, 141, 142, 142, 142, 142,
+        142, 142, 143, 143, 143, 143, 143, 144, 144, 144, 144, 144, 145, 145, 145, 145,
+        145, 145, 146, 146, 146, 146, 146, 147, 147, 147, 147, 147, 148, 148, 148, 148,
+        148, 148, 149, 149, 149, 149, 149, 150, 150, 150, 150, 150, 151, 151, 151, 151,
+        151, 151, 152, 152, 152, 152, 152, 153, 153, 153, 153, 153, 154, 154, 154, 154,
+        154, 154, 155, 155, 155, 155, 155, 156, 156, 156, 156, 156, 157, 157, 157, 157,
+        157, 157, 158, 158, 158, 158, 158, 159, 159, 159, 159, 159, 159, 159, 159, 159,
+    },
+    {
+        160, 160, 161, 161, 162, 162, 162, 163, 163, 163, 164, 164, 165, 165, 165, 166,
+        166, 166, 167, 167, 168, 168, 168, 169, 169, 169, 170, 170, 171, 171, 171, 172,
+        172, 172, 173, 173, 174, 174, 174, 175, 175, 175, 176, 176, 176, 177, 177, 178,
+        178, 178, 179, 179, 179, 180, 180, 181, 181, 181, 182, 182, 182, 183, 183, 184,
+        184, 184, 185, 185, 185, 186, 186, 187, 187, 187, 188, 188, 188, 189, 189, 190,
+        190, 190, 191, 191, 192, 192, 193, 193, 194, 194, 194, 195, 195, 195, 196, 196,
+        197, 197, 197, 198, 198, 198, 199, 199, 200, 200, 200, 201, 201, 201, 202, 202,
+        203, 203, 203, 204, 204, 204, 205, 205, 206, 206, 206, 207, 207, 207, 208, 208,
+        208, 209, 209, 210, 210, 210, 211, 211, 211, 212, 212, 213, 213, 213, 214, 214,
+        214, 215, 215, 216, 216, 216, 217, 217, 217, 218, 218, 219, 219, 219, 220, 220,
+        220, 221, 221, 222, 222, 222, 223, 223, 223, 224, 224, 224, 225, 225, 226, 226,
+        226, 227, 227, 227, 228, 228, 229, 229, 229, 230, 230, 230, 231, 231, 232, 232,
+        232, 233, 233, 233, 234, 234, 235, 235, 235, 236, 236, 236, 237, 237, 238, 238,
+        238, 239, 239, 239, 240, 240, 240, 241, 241, 242, 242, 242, 243, 243, 243, 244,
+        244, 245, 245, 245, 246, 246, 246, 247, 247, 248, 248, 248, 249, 249, 249, 250,
+        250, 251, 251, 251, 252, 252, 252, 253, 253, 254, 254, 254, 255, 255, 255, 255,
+    },
+};
+
+// First hue of section, counted from its start, whose channel b is at least index
+static const uint8_t rainbow_b_first[3][257] = {
+    {
+          0,   1,   1,   2,   2,   2,   3,   3,   3,   4,   4,   5,   5,   5,   6,   6,
+          6,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,  12,
+         12,  13,  13,  14,  14,  14,  15,  15,  15,  16,  16,  16,  17,  17,  18,  18,
+         18,  19,  19,  19,  20,  20,  21,  21,  21,  22,  22,  22,  23,  23,  24,  24,
+         24,  25,  25,  25,  26,  26,  27,  27,  27,  28,  28,  28,  29,  29,  30,  30,
+         30,  31,  31,  31,  32,  32,  33,  33,  34,  34,  34,  35,  35,  35,  36,  36,
+         37,  37,  37,  38,  38,  38,  39,  39,  40,  40,  40,  41,  41,  41,  42,  42,
+         43,  43,  43,  44,  44,  44,  45,  45,  46,  46,  46,  47,  47,  47,  48,  48,
+         48,  49,  49,  50,  50,  50,  51,  51,  51,  52,  52,  53,  53,  53,  54,  54,
+         54,  55,  55,  56,  56,  56,  57,  57,  57,  58,  58,  59,  59,  59,  60,  60,
+         60,  61,  61,  62,  62,  62,  63,  63,  63,  64,  64,  65,  65,  66,  66,  66,
+         67,  67,  67,  68,  68,  69,  69,  69,  70,  70,  70,  71,  71,  72,  72,  72,
+         73,  73,  73,  74,  74,  75,  75,  75,  76,  76,  76,  77,  77,  78,  78,  78,
+         79,  79,  79,  80,  80,  80,  81,  81,  82,  82,  82,  83,  83,  83,  84,  84,
+         85,  85,  85,  86,  86,  86,  87,  87,  88,  88,  88,  89,  89,  89,  90,  90,
+         91,  91,  91,  92,  92,  92,  93,  93,  94,  94,  94,  95,  95,  95,  96,  96,
+         97,
+    },
+    {
+          0,   1,   1,   2,   2,   2,   3,   3,   3,   4,   4,   5,   5,   5,   6,   6,
+          6,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,  12,
+         12,  13,  13,  14,  14,  14,  15,  15,  15,  16,  16,  16,  17,  17,  18,  18,
+         18,  19,  19,  19,  20,  20,  21,  21,  21,  22,  22,  22,  23,  23,  24,  24,
+         24,  25,  25,  25,  26,  26,  27,  27,  27,  28,  28,  28,  29,  29,  30,  30,
+         30,  31,  31,  31,  32,  32,  33,  33,  33,  33,  33,  34,  34,  34,  34,  34,
+         35,  35,  35,  35,  35,  35,  36,  36,  36,  36,  36,  37,  37,  37,  37,  37,
+         38,  38,  38,  38,  38,  38,  39,  39,  39,  39,  39,  40,  40,  40,  40,  40,
+         41,  41,  41,  41,  41,  41,  42,  42,  42,  42,  42,  43,  43,  43,  43,  43,
+         44,  44,  44,  44,  44,  44,  45,  45,  45,  45,  45,  46,  46,  46,  46,  46,
+         47,  47,  47,  47,  47,  47,  48,  48,  48,  48,  48,  49,  49,  49,  49,  49,
+         50,  50,  50,  50,  50,  50,  51,  51,  51,  51,  51,  52,  52,  52,  52,  52,
+         53,  53,  53,  53,  53,  53,  54,  54,  54,  54,  54,  55,  55,  55,  55,  55,
+         56,  56,  56,  56,  56,  56,  57,  57,  57,  57,  57,  58,  58,  58,  58,  58,
+         59,  59,  59,  59,  59,  59,  60,  60,  60,  60,  60,  61,  61,  61,  61,  61,
+         62,  62,  62,  62,  62,  62,  63,  63,  63,  63,  63,  64,  64,  64,  64,  64,
+         65,
+    },
+    {
+          0,   1,   1,   2,   2,   2,   3,   3,   3,   4,   4,   5,   5,   5,   6,   6,
+          6,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,  12,
+         12,  13,  13,  14,  14,  14,  15,  15,  15,  16,  16,  16,  17,  17,  18,  18,
+         18,  19,  19,  19,  20,  20,  21,  21,  21,  22,  22,  22,  23,  23,  24,  24,
+         24,  25,  25,  25,  26,  26,  27,  27,  27,  28,  28,  28,  29,  29,  30,  30,
+         30,  31,  31,  31,  32,  32,  33,  33,  34,  34,  34,  35,  35,  35,  36,  36,
+         37,  37,  37,  38,  38,  38,  39,  39,  40,  40,  40,  41,  41,  41,  42,  42,
+         43,  43,  43,  44,  44,  44,  45,  45,  46,  46,  46,  47,  47,  47,  48,  48,
+         48,  49,  49,  50,  50,  50,  51,  51,  51,  52,  52,  53,  53,  53,  54,  54,
+         54,  55,  55,  56,  56,  56,  57,  57,  57,  58,  58,  59,  59,  59,  60,  60,
+         60,  61,  61,  62,  62,  62,  63,  63,  63,  64,  64,  65,  65,  66,  66,  66,
+         67,  67,  67,  68,  68,  69,  69,  69,  70,  70,  70,  71,  71,  72,  72,  72,
+         73,  73,  73,  74,  74,  75,  75,  75,  76,  76,  76,  77,  77,  78,  78,  78,
+         79,  79,  79,  80,  80,  80,  81,  81,  82,  82,  82,  83,  83,  83,  84,  84,
+         85,  85,  85,  86,  86,  86,  87,  87,  88,  88,  88,  89,  89,  89,  90,  90,
+         91,  91,  91,  92,  92,  92,  93,  93,  94,  94,  94,  95,  95,  95,  96,  96,
+         97,
+    },
+};
+
+// First hue of section, counted from its start, whose channel a is at most index
+static const uint8_t rainbow_a_first[3][256] = {
+    {
+         96,  96,  96,  96,  96,  96,  95,  95,  95,  95,  95,  94,  94,  94,  94,  94,
+         94,  93,  93,  93,  93,  93,  92,  92,  92,  92,  92,  91,  91,  91,  91,  91,
+         91,  90,  90,  90,  90,  90,  89,  89,  89,  89,  89,  88,  88,  88,  88,  88,
+         88,  87,  87,  87,  87,  87,  86,  86,  86,  86,  86,  85,  85,  85,  85,  85,
+         85,  84,  84,  84,  84,  84,  83,  83,  83,  83,  83,  82,  82,  82,  82,  82,
+         82,  81,  81,  81,  81,  81,  80,  80,  80,  80,  80,  79,  79,  79,  79,  79,
+         79,  78,  78,  78,  78,  78,  77,  77,  77,  77,  77,  76,  76,  76,  76,  76,
+         76,  75,  75,  75,  75,  75,  74,  74,  74,  74,  74,  73,  73,  73,  73,  73,
+         73,  72,  72,  72,  72,  72,  71,  71,  71,  71,  71,  70,  70,  70,  70,  70,
+         70,  69,  69,  69,  69,  69,  68,  68,  68,  68,  68,  67,  67,  67,  67,  67,
+         67,  66,  66,  66,  66,  66,  65,  65,  65,  65,  65,  32,  31,  31,  31,  30,
+         30,  30,  29,  29,  28,  28,  28,  27,  27,  27,  26,  26,  25,  25,  25,  24,
+         24,  24,  23,  23,  22,  22,  22,  21,  21,  21,  20,  20,  19,  19,  19,  18,
+         18,  18,  17,  17,  16,  16,  16,  15,  15,  15,  14,  14,  14,  13,  13,  12,
+         12,  12,  11,  11,  11,  10,  10,   9,   9,   9,   8,   8,   8,   7,   7,   6,
+          6,   6,   5,   5,   5,   4,   4,   3,   3,   3,   2,   2,   2,   1,   1,   0,
+    },
+    {
+         64,  64,  64,  64,  64,  64,  63,  63,  63,  63,  63,  62,  62,  62,  62,  62,
+         62,  61,  61,  61,  61,  61,  60,  60,  60,  60,  60,  59,  59,  59,  59,  59,
+         59,  58,  58,  58,  58,  58,  57,  57,  57,  57,  57,  56,  56,  56,  56,  56,
+         56,  55,  55,  55,  55,  55,  54,  54,  54,  54,  54,  53,  53,  53,  53,  53,
+         53,  52,  52,  52,  52,  52,  51,  51,  51,  51,  51,  50,  50,  50,  50,  50,
+         50,  49,  49,  49,  49,  49,  48,  48,  48,  48,  48,  47,  47,  47,  47,  47,
+         47,  46,  46,  46,  46,  46,  45,  45,  45,  45,  45,  44,  44,  44,  44,  44,
+         44,  43,  43,  43,  43,  43,  42,  42,  42,  42,  42,  41,  41,  41,  41,  41,
+         41,  40,  40,  40,  40,  40,  39,  39,  39,  39,  39,  38,  38,  38,  38,  38,
+         38,  37,  37,  37,  37,  37,  36,  36,  36,  36,  36,  35,  35,  35,  35,  35,
+         35,  34,  34,  34,  34,  34,  33,  33,  33,  33,  33,  32,  31,  31,  31,  30,
+         30,  30,  29,  29,  28,  28,  28,  27,  27,  27,  26,  26,  25,  25,  25,  24,
+         24,  24,  23,  23,  22,  22,  22,  21,  21,  21,  20,  20,  19,  19,  19,  18,
+         18,  18,  17,  17,  16,  16,  16,  15,  15,  15,  14,  14,  14,  13,  13,  12,
+         12,  12,  11,  11,  11,  10,  10,   9,   9,   9,   8,   8,   8,   7,   7,   6,
+          6,   6,   5,   5,   5,   4,   4,   3,   3,   3,   2,   2,   2,   1,   1,   0,
+    },
+    {
+         96,  96,  95,  95,  95,  94,  94,  94,  93,  93,  92,  92,  92,  91,  91,  91,
+         90,  90,  89,  89,  89,  88,  88,  88,  87,  87,  86,  86,  86,  85,  85,  85,
+         84,  84,  83,  83,  83,  82,  82,  82,  81,  81,  80,  80,  80,  79,  79,  79,
+         78,  78,  78,  77,  77,  76,  76,  76,  75,  75,  75,  74,  74,  73,  73,  73,
+         72,  72,  72,  71,  71,  70,  70,  70,  69,  69,  69,  68,  68,  67,  67,  67,
+         66,  66,  66,  65,  65,  64,  64,  64,  63,  63,  63,  62,  62,  62,  61,  61,
+         60,  60,  60,  59,  59,  59,  58,  58,  57,  57,  57,  56,  56,  56,  55,  55,
+         54,  54,  54,  53,  53,  53,  52,  52,  51,  51,  51,  50,  50,  50,  49,  49,
+         48,  48,  48,  47,  47,  47,  46,  46,  46,  45,  45,  44,  44,  44,  43,  43,
+         43,  42,  42,  41,  41,  41,  40,  40,  40,  39,  39,  38,  38,  38,  37,  37,
+         37,  36,  36,  35,  35,  35,  34,  34,  34,  33,  33,  32,  31,  31,  31,  30,
+         30,  30,  29,  29,  28,  28,  28,  27,  27,  27,  26,  26,  25,  25,  25,  24,
+         24,  24,  23,  23,  22,  22,  22,  21,  21,  21,  20,  20,  19,  19,  19,  18,
+         18,  18,  17,  17,  16,  16,  16,  15,  15,  15,  14,  14,  14,  13,  13,  12,
+         12,  12,  11,  11,  11,  10,  10,   9,   9,   9,   8,   8,   8,   7,   7,   6,
+          6,   6,   5,   5,   5,   4,   4,   3,   3,   3,   2,   2,   2,   1,   1,   0,
+    },
+};
+
+// Reciprocals for division by multiplication, floor(2^31 / index) + 1
+static const uint32_t rainbow_recip[512] = {
+    0x00000000, 0x80000001, 0x40000001, 0x2aaaaaab, 0x20000001, 0x1999999a, 0x15555556, 0x12492493,
+    0x10000001, 0x0e38e38f, 0x0ccccccd, 0x0ba2e8bb, 0x0aaaaaab, 0x09d89d8a, 0x0924924a, 0x08888889,
+    0x08000001, 0x07878788, 0x071c71c8, 0x06bca1b0, 0x06666667, 0x06186187, 0x05d1745e, 0x0590b217,
+    0x05555556, 0x051eb852, 0x04ec4ec5, 0x04bda130, 0x04924925, 0x0469ee59, 0x04444445, 0x04210843,
+    0x04000001, 0x03e0f83f, 0x03c3c3c4, 0x03a83a84, 0x038e38e4, 0x03759f23, 0x035e50d8, 0x03483484,
+    0x03333334, 0x031f3832, 0x030c30c4, 0x02fa0be9, 0x02e8ba2f, 0x02d82d83, 0x02c8590c, 0x02b93106,
+    0x02aaaaab, 0x029cbc15, 0x028f5c29, 0x02828283, 0x02762763, 0x026a43a0, 0x025ed098, 0x0253c826,
+    0x02492493, 0x023ee090, 0x0234f72d, 0x022b63cc, 0x02222223, 0x02192e2a, 0x02108422, 0x02082083,
+    0x02000001, 0x01f81f82, 0x01f07c20, 0x01e9131b, 0x01e1e1e2, 0x01dae608, 0x01d41d42, 0x01cd8569,
+    0x01c71c72, 0x01c0e071, 0x01bacf92, 0x01b4e81c, 0x01af286c, 0x01a98ef7, 0x01a41a42, 0x019ec8ea,
+    0x0199999a, 0x01948b10, 0x018f9c19, 0x018acb91, 0x01861862, 0x01818182, 0x017d05f5, 0x0178a4c9,
+    0x01745d18, 0x01702e06, 0x016c16c2, 0x01681682, 0x01642c86, 0x01605817, 0x015c9883, 0x0158ed24,
+    0x01555556, 0x0151d07f, 0x014e5e0b, 0x014afd6b, 0x0147ae15, 0x01446f87, 0x01414142, 0x013e22cc,
+    0x013b13b2, 0x01381382, 0x013521d0, 0x01323e35, 0x012f684c, 0x012c9fb5, 0x0129e413, 0x0127350c,
+    0x0124924a, 0x0121fb79, 0x011f7048, 0x011cf06b, 0x011a7b97, 0x01181182, 0x0115b1e6, 0x01135c82,
+    0x01111112, 0x010ecf57, 0x010c9715, 0x010a6811, 0x01084211, 0x010624de, 0x01041042, 0x01020409,
+    0x01000001, 0x00fe03f9, 0x00fc0fc1, 0x00fa232d, 0x00f83e10, 0x00f6603e, 0x00f4898e, 0x00f2b9d7,
+    0x00f0f0f1, 0x00ef2eb8, 0x00ed7304, 0x00ebbdb3, 0x00ea0ea1, 0x00e865ad, 0x00e6c2b5, 0x00e52599,
+    0x00e38e39, 0x00e1fc79, 0x00e07039, 0x00dee95d, 0x00dd67c9, 0x00dbeb62, 0x00da740e, 0x00d901b3,
+    0x00d79436, 0x00d62b81, 0x00d4c77c, 0x00d3680e, 0x00d20d21, 0x00d0b6a0, 0x00cf6475, 0x00ce168b,
+    0x00cccccd, 0x00cb8728, 0x00ca4588, 0x00c907db, 0x00c7ce0d, 0x00c6980d, 0x00c565c9, 0x00c43730,
+    0x00c30c31, 0x00c1e4bc, 0x00c0c0c1, 0x00bfa030, 0x00be82fb, 0x00bd6911, 0x00bc5265, 0x00bb3ee8,
+    0x00ba2e8c, 0x00b92144, 0x00b81703, 0x00b70fbc, 0x00b60b61, 0x00b509e7, 0x00b40b41, 0x00b30f64,
+    0x00b21643, 0x00b11fd4, 0x00b02c0c, 0x00af3ade, 0x00ae4c42, 0x00ad602c, 0x00ac7692, 0x00ab8f6a,
+    0x00aaaaab, 0x00a9c84b, 0x00a8e840, 0x00a80a81, 0x00a72f06, 0x00a655c5, 0x00a57eb6, 0x00a4a9d0,
+    0x00a3d70b, 0x00a3065f, 0x00a237c4, 0x00a16b32, 0x00a0a0a1, 0x009fd80a, 0x009f1166, 0x009e4cae,
+    0x009d89d9, 0x009cc8e2, 0x009c09c1, 0x009b4c70, 0x009a90e8, 0x0099d723, 0x00991f1b, 0x009868c9,
+    0x0097b426, 0x0097012f, 0x00964fdb, 0x0095a026, 0x0094f20a, 0x00944581, 0x00939a86, 0x0092f114,
+    0x00924925, 0x0091a2b4, 0x0090fdbd, 0x00905a39, 0x008fb824, 0x008f177a, 0x008e7836, 0x008dda53,
+    0x008d3dcc, 0x008ca29d, 0x008c08c1, 0x008b7035, 0x008ad8f3, 0x008a42f9, 0x0089ae41, 0x00891ac8,
+    0x00888889, 0x0087f781, 0x008767ac, 0x0086d906, 0x00864b8b, 0x0085bf38, 0x00853409, 0x0084a9fa,
+    0x00842109, 0x00839931, 0x0083126f, 0x00828cc0, 0x00820821, 0x0081848e, 0x00810205, 0x00808081,
+    0x00800001, 0x007f8080, 0x007f01fd, 0x007e8473, 0x007e07e1, 0x007d8c43, 0x007d1197, 0x007c97da,
+    0x007c1f08, 0x007ba720, 0x007b301f, 0x007aba02, 0x007a44c7, 0x0079d06b, 0x00795cec, 0x0078ea46,
+    0x00787879, 0x00780781, 0x0077975c, 0x00772808, 0x0076b982, 0x00764bc9, 0x0075deda, 0x007572b3,
+    0x00750751, 0x00749cb3, 0x007432d7, 0x0073c9ba, 0x0073615b, 0x0072f9b7, 0x007292cd, 0x00722c9a,
+    0x0071c71d, 0x00716254, 0x0070fe3d, 0x00709ad5, 0x0070381d, 0x006fd610, 0x006f74af, 0x006f13f6,
+    0x006eb3e5, 0x006e5479, 0x006df5b1, 0x006d978c, 0x006d3a07, 0x006cdd22, 0x006c80da, 0x006c252d,
+    0x006bca1b, 0x006b6fa2, 0x006b15c1, 0x006abc75, 0x006a63be, 0x006a0b9a, 0x0069b407, 0x00695d05,
+    0x00690691, 0x0068b0ab, 0x00685b50, 0x00680681, 0x0067b23b, 0x00675e7d, 0x00670b46, 0x0066b894,
+    0x00666667, 0x006614bd, 0x0065c394, 0x006572ed, 0x006522c4, 0x0064d31a, 0x006483ee, 0x0064353d,
+    0x0063e707, 0x0063994a, 0x00634c07, 0x0062ff3b, 0x0062b2e5, 0x00626704, 0x00621b98, 0x0061d09f,
+    0x00618619, 0x00613c04, 0x0060f25e, 0x0060a929, 0x00606061, 0x00601807, 0x005fd018, 0x005f8896,
+    0x005f417e, 0x005efacf, 0x005eb489, 0x005e6eaa, 0x005e2933, 0x005de421, 0x005d9f74, 0x005d5b2c,
+    0x005d1746, 0x005cd3c4, 0x005c90a2, 0x005c4de2, 0x005c0b82, 0x005bc981, 0x005b87de, 0x005b4699,
+    0x005b05b1, 0x005ac525, 0x005a84f4, 0x005a451d, 0x005a05a1, 0x0059c67d, 0x005987b2, 0x0059493f,
+    0x00590b22, 0x0058cd5b, 0x00588fea, 0x005852ce, 0x00581606, 0x0057d991, 0x00579d6f, 0x005761a0,
+    0x00572621, 0x0056eaf4, 0x0056b016, 0x00567588, 0x00563b49, 0x00560159, 0x0055c7b5, 0x00558e5f,
+    0x00555556, 0x00551c98, 0x0054e426, 0x0054abfe, 0x00547420, 0x00543c8c, 0x00540541, 0x0053ce3e,
+    0x00539783, 0x0053610f, 0x00532ae3, 0x0052f4fc, 0x0052bf5b, 0x005289ff, 0x005254e8, 0x00522015,
+    0x0051eb86, 0x0051b739, 0x00518330, 0x00514f68, 0x00511be2, 0x0050e89d, 0x0050b599, 0x005082d5,
+    0x00505051, 0x00501e0c, 0x004fec05, 0x004fba3e, 0x004f88b3, 0x004f5767, 0x004f2657, 0x004ef584,
+    0x004ec4ed, 0x004e9491, 0x004e6471, 0x004e348c, 0x004e04e1, 0x004dd570, 0x004da638, 0x004d773a,
+    0x004d4874, 0x004d19e7, 0x004ceb92, 0x004cbd74, 0x004c8f8e, 0x004c61de, 0x004c3465, 0x004c0721,
+    0x004bda13, 0x004bad3b, 0x004b8098, 0x004b5429, 0x004b27ee, 0x004afbe7, 0x004ad013, 0x004aa473,
+    0x004a7905, 0x004a4dca, 0x004a22c1, 0x0049f7e9, 0x0049cd43, 0x0049a2ce, 0x0049788a, 0x00494e76,
+    0x00492493, 0x0048fadf, 0x0048d15a, 0x0048a805, 0x00487edf, 0x004855e7, 0x00482d1d, 0x00480481,
+    0x0047dc12, 0x0047b3d1, 0x00478bbd, 0x004763d6, 0x00473c1b, 0x0047148c, 0x0046ed2a, 0x0046c5f2,
+    0x00469ee6, 0x00467805, 0x0046514f, 0x00462ac3, 0x00460461, 0x0045de29, 0x0045b81b, 0x00459236,
+    0x00456c7a, 0x004546e7, 0x0045217d, 0x0044fc3b, 0x0044d721, 0x0044b22f, 0x00448d64, 0x004468c1,
+    0x00444445, 0x00441fef, 0x0043fbc1, 0x0043d7b8, 0x0043b3d6, 0x0043901a, 0x00436c83, 0x00434912,
+    0x004325c6, 0x0043029f, 0x0042df9c, 0x0042bcbe, 0x00429a05, 0x0042776f, 0x004254fd, 0x004232af,
+    0x00421085, 0x0041ee7d, 0x0041cc99, 0x0041aad7, 0x00418938, 0x004167bb, 0x00414660, 0x00412528,
+    0x00410411, 0x0040e31b, 0x0040c247, 0x0040a194, 0x00408103, 0x00406091, 0x00404041, 0x00402011,
+};
+
+#endif /* __COLOR_RAINBOW_TABLES_H__ */
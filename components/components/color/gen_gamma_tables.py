@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""
+Generate color_gamma_tables.h with gamma lookup tables for common gammas.
+
+Values match apply_gamma2brightness() computed with single precision powf().
+Run after changing GAMMAS: python3 gen_gamma_tables.py > color_gamma_tables.h
+"""
+import struct
+
+GAMMAS = ['1.8', '2.0', '2.2', '2.5', '2.8']
+
+
+def f32(x):
+    return struct.unpack('f', struct.pack('f', x))[0]
+
+
+def gamma_value(brightness, gamma):
+    orig = f32(brightness / 255.0)
+    adj = f32(f32(orig ** gamma) * 255.0)
+    result = int(adj)
+    if brightness > 0 and not result:
+        result = 1
+    return result
+
+
+def main():
+    print('/**')
+    print(' * @file color_gamma_tables.h')
+    print(' *')
+    print(' * Gamma tables for common gammas, generated by gen_gamma_tables.py')
+    print(' */')
+    print('#ifndef __COLOR_GAMMA_TABLES_H__')
+    print('#define __COLOR_GAMMA_TABLES_H__')
+    print()
+    print('#include <stdint.h>')
+    print()
+    print('#define COLOR_GAMMA_BUILTIN_COUNT %d' % len(GAMMAS))
+    print()
+    print('#define COLOR_GAMMA_BUILTIN_VALUES ' + ', '.join(g + 'f' for g in GAMMAS))
+    print()
+    print('static const uint8_t color_gamma_builtin_lut[COLOR_GAMMA_BUILTIN_COUNT][256] = {')
+    for g in GAMMAS:
+        values = [gamma_value(i, f32(float(g))) for i in range(256)]
+        print('    // %s' % g)
+        print('    {')
+        for row in range(0, 256, 16):
+            print('        ' + ', '.join('%3d' % v for v in values[row:row + 16]) + ',')
+        print('    },')
+    print('};')
+    print()
+    print('#endif /* __COLOR_GAMMA_TABLES_H__ */')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Generate color_rainbow_tables.h with tables of hsv2rgb_rainbow() and its
+inverse rgb2hsv_rainbow().
+
+Values match scale8() and scale8_video() of lib8tion and the rainbow of
+hsv2rgb_rainbow() with the default moderate yellow boost.
+Run after changing them: python3 gen_rainbow_tables.py > color_rainbow_tables.h
+"""
+
+# First hue of rainbow sections, by the channel which is zero at full
+# saturation: red-yellow-green (blue), green-aqua-blue (red),
+# blue-purple-red (green). Channel a falls and channel b rises over a section.
+SECTION_FIRST = [0, 96, 160, 256]
+SECTION_A = [0, 1, 2]
+SECTION_B = [1, 2, 0]
+
+
+def scale8(i, scale):
+    return (i * (1 + scale)) >> 8
+
+
+def scale8_video(i, scale):
+    return ((i * scale) >> 8) + (1 if i and scale else 0)
+
+
+def rainbow(hue):
+    third = scale8((hue & 0x1f) << 3, 256 // 3)
+    twothirds = scale8((hue & 0x1f) << 3, (256 * 2) // 3)
+    return [
+        (255 - third, third, 0),
+        (171, 85 + third, 0),
+        (171 - twothirds, 170 + third, 0),
+        (0, 255 - third, third),
+        (0, 171 - twothirds, 85 + twothirds),
+        (third, 0, 255 - third),
+        (85 + third, 0, 171 - third),
+        (170 + third, 0, 85 - third),
+    ][hue >> 5]
+
+
+def nearest(values, t):
+    # First index of the value nearest to t
+    return min(range(256), key=lambda i: (abs(values[i] - t), i))
+
+
+def section(s):
+    # Hues of section s including the first one of the next section,
+    # whose zero channel is also zero in this one
+    a, b = SECTION_A[s], SECTION_B[s]
+    hues = [rainbow(h & 0xff) for h in range(SECTION_FIRST[s], SECTION_FIRST[s + 1] + 1)]
+    for prev, c in zip(hues, hues[1:]):
+        assert c[3 - a - b] == 0 and c[a] <= prev[a] and c[b] > prev[b]
+    return [c[a] for c in hues], [c[b] for c in hues]
+
+
+def print_table(decl, values, width=16, fmt='%3d'):
+    print('static const %s = {' % decl)
+    for row in range(0, len(values), width):
+        print('    ' + ', '.join(fmt % v for v in values[row:row + width]) + ',')
+    print('};')
+    print()
+
+
+def print_table2(decl, rows, width=16):
+    print('static const %s = {' % decl)
+    for values in rows:
+        print('    {')
+        for row in range(0, len(values), width):
+            print('        ' + ', '.join('%3d' % v for v in values[row:row + width]) + ',')
+        print('    },')
+    print('};')
+    print()
+
+
+def main():
+    hue_lut = [rainbow(h) for h in range(256)]
+    video = [scale8_video(i, i) for i in range(256)]
+    desat = [scale8_video(255 - i, 255 - i) for i in range(256)]
+
+    inv_hue = []
+    for s in range(3):
+        a, b = SECTION_A[s], SECTION_B[s]
+        first, last = SECTION_FIRST[s], SECTION_FIRST[s + 1]
+        ratio = [hue_lut[h][b] * 255 // (hue_lut[h][a] + hue_lut[h][b]) for h in range(first, last)]
+        inv_hue.append([first + min(range(last - first), key=lambda i: (abs(ratio[i] - q), i)) for q in range(256)])
+
+    desat_next = [min(x for x in set(desat) if x >= d) for d in range(256)]
+
+    b_first, a_first = [], []
+    for s in range(3):
+        ca, cb = section(s)
+        b_first.append([next((i for i, c in enumerate(cb) if c >= x), len(cb)) for x in range(257)])
+        a_first.append([next((i for i, c in enumerate(ca) if c <= x), len(ca)) for x in range(256)])
+
+    # floor(n / d) == (n * recip[d]) >> 31 whenever n * d < 2^31
+    recip = [0] + [(1 << 31) // d + 1 for d in range(1, 512)]
+    for d in range(1, 512):
+        for n in (0, 1, d - 1, d, d + 1, (1 << 31) // d - 1):
+            assert (n * recip[d]) >> 31 == n // d
+
+    print('/**')
+    print(' * @file color_rainbow_tables.h')
+    print(' *')
+    print(' * Tables of hsv2rgb_rainbow() and rgb2hsv_rainbow(), generated by gen_rainbow_tables.py')
+    print(' */')
+    print('#ifndef __COLOR_RAINBOW_TABLES_H__')
+    print('#define __COLOR_RAINBOW_TABLES_H__')
+    print()
+    print('#include <stdint.h>')
+    print()
+    print('// hsv2rgb_rainbow() of every hue at full saturation and value')
+    print('static const uint8_t rainbow_hue_lut[256][3] = {')
+    for row in range(0, 256, 8):
+        print('    ' + ', '.join('{%d, %d, %d}' % c for c in hue_lut[row:row + 8]) + ',')
+    print('};')
+    print()
+    print('// Rainbow sections, see rgb2hsv_rainbow()')
+    print('static const uint16_t rainbow_section_first[4] = { %s };' % ', '.join(map(str, SECTION_FIRST)))
+    print('static const uint8_t rainbow_section_a[3] = { %s };' % ', '.join(map(str, SECTION_A)))
+    print('static const uint8_t rainbow_section_b[3] = { %s };' % ', '.join(map(str, SECTION_B)))
+    print()
+    print('// val whose scale8_video(val, val) is nearest to index')
+    print_table('uint8_t rainbow_inv_val[256]', [nearest(video, t) for t in range(256)])
+    print('// sat whose desaturation scale8_video(255 - sat, 255 - sat) is nearest to index')
+    print_table('uint8_t rainbow_inv_sat[256]', [nearest(desat, t) for t in range(256)])
+    print('// Smallest desaturation of some sat not below index')
+    print_table('uint8_t rainbow_desat_next[256]', desat_next)
+    print('// Hue nearest to ratio b * 255 / (a + b) of two nonzero channels, per section')
+    print_table2('uint8_t rainbow_inv_hue[3][256]', inv_hue)
+    print('// First hue of section, counted from its start, whose channel b is at least index')
+    print_table2('uint8_t rainbow_b_first[3][257]', b_first)
+    print('// First hue of section, counted from its start, whose channel a is at most index')
+    print_table2('uint8_t rainbow_a_first[3][256]', a_first)
+    print('// Reciprocals for division by multiplication, floor(2^31 / index) + 1')
+    print_table('uint32_t rainbow_recip[512]', recip, 8, '0x%08x')
+    print('#endif /* __COLOR_RAINBOW_TABLES_H__ */')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,192 @@
+/**
+ * @file fblayers.c
+ *
+ * Stacked framebuffer layers with blend modes
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include <esp_err.h>
+#include "fblayers.h"
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+// Row blenders, work on channels, len is number of bytes
+
+static void row_replace(uint8_t *d, const uint8_t *s, size_t len, fract8 a)
+{
+    if (a == 255)
+    {
+        memcpy(d, s, len);
+        return;
+    }
+    for (size_t i = 0; i < len; i++)
+        d[i] = blend8(d[i], s[i], a);
+}
+
+static void row_add(uint8_t *d, const uint8_t *s, size_t len, fract8 a)
+{
+    if (a == 255)
+        for (size_t i = 0; i < len; i++)
+            d[i] = qadd8(d[i], s[i]);
+    else
+        for (size_t i = 0; i < len; i++)
+            d[i] = qadd8(d[i], scale8(s[i], a));
+}
+
+static void row_multiply(uint8_t *d, const uint8_t *s, size_t len, fract8 a)
+{
+    if (a == 255)
+        for (size_t i = 0; i < len; i++)
+            d[i] = scale8(d[i], s[i]);
+    else
+        for (size_t i = 0; i < len; i++)
+            d[i] = blend8(d[i], scale8(d[i], s[i]), a);
+}
+
+static void row_screen(uint8_t *d, const uint8_t *s, size_t len, fract8 a)
+{
+    if (a == 255)
+        for (size_t i = 0; i < len; i++)
+            d[i] = 255 - scale8(255 - d[i], 255 - s[i]);
+    else
+        for (size_t i = 0; i < len; i++)
+            d[i] = blend8(d[i], 255 - scale8(255 - d[i], 255 - s[i]), a);
+}
+
+static void compose_rect(fb_layers_t *stack, fb_rect_t r)
+{
+    framebuffer_t *out = stack->out;
+
+    // Layers below the topmost opaque replacing layer are invisible
+    uint8_t first = 0;
+    for (uint8_t i = stack->count; i > 0; i--)
+    {
+        fb_layer_t *l = &stack->layers[i - 1];
+        if (l->mode == FB_BLEND_REPLACE && l->opacity == 255)
+        {
+            first = i - 1;
+            break;
+        }
+    }
+
+    for (size_t y = r.y; y < (size_t)r.y + r.h; y++)
+    {
+        rgb_t *row = out->data + FB_OFFSET(out, 0, y);
+        if (stack->layers[first].mode != FB_BLEND_REPLACE || stack->layers[first].opacity != 255)
+            memset(row + r.x, 0, r.w * sizeof(rgb_t));
+
+        for (uint8_t i = first; i < stack->count; i++)
+        {
+            fb_layer_t *l = &stack->layers[i];
+            if (!l->opacity)
+                continue;
+
+            size_t x0 = r.x, x1 = (size_t)r.x + r.w;
+            if (l->mode == FB_BLEND_ADD || l->mode == FB_BLEND_SCREEN)
+            {
+                // Black is transparent, skip everything outside of content
+                fb_rect_t b = l->fb->bounds;
+                if (!b.w || y < b.y || y >= (size_t)b.y + b.h)
+                    continue;
+                if (x0 < b.x)
+                    x0 = b.x;
+                if (x1 > (size_t)b.x + b.w)
+                    x1 = (size_t)b.x + b.w;
+                if (x0 >= x1)
+                    continue;
+            }
+
+            uint8_t *d = (uint8_t *)(row + x0);
+            const uint8_t *s = (const uint8_t *)(l->fb->data + FB_OFFSET(l->fb, x0, y));
+            size_t len = (x1 - x0) * sizeof(rgb_t);
+            switch (l->mode)
+            {
+                case FB_BLEND_REPLACE:
+                    row_replace(d, s, len, l->opacity);
+                    break;
+                case FB_BLEND_ADD:
+                    row_add(d, s, len, l->opacity);
+                    break;
+                case FB_BLEND_MULTIPLY:
+                    row_multiply(d, s, len, l->opacity);
+                    break;
+                case FB_BLEND_SCREEN:
+                    row_screen(d, s, len, l->opacity);
+                    break;
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t fb_layers_init(fb_layers_t *stack, framebuffer_t *out)
+{
+    CHECK_ARG(stack && out && out->data);
+
+    memset(stack, 0, sizeof(fb_layers_t));
+    stack->out = out;
+
+    return ESP_OK;
+}
+
+esp_err_t fb_layers_add(fb_layers_t *stack, framebuffer_t *fb, fb_blend_mode_t mode, fract8 opacity)
+{
+    CHECK_ARG(stack && fb && fb->data);
+    CHECK_ARG(fb->width == stack->out->width && fb->height == stack->out->height);
+
+    if (stack->count >= FB_LAYERS_MAX)
+        return ESP_ERR_NO_MEM;
+
+    stack->count++;
+    stack->layers[stack->count - 1].fb = fb;
+
+    return fb_layers_set(stack, stack->count - 1, mode, opacity);
+}
+
+esp_err_t fb_layers_set(fb_layers_t *stack, uint8_t index, fb_blend_mode_t mode, fract8 opacity)
+{
+    CHECK_ARG(stack && index < stack->count && mode <= FB_BLEND_SCREEN);
+
+    fb_layer_t *l = &stack->layers[index];
+    l->mode = mode;
+    l->opacity = opacity;
+
+    // Layer affects whole output now
+    return fb_mark_dirty(l->fb, 0, 0, l->fb->width, l->fb->height);
+}
+
+esp_err_t fb_layers_compose(fb_layers_t *stack)
+{
+    CHECK_ARG(stack);
+
+    if (!stack->count)
+        return ESP_OK;
+
+    // Collect dirty areas of all layers using dirty list of scratch framebuffer
+    framebuffer_t areas = {
+        .width = stack->out->width,
+        .height = stack->out->height,
+    };
+    for (uint8_t i = 0; i < stack->count; i++)
+    {
+        framebuffer_t *fb = stack->layers[i].fb;
+        // Untracked writes may be anywhere, this widens bounds as well
+        if (fb->direct_writes)
+            CHECK(fb_mark_dirty(fb, 0, 0, fb->width, fb->height));
+        for (uint8_t j = 0; j < fb->dirty_count; j++)
+            CHECK(fb_mark_dirty(&areas, fb->dirty[j].x, fb->dirty[j].y, fb->dirty[j].w, fb->dirty[j].h));
+        fb->dirty_count = 0;
+    }
+
+    for (uint8_t i = 0; i < areas.dirty_count; i++)
+    {
+        fb_rect_t r = areas.dirty[i];
+        compose_rect(stack, r);
+        CHECK(fb_mark_dirty(stack->out, r.x, r.y, r.w, r.h));
+    }
+
+    return ESP_OK;
+}
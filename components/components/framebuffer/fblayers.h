@@ -0,0 +1,119 @@
+/**
+ * @file fblayers.h
+ * @defgroup layers layers
+ * @{
+ *
+ * Stacked framebuffer layers with blend modes
+ *
+ * Layers are ordinary framebuffers of the same size as the output one.
+ * Effects draw into their own layers, ::fb_layers_compose() blends them
+ * bottom to top into the output framebuffer. Only the areas marked dirty
+ * in layers are composed, dirty lists of layers are cleared afterwards.
+ *
+ * Layers follow the contract of ::framebuffer_s: pixels written to layer
+ * `data` directly must be marked with ::fb_mark_dirty(), or the layer must
+ * set `direct_writes`, which makes every composition take whole layer.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __FBLAYERS_H__
+#define __FBLAYERS_H__
+
+#include <stdbool.h>
+#include "framebuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Max number of layers
+ */
+#define FB_LAYERS_MAX 8
+
+/**
+ * Blend modes, applied with layer opacity
+ */
+typedef enum {
+    FB_BLEND_REPLACE = 0, ///< Layer covers layers below
+    FB_BLEND_ADD,         ///< Saturating add, black is transparent
+    FB_BLEND_MULTIPLY,    ///< Darken, white is transparent
+    FB_BLEND_SCREEN,      ///< Lighten, black is transparent
+} fb_blend_mode_t;
+
+/**
+ * Layer descriptor
+ */
+typedef struct
+{
+    framebuffer_t *fb;     ///< Layer framebuffer
+    fb_blend_mode_t mode;  ///< Blend mode
+    fract8 opacity;        ///< Layer opacity, 0 hides layer
+} fb_layer_t;
+
+/**
+ * Layer stack descriptor
+ */
+typedef struct
+{
+    framebuffer_t *out;                  ///< Output framebuffer
+    fb_layer_t layers[FB_LAYERS_MAX];    ///< Layers, bottom first
+    uint8_t count;                       ///< Number of layers
+} fb_layers_t;
+
+/**
+ * @brief Initialize empty layer stack
+ *
+ * @param stack     Layer stack descriptor
+ * @param out       Output framebuffer
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_layers_init(fb_layers_t *stack, framebuffer_t *out);
+
+/**
+ * @brief Add layer on top of stack
+ *
+ * @param stack     Layer stack descriptor
+ * @param fb        Layer framebuffer, must be of the same size as output
+ * @param mode      Blend mode
+ * @param opacity   Layer opacity
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_layers_add(fb_layers_t *stack, framebuffer_t *fb, fb_blend_mode_t mode, fract8 opacity);
+
+/**
+ * @brief Change blend mode and opacity of layer
+ *
+ * Whole output is composed again on next ::fb_layers_compose().
+ *
+ * @param stack     Layer stack descriptor
+ * @param index     Layer index, 0 is the bottom layer
+ * @param mode      Blend mode
+ * @param opacity   Layer opacity
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_layers_set(fb_layers_t *stack, uint8_t index, fb_blend_mode_t mode, fract8 opacity);
+
+/**
+ * @brief Compose dirty areas of layers into output framebuffer
+ *
+ * Every output row is computed in one pass over all layers. Layers
+ * with add or screen mode are skipped outside their `bounds`, so their
+ * unmarked direct writes don't show up, see ::framebuffer_s.
+ * Composed areas are marked dirty in the output framebuffer.
+ *
+ * Doesn't lock framebuffers, call it from the draw callback or
+ * between ::fb_begin() and ::fb_end() of output.
+ *
+ * @param stack     Layer stack descriptor
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_layers_compose(fb_layers_t *stack);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __FBLAYERS_H__ */
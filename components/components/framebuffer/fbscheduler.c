@@ -0,0 +1,237 @@
+/**
+ * @file fbscheduler.c
+ *
+ * Frame scheduler: paced drawing overlapped with output transfer
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include "fbscheduler.h"
+
+static const char *TAG = "fbscheduler";
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+// Guards statistics, which are updated by scheduler task and read by others
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline void update(uint32_t *avg, uint32_t *max, int64_t sample)
+{
+    uint32_t v = sample > 0 ? (uint32_t)sample : 0;
+    *avg = *avg ? *avg + ((int32_t)v - (int32_t)*avg) / 8 : v;
+    if (max && v > *max)
+        *max = v;
+}
+
+static void timer_cb(void *ctx)
+{
+    fb_scheduler_t *sched = (fb_scheduler_t *)ctx;
+    if (sched->task)
+        xTaskNotifyGive(sched->task);
+}
+
+static void scheduler_task(void *ctx)
+{
+    fb_scheduler_t *sched = (fb_scheduler_t *)ctx;
+    fb_scheduler_stats_t *st = &sched->stats;
+    bool tx_pending = false;
+    int64_t tx_start = 0;
+    int64_t next = esp_timer_get_time();
+
+    while (sched->running)
+    {
+        // Draw next frame while previous one is being sent
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t res = fb_begin(sched->fb);
+        if (res == ESP_OK)
+        {
+            res = sched->draw(sched->fb);
+            fb_end(sched->fb);
+        }
+        int64_t t1 = esp_timer_get_time();
+
+        bool tx_done = false, tx_timeout = false;
+        int64_t tx_us = 0;
+        if (res == ESP_OK && tx_pending)
+        {
+            tx_done = xSemaphoreTake(sched->tx_done, pdMS_TO_TICKS(sched->tx_timeout_ms)) == pdTRUE;
+            if (tx_done)
+                tx_us = sched->tx_end_us - tx_start;
+            else
+            {
+                ESP_LOGW(TAG, "Frame transfer timeout");
+                tx_timeout = true;
+            }
+            tx_pending = false;
+        }
+        int64_t t2 = esp_timer_get_time();
+
+        if (res == ESP_OK)
+            res = fb_render(sched->fb, sched->render_ctx);
+        int64_t t3 = esp_timer_get_time();
+
+        if (res == ESP_OK)
+        {
+            tx_start = t3;
+            tx_pending = sched->async;
+        }
+        else
+            ESP_LOGE(TAG, "Error drawing frame %d (%s)", res, esp_err_to_name(res));
+
+        // Skip missed frames instead of catching up
+        uint32_t missed = 0;
+        next += sched->period_us;
+        if (t3 >= next)
+        {
+            missed = (t3 - next) / sched->period_us + 1;
+            next += (int64_t)missed * sched->period_us;
+        }
+
+        portENTER_CRITICAL(&mux);
+        update(&st->draw_us, &st->draw_us_max, t1 - t0);
+        if (tx_done)
+            update(&st->tx_us, &st->tx_us_max, tx_us);
+        if (tx_timeout)
+            st->timeouts++;
+        update(&st->wait_us, NULL, t2 - t1);
+        if (res == ESP_OK)
+        {
+            update(&st->render_us, &st->render_us_max, t3 - t2);
+            st->frames++;
+        }
+        else
+            st->errors++;
+        st->skipped += missed;
+        portEXIT_CRITICAL(&mux);
+        if (sched->running && esp_timer_start_once(sched->timer, next - t3) == ESP_OK)
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    esp_timer_stop(sched->timer);
+
+    // Don't leave transfer running with stale completion signal
+    if (tx_pending)
+        xSemaphoreTake(sched->tx_done, pdMS_TO_TICKS(sched->tx_timeout_ms));
+
+    sched->task = NULL;
+    vTaskDelete(NULL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t fb_scheduler_init(fb_scheduler_t *sched, framebuffer_t *fb, bool async)
+{
+    CHECK_ARG(sched && fb);
+
+    memset(sched, 0, sizeof(fb_scheduler_t));
+    sched->fb = fb;
+    sched->async = async;
+    sched->tx_timeout_ms = FB_SCHEDULER_TX_TIMEOUT_MS;
+
+    sched->tx_done = xSemaphoreCreateBinary();
+    if (!sched->tx_done)
+        return ESP_ERR_NO_MEM;
+
+    esp_timer_create_args_t timer_args = {
+        .arg = sched,
+        .callback = timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "fbscheduler",
+    };
+    esp_err_t res = esp_timer_create(&timer_args, &sched->timer);
+    if (res != ESP_OK)
+    {
+        vSemaphoreDelete(sched->tx_done);
+        sched->tx_done = NULL;
+    }
+
+    return res;
+}
+
+esp_err_t fb_scheduler_free(fb_scheduler_t *sched)
+{
+    CHECK_ARG(sched);
+
+    CHECK(fb_scheduler_stop(sched));
+    if (sched->timer)
+        esp_timer_delete(sched->timer);
+    if (sched->tx_done)
+        vSemaphoreDelete(sched->tx_done);
+    sched->timer = NULL;
+    sched->tx_done = NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t fb_scheduler_start(fb_scheduler_t *sched, uint8_t fps, fb_draw_cb_t draw, void *render_ctx)
+{
+    CHECK_ARG(sched && sched->timer && fps && draw);
+
+    if (sched->task)
+        return ESP_ERR_INVALID_STATE;
+
+    sched->draw = draw;
+    sched->render_ctx = render_ctx;
+    sched->period_us = 1000000 / fps;
+    sched->running = true;
+    // Drop completion signal of a transfer not started by us
+    xSemaphoreTake(sched->tx_done, 0);
+
+    if (xTaskCreate(scheduler_task, "fbscheduler", FB_SCHEDULER_STACK_SIZE, sched,
+            FB_SCHEDULER_PRIORITY, &sched->task) != pdPASS)
+    {
+        sched->running = false;
+        sched->task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t fb_scheduler_stop(fb_scheduler_t *sched)
+{
+    CHECK_ARG(sched);
+
+    if (!sched->task)
+        return ESP_OK;
+
+    sched->running = false;
+    esp_timer_stop(sched->timer);
+    xTaskNotifyGive(sched->task);
+    while (sched->task)
+        vTaskDelay(1);
+
+    return ESP_OK;
+}
+
+void IRAM_ATTR fb_scheduler_tx_done(void *ctx)
+{
+    fb_scheduler_t *sched = (fb_scheduler_t *)ctx;
+
+    sched->tx_end_us = esp_timer_get_time();
+    if (xPortInIsrContext())
+    {
+        BaseType_t hp_task_woken = pdFALSE;
+        xSemaphoreGiveFromISR(sched->tx_done, &hp_task_woken);
+        if (hp_task_woken == pdTRUE)
+            portYIELD_FROM_ISR();
+    }
+    else
+        xSemaphoreGive(sched->tx_done);
+}
+
+esp_err_t fb_scheduler_get_stats(fb_scheduler_t *sched, fb_scheduler_stats_t *stats, bool reset)
+{
+    CHECK_ARG(sched && stats);
+
+    portENTER_CRITICAL(&mux);
+    *stats = sched->stats;
+    if (reset)
+        memset(&sched->stats, 0, sizeof(fb_scheduler_stats_t));
+    portEXIT_CRITICAL(&mux);
+
+    return ESP_OK;
+}
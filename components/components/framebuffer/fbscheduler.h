@@ -0,0 +1,154 @@
+/**
+ * @file fbscheduler.h
+ * @defgroup scheduler scheduler
+ * @{
+ *
+ * Frame scheduler: paced drawing overlapped with output transfer
+ *
+ * Each frame is drawn between ::fb_begin() and ::fb_end() while the
+ * previous frame is still being transmitted. Then the scheduler waits
+ * for the transfer to complete and calls ::fb_render(), which is expected
+ * to start sending the new frame and return (e.g. with
+ * led_strip_spi_flush_async()). When drawing or sending takes longer
+ * than frame period, missed frames are skipped, not queued.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __FBSCHEDULER_H__
+#define __FBSCHEDULER_H__
+
+#include <stdbool.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "framebuffer.h"
+#include "fbanimation.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FB_SCHEDULER_STACK_SIZE
+#define FB_SCHEDULER_STACK_SIZE 4096
+#endif
+
+#ifndef FB_SCHEDULER_PRIORITY
+#define FB_SCHEDULER_PRIORITY 5
+#endif
+
+/**
+ * Default of ::fb_scheduler_t::tx_timeout_ms
+ */
+#ifndef FB_SCHEDULER_TX_TIMEOUT_MS
+#define FB_SCHEDULER_TX_TIMEOUT_MS 1000
+#endif
+
+/**
+ * Timing statistics, all times in microseconds
+ *
+ * Averages are exponential over about 8 frames.
+ */
+typedef struct
+{
+    uint32_t frames;       ///< Rendered frames
+    uint32_t skipped;      ///< Frames skipped due to overload
+    uint32_t errors;       ///< Failed draw or render calls
+    uint32_t timeouts;     ///< Transfers not completed in ::fb_scheduler_t::tx_timeout_ms
+    uint32_t draw_us;      ///< Average time of draw callback
+    uint32_t draw_us_max;  ///< Max time of draw callback
+    uint32_t render_us;    ///< Average time of render callback
+    uint32_t render_us_max;///< Max time of render callback
+    uint32_t tx_us;        ///< Average transfer time, from render callback return to ::fb_scheduler_tx_done()
+    uint32_t tx_us_max;    ///< Max transfer time
+    uint32_t wait_us;      ///< Average time spent waiting for previous transfer
+} fb_scheduler_stats_t;
+
+/**
+ * Scheduler descriptor
+ */
+typedef struct
+{
+    framebuffer_t *fb;            ///< Framebuffer descriptor
+    void *render_ctx;             ///< Renderer context
+    fb_draw_cb_t draw;            ///< Draw function
+    bool async;                   ///< Render callback only starts transfer, see ::fb_scheduler_tx_done()
+    uint32_t period_us;           ///< Frame period
+    uint32_t tx_timeout_ms;       ///< Max wait for transfer of previous frame, may be changed before start
+    TaskHandle_t task;            ///< Scheduler task
+    esp_timer_handle_t timer;     ///< Pacing timer
+    SemaphoreHandle_t tx_done;    ///< Given when transfer is complete
+    volatile bool running;
+    volatile int64_t tx_end_us;   ///< Time of last transfer completion
+    fb_scheduler_stats_t stats;   ///< Timing statistics
+} fb_scheduler_t;
+
+/**
+ * @brief Initialize scheduler
+ *
+ * Transfer timeout is set to ::FB_SCHEDULER_TX_TIMEOUT_MS.
+ *
+ * @param sched     Scheduler descriptor
+ * @param fb        Framebuffer descriptor
+ * @param async     true if render callback returns before frame is sent
+ *                  and ::fb_scheduler_tx_done() is called on completion
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_scheduler_init(fb_scheduler_t *sched, framebuffer_t *fb, bool async);
+
+/**
+ * @brief Free scheduler resources, stops it first
+ *
+ * @param sched     Scheduler descriptor
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_scheduler_free(fb_scheduler_t *sched);
+
+/**
+ * @brief Start scheduler task
+ *
+ * @param sched     Scheduler descriptor
+ * @param fps       Target FPS
+ * @param draw      Function for drawing on a framebuffer
+ * @param render_ctx Renderer callback argument
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_scheduler_start(fb_scheduler_t *sched, uint8_t fps, fb_draw_cb_t draw, void *render_ctx);
+
+/**
+ * @brief Stop scheduler task, waits for the current frame to finish
+ *
+ * @param sched     Scheduler descriptor
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_scheduler_stop(fb_scheduler_t *sched);
+
+/**
+ * @brief Signal completion of frame transfer
+ *
+ * May be called from ISR and is placed in IRAM, so it can be used
+ * directly as led_strip_spi `flush_cb` with the scheduler as `flush_cb_ctx`.
+ *
+ * @param ctx       Scheduler descriptor
+ */
+void fb_scheduler_tx_done(void *ctx);
+
+/**
+ * @brief Get copy of timing statistics
+ *
+ * Safe to call from any task while scheduler is running.
+ *
+ * @param sched     Scheduler descriptor
+ * @param[out] stats Statistics
+ * @param reset     Reset statistics after reading
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_scheduler_get_stats(fb_scheduler_t *sched, fb_scheduler_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __FBSCHEDULER_H__ */
@@ -0,0 +1,136 @@
+/**
+ * @file fbsprite.c
+ *
+ * Sprite and bitmap blitter for framebuffer
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include <esp_err.h>
+#include "fbsprite.h"
+
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+static inline void put(rgb_t *dst, rgb_t c, bool blend, fract8 alpha)
+{
+    *dst = blend ? rgb_blend(*dst, c, alpha) : c;
+}
+
+static void row_rgb(rgb_t *dst, const rgb_t *src, size_t w, bool key, rgb_t key_color, bool blend, fract8 alpha)
+{
+    if (!key && !blend)
+    {
+        memcpy(dst, src, w * sizeof(rgb_t));
+        return;
+    }
+    for (size_t i = 0; i < w; i++)
+    {
+        rgb_t c = src[i];
+        if (key && c.r == key_color.r && c.g == key_color.g && c.b == key_color.b)
+            continue;
+        put(dst + i, c, blend, alpha);
+    }
+}
+
+static void row_palette(rgb_t *dst, const uint8_t *src, size_t w, const rgb_t *palette,
+        bool key, uint8_t key_index, bool blend, fract8 alpha)
+{
+    for (size_t i = 0; i < w; i++)
+    {
+        uint8_t idx = src[i];
+        if (key && idx == key_index)
+            continue;
+        put(dst + i, palette[idx], blend, alpha);
+    }
+}
+
+static void row_mask(rgb_t *dst, const uint8_t *src, size_t bit, size_t w, rgb_t color,
+        bool key, bool blend, fract8 alpha)
+{
+    static const rgb_t black = { 0 };
+
+    for (size_t i = 0; i < w; i++, bit++)
+    {
+        uint8_t byte = src[bit >> 3];
+        // Skip empty bytes at once
+        if (key && !byte)
+        {
+            size_t skip = 8 - (bit & 7);
+            i += skip - 1;
+            bit += skip - 1;
+            continue;
+        }
+        if (byte & (0x80 >> (bit & 7)))
+            put(dst + i, color, blend, alpha);
+        else if (!key)
+            put(dst + i, black, blend, alpha);
+    }
+}
+
+esp_err_t fb_blit_rect(framebuffer_t *fb, const fb_sprite_t *sprite, size_t sx, size_t sy, size_t w, size_t h,
+        int x, int y, uint8_t flags, fract8 alpha)
+{
+    CHECK_ARG(fb && fb->data && sprite && sprite->data);
+    CHECK_ARG(sprite->format <= FB_SPRITE_MASK);
+    CHECK_ARG(sprite->format != FB_SPRITE_PALETTE || sprite->palette);
+
+    bool key = flags & FB_BLIT_KEY;
+    bool blend = (flags & FB_BLIT_ALPHA) && alpha != 255;
+    if ((flags & FB_BLIT_ALPHA) && !alpha)
+        return ESP_OK;
+
+    // Clip to sprite
+    if (sx >= sprite->width || sy >= sprite->height)
+        return ESP_OK;
+    if (w > sprite->width - sx)
+        w = sprite->width - sx;
+    if (h > sprite->height - sy)
+        h = sprite->height - sy;
+
+    // Clip to framebuffer
+    if (x < 0)
+    {
+        if ((size_t)-(long)x >= w)
+            return ESP_OK;
+        sx += -(long)x;
+        w -= -(long)x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        if ((size_t)-(long)y >= h)
+            return ESP_OK;
+        sy += -(long)y;
+        h -= -(long)y;
+        y = 0;
+    }
+    if ((size_t)x >= fb->width || (size_t)y >= fb->height)
+        return ESP_OK;
+    if (w > fb->width - x)
+        w = fb->width - x;
+    if (h > fb->height - y)
+        h = fb->height - y;
+
+    size_t stride = sprite->stride ? sprite->stride : sprite->width;
+    for (size_t row = 0; row < h; row++)
+    {
+        rgb_t *dst = fb->data + FB_OFFSET(fb, x, y + row);
+        size_t line = (sy + row) * stride;
+        switch (sprite->format)
+        {
+            case FB_SPRITE_RGB:
+                row_rgb(dst, (const rgb_t *)sprite->data + line + sx, w, key, sprite->key, blend, alpha);
+                break;
+            case FB_SPRITE_PALETTE:
+                row_palette(dst, (const uint8_t *)sprite->data + line + sx, w, sprite->palette,
+                        key, sprite->key_index, blend, alpha);
+                break;
+            case FB_SPRITE_MASK:
+                row_mask(dst, (const uint8_t *)sprite->data + (sy + row) * ((stride + 7) / 8), sx, w,
+                        sprite->color, key, blend, alpha);
+                break;
+        }
+    }
+
+    return fb_mark_dirty(fb, x, y, w, h);
+}
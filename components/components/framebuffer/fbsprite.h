@@ -0,0 +1,93 @@
+/**
+ * @file fbsprite.h
+ * @defgroup sprite sprite
+ * @{
+ *
+ * Sprite and bitmap blitter for framebuffer
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __FBSPRITE_H__
+#define __FBSPRITE_H__
+
+#include <stdbool.h>
+#include "framebuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pixel format of sprite data
+ */
+typedef enum {
+    FB_SPRITE_RGB = 0, ///< Array of rgb_t
+    FB_SPRITE_PALETTE, ///< Array of uint8_t palette indices
+    FB_SPRITE_MASK,    ///< 1 bit per pixel, MSB first, each row padded to byte
+} fb_sprite_format_t;
+
+/**
+ * Blit flags, may be combined
+ */
+typedef enum {
+    FB_BLIT_COPY  = 0,      ///< Plain copy
+    FB_BLIT_KEY   = 1 << 0, ///< Skip transparent pixels, see ::fb_sprite_t
+    FB_BLIT_ALPHA = 1 << 1, ///< Blend sprite over framebuffer with constant alpha
+} fb_blit_flags_t;
+
+/**
+ * Sprite descriptor
+ *
+ * Transparent pixels are pixels equal to `key` for RGB sprites, pixels
+ * with index `key_index` for paletted sprites and zero bits for masks.
+ * Without ::FB_BLIT_KEY zero bits of a mask are drawn black.
+ */
+typedef struct
+{
+    size_t width;              ///< Sprite width
+    size_t height;             ///< Sprite height
+    size_t stride;             ///< Row length in pixels, 0 for `width`
+    fb_sprite_format_t format; ///< Pixel format
+    const void *data;          ///< Pixel data
+    const rgb_t *palette;      ///< Palette for ::FB_SPRITE_PALETTE
+    rgb_t color;               ///< Color of set bits for ::FB_SPRITE_MASK
+    rgb_t key;                 ///< Transparent color for ::FB_SPRITE_RGB
+    uint8_t key_index;         ///< Transparent index for ::FB_SPRITE_PALETTE
+} fb_sprite_t;
+
+/**
+ * @brief Draw rectangular part of sprite
+ *
+ * Part is clipped to the sprite, result is clipped to the framebuffer
+ * and the drawn area is marked dirty. Useful for sprite sheets and fonts.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param sprite    Sprite descriptor
+ * @param sx        Left of the part in sprite
+ * @param sy        Top of the part in sprite
+ * @param w         Width of the part
+ * @param h         Height of the part
+ * @param x         Destination left, may be negative
+ * @param y         Destination top, may be negative
+ * @param flags     Combination of ::fb_blit_flags_t
+ * @param alpha     Opacity for ::FB_BLIT_ALPHA, 255 is opaque
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_blit_rect(framebuffer_t *fb, const fb_sprite_t *sprite, size_t sx, size_t sy, size_t w, size_t h,
+        int x, int y, uint8_t flags, fract8 alpha);
+
+/**
+ * @brief Draw whole sprite, see ::fb_blit_rect()
+ */
+static inline esp_err_t fb_blit(framebuffer_t *fb, const fb_sprite_t *sprite, int x, int y, uint8_t flags, fract8 alpha)
+{
+    return fb_blit_rect(fb, sprite, 0, 0, sprite ? sprite->width : 0, sprite ? sprite->height : 0, x, y, flags, alpha);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __FBSPRITE_H__ */
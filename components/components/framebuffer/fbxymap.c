@@ -0,0 +1,100 @@
+/**
+ * @file fbxymap.c
+ *
+ * Precomputed XY mapping of LED matrix layouts
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdlib.h>
+#include <esp_err.h>
+#include "fbxymap.h"
+
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+// Offset of LED at physical coordinates
+static size_t physical_offs(const fb_layout_t *l, size_t tw, size_t th, size_t x, size_t y)
+{
+    size_t tiles_x = l->width / tw;
+    size_t tx = x / tw, ty = y / th;
+    size_t lx = x % tw, ly = y % th;
+
+    if (l->tiles_serpentine && (ty & 1))
+        tx = tiles_x - 1 - tx;
+    if (l->serpentine && (ly & 1))
+        lx = tw - 1 - lx;
+
+    return (ty * tiles_x + tx) * tw * th + ly * tw + lx;
+}
+
+esp_err_t fb_xymap_init(fb_xymap_t *map, const fb_layout_t *layout)
+{
+    CHECK_ARG(map && layout && layout->width && layout->height
+            && layout->width * layout->height <= UINT16_MAX + 1);
+
+    size_t w = layout->width, h = layout->height;
+    size_t tw = layout->tile_width ? layout->tile_width : w;
+    size_t th = layout->tile_height ? layout->tile_height : h;
+    CHECK_ARG(w % tw == 0 && h % th == 0);
+
+    bool swap = layout->rotation == FB_ROTATE_90 || layout->rotation == FB_ROTATE_270;
+    map->width = swap ? h : w;
+    map->height = swap ? w : h;
+    map->table = malloc(w * h * sizeof(uint16_t));
+    if (!map->table)
+        return ESP_ERR_NO_MEM;
+
+    for (size_t y = 0; y < map->height; y++)
+        for (size_t x = 0; x < map->width; x++)
+        {
+            size_t px, py;
+            switch (layout->rotation)
+            {
+                case FB_ROTATE_90:
+                    px = y;
+                    py = h - 1 - x;
+                    break;
+                case FB_ROTATE_180:
+                    px = w - 1 - x;
+                    py = h - 1 - y;
+                    break;
+                case FB_ROTATE_270:
+                    px = w - 1 - y;
+                    py = x;
+                    break;
+                default:
+                    px = x;
+                    py = y;
+            }
+            map->table[y * map->width + x] = physical_offs(layout, tw, th, px, py);
+        }
+
+    return ESP_OK;
+}
+
+esp_err_t fb_xymap_free(fb_xymap_t *map)
+{
+    CHECK_ARG(map);
+
+    free(map->table);
+    map->table = NULL;
+
+    return ESP_OK;
+}
+
+size_t fb_xymap_cb(void *ctx, size_t x, size_t y)
+{
+    return fb_xymap_offs((const fb_xymap_t *)ctx, x, y);
+}
+
+esp_err_t fb_xymap_blit(const fb_xymap_t *map, const framebuffer_t *fb, rgb_t *dst)
+{
+    CHECK_ARG(map && map->table && fb && fb->data && dst
+            && fb->width == map->width && fb->height == map->height);
+
+    const uint16_t *table = map->table;
+    const rgb_t *src = fb->data;
+    for (size_t i = 0; i < map->width * map->height; i++)
+        dst[table[i]] = src[i];
+
+    return ESP_OK;
+}
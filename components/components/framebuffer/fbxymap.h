@@ -0,0 +1,105 @@
+/**
+ * @file fbxymap.h
+ * @defgroup xymap xymap
+ * @{
+ *
+ * Precomputed XY mapping of LED matrix layouts
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __FBXYMAP_H__
+#define __FBXYMAP_H__
+
+#include <stdbool.h>
+#include "framebuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rotation of the layout, clockwise
+ */
+typedef enum {
+    FB_ROTATE_0 = 0,
+    FB_ROTATE_90,
+    FB_ROTATE_180,
+    FB_ROTATE_270
+} fb_rotation_t;
+
+/**
+ * Physical layout of LED matrix
+ *
+ * Matrix is made of panels of `tile_width` x `tile_height` LEDs, chained
+ * row by row. LEDs in a panel are chained row by row too.
+ */
+typedef struct
+{
+    size_t width;           ///< Physical matrix width
+    size_t height;          ///< Physical matrix height
+    size_t tile_width;      ///< Panel width, 0 for single panel
+    size_t tile_height;     ///< Panel height, 0 for single panel
+    bool serpentine;        ///< Odd rows of a panel go right to left
+    bool tiles_serpentine;  ///< Odd rows of panels go right to left
+    fb_rotation_t rotation; ///< Rotation of logical coordinates
+} fb_layout_t;
+
+/**
+ * XY mapping table
+ */
+typedef struct
+{
+    size_t width;           ///< Logical width, physical height if rotated by 90 or 270
+    size_t height;          ///< Logical height
+    uint16_t *table;        ///< LED offset of (x, y) is table[y * width + x]
+} fb_xymap_t;
+
+/**
+ * @brief Build mapping table from layout
+ *
+ * @param map       Mapping descriptor
+ * @param layout    Matrix layout
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_xymap_init(fb_xymap_t *map, const fb_layout_t *layout);
+
+/**
+ * @brief Free mapping table
+ *
+ * @param map       Mapping descriptor
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_xymap_free(fb_xymap_t *map);
+
+/**
+ * @brief Get LED offset of logical coordinates
+ */
+static inline size_t fb_xymap_offs(const fb_xymap_t *map, size_t x, size_t y)
+{
+    return map->table[y * map->width + x];
+}
+
+/**
+ * @brief Mapping as ::xy_to_offs_cb, pass mapping descriptor as context
+ */
+size_t fb_xymap_cb(void *ctx, size_t x, size_t y);
+
+/**
+ * @brief Copy framebuffer to LED buffer in physical order
+ *
+ * Framebuffer must have the logical size of the mapping.
+ *
+ * @param map       Mapping descriptor
+ * @param fb        Framebuffer descriptor
+ * @param[out] dst  LED buffer, width * height items
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_xymap_blit(const fb_xymap_t *map, const framebuffer_t *fb, rgb_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __FBXYMAP_H__ */
@@ -31,15 +31,80 @@
  * MIT Licensed as described in the file LICENSE
  */
 #include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
 #include "framebuffer.h"
 
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 #define CHECK(x) do { esp_err_t __; if ((__ = (x)) != ESP_OK) return __; } while (0)
 
-static size_t xy(void *ctx, size_t x, size_t y)
+static inline uint32_t rect_area(fb_rect_t r)
 {
-    framebuffer_t *fb = (framebuffer_t *)ctx;
-    return y * fb->width + x;
+    return (uint32_t)r.w * r.h;
+}
+
+static fb_rect_t rect_union(fb_rect_t a, fb_rect_t b)
+{
+    if (!a.w)
+        return b;
+    if (!b.w)
+        return a;
+
+    uint16_t x0 = a.x < b.x ? a.x : b.x;
+    uint16_t y0 = a.y < b.y ? a.y : b.y;
+    uint16_t x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    uint16_t y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    fb_rect_t r = { .x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0 };
+    return r;
+}
+
+// Merge rects while it doesn't add area, so overlapping and adjacent rects become one
+static void merge_dirty(framebuffer_t *fb)
+{
+    for (uint8_t i = 0; i < fb->dirty_count; i++)
+        for (uint8_t j = i + 1; j < fb->dirty_count; j++)
+        {
+            fb_rect_t u = rect_union(fb->dirty[i], fb->dirty[j]);
+            if (rect_area(u) > rect_area(fb->dirty[i]) + rect_area(fb->dirty[j]))
+                continue;
+            fb->dirty[i] = u;
+            fb->dirty[j] = fb->dirty[--fb->dirty_count];
+            j = i;
+        }
+}
+
+static void add_dirty(framebuffer_t *fb, fb_rect_t r)
+{
+    if (!r.w || !r.h)
+        return;
+
+    fb->bounds = rect_union(fb->bounds, r);
+
+    if (fb->dirty_count < FB_DIRTY_RECTS)
+        fb->dirty[fb->dirty_count++] = r;
+    else
+    {
+        // List is full, grow the rect which grows least
+        uint8_t best = 0;
+        uint32_t best_growth = UINT32_MAX;
+        for (uint8_t i = 0; i < fb->dirty_count; i++)
+        {
+            uint32_t growth = rect_area(rect_union(fb->dirty[i], r)) - rect_area(fb->dirty[i]);
+            if (growth < best_growth)
+            {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        fb->dirty[best] = rect_union(fb->dirty[best], r);
+    }
+    merge_dirty(fb);
+}
+
+static inline void add_dirty_pixel(framebuffer_t *fb, size_t x, size_t y)
+{
+    fb_rect_t r = { .x = x, .y = y, .w = 1, .h = 1 };
+    add_dirty(fb, r);
 }
 
 esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb)
@@ -52,6 +117,7 @@ esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t
     fb->last_frame_us = 0;
     fb->render = render_cb;
     fb->internal = NULL;
+    fb->direct_writes = false;
     fb->mutex = xSemaphoreCreateMutex();
     if (!fb->mutex)
         return ESP_ERR_NO_MEM;
@@ -59,6 +125,11 @@ esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t
     if (!fb->data)
         return ESP_ERR_NO_MEM;
 
+    // Contents of display are unknown
+    fb->dirty_count = 0;
+    fb_mark_dirty(fb, 0, 0, width, height);
+    memset(&fb->bounds, 0, sizeof(fb->bounds));
+
     return ESP_OK;
 }
 
@@ -80,9 +151,28 @@ esp_err_t fb_render(framebuffer_t *fb, void *render_ctx)
 
     if (xSemaphoreTake(fb->mutex, 0) != pdTRUE)
         return ESP_ERR_INVALID_STATE;
-    CHECK(fb->render(fb, render_ctx));
+    esp_err_t res = fb->render(fb, render_ctx);
+    if (res == ESP_OK)
+        fb->dirty_count = 0;
     xSemaphoreGive(fb->mutex);
 
+    return res;
+}
+
+esp_err_t fb_mark_dirty(framebuffer_t *fb, size_t x, size_t y, size_t w, size_t h)
+{
+    CHECK_ARG(fb);
+
+    if (x >= fb->width || y >= fb->height)
+        return ESP_OK;
+    fb_rect_t r = {
+        .x = x,
+        .y = y,
+        .w = w < fb->width - x ? w : fb->width - x,
+        .h = h < fb->height - y ? h : fb->height - y,
+    };
+    add_dirty(fb, r);
+
     return ESP_OK;
 }
 
@@ -91,6 +181,7 @@ esp_err_t fb_set_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t color)
     CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
 
     fb->data[FB_OFFSET(fb, x, y)] = color;
+    add_dirty_pixel(fb, x, y);
 
     return ESP_OK;
 }
@@ -100,6 +191,7 @@ esp_err_t fb_set_pixel_hsv(framebuffer_t *fb, size_t x, size_t y, hsv_t color)
     CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
 
     fb->data[FB_OFFSET(fb, x, y)] = hsv2rgb_rainbow(color);
+    add_dirty_pixel(fb, x, y);
 
     return ESP_OK;
 }
@@ -117,7 +209,7 @@ esp_err_t fb_get_pixel_hsv(framebuffer_t *fb, size_t x, size_t y, hsv_t *color)
 {
     CHECK_ARG(color && fb && fb->data && x < fb->width && y < fb->height);
 
-    *color = rgb2hsv_approximate(fb->data[FB_OFFSET(fb, x, y)]);
+    *color = rgb2hsv_rainbow(fb->data[FB_OFFSET(fb, x, y)]);
 
     return ESP_OK;
 }
@@ -162,11 +254,173 @@ esp_err_t fb_set_pixelf_hsv(framebuffer_t *fb, float x, float y, hsv_t color)
     return fb_set_pixelf_rgb(fb, x, y, hsv2rgb_rainbow(color));
 }
 
+// Saturating add of color scaled by weight, clip is true if pixel may be outside
+static inline void plot(framebuffer_t *fb, int32_t x, int32_t y, rgb_t color, uint8_t weight, bool clip)
+{
+    if (clip && ((uint32_t)x >= fb->width || (uint32_t)y >= fb->height))
+        return;
+    rgb_t *p = fb->data + FB_OFFSET(fb, x, y);
+    p->r = qadd8(p->r, (color.r * weight) >> 8);
+    p->g = qadd8(p->g, (color.g * weight) >> 8);
+    p->b = qadd8(p->b, (color.b * weight) >> 8);
+}
+
+// Mark bounding box of pixels [x0..x1] x [y0..y1] dirty, true if it needs clipping
+static bool mark_box(framebuffer_t *fb, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+    bool clip = x0 < 0 || y0 < 0 || x1 >= (int32_t)fb->width || y1 >= (int32_t)fb->height;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= x0 && y1 >= y0)
+        fb_mark_dirty(fb, x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+    return clip;
+}
+
+esp_err_t fb_set_pixelq_rgb(framebuffer_t *fb, fb_q8_t x, fb_q8_t y, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data);
+
+    int32_t px = x >> 8, py = y >> 8;
+    uint8_t xx = x & 0xff, yy = y & 0xff;
+    uint8_t ix = 255 - xx, iy = 255 - yy;
+    bool clip = mark_box(fb, px, py, px + 1, py + 1);
+
+    plot(fb, px, py, color, WU_WEIGHT(ix, iy), clip);
+    plot(fb, px + 1, py, color, WU_WEIGHT(xx, iy), clip);
+    plot(fb, px, py + 1, color, WU_WEIGHT(ix, yy), clip);
+    plot(fb, px + 1, py + 1, color, WU_WEIGHT(xx, yy), clip);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_draw_lineq_rgb(framebuffer_t *fb, fb_q8_t x0, fb_q8_t y0, fb_q8_t x1, fb_q8_t y1, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data);
+
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    fb_q8_t t;
+    if (steep)
+    {
+        t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+    if (x0 > x1)
+    {
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+
+    // Gradient in Q16.16, |gradient| <= 1
+    int32_t dx = x1 - x0;
+    int32_t gradient = dx ? (int32_t)((int64_t)(y1 - y0) * 65536 / dx) : 0;
+
+    // Pixel columns along major axis, rounded to pixel centers and clipped
+    // to the visible ones, so lines mostly outside cost nothing
+    int32_t xs = (x0 + 128) >> 8;
+    int32_t xe = (x1 + 128) >> 8;
+    int32_t major = steep ? fb->height : fb->width;
+    if (xs < 0)
+        xs = 0;
+    if (xe >= major)
+        xe = major - 1;
+    if (xs > xe)
+        return ESP_OK;
+
+    // Minor coordinate is linear in column, so ends of the clipped span bound it
+    fb_q8_t ys = y0 + (int32_t)(((int64_t)gradient * (xs * 256 - x0)) >> 16);
+    fb_q8_t ye = y0 + (int32_t)(((int64_t)gradient * (xe * 256 - x0)) >> 16);
+    int32_t ymin = (ys < ye ? ys : ye) >> 8;
+    int32_t ymax = ((ys > ye ? ys : ye) >> 8) + 1;
+    bool clip = steep ? mark_box(fb, ymin, xs, ymax, xe) : mark_box(fb, xs, ymin, xe, ymax);
+
+    for (int32_t x = xs; x <= xe; x++)
+    {
+        // Minor coordinate at this column, Q8.8
+        fb_q8_t y = y0 + (int32_t)(((int64_t)gradient * (x * 256 - x0)) >> 16);
+        int32_t py = y >> 8;
+        uint8_t f = y & 0xff;
+        if (steep)
+        {
+            plot(fb, py, x, color, 255 - f, clip);
+            plot(fb, py + 1, x, color, f, clip);
+        }
+        else
+        {
+            plot(fb, x, py, color, 255 - f, clip);
+            plot(fb, x, py + 1, color, f, clip);
+        }
+    }
+
+    return ESP_OK;
+}
+
+static uint32_t isqrt32(uint32_t v)
+{
+    uint32_t res = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > v)
+        bit >>= 2;
+    while (bit)
+    {
+        if (v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+            res >>= 1;
+        bit >>= 2;
+    }
+    return res;
+}
+
+esp_err_t fb_draw_circleq_rgb(framebuffer_t *fb, fb_q8_t cx, fb_q8_t cy, fb_q8_t r, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data && r > 0 && r < FB_Q8(128));
+
+    bool clip = mark_box(fb, (cx - r) >> 8, (cy - r) >> 8, ((cx + r) >> 8) + 1, ((cy + r) >> 8) + 1);
+    uint32_t r2 = (uint32_t)r * r;
+    // Each half of the circle is drawn along the axis where it is flat (slope <= 1)
+    int32_t d = (r * 181) >> 8; // r / sqrt(2)
+
+    for (int32_t p = (cx - d + 255) >> 8; p <= (cx + d) >> 8; p++)
+    {
+        int32_t off = p * 256 - cx;
+        fb_q8_t h = isqrt32(r2 - (uint32_t)(off * off));
+        fb_q8_t ys[2] = { cy - h, cy + h };
+        for (int i = 0; i < 2; i++)
+        {
+            uint8_t f = ys[i] & 0xff;
+            plot(fb, p, ys[i] >> 8, color, 255 - f, clip);
+            plot(fb, p, (ys[i] >> 8) + 1, color, f, clip);
+        }
+    }
+    for (int32_t p = (cy - d + 255) >> 8; p <= (cy + d) >> 8; p++)
+    {
+        int32_t off = p * 256 - cy;
+        fb_q8_t w = isqrt32(r2 - (uint32_t)(off * off));
+        fb_q8_t xs[2] = { cx - w, cx + w };
+        for (int i = 0; i < 2; i++)
+        {
+            uint8_t f = xs[i] & 0xff;
+            plot(fb, xs[i] >> 8, p, color, 255 - f, clip);
+            plot(fb, (xs[i] >> 8) + 1, p, color, f, clip);
+        }
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t fb_clear(framebuffer_t *fb)
 {
     CHECK_ARG(fb && fb->data);
 
-    memset(fb->data, 0, FB_SIZE(fb));
+    // Only the area which may be non-black needs clearing
+    fb_rect_t b = fb->bounds;
+    for (size_t row = b.y; row < b.y + b.h; row++)
+        memset(fb->data + FB_OFFSET(fb, b.x, row), 0, b.w * sizeof(rgb_t));
+    add_dirty(fb, b);
+    memset(&fb->bounds, 0, sizeof(fb->bounds));
 
     return ESP_OK;
 }
@@ -179,6 +433,33 @@ esp_err_t fb_shift(framebuffer_t *fb, size_t offs, fb_shift_direction_t dir)
             || ((dir == FB_SHIFT_UP || dir == FB_SHIFT_DOWN) && offs >= fb->height))
         return ESP_OK;
 
+    // Content moves by offs, pixels it leaves keep old values or get
+    // values from outside of bounds, so both old and new areas change
+    fb_rect_t b = fb->bounds;
+    size_t x0 = b.x, x1 = b.x + b.w, y0 = b.y, y1 = b.y + b.h;
+    switch (dir)
+    {
+        case FB_SHIFT_LEFT:
+            x0 = x0 > offs ? x0 - offs : 0;
+            x1 = x1 > offs ? x1 - offs : 0;
+            break;
+        case FB_SHIFT_RIGHT:
+            x0 += offs;
+            x1 += offs;
+            break;
+        case FB_SHIFT_UP:
+            y0 += offs;
+            y1 += offs;
+            break;
+        case FB_SHIFT_DOWN:
+            y0 = y0 > offs ? y0 - offs : 0;
+            y1 = y1 > offs ? y1 - offs : 0;
+            break;
+    }
+    add_dirty(fb, b);
+    if (b.w && x1 > x0 && y1 > y0)
+        fb_mark_dirty(fb, x0, y0, x1 - x0, y1 - y0);
+
     switch (dir)
     {
         case FB_SHIFT_LEFT:
@@ -212,8 +493,12 @@ esp_err_t fb_fade(framebuffer_t *fb, uint8_t scale)
 {
     CHECK_ARG(fb && fb->data);
 
-    for (size_t i = 0; i < fb->width * fb->height; i++)
-        fb->data[i] = rgb_fade(fb->data[i], scale);
+    // Black pixels stay black
+    fb_rect_t b = fb->bounds;
+    for (size_t row = b.y; row < b.y + b.h; row++)
+        for (size_t i = FB_OFFSET(fb, b.x, row); i < FB_OFFSET(fb, b.x + b.w, row); i++)
+            fb->data[i] = rgb_fade(fb->data[i], scale);
+    add_dirty(fb, b);
 
     return ESP_OK;
 }
@@ -222,7 +507,20 @@ esp_err_t fb_blur2d(framebuffer_t *fb, fract8 amount)
 {
     CHECK_ARG(fb && fb->data);
 
-    blur2d(fb->data, fb->width, fb->height, amount, xy, fb);
+    if (!fb->bounds.w)
+        return ESP_OK;
+
+    // Light spreads by one pixel, black pixels further away stay black
+    fb_rect_t area = fb->bounds;
+    size_t x1 = area.x + area.w + 1;
+    size_t y1 = area.y + area.h + 1;
+    if (area.x) area.x--;
+    if (area.y) area.y--;
+    area.w = (x1 < fb->width ? x1 : fb->width) - area.x;
+    area.h = (y1 < fb->height ? y1 : fb->height) - area.y;
+
+    blur2d_linear(fb->data + FB_OFFSET(fb, area.x, area.y), area.w, area.h, fb->width, amount);
+    add_dirty(fb, area);
 
     return ESP_OK;
 }
@@ -234,6 +532,10 @@ esp_err_t fb_begin(framebuffer_t *fb)
     if (xSemaphoreTake(fb->mutex, 0) != pdTRUE)
         return ESP_ERR_INVALID_STATE;
 
+    // Untracked writes may be anywhere
+    if (fb->direct_writes)
+        fb_mark_dirty(fb, 0, 0, fb->width, fb->height);
+
     return ESP_OK;
 }
 
@@ -35,6 +35,7 @@
 #ifndef __FRAMEBUFFER_H__
 #define __FRAMEBUFFER_H__
 
+#include <stdbool.h>
 #include <esp_err.h>
 #include <color.h>
 #include <freertos/FreeRTOS.h>
@@ -48,6 +49,14 @@ extern "C" {
 
 #define FB_SIZE(fb) ((fb)->width * (fb)->height * sizeof(rgb_t))
 
+/**
+ * Signed Q8.8 fixed-point coordinate: integer part in the upper bits,
+ * 1/256 pixel in the lower 8 bits
+ */
+typedef int32_t fb_q8_t;
+
+#define FB_Q8(v) ((fb_q8_t)((v) * 256))
+
 typedef enum {
     FB_SHIFT_LEFT  = 0,
     FB_SHIFT_RIGHT,
@@ -55,6 +64,22 @@ typedef enum {
     FB_SHIFT_DOWN
 } fb_shift_direction_t;
 
+/**
+ * Max number of dirty rectangles tracked, nearby rectangles are merged
+ */
+#define FB_DIRTY_RECTS 4
+
+/**
+ * Rectangular area of framebuffer, empty if width is 0
+ */
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} fb_rect_t;
+
 typedef struct framebuffer_s framebuffer_t;
 
 /**
@@ -64,6 +89,13 @@ typedef esp_err_t (*fb_render_cb_t)(framebuffer_t *fb, void *arg);
 
 /**
  * Framebuffer descriptor descriptor
+ *
+ * Functions of this module track in `bounds` the area which may contain
+ * non-black pixels, and ::fb_clear(), ::fb_fade(), ::fb_blur2d() and
+ * layer composition touch only that area. Pixels written to `data`
+ * directly are outside of it until they are marked with ::fb_mark_dirty(),
+ * otherwise they are not cleared or faded. Effects which write `data`
+ * directly and don't mark what they write set `direct_writes`.
  */
 struct framebuffer_s
 {
@@ -75,6 +107,10 @@ struct framebuffer_s
     fb_render_cb_t render;         ///< See ::fb_render()
     uint8_t *internal;             ///< Buffer for effect settings, internal vars, palettes and so on
     SemaphoreHandle_t mutex;
+    fb_rect_t dirty[FB_DIRTY_RECTS]; ///< Areas changed since last ::fb_render(), may be used by renderer
+    uint8_t dirty_count;           ///< Number of dirty areas
+    fb_rect_t bounds;              ///< Area which may contain non-black pixels
+    bool direct_writes;            ///< `data` is written without ::fb_mark_dirty(), ::fb_begin() marks the whole frame
 };
 
 /**
@@ -101,7 +137,8 @@ esp_err_t fb_free(framebuffer_t *fb);
  * @brief Render frambuffer to actual display or LED strip
  *
  * Rendering is performed by calling the callback function with passing
- * it as arguments \p fb and \p ctx
+ * it as arguments \p fb and \p ctx. Callback may send only the areas
+ * listed in `fb->dirty`, the list is cleared after successful rendering.
  *
  * @param fb   Framebuffer descriptor
  * @param ctx  Argument to pass to callback
@@ -109,6 +146,22 @@ esp_err_t fb_free(framebuffer_t *fb);
  */
 esp_err_t fb_render(framebuffer_t *fb, void *ctx);
 
+/**
+ * @brief Mark area of framebuffer as changed
+ *
+ * Functions of this module do it themselves, call it after writing
+ * to `fb->data` directly. Area is clipped to the framebuffer and added
+ * to `fb->bounds`, so it's cleared, faded and blurred from now on.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         X coordinate of top left corner
+ * @param y         Y coordinate of top left corner
+ * @param w         Width of area
+ * @param h         Height of area
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_mark_dirty(framebuffer_t *fb, size_t x, size_t y, size_t w, size_t h);
+
 /**
  * @brief Set RGB color of framebuffer pixel
  *
@@ -153,6 +206,51 @@ esp_err_t fb_set_pixelf_rgb(framebuffer_t *fb, float x, float y, rgb_t color);
  */
 esp_err_t fb_set_pixelf_hsv(framebuffer_t *fb, float x, float y, hsv_t color);
 
+/**
+ * @brief Set RGB pixel with subpixel resolution, fixed-point version
+ *
+ * Color is spread over 4 pixels with Wu weights and added with saturation,
+ * like ::fb_set_pixelf_rgb(). Pixels outside of framebuffer are skipped.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         X coordinate, Q8.8
+ * @param y         Y coordinate, Q8.8
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_set_pixelq_rgb(framebuffer_t *fb, fb_q8_t x, fb_q8_t y, rgb_t color);
+
+/**
+ * @brief Draw antialiased line with subpixel resolution
+ *
+ * Xiaolin Wu's algorithm: for every pixel step along the major axis,
+ * color is split between the two pixels nearest to the line.
+ * Pixels outside of framebuffer are skipped.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x0        X coordinate of start, Q8.8
+ * @param y0        Y coordinate of start, Q8.8
+ * @param x1        X coordinate of end, Q8.8
+ * @param y1        Y coordinate of end, Q8.8
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_draw_lineq_rgb(framebuffer_t *fb, fb_q8_t x0, fb_q8_t y0, fb_q8_t x1, fb_q8_t y1, rgb_t color);
+
+/**
+ * @brief Draw antialiased circle with subpixel resolution
+ *
+ * Pixels outside of framebuffer are skipped.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param cx        X coordinate of center, Q8.8
+ * @param cy        Y coordinate of center, Q8.8
+ * @param r         Radius, Q8.8, up to 127 pixels
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_draw_circleq_rgb(framebuffer_t *fb, fb_q8_t cx, fb_q8_t cy, fb_q8_t r, rgb_t color);
+
 /**
  * @brief Get RGB color of framebuffer pixel
  *
@@ -167,6 +265,9 @@ esp_err_t fb_get_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t *color);
 /**
  * @brief Get HSV color of framebuffer pixel
  *
+ * Uses rgb2hsv_rainbow(), so the color of a pixel set with
+ * ::fb_set_pixel_hsv() converts back to the same RGB color, see its notes.
+ *
  * @param fb          Framebuffer descriptor
  * @param x           X coordinate
  * @param y           Y coordinate
@@ -178,6 +279,8 @@ esp_err_t fb_get_pixel_hsv(framebuffer_t *fb, size_t x, size_t y, hsv_t *color);
 /**
  * @brief Clear framebuffer
  *
+ * Clears `fb->bounds`, see ::framebuffer_s.
+ *
  * @param fb     Framebuffer descriptor
  * @return       ESP_OK on success
  */
@@ -196,7 +299,7 @@ esp_err_t fb_shift(framebuffer_t *fb, size_t offs, fb_shift_direction_t dir);
 /**
  * @brief Fade pixels to black
  *
- * rgb_fade(pixel, scale) for all pixels in framebuffer
+ * rgb_fade(pixel, scale) for all pixels in `fb->bounds`, see ::framebuffer_s
  *
  * @param fb        Framebuffer descriptor
  * @param scale     Amount of scaling
@@ -207,7 +310,8 @@ esp_err_t fb_fade(framebuffer_t *fb, uint8_t scale);
 /**
  * @brief Aplly two-dimensional blur filter on framebuffer
  *
- * Spreads light to 8 XY neighbors.
+ * Spreads light to 8 XY neighbors. Blurs `fb->bounds` and one pixel
+ * around it, see ::framebuffer_s.
  *
  *   0 = no spread at all
  *  64 = moderate spreading
@@ -224,7 +328,8 @@ esp_err_t fb_blur2d(framebuffer_t *fb, fract8 amount);
 /**
  * @brief Start frame rendering
  *
- * This function must be called in effects at the beginning of rendering frame
+ * This function must be called in effects at the beginning of rendering frame.
+ * With `fb->direct_writes` whole frame is marked as changed.
  *
  * @param fb     Framebuffer descriptor
  * @return       ESP_OK on success
@@ -1,7 +1,7 @@
 COMPONENT_ADD_INCLUDEDIRS = .
 
 ifdef CONFIG_IDF_TARGET_ESP8266
-COMPONENT_DEPENDS = esp8266 freertos esp_idf_lib_helpers
+COMPONENT_DEPENDS = esp8266 freertos esp_idf_lib_helpers esp_timer
 else
-COMPONENT_DEPENDS = driver freertos esp_idf_lib_helpers
+COMPONENT_DEPENDS = driver freertos esp_idf_lib_helpers esp_timer
 endif
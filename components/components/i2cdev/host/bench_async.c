@@ -0,0 +1,194 @@
+/**
+ * @file bench_async.c
+ *
+ * Throughput of blocking and asynchronous i2cdev API on mock bus
+ *
+ * Every sensor measurement is a 2-byte command, a conversion delay and
+ * a 6-byte read, like SHT3x single shot mode. Blocking API polls sensors
+ * one after another from one task, asynchronous API submits all of them
+ * at once and lets the port worker overlap the conversion delays. Two
+ * operations per sensor must fit CONFIG_I2CDEV_ASYNC_QUEUE_SIZE.
+ *
+ * Then checks that conversion delays count from completion of the command
+ * when the bus is busy with a long write to another device at submission,
+ * and that reads never start before the conversion ends. Times are
+ * esp_timer microseconds, ticks are too coarse at the default 100 Hz.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <i2cdev.h>
+#include "i2c_mock.h"
+
+#define MAX_SENSORS 8
+#define CONVERSION_MS 15
+#define ROUNDS 5
+// Sensors of delay check, their operations and the long write must fit the queue
+#define CHECK_QUEUED ((CONFIG_I2CDEV_ASYNC_QUEUE_SIZE - 1) / 2)
+#define CHECK_SENSORS (CHECK_QUEUED < MAX_SENSORS ? CHECK_QUEUED : MAX_SENSORS)
+
+static i2c_dev_t sensors[MAX_SENSORS];
+static uint8_t results[MAX_SENSORS][6];
+static const uint8_t measure_cmd[2] = { 0x24, 0x00 };
+
+static i2c_dev_t display;
+static uint8_t frame[1024];
+static int64_t measured[MAX_SENSORS], fetched[MAX_SENSORS];
+
+static SemaphoreHandle_t done;
+static volatile int failed;
+
+static void read_done(const i2c_dev_t *dev, esp_err_t res, void *ctx)
+{
+    (void)dev;
+    (void)ctx;
+    if (res != ESP_OK)
+        failed++;
+    xSemaphoreGive(done);
+}
+
+static void blocking_round(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        ESP_ERROR_CHECK(i2c_dev_write(&sensors[i], NULL, 0, measure_cmd, sizeof(measure_cmd)));
+        // Rounded up, plus the tick in progress
+        vTaskDelay((CONVERSION_MS * configTICK_RATE_HZ + 999) / 1000 + 1);
+        ESP_ERROR_CHECK(i2c_dev_read(&sensors[i], NULL, 0, results[i], sizeof(results[i])));
+    }
+}
+
+static void async_round(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        i2c_dev_op_t measure = {
+            .type = I2C_DEV_WRITE,
+            .out_data = measure_cmd,
+            .out_size = sizeof(measure_cmd),
+        };
+        i2c_dev_op_t fetch = {
+            .type = I2C_DEV_READ,
+            .in_data = results[i],
+            .in_size = sizeof(results[i]),
+            .delay_ms = CONVERSION_MS,
+        };
+        ESP_ERROR_CHECK(i2c_dev_submit(&sensors[i], &measure, NULL, NULL));
+        ESP_ERROR_CHECK(i2c_dev_submit(&sensors[i], &fetch, read_done, NULL));
+    }
+    for (int i = 0; i < count; i++)
+        xSemaphoreTake(done, portMAX_DELAY);
+}
+
+static void measure_done(const i2c_dev_t *dev, esp_err_t res, void *ctx)
+{
+    (void)dev;
+    measured[(intptr_t)ctx] = esp_timer_get_time();
+    if (res != ESP_OK)
+        failed++;
+}
+
+static void fetch_done(const i2c_dev_t *dev, esp_err_t res, void *ctx)
+{
+    fetched[(intptr_t)ctx] = esp_timer_get_time();
+    read_done(dev, res, ctx);
+}
+
+static bool check_delays(void)
+{
+    // About 23 ms at 400 kHz, longer than conversion
+    i2c_dev_op_t busy = {
+        .type = I2C_DEV_WRITE,
+        .out_data = frame,
+        .out_size = sizeof(frame),
+    };
+    ESP_ERROR_CHECK(i2c_dev_submit(&display, &busy, NULL, NULL));
+    for (intptr_t i = 0; i < CHECK_SENSORS; i++)
+    {
+        i2c_dev_op_t measure = {
+            .type = I2C_DEV_WRITE,
+            .out_data = measure_cmd,
+            .out_size = sizeof(measure_cmd),
+        };
+        i2c_dev_op_t fetch = {
+            .type = I2C_DEV_READ,
+            .in_data = results[i],
+            .in_size = sizeof(results[i]),
+            .delay_ms = CONVERSION_MS,
+        };
+        ESP_ERROR_CHECK(i2c_dev_submit(&sensors[i], &measure, measure_done, (void *)i));
+        ESP_ERROR_CHECK(i2c_dev_submit(&sensors[i], &fetch, fetch_done, (void *)i));
+    }
+    for (int i = 0; i < CHECK_SENSORS; i++)
+        xSemaphoreTake(done, portMAX_DELAY);
+
+    bool ok = true;
+    for (int i = 0; i < CHECK_SENSORS; i++)
+        if (fetched[i] - measured[i] < CONVERSION_MS * 1000)
+        {
+            fprintf(stderr, "sensor %d: read %.1f ms after command, conversion takes %d ms\n",
+                    i, (fetched[i] - measured[i]) / 1000.0, CONVERSION_MS);
+            ok = false;
+        }
+    printf("delays from completion: %s\n", ok ? "OK" : "FAILED");
+    return ok;
+}
+
+static void run(const char *name, void (*round)(int), int count)
+{
+    i2c_mock_stats_t stats;
+    i2c_mock_get_stats(I2C_NUM_0, NULL, true);
+
+    int64_t t = esp_timer_get_time();
+    for (int r = 0; r < ROUNDS; r++)
+        round(count);
+    t = esp_timer_get_time() - t;
+
+    i2c_mock_get_stats(I2C_NUM_0, &stats, false);
+    printf("%-10s %7d %10.1f %10.1f %12u\n", name, count, t / 1000.0 / ROUNDS,
+            t ? 1e6 * count * ROUNDS / t : 0, (unsigned)(stats.submissions / ROUNDS));
+}
+
+int main(void)
+{
+    ESP_ERROR_CHECK(i2cdev_init());
+    done = xSemaphoreCreateCounting(MAX_SENSORS, 0);
+
+    for (int i = 0; i < MAX_SENSORS; i++)
+    {
+        sensors[i].port = I2C_NUM_0;
+        sensors[i].addr = 0x40 + i;
+        sensors[i].cfg.sda_io_num = 21;
+        sensors[i].cfg.scl_io_num = 22;
+        sensors[i].cfg.master.clk_speed = 400000;
+        ESP_ERROR_CHECK(i2c_dev_create_mutex(&sensors[i]));
+    }
+    display = sensors[0];
+    display.addr = 0x3c;
+    ESP_ERROR_CHECK(i2c_dev_create_mutex(&display));
+
+    printf("%-10s %7s %10s %10s %12s\n", "api", "sensors", "ms/round", "meas/s", "submissions");
+    static const int counts[] = { 1, 4, 8 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        run("blocking", blocking_round, counts[i]);
+        run("async", async_round, counts[i]);
+    }
+    bool delays_ok = check_delays();
+
+    for (int i = 0; i < MAX_SENSORS; i++)
+        i2c_dev_delete_mutex(&sensors[i]);
+    i2c_dev_delete_mutex(&display);
+    ESP_ERROR_CHECK(i2cdev_done());
+    vSemaphoreDelete(done);
+
+    if (failed)
+        fprintf(stderr, "%d operations failed\n", failed);
+    return failed || !delays_ok ? 1 : 0;
+}
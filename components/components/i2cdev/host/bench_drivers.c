@@ -0,0 +1,459 @@
+/**
+ * @file bench_drivers.c
+ *
+ * Unmodified drivers on simulated bus with device models
+ *
+ * Every driver talks to a model of its chip. Results of the drivers are
+ * checked against the values set in the models, then bus transactions,
+ * bytes, bus time and wall time of typical operations are printed.
+ * SSD1306 driver uses legacy I2C driver on port 0 directly, so i2cdev
+ * devices are on port 1. Batch transactions are checked on PCA9685
+ * registers: every write must end with STOP.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <i2cdev.h>
+#include <bme680.h>
+#include <sht3x.h>
+#include <ads111x.h>
+#include <pca9685.h>
+#include <mcp23x17.h>
+#include <ssd1306.h>
+#include "i2c_mock.h"
+#include "models/models.h"
+
+#define PORT I2C_NUM_1
+#define SDA_GPIO 21
+#define SCL_GPIO 22
+
+static int failed;
+
+#define EXPECT(cond, fmt, ...) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: " fmt "\n", __FILE__, __LINE__, ## __VA_ARGS__); \
+            failed++; \
+        } \
+    } while (0)
+
+typedef void (*op_t)(void);
+
+// Returns wall time of one operation, milliseconds
+static double run(i2c_port_t port, const char *name, op_t op, int reps)
+{
+    i2c_mock_stats_t stats;
+    i2c_mock_get_stats(port, NULL, true);
+
+    uint64_t t = i2c_mock_time_us();
+    for (int r = 0; r < reps; r++)
+        op();
+    t = i2c_mock_time_us() - t;
+
+    i2c_mock_get_stats(port, &stats, false);
+    printf("  %-24s %8.1f %8.1f %10.3f %10.3f\n", name,
+            (double)stats.submissions / reps, (double)stats.bytes / reps,
+            stats.bus_us / 1000.0 / reps, t / 1000.0 / reps);
+
+    return t / 1000.0 / reps;
+}
+
+static void header(const char *chip)
+{
+    printf("%s\n  %-24s %8s %8s %10s %10s\n", chip, "operation", "trans", "bytes", "bus ms", "wall ms");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static sim_bme680_t bme680_sim;
+static bme680_t bme680;
+static bme680_values_float_t bme680_values;
+
+static void bme680_setup(void)
+{
+    ESP_ERROR_CHECK(bme680_init_sensor(&bme680));
+}
+
+static void bme680_read(void)
+{
+    ESP_ERROR_CHECK(bme680_measure_float(&bme680, &bme680_values));
+}
+
+static void bench_bme680(void)
+{
+    sim_bme680_init(&bme680_sim, BME680_I2C_ADDR_0);
+    ESP_ERROR_CHECK(i2c_mock_attach(PORT, &bme680_sim.dev));
+    memset(&bme680, 0, sizeof(bme680));
+    ESP_ERROR_CHECK(bme680_init_desc(&bme680, BME680_I2C_ADDR_0, PORT, SDA_GPIO, SCL_GPIO));
+
+    header("bme680");
+    run(PORT, "init", bme680_setup, 1);
+    run(PORT, "measure TPHG", bme680_read, 3);
+    EXPECT(fabsf(bme680_values.temperature - 25) < 1, "temperature %.2f", bme680_values.temperature);
+    EXPECT(fabsf(bme680_values.pressure - 1000) < 10, "pressure %.2f", bme680_values.pressure);
+    EXPECT(fabsf(bme680_values.humidity - 50) < 3, "humidity %.2f", bme680_values.humidity);
+    EXPECT(bme680_values.gas_resistance > 0, "gas resistance %.0f", bme680_values.gas_resistance);
+
+    ESP_ERROR_CHECK(bme680_use_heater_profile(&bme680, BME680_HEATER_NOT_USED));
+    run(PORT, "measure TPH", bme680_read, 3);
+    EXPECT(bme680_values.gas_resistance == 0, "gas resistance %.0f", bme680_values.gas_resistance);
+    printf("  %.2f C, %.2f hPa, %.2f %%\n", bme680_values.temperature, bme680_values.pressure,
+            bme680_values.humidity);
+
+    ESP_ERROR_CHECK(bme680_free_desc(&bme680));
+    ESP_ERROR_CHECK(i2c_mock_detach(&bme680_sim.dev));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static sim_sht3x_t sht3x_sim;
+static sht3x_t sht3x;
+static float sht3x_temp, sht3x_hum;
+
+static void sht3x_setup(void)
+{
+    ESP_ERROR_CHECK(sht3x_init(&sht3x));
+}
+
+static void sht3x_single(void)
+{
+    ESP_ERROR_CHECK(sht3x_measure(&sht3x, &sht3x_temp, &sht3x_hum));
+}
+
+static void sht3x_periodic(void)
+{
+    sht3x_raw_data_t raw;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    ESP_ERROR_CHECK(sht3x_get_raw_data(&sht3x, raw));
+    ESP_ERROR_CHECK(sht3x_compute_values(raw, &sht3x_temp, &sht3x_hum));
+}
+
+static void bench_sht3x(void)
+{
+    sim_sht3x_init(&sht3x_sim, SHT3X_I2C_ADDR_GND);
+    ESP_ERROR_CHECK(i2c_mock_attach(PORT, &sht3x_sim.dev));
+    sim_sht3x_set(&sht3x_sim, 21.5f, 40);
+    memset(&sht3x, 0, sizeof(sht3x));
+    ESP_ERROR_CHECK(sht3x_init_desc(&sht3x, SHT3X_I2C_ADDR_GND, PORT, SDA_GPIO, SCL_GPIO));
+
+    header("sht3x");
+    run(PORT, "init", sht3x_setup, 1);
+    run(PORT, "measure single shot", sht3x_single, 3);
+    EXPECT(fabsf(sht3x_temp - 21.5f) < 0.01f, "temperature %.2f", sht3x_temp);
+    EXPECT(fabsf(sht3x_hum - 40) < 0.01f, "humidity %.2f", sht3x_hum);
+
+    // Fetching before next data is ready is not acknowledged, driver logs error
+    sht3x_raw_data_t raw;
+    ESP_ERROR_CHECK(sht3x_start_measurement(&sht3x, SHT3X_PERIODIC_10MPS, SHT3X_HIGH));
+    vTaskDelay(pdMS_TO_TICKS(20));
+    ESP_ERROR_CHECK(sht3x_get_raw_data(&sht3x, raw));
+    EXPECT(sht3x_get_raw_data(&sht3x, raw) == ESP_FAIL, "fetched twice");
+    sim_sht3x_set(&sht3x_sim, -10, 90);
+    run(PORT, "fetch periodic 10 mps", sht3x_periodic, 3);
+    EXPECT(fabsf(sht3x_temp + 10) < 0.01f, "temperature %.2f", sht3x_temp);
+    EXPECT(fabsf(sht3x_hum - 90) < 0.01f, "humidity %.2f", sht3x_hum);
+    ESP_ERROR_CHECK(sht3x_stop_periodic_measurement(&sht3x));
+
+    ESP_ERROR_CHECK(sht3x_free_desc(&sht3x));
+    ESP_ERROR_CHECK(i2c_mock_detach(&sht3x_sim.dev));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static sim_ads1115_t ads1115_sim;
+static i2c_dev_t ads1115;
+static int16_t ads1115_value;
+
+static void ads1115_setup(void)
+{
+    ESP_ERROR_CHECK(ads111x_set_mode(&ads1115, ADS111X_MODE_SINGLE_SHOT));
+    ESP_ERROR_CHECK(ads111x_set_data_rate(&ads1115, ADS111X_DATA_RATE_860));
+    ESP_ERROR_CHECK(ads111x_set_input_mux(&ads1115, ADS111X_MUX_0_GND));
+    ESP_ERROR_CHECK(ads111x_set_gain(&ads1115, ADS111X_GAIN_4V096));
+}
+
+static void ads1115_read(void)
+{
+    bool busy;
+    ESP_ERROR_CHECK(ads111x_start_conversion(&ads1115));
+    do
+        ESP_ERROR_CHECK(ads111x_is_busy(&ads1115, &busy));
+    while (busy);
+    ESP_ERROR_CHECK(ads111x_get_value(&ads1115, &ads1115_value));
+}
+
+static void ads1115_scan(void)
+{
+    for (int mux = ADS111X_MUX_0_GND; mux <= ADS111X_MUX_3_GND; mux++)
+    {
+        ESP_ERROR_CHECK(ads111x_set_input_mux(&ads1115, mux));
+        ads1115_read();
+        float v = ads111x_gain_values[ADS111X_GAIN_4V096] * ads1115_value / ADS111X_MAX_VALUE;
+        EXPECT(fabsf(v - 0.5f * (mux - ADS111X_MUX_0_GND + 1)) < 0.001f, "AIN%d %.4f", mux - ADS111X_MUX_0_GND, v);
+    }
+}
+
+static void bench_ads1115(void)
+{
+    sim_ads1115_init(&ads1115_sim, ADS111X_ADDR_GND);
+    ESP_ERROR_CHECK(i2c_mock_attach(PORT, &ads1115_sim.dev));
+    for (int i = 0; i < 4; i++)
+        sim_ads1115_set_input(&ads1115_sim, i, 0.5f * (i + 1));
+    memset(&ads1115, 0, sizeof(ads1115));
+    ESP_ERROR_CHECK(ads111x_init_desc(&ads1115, ADS111X_ADDR_GND, PORT, SDA_GPIO, SCL_GPIO));
+
+    header("ads1115");
+    run(PORT, "configure", ads1115_setup, 1);
+    run(PORT, "single shot 860 SPS", ads1115_read, 10);
+    run(PORT, "scan 4 inputs", ads1115_scan, 3);
+
+    i2c_dev_regcache_stats_t stats;
+    ESP_ERROR_CHECK(i2c_dev_regcache_get_stats(&ads1115, &stats, false));
+    printf("  register cache: %u transactions saved, %u misses\n", (unsigned)stats.saved, (unsigned)stats.misses);
+    // Config and two thresholds, 16 bits each
+    EXPECT(stats.shadow_size == 3 * 2, "%u bytes of shadows", (unsigned)stats.shadow_size);
+
+    ESP_ERROR_CHECK(ads111x_free_desc(&ads1115));
+    ESP_ERROR_CHECK(i2c_mock_detach(&ads1115_sim.dev));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static sim_pca9685_t pca9685_sim;
+static i2c_dev_t pca9685;
+static uint16_t pca9685_values[16];
+
+static void pca9685_setup(void)
+{
+    ESP_ERROR_CHECK(pca9685_init(&pca9685));
+    ESP_ERROR_CHECK(pca9685_restart(&pca9685));
+    ESP_ERROR_CHECK(pca9685_set_pwm_frequency(&pca9685, 1000));
+}
+
+static void pca9685_set_one(void)
+{
+    ESP_ERROR_CHECK(pca9685_set_pwm_value(&pca9685, 5, 1234));
+}
+
+static void pca9685_set_all(void)
+{
+    // pca9685_set_pwm_values() indexes its buffer by channel, so first_ch must be 0
+    ESP_ERROR_CHECK(pca9685_set_pwm_values(&pca9685, 0, 16, pca9685_values));
+}
+
+static void bench_pca9685(void)
+{
+    sim_pca9685_init(&pca9685_sim, PCA9685_ADDR_BASE);
+    ESP_ERROR_CHECK(i2c_mock_attach(PORT, &pca9685_sim.dev));
+    memset(&pca9685, 0, sizeof(pca9685));
+    // Leftover of a previous user of the descriptor, cleared by i2c_dev_create_mutex()
+    pca9685.regcache = (i2c_dev_regcache_t *)&pca9685_sim;
+    ESP_ERROR_CHECK(pca9685_init_desc(&pca9685, PCA9685_ADDR_BASE, PORT, SDA_GPIO, SCL_GPIO));
+    // Creating a cache again replaces the old one, LeakSanitizer reports it otherwise
+    ESP_ERROR_CHECK(i2c_dev_create_regcache(&pca9685, 1));
+    ESP_ERROR_CHECK(i2c_dev_create_regcache(&pca9685, 1));
+    // Shadows span the marked registers only
+    i2c_dev_regcache_stats_t stats;
+    ESP_ERROR_CHECK(i2c_dev_regcache_mark(&pca9685, 0x10, 2, true));
+    ESP_ERROR_CHECK(i2c_dev_regcache_mark(&pca9685, 0x08, 1, true));
+    ESP_ERROR_CHECK(i2c_dev_regcache_get_stats(&pca9685, &stats, false));
+    EXPECT(stats.shadow_size == 0x12 - 0x08, "%u bytes of shadows", (unsigned)stats.shadow_size);
+    ESP_ERROR_CHECK(i2c_dev_delete_regcache(&pca9685));
+
+    header("pca9685");
+    run(PORT, "init 1 kHz", pca9685_setup, 1);
+    // Prescaler resolution makes it 1017 Hz
+    uint16_t freq;
+    ESP_ERROR_CHECK(pca9685_get_pwm_frequency(&pca9685, &freq));
+    EXPECT(sim_pca9685_freq(&pca9685_sim) == freq, "frequency %u, driver %u",
+            (unsigned)sim_pca9685_freq(&pca9685_sim), freq);
+
+    run(PORT, "set 1 channel", pca9685_set_one, 10);
+    EXPECT(sim_pca9685_duty(&pca9685_sim, 5) == 1234, "duty %u", sim_pca9685_duty(&pca9685_sim, 5));
+
+    for (int ch = 0; ch < 16; ch++)
+        pca9685_values[ch] = ch * 273;
+    run(PORT, "set 16 channels", pca9685_set_all, 10);
+    for (int ch = 0; ch < 16; ch++)
+        EXPECT(sim_pca9685_duty(&pca9685_sim, ch) == pca9685_values[ch], "channel %d duty %u", ch,
+                sim_pca9685_duty(&pca9685_sim, ch));
+
+    ESP_ERROR_CHECK(pca9685_free_desc(&pca9685));
+    ESP_ERROR_CHECK(i2c_mock_detach(&pca9685_sim.dev));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define BATCH_LEDS 2
+
+static uint8_t batch_out[BATCH_LEDS][4], batch_in[BATCH_LEDS][4];
+
+// Writes of LED registers, then reads of them back
+static void batch_leds(void)
+{
+    i2c_dev_segment_t segments[BATCH_LEDS * 2];
+    i2c_dev_batch_t batch;
+    ESP_ERROR_CHECK(i2c_dev_batch_init(&batch, PORT, segments, BATCH_LEDS * 2));
+    for (int i = 0; i < BATCH_LEDS; i++)
+        ESP_ERROR_CHECK(i2c_dev_batch_write_reg(&batch, &pca9685, 0x06 + i * 4, batch_out[i], 4));
+    for (int i = 0; i < BATCH_LEDS; i++)
+        ESP_ERROR_CHECK(i2c_dev_batch_read_reg(&batch, &pca9685, 0x06 + i * 4, batch_in[i], 4));
+    ESP_ERROR_CHECK(i2c_dev_batch_run(&batch));
+}
+
+static void bench_batch(void)
+{
+    sim_pca9685_init(&pca9685_sim, PCA9685_ADDR_BASE);
+    ESP_ERROR_CHECK(i2c_mock_attach(PORT, &pca9685_sim.dev));
+    memset(&pca9685, 0, sizeof(pca9685));
+    ESP_ERROR_CHECK(pca9685_init_desc(&pca9685, PCA9685_ADDR_BASE, PORT, SDA_GPIO, SCL_GPIO));
+    ESP_ERROR_CHECK(pca9685_init(&pca9685));
+
+    // Duty of LED i is 1000 * (i + 1), OFF time minus ON time
+    for (int i = 0; i < BATCH_LEDS; i++)
+    {
+        uint16_t off = 1000 * (i + 1);
+        uint8_t out[4] = { 0, 0, off & 0xff, off >> 8 };
+        memcpy(batch_out[i], out, 4);
+    }
+
+    header("batch");
+    i2c_mock_dev_stats_t stats;
+    i2c_mock_get_dev_stats(&pca9685_sim.dev, NULL, true);
+    run(PORT, "2 writes, 2 reads", batch_leds, 1);
+    i2c_mock_get_dev_stats(&pca9685_sim.dev, &stats, false);
+
+    // Writes end with STOP, reads are chained into one submission
+    EXPECT(stats.stops == BATCH_LEDS + 1, "%u STOPs, %d writes", (unsigned)stats.stops, BATCH_LEDS);
+    for (int i = 0; i < BATCH_LEDS; i++)
+    {
+        EXPECT(sim_pca9685_duty(&pca9685_sim, i) == 1000 * (i + 1), "LED %d duty %u", i,
+                sim_pca9685_duty(&pca9685_sim, i));
+        EXPECT(!memcmp(batch_in[i], batch_out[i], 4), "LED %d read back differs", i);
+    }
+
+    ESP_ERROR_CHECK(pca9685_free_desc(&pca9685));
+    ESP_ERROR_CHECK(i2c_mock_detach(&pca9685_sim.dev));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static sim_mcp23017_t mcp23017_sim;
+static mcp23x17_t mcp23017;
+static uint16_t mcp23017_port;
+
+static void mcp23017_setup(void)
+{
+    // Low byte outputs, high byte inputs
+    ESP_ERROR_CHECK(mcp23x17_port_set_mode(&mcp23017, 0xff00));
+    ESP_ERROR_CHECK(mcp23x17_port_set_pullup(&mcp23017, 0xff00));
+}
+
+static void mcp23017_write_pin(void)
+{
+    ESP_ERROR_CHECK(mcp23x17_set_level(&mcp23017, 3, 1));
+}
+
+static void mcp23017_write_port(void)
+{
+    ESP_ERROR_CHECK(mcp23x17_port_write(&mcp23017, 0x00a5));
+}
+
+static void mcp23017_read_port(void)
+{
+    ESP_ERROR_CHECK(mcp23x17_port_read(&mcp23017, &mcp23017_port));
+}
+
+static void bench_mcp23017(void)
+{
+    sim_mcp23017_init(&mcp23017_sim, MCP23X17_ADDR_BASE);
+    ESP_ERROR_CHECK(i2c_mock_attach(PORT, &mcp23017_sim.dev));
+    memset(&mcp23017, 0, sizeof(mcp23017));
+    ESP_ERROR_CHECK(mcp23x17_init_desc(&mcp23017, MCP23X17_ADDR_BASE, PORT, SDA_GPIO, SCL_GPIO));
+
+    header("mcp23017");
+    run(PORT, "configure", mcp23017_setup, 1);
+    run(PORT, "write port", mcp23017_write_port, 10);
+    EXPECT(sim_mcp23017_get_outputs(&mcp23017_sim) == 0x00a5, "outputs 0x%04x", sim_mcp23017_get_outputs(&mcp23017_sim));
+    run(PORT, "write pin", mcp23017_write_pin, 10);
+    EXPECT(sim_mcp23017_get_outputs(&mcp23017_sim) == 0x00ad, "outputs 0x%04x", sim_mcp23017_get_outputs(&mcp23017_sim));
+
+    sim_mcp23017_set_inputs(&mcp23017_sim, 0x3c00);
+    run(PORT, "read port", mcp23017_read_port, 10);
+    EXPECT(mcp23017_port == 0x3cad, "port 0x%04x", mcp23017_port);
+
+    ESP_ERROR_CHECK(mcp23x17_free_desc(&mcp23017));
+    ESP_ERROR_CHECK(i2c_mock_detach(&mcp23017_sim.dev));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static sim_ssd1306_t ssd1306_sim;
+static SSD1306_t ssd1306;
+
+static void ssd1306_refresh(void)
+{
+    ssd1306_show_buffer(&ssd1306);
+}
+
+static void ssd1306_text(void)
+{
+    ssd1306_display_text(&ssd1306, 0, "i2cdev", 6, false);
+}
+
+static void bench_ssd1306(void)
+{
+    sim_ssd1306_init(&ssd1306_sim, 0x3c);
+    ESP_ERROR_CHECK(i2c_mock_attach(I2C_NUM_0, &ssd1306_sim.dev));
+    memset(&ssd1306, 0, sizeof(ssd1306));
+    i2c_master_init(&ssd1306, SDA_GPIO, SCL_GPIO, -1);
+
+    header("ssd1306");
+    i2c_mock_get_stats(I2C_NUM_0, NULL, true);
+    ssd1306_init(&ssd1306, 128, 64);
+    EXPECT(ssd1306_sim.on && ssd1306_sim.contrast == 0xff, "display is not configured");
+
+    run(I2C_NUM_0, "text line", ssd1306_text, 10);
+    // Glyph of 'i' has pixels in columns 2..4
+    bool lit = false;
+    for (int x = 0; x < 8; x++)
+        for (int y = 0; y < 8; y++)
+            lit |= sim_ssd1306_pixel(&ssd1306_sim, x, y);
+    EXPECT(lit, "text is not displayed");
+
+    for (int page = 0; page < 8; page++)
+        memset(ssd1306._page[page]._segs, page & 1 ? 0xff : 0, 128);
+    ssd1306_sim.data_bytes = 0;
+    double ms = run(I2C_NUM_0, "full refresh", ssd1306_refresh, 10);
+    EXPECT(sim_ssd1306_pixel(&ssd1306_sim, 127, 63) && !sim_ssd1306_pixel(&ssd1306_sim, 0, 0), "refresh failed");
+    EXPECT(ssd1306_sim.data_bytes == 10 * 8 * 128, "%u data bytes", (unsigned)ssd1306_sim.data_bytes);
+    printf("  full refresh %.1f fps\n", 1000 / ms);
+
+    ESP_ERROR_CHECK(i2c_mock_detach(&ssd1306_sim.dev));
+}
+
+int main(void)
+{
+    ESP_ERROR_CHECK(i2cdev_init());
+    i2c_mock_set_strict(PORT, true);
+    i2c_mock_set_strict(I2C_NUM_0, true);
+
+    bench_bme680();
+    bench_sht3x();
+    bench_ads1115();
+    bench_pca9685();
+    bench_batch();
+    bench_mcp23017();
+    bench_ssd1306();
+
+    ESP_ERROR_CHECK(i2cdev_done());
+
+    if (failed)
+        fprintf(stderr, "%d checks failed\n", failed);
+    return failed ? 1 : 0;
+}
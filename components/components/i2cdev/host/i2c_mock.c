@@ -0,0 +1,433 @@
+/**
+ * @file i2c_mock.c
+ *
+ * Simulated I2C bus for host builds of i2cdev
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <esp_timer.h>
+#include "i2c_mock.h"
+
+// Timing registers count APB clock ticks
+#define APB_HZ 80000000
+
+typedef enum {
+    CMD_START = 0,
+    CMD_STOP,
+    CMD_WRITE,
+    CMD_READ,
+} cmd_type_t;
+
+typedef struct
+{
+    cmd_type_t type;
+    uint8_t byte;           // Single byte writes are copied
+    const uint8_t *wdata;
+    uint8_t *rdata;
+    size_t len;
+} cmd_t;
+
+typedef struct
+{
+    cmd_t *cmds;
+    size_t count;
+    size_t capacity;
+} cmd_link_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    bool installed;
+    int timeout;
+    int high_period, low_period;
+    int start_setup, start_hold;
+    int stop_setup, stop_hold;
+    int sample_time, hold_time;
+    bool strict;
+    i2c_mock_dev_t *devs;
+    i2c_mock_stats_t stats;
+} port_t;
+
+static port_t ports[I2C_NUM_MAX] = {
+    { .lock = PTHREAD_MUTEX_INITIALIZER },
+    { .lock = PTHREAD_MUTEX_INITIALIZER },
+};
+
+#define CHECK_PORT(p) do { if ((p) < 0 || (p) >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG; } while (0)
+
+uint64_t i2c_mock_time_us(void)
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+static void sleep_us(uint64_t us)
+{
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) && errno == EINTR)
+        ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Driver
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf)
+{
+    CHECK_PORT(i2c_num);
+    if (!i2c_conf || !i2c_conf->master.clk_speed)
+        return ESP_ERR_INVALID_ARG;
+
+    port_t *p = &ports[i2c_num];
+    int half = APB_HZ / i2c_conf->master.clk_speed / 2;
+    p->high_period = p->low_period = half;
+    p->start_setup = p->start_hold = half;
+    p->stop_setup = p->stop_hold = half;
+    p->sample_time = p->hold_time = half / 2;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+        int intr_alloc_flags)
+{
+    (void)slv_rx_buf_len;
+    (void)slv_tx_buf_len;
+    (void)intr_alloc_flags;
+    CHECK_PORT(i2c_num);
+    if (mode != I2C_MODE_MASTER)
+        return ESP_ERR_NOT_SUPPORTED;
+    if (ports[i2c_num].installed)
+        return ESP_FAIL;
+
+    ports[i2c_num].installed = true;
+    ports[i2c_num].stats.installs++;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num)
+{
+    CHECK_PORT(i2c_num);
+    if (!ports[i2c_num].installed)
+        return ESP_ERR_INVALID_STATE;
+
+    ports[i2c_num].installed = false;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_set_timeout(i2c_port_t i2c_num, int timeout)
+{
+    CHECK_PORT(i2c_num);
+    ports[i2c_num].timeout = timeout;
+    return ESP_OK;
+}
+
+esp_err_t i2c_get_timeout(i2c_port_t i2c_num, int *timeout)
+{
+    CHECK_PORT(i2c_num);
+    *timeout = ports[i2c_num].timeout;
+    return ESP_OK;
+}
+
+#define TIMING_PAIR(NAME, A, B) \
+    esp_err_t i2c_set_##NAME(i2c_port_t i2c_num, int a, int b) \
+    { \
+        CHECK_PORT(i2c_num); \
+        ports[i2c_num].A = a; \
+        ports[i2c_num].B = b; \
+        return ESP_OK; \
+    } \
+    esp_err_t i2c_get_##NAME(i2c_port_t i2c_num, int *a, int *b) \
+    { \
+        CHECK_PORT(i2c_num); \
+        *a = ports[i2c_num].A; \
+        *b = ports[i2c_num].B; \
+        return ESP_OK; \
+    }
+
+TIMING_PAIR(period, high_period, low_period)
+TIMING_PAIR(start_timing, start_setup, start_hold)
+TIMING_PAIR(stop_timing, stop_setup, stop_hold)
+TIMING_PAIR(data_timing, sample_time, hold_time)
+
+////////////////////////////////////////////////////////////////////////////////
+// Command links
+
+i2c_cmd_handle_t i2c_cmd_link_create(void)
+{
+    return calloc(1, sizeof(cmd_link_t));
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle)
+{
+    cmd_link_t *link = cmd_handle;
+    if (!link)
+        return;
+    free(link->cmds);
+    free(link);
+}
+
+static esp_err_t add_cmd(i2c_cmd_handle_t cmd_handle, cmd_t cmd)
+{
+    cmd_link_t *link = cmd_handle;
+    if (!link)
+        return ESP_ERR_INVALID_ARG;
+    if (link->count == link->capacity)
+    {
+        size_t capacity = link->capacity ? link->capacity * 2 : 8;
+        cmd_t *cmds = realloc(link->cmds, capacity * sizeof(cmd_t));
+        if (!cmds)
+            return ESP_ERR_NO_MEM;
+        link->cmds = cmds;
+        link->capacity = capacity;
+    }
+    link->cmds[link->count++] = cmd;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle)
+{
+    return add_cmd(cmd_handle, (cmd_t){ .type = CMD_START });
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle)
+{
+    return add_cmd(cmd_handle, (cmd_t){ .type = CMD_STOP });
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data, bool ack_en)
+{
+    (void)ack_en;
+    return add_cmd(cmd_handle, (cmd_t){ .type = CMD_WRITE, .byte = data, .len = 1 });
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, const uint8_t *data, size_t data_len, bool ack_en)
+{
+    (void)ack_en;
+    if (!data && data_len)
+        return ESP_ERR_INVALID_ARG;
+    return add_cmd(cmd_handle, (cmd_t){ .type = CMD_WRITE, .wdata = data, .len = data_len });
+}
+
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd_handle, uint8_t *data, i2c_ack_type_t ack)
+{
+    return i2c_master_read(cmd_handle, data, 1, ack);
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data, size_t data_len, i2c_ack_type_t ack)
+{
+    (void)ack;
+    if (!data || !data_len)
+        return ESP_ERR_INVALID_ARG;
+    return add_cmd(cmd_handle, (cmd_t){ .type = CMD_READ, .rdata = data, .len = data_len });
+}
+
+static i2c_mock_dev_t *find_dev(port_t *p, uint8_t addr)
+{
+    for (i2c_mock_dev_t *d = p->devs; d; d = d->next)
+        if (d->addr == addr)
+            return d;
+    return NULL;
+}
+
+static void dev_stop(i2c_mock_dev_t *dev)
+{
+    if (dev && dev->model->stop)
+        dev->model->stop(dev);
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    CHECK_PORT(i2c_num);
+    cmd_link_t *link = cmd_handle;
+    if (!link)
+        return ESP_ERR_INVALID_ARG;
+
+    port_t *p = &ports[i2c_num];
+    pthread_mutex_lock(&p->lock);
+    if (!p->installed)
+    {
+        pthread_mutex_unlock(&p->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Replay commands on the bus until the end or first NACK.
+    // START and STOP take about one bit time, bytes take nine with ACK
+    esp_err_t res = ESP_OK;
+    uint32_t bits = 0, bytes = 0;
+    i2c_mock_dev_t *dev = NULL;   // Addressed device, NULL if none or no model
+    bool addressing = false;      // Next written byte is address
+    bool acked = false;           // Address was acknowledged
+    for (size_t i = 0; i < link->count && res == ESP_OK; i++)
+    {
+        cmd_t *c = &link->cmds[i];
+        switch (c->type)
+        {
+            case CMD_START:
+                bits++;
+                addressing = true;
+                break;
+            case CMD_STOP:
+                bits++;
+                if (dev && acked)
+                    dev->stats.stops++;
+                dev_stop(dev);
+                dev = NULL;
+                acked = false;
+                break;
+            case CMD_WRITE:
+                for (size_t j = 0; j < c->len && res == ESP_OK; j++)
+                {
+                    uint8_t b = c->wdata ? c->wdata[j] : c->byte;
+                    bits += 9;
+                    bytes++;
+                    if (addressing)
+                    {
+                        addressing = false;
+                        i2c_mock_dev_t *d = find_dev(p, b >> 1);
+                        if (d != dev)
+                            dev_stop(dev);
+                        dev = d;
+                        acked = dev ? dev->model->start(dev, b & 1) : !p->strict;
+                        if (dev && acked)
+                            dev->stats.transactions++;
+                    }
+                    else if (dev && acked)
+                    {
+                        acked = dev->model->write(dev, b);
+                        if (acked)
+                            dev->stats.written++;
+                    }
+                    if (!acked)
+                        res = ESP_FAIL;
+                }
+                break;
+            case CMD_READ:
+                for (size_t j = 0; j < c->len; j++)
+                {
+                    if (dev && acked)
+                    {
+                        c->rdata[j] = dev->model->read(dev);
+                        dev->stats.read++;
+                    }
+                    else
+                        c->rdata[j] = 0;
+                }
+                bits += 9 * c->len;
+                bytes += c->len;
+                break;
+        }
+    }
+    if (res != ESP_OK)
+    {
+        // Master sends STOP after NACK
+        bits++;
+        dev_stop(dev);
+        p->stats.nacks++;
+    }
+    uint32_t period = p->high_period + p->low_period;
+    uint64_t bus_us = period ? (uint64_t)bits * period * 1000000 / APB_HZ : 0;
+
+    p->stats.submissions++;
+    p->stats.bytes += bytes;
+    p->stats.bus_us += bus_us;
+    pthread_mutex_unlock(&p->lock);
+
+    sleep_us(bus_us + I2C_MOCK_OVERHEAD_US);
+
+    return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void i2c_mock_get_stats(i2c_port_t port, i2c_mock_stats_t *stats, bool reset)
+{
+    if (port < 0 || port >= I2C_NUM_MAX)
+        return;
+
+    pthread_mutex_lock(&ports[port].lock);
+    if (stats)
+        *stats = ports[port].stats;
+    if (reset)
+        memset(&ports[port].stats, 0, sizeof(i2c_mock_stats_t));
+    pthread_mutex_unlock(&ports[port].lock);
+}
+
+void i2c_mock_set_strict(i2c_port_t port, bool strict)
+{
+    if (port < 0 || port >= I2C_NUM_MAX)
+        return;
+
+    pthread_mutex_lock(&ports[port].lock);
+    ports[port].strict = strict;
+    pthread_mutex_unlock(&ports[port].lock);
+}
+
+esp_err_t i2c_mock_attach(i2c_port_t port, i2c_mock_dev_t *dev)
+{
+    CHECK_PORT(port);
+    if (!dev || !dev->model || !dev->model->start || !dev->model->write || !dev->model->read || dev->addr > 0x7f)
+        return ESP_ERR_INVALID_ARG;
+
+    port_t *p = &ports[port];
+    pthread_mutex_lock(&p->lock);
+    if (find_dev(p, dev->addr))
+    {
+        pthread_mutex_unlock(&p->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    dev->port = port;
+    dev->next = p->devs;
+    p->devs = dev;
+    pthread_mutex_unlock(&p->lock);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_mock_detach(i2c_mock_dev_t *dev)
+{
+    if (!dev)
+        return ESP_ERR_INVALID_ARG;
+    CHECK_PORT(dev->port);
+
+    port_t *p = &ports[dev->port];
+    esp_err_t res = ESP_ERR_NOT_FOUND;
+    pthread_mutex_lock(&p->lock);
+    for (i2c_mock_dev_t **d = &p->devs; *d; d = &(*d)->next)
+        if (*d == dev)
+        {
+            *d = dev->next;
+            dev->next = NULL;
+            res = ESP_OK;
+            break;
+        }
+    pthread_mutex_unlock(&p->lock);
+
+    return res;
+}
+
+void i2c_mock_lock(i2c_mock_dev_t *dev)
+{
+    pthread_mutex_lock(&ports[dev->port].lock);
+}
+
+void i2c_mock_unlock(i2c_mock_dev_t *dev)
+{
+    pthread_mutex_unlock(&ports[dev->port].lock);
+}
+
+void i2c_mock_get_dev_stats(i2c_mock_dev_t *dev, i2c_mock_dev_stats_t *stats, bool reset)
+{
+    i2c_mock_lock(dev);
+    if (stats)
+        *stats = dev->stats;
+    if (reset)
+        memset(&dev->stats, 0, sizeof(i2c_mock_dev_stats_t));
+    i2c_mock_unlock(dev);
+}
@@ -0,0 +1,158 @@
+/**
+ * @file i2c_mock.h
+ *
+ * Simulated I2C bus for host builds of i2cdev
+ *
+ * Implements legacy ESP-IDF I2C master driver API. Transfers take as long
+ * as they would on a real bus at the configured clock speed, plus a fixed
+ * driver overhead per submission.
+ *
+ * Device models are attached to ports at their addresses and see the
+ * traffic byte by byte, see models/models.h. Addresses without a model
+ * acknowledge everything and read as zeros, unless the port is strict,
+ * then they don't acknowledge like on a real bus.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __I2C_MOCK_H__
+#define __I2C_MOCK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <driver/i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Time of i2c_master_cmd_begin() in addition to bus time, microseconds
+ */
+#ifndef I2C_MOCK_OVERHEAD_US
+#define I2C_MOCK_OVERHEAD_US 30
+#endif
+
+/**
+ * Bus statistics
+ */
+typedef struct
+{
+    uint32_t submissions;   ///< Number of i2c_master_cmd_begin() calls
+    uint32_t bytes;         ///< Bytes transferred, including addresses
+    uint64_t bus_us;        ///< Simulated bus time, microseconds
+    uint32_t installs;      ///< Number of i2c_driver_install() calls
+    uint32_t nacks;         ///< Submissions failed due to NACK
+} i2c_mock_stats_t;
+
+/**
+ * Traffic statistics of a device
+ */
+typedef struct
+{
+    uint32_t transactions;  ///< Acknowledged address phases, including repeated START
+    uint32_t written;       ///< Bytes written to device, without addresses
+    uint32_t read;          ///< Bytes read from device
+    uint32_t stops;         ///< STOP conditions ending acknowledged transactions
+} i2c_mock_dev_stats_t;
+
+typedef struct i2c_mock_dev i2c_mock_dev_t;
+
+/**
+ * Device model
+ *
+ * Callbacks are called in bus order with the port locked, so they must
+ * not call i2c_mock_lock().
+ */
+typedef struct
+{
+    const char *name;                                   ///< Model name
+    bool (*start)(i2c_mock_dev_t *dev, bool read);      ///< Device addressed after START, false to NACK
+    bool (*write)(i2c_mock_dev_t *dev, uint8_t data);   ///< Byte written by master, false to NACK
+    uint8_t (*read)(i2c_mock_dev_t *dev);               ///< Byte read by master
+    void (*stop)(i2c_mock_dev_t *dev);                  ///< STOP or START to another device, may be NULL
+} i2c_mock_model_t;
+
+/**
+ * Simulated device, first member of model state
+ */
+struct i2c_mock_dev
+{
+    const i2c_mock_model_t *model; ///< Device model
+    uint8_t addr;                  ///< Unshifted address
+    i2c_port_t port;               ///< Port the device is attached to
+    i2c_mock_dev_stats_t stats;    ///< Traffic statistics
+    i2c_mock_dev_t *next;          ///< Next device on the port
+};
+
+/**
+ * @brief Get bus statistics
+ *
+ * @param port       I2C port
+ * @param[out] stats Statistics
+ * @param reset      Reset statistics after reading
+ */
+void i2c_mock_get_stats(i2c_port_t port, i2c_mock_stats_t *stats, bool reset);
+
+/**
+ * @brief Make port strict or permissive
+ *
+ * Strict port doesn't acknowledge addresses without a device model,
+ * permissive one (default) acknowledges them and reads zeros.
+ *
+ * @param port   I2C port
+ * @param strict true for strict port
+ */
+void i2c_mock_set_strict(i2c_port_t port, bool strict);
+
+/**
+ * @brief Attach device model to port
+ *
+ * @param port   I2C port
+ * @param dev    Device with model and address set
+ * @return       ESP_OK on success, ESP_ERR_INVALID_STATE if address is taken
+ */
+esp_err_t i2c_mock_attach(i2c_port_t port, i2c_mock_dev_t *dev);
+
+/**
+ * @brief Detach device model from its port
+ *
+ * @param dev    Attached device
+ * @return       ESP_OK on success
+ */
+esp_err_t i2c_mock_detach(i2c_mock_dev_t *dev);
+
+/**
+ * @brief Lock port of device to access model state from outside
+ *
+ * @param dev    Attached device
+ */
+void i2c_mock_lock(i2c_mock_dev_t *dev);
+
+/**
+ * @brief Unlock port of device
+ *
+ * @param dev    Attached device
+ */
+void i2c_mock_unlock(i2c_mock_dev_t *dev);
+
+/**
+ * @brief Get device traffic statistics
+ *
+ * @param dev        Attached device
+ * @param[out] stats Statistics
+ * @param reset      Reset statistics after reading
+ */
+void i2c_mock_get_dev_stats(i2c_mock_dev_t *dev, i2c_mock_dev_stats_t *stats, bool reset);
+
+/**
+ * @brief Simulation time for device timing, microseconds
+ *
+ * Simulated bus runs in real time, so this is esp_timer_get_time().
+ */
+uint64_t i2c_mock_time_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __I2C_MOCK_H__ */
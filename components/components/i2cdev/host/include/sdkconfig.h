@@ -0,0 +1,29 @@
+/*
+ * sdkconfig.h replacement for host builds of i2cdev
+ *
+ * Replaces the one of the host shim. Host behaves like ESP32 with legacy
+ * I2C driver. Options of drivers built for host select their I2C variants.
+ */
+#ifndef __SDKCONFIG_H__
+#define __SDKCONFIG_H__
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_IDF_TARGET "esp32"
+
+#define CONFIG_I2CDEV_TIMEOUT 1000
+#define CONFIG_I2CDEV_ASYNC_QUEUE_SIZE 16
+#define CONFIG_I2CDEV_ASYNC_TASK_PRIORITY 5
+#define CONFIG_I2CDEV_ASYNC_STACK_SIZE 4096
+
+// ESP-IDF default, coarse ticks show delays rounded to ticks
+#ifndef CONFIG_FREERTOS_HZ
+#define CONFIG_FREERTOS_HZ 100
+#endif
+
+#define CONFIG_MCP23X17_IFACE_I2C 1
+
+#define CONFIG_I2C_INTERFACE 1
+#define CONFIG_SSD1306_128x64 1
+#define CONFIG_OFFSETX 0
+
+#endif /* __SDKCONFIG_H__ */
@@ -0,0 +1,9 @@
+/*
+ * soc/i2c_reg.h replacement for host builds of i2cdev
+ */
+#ifndef __HOST_I2C_REG_H__
+#define __HOST_I2C_REG_H__
+
+#define I2C_TIME_OUT_REG_V 0x000fffff
+
+#endif /* __HOST_I2C_REG_H__ */
@@ -0,0 +1,297 @@
+/**
+ * @file models.h
+ *
+ * Device models for the simulated I2C bus
+ *
+ * Every model embeds ::i2c_mock_dev_t as its first member. Initialize
+ * the model with its init function and attach it with
+ *
+ *     i2c_mock_attach(port, &model.dev);
+ *
+ * Models implement register maps, auto-increment, reset values and
+ * conversion timing of the chips as far as the drivers of this library
+ * use them. Setters and getters lock the port, call them after attaching.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __MODELS_H__
+#define __MODELS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../i2c_mock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// BME680
+
+/**
+ * BME680 gas sensor
+ *
+ * Forced mode measurement takes the time computed from oversampling
+ * settings and heater duration like the vendor API does. ADC values
+ * are set directly, calibration data is fixed.
+ */
+typedef struct
+{
+    i2c_mock_dev_t dev;
+    uint8_t regs[256];
+    uint8_t ptr;
+    bool ptr_next;          ///< Next written byte is register address
+    bool measuring;
+    uint64_t ready_us;      ///< End of running measurement
+    uint32_t temp_adc, press_adc, hum_adc, gas_adc;
+    uint8_t gas_range;
+} sim_bme680_t;
+
+/**
+ * @brief Initialize BME680 model
+ *
+ * Default ADC values compensate to about 25 °C, 1000 hPa and 50 %RH.
+ *
+ * @param s     Model
+ * @param addr  I2C address, 0x76 or 0x77
+ */
+void sim_bme680_init(sim_bme680_t *s, uint8_t addr);
+
+/**
+ * @brief Set ADC values of next measurements
+ *
+ * @param s         Model
+ * @param temp_adc  20-bit temperature
+ * @param press_adc 20-bit pressure
+ * @param hum_adc   16-bit humidity
+ * @param gas_adc   10-bit gas resistance
+ * @param gas_range Gas range, 0..15
+ */
+void sim_bme680_set_adc(sim_bme680_t *s, uint32_t temp_adc, uint32_t press_adc, uint16_t hum_adc,
+        uint16_t gas_adc, uint8_t gas_range);
+
+////////////////////////////////////////////////////////////////////////////////
+// SHT3x
+
+/**
+ * SHT3x humidity sensor
+ *
+ * Single shot and periodic modes with maximum conversion times from the
+ * datasheet. Address is not acknowledged during single shot measurement,
+ * fetching data before it is ready is not acknowledged too. Clock
+ * stretching commands behave like the ones without it.
+ */
+typedef struct
+{
+    i2c_mock_dev_t dev;
+    uint8_t cmd[2];
+    uint8_t cmd_len;
+    uint8_t out[6];         ///< Response being read
+    uint8_t out_len, out_pos;
+    uint16_t status;
+    bool periodic;
+    bool measuring;         ///< Single shot measurement is running
+    bool has_data;
+    uint32_t period_us;     ///< Period of periodic mode
+    uint32_t meas_us;       ///< Conversion time of current repeatability
+    uint64_t start_us;      ///< Start of running or next periodic measurement
+    uint16_t temp_raw, hum_raw;
+} sim_sht3x_t;
+
+/**
+ * @brief Initialize SHT3x model
+ *
+ * @param s     Model
+ * @param addr  I2C address, 0x44 or 0x45
+ */
+void sim_sht3x_init(sim_sht3x_t *s, uint8_t addr);
+
+/**
+ * @brief Set environment measured by next conversions
+ *
+ * @param s           Model
+ * @param temperature Temperature, °C
+ * @param humidity    Relative humidity, %
+ */
+void sim_sht3x_set(sim_sht3x_t *s, float temperature, float humidity);
+
+////////////////////////////////////////////////////////////////////////////////
+// ADS1115
+
+/**
+ * ADS1115 16-bit ADC
+ *
+ * Single shot conversion takes one data rate period, OS bit reads 0
+ * until it is done. In continuous mode conversion register is updated
+ * every period. Comparator is not simulated.
+ */
+typedef struct
+{
+    i2c_mock_dev_t dev;
+    uint16_t regs[4];
+    uint8_t ptr;
+    uint8_t wpos;           ///< Position in write transfer
+    uint8_t rpos;           ///< Position in read transfer
+    uint16_t wval;
+    uint16_t rval;
+    bool converting;
+    uint64_t ready_us;      ///< End of single shot conversion
+    uint64_t cont_us;       ///< Start of continuous mode
+    float inputs[4];        ///< Voltages of AIN0..AIN3
+} sim_ads1115_t;
+
+/**
+ * @brief Initialize ADS1115 model
+ *
+ * @param s     Model
+ * @param addr  I2C address, 0x48..0x4b
+ */
+void sim_ads1115_init(sim_ads1115_t *s, uint8_t addr);
+
+/**
+ * @brief Set input voltage
+ *
+ * @param s     Model
+ * @param ain   Input, 0..3
+ * @param volts Voltage
+ */
+void sim_ads1115_set_input(sim_ads1115_t *s, uint8_t ain, float volts);
+
+////////////////////////////////////////////////////////////////////////////////
+// PCA9685
+
+/**
+ * PCA9685 16-channel PWM controller
+ *
+ * MODE1 auto-increment, ALL_LED broadcast and prescaler write protection
+ * outside of sleep are simulated, the oscillator is always stable.
+ */
+typedef struct
+{
+    i2c_mock_dev_t dev;
+    uint8_t regs[256];
+    uint8_t ptr;
+    bool ptr_next;
+} sim_pca9685_t;
+
+/**
+ * @brief Initialize PCA9685 model
+ *
+ * @param s     Model
+ * @param addr  I2C address, 0x40..0x7f
+ */
+void sim_pca9685_init(sim_pca9685_t *s, uint8_t addr);
+
+/**
+ * @brief Get channel duty cycle
+ *
+ * @param s       Model
+ * @param channel Channel, 0..15
+ * @return        Duty cycle, 0..4096, 4096 is full on
+ */
+uint16_t sim_pca9685_duty(sim_pca9685_t *s, uint8_t channel);
+
+/**
+ * @brief Get PWM frequency
+ *
+ * @param s       Model
+ * @return        Frequency, Hz
+ */
+uint32_t sim_pca9685_freq(sim_pca9685_t *s);
+
+////////////////////////////////////////////////////////////////////////////////
+// MCP23017
+
+/**
+ * MCP23017 16-bit GPIO expander
+ *
+ * Register layout with IOCON.BANK = 0 only. Input polarity, interrupt
+ * on change or compare and interrupt capture are simulated, INT pins
+ * are not.
+ */
+typedef struct
+{
+    i2c_mock_dev_t dev;
+    uint8_t regs[0x16];
+    uint8_t ptr;
+    bool ptr_next;
+    uint16_t inputs;        ///< External levels of pins
+} sim_mcp23017_t;
+
+/**
+ * @brief Initialize MCP23017 model
+ *
+ * @param s     Model
+ * @param addr  I2C address, 0x20..0x27
+ */
+void sim_mcp23017_init(sim_mcp23017_t *s, uint8_t addr);
+
+/**
+ * @brief Drive input pins from outside
+ *
+ * @param s      Model
+ * @param levels Levels of pins, bit 0 is GPA0, bit 15 is GPB7
+ */
+void sim_mcp23017_set_inputs(sim_mcp23017_t *s, uint16_t levels);
+
+/**
+ * @brief Get levels of output pins
+ *
+ * @param s      Model
+ * @return       Output latch masked by direction, input pins read as 0
+ */
+uint16_t sim_mcp23017_get_outputs(sim_mcp23017_t *s);
+
+////////////////////////////////////////////////////////////////////////////////
+// SSD1306
+
+#define SIM_SSD1306_WIDTH 128
+#define SIM_SSD1306_PAGES 8
+
+/**
+ * SSD1306 OLED controller
+ *
+ * Control bytes, command parameters and page, horizontal and vertical
+ * addressing modes are simulated. Scrolling commands are parsed and
+ * ignored.
+ */
+typedef struct
+{
+    i2c_mock_dev_t dev;
+    uint8_t ram[SIM_SSD1306_PAGES][SIM_SSD1306_WIDTH];
+    bool control_next;      ///< Next byte is control byte
+    bool single;            ///< Control byte is followed by one byte
+    bool data;              ///< Bytes are data, not commands
+    uint8_t cmd[7];
+    uint8_t cmd_len, cmd_need;
+    uint8_t addr_mode;
+    uint8_t col, col_start, col_end;
+    uint8_t page, page_start, page_end;
+    uint8_t contrast;
+    bool on;
+    uint32_t data_bytes;    ///< Bytes written to display RAM
+} sim_ssd1306_t;
+
+/**
+ * @brief Initialize SSD1306 model
+ *
+ * @param s     Model
+ * @param addr  I2C address, 0x3c or 0x3d
+ */
+void sim_ssd1306_init(sim_ssd1306_t *s, uint8_t addr);
+
+/**
+ * @brief Get pixel from display RAM
+ *
+ * @param s     Model
+ * @param x     Column, 0..127
+ * @param y     Row, 0..63
+ * @return      true if pixel is on
+ */
+bool sim_ssd1306_pixel(sim_ssd1306_t *s, uint8_t x, uint8_t y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MODELS_H__ */
@@ -0,0 +1,158 @@
+/**
+ * @file sim_ads1115.c
+ *
+ * ADS1115 model for the simulated I2C bus
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "models.h"
+
+#define REG_CONVERSION 0
+#define REG_CONFIG     1
+#define REG_THRESH_L   2
+#define REG_THRESH_H   3
+
+#define CONFIG_OS     0x8000
+#define CONFIG_SINGLE 0x0100
+
+static const float fsr[8] = { 6.144f, 4.096f, 2.048f, 1.024f, 0.512f, 0.256f, 0.256f, 0.256f };
+static const uint16_t rates[8] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+
+static uint32_t period_us(sim_ads1115_t *s)
+{
+    return 1000000 / rates[(s->regs[REG_CONFIG] >> 5) & 7];
+}
+
+static uint16_t convert(sim_ads1115_t *s)
+{
+    static const int8_t mux[8][2] = {
+        { 0, 1 }, { 0, 3 }, { 1, 3 }, { 2, 3 }, { 0, -1 }, { 1, -1 }, { 2, -1 }, { 3, -1 },
+    };
+    uint16_t config = s->regs[REG_CONFIG];
+    const int8_t *m = mux[(config >> 12) & 7];
+    float v = s->inputs[m[0]] - (m[1] < 0 ? 0 : s->inputs[m[1]]);
+    float code = v / fsr[(config >> 9) & 7] * 32768;
+    if (code >= 32767)
+        return 32767;
+    if (code <= -32768)
+        return (uint16_t)-32768;
+    return (uint16_t)(int16_t)(code < 0 ? code - 0.5f : code + 0.5f);
+}
+
+static void update(sim_ads1115_t *s)
+{
+    uint64_t now = i2c_mock_time_us();
+    if (s->converting && now >= s->ready_us)
+    {
+        s->regs[REG_CONVERSION] = convert(s);
+        s->converting = false;
+    }
+    if (!(s->regs[REG_CONFIG] & CONFIG_SINGLE) && now >= s->cont_us + period_us(s))
+    {
+        s->regs[REG_CONVERSION] = convert(s);
+        s->cont_us = now;
+    }
+}
+
+static uint16_t read_reg(sim_ads1115_t *s, uint8_t reg)
+{
+    if (reg != REG_CONFIG)
+        return s->regs[reg];
+    // OS bit reads 1 when no conversion is running
+    bool busy = s->converting || !(s->regs[REG_CONFIG] & CONFIG_SINGLE);
+    return (s->regs[REG_CONFIG] & ~CONFIG_OS) | (busy ? 0 : CONFIG_OS);
+}
+
+static void write_reg(sim_ads1115_t *s, uint8_t reg, uint16_t val)
+{
+    if (reg == REG_CONVERSION)
+        return;
+    if (reg != REG_CONFIG)
+    {
+        s->regs[reg] = val;
+        return;
+    }
+
+    bool was_single = s->regs[REG_CONFIG] & CONFIG_SINGLE;
+    s->regs[REG_CONFIG] = val & ~CONFIG_OS;
+    if (!(val & CONFIG_SINGLE))
+    {
+        // Continuous mode, first result after one period
+        if (was_single)
+            s->cont_us = i2c_mock_time_us();
+        s->converting = false;
+    }
+    else if ((val & CONFIG_OS) && !s->converting)
+    {
+        s->converting = true;
+        s->ready_us = i2c_mock_time_us() + period_us(s);
+    }
+}
+
+static bool dev_start(i2c_mock_dev_t *dev, bool read)
+{
+    sim_ads1115_t *s = (sim_ads1115_t *)dev;
+    update(s);
+    if (read)
+        s->rpos = 0;
+    else
+        s->wpos = 0;
+    return true;
+}
+
+static bool dev_write(i2c_mock_dev_t *dev, uint8_t data)
+{
+    sim_ads1115_t *s = (sim_ads1115_t *)dev;
+    switch (s->wpos++)
+    {
+        case 0:
+            s->ptr = data & 3;
+            break;
+        case 1:
+            s->wval = data << 8;
+            break;
+        case 2:
+            write_reg(s, s->ptr, s->wval | data);
+            break;
+    }
+    return true;
+}
+
+static uint8_t dev_read(i2c_mock_dev_t *dev)
+{
+    sim_ads1115_t *s = (sim_ads1115_t *)dev;
+    // Register is repeated when reading more than two bytes
+    if (!(s->rpos++ & 1))
+    {
+        s->rval = read_reg(s, s->ptr);
+        return s->rval >> 8;
+    }
+    return s->rval;
+}
+
+static const i2c_mock_model_t model = {
+    .name = "ads1115",
+    .start = dev_start,
+    .write = dev_write,
+    .read = dev_read,
+};
+
+void sim_ads1115_init(sim_ads1115_t *s, uint8_t addr)
+{
+    memset(s, 0, sizeof(sim_ads1115_t));
+    s->dev.model = &model;
+    s->dev.addr = addr;
+    s->regs[REG_CONFIG] = 0x8583 & ~CONFIG_OS;
+    s->regs[REG_THRESH_L] = 0x8000;
+    s->regs[REG_THRESH_H] = 0x7fff;
+}
+
+void sim_ads1115_set_input(sim_ads1115_t *s, uint8_t ain, float volts)
+{
+    if (ain > 3)
+        return;
+    i2c_mock_lock(&s->dev);
+    s->inputs[ain] = volts;
+    i2c_mock_unlock(&s->dev);
+}
@@ -0,0 +1,202 @@
+/**
+ * @file sim_bme680.c
+ *
+ * BME680 model for the simulated I2C bus
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "models.h"
+
+#define REG_RES_HEAT_VAL   0x00
+#define REG_RES_HEAT_RANGE 0x02
+#define REG_RANGE_SW_ERR   0x04
+#define REG_MEAS_STATUS    0x1d
+#define REG_MEAS_INDEX     0x1e
+#define REG_PRESS          0x1f
+#define REG_TEMP           0x22
+#define REG_HUM            0x25
+#define REG_GAS_R          0x2a
+#define REG_GAS_WAIT       0x64
+#define REG_CTRL_GAS_1     0x71
+#define REG_CTRL_HUM       0x72
+#define REG_CTRL_MEAS      0x74
+#define REG_CONFIG         0x75
+#define REG_ID             0xd0
+#define REG_RESET          0xe0
+
+#define CHIP_ID   0x61
+#define RESET_CMD 0xb6
+
+#define STATUS_NEW_DATA  0x80
+#define STATUS_MEASURING 0x20
+#define GAS_VALID        0x20
+#define HEAT_STAB        0x10
+#define RUN_GAS          0x10
+#define MODE_FORCED      0x01
+
+// Skipped measurements read as this
+#define ADC_SKIPPED 0x80000
+
+// Calibration data of a typical sensor, see bme680.c for the layout
+static const struct { uint8_t reg, val; } calib[] = {
+    // T2 = 26354, T3 = 3
+    { 0x8a, 0xf2 }, { 0x8b, 0x66 }, { 0x8c, 0x03 },
+    // P1 = 36378, P2 = -10426, P3 = 88
+    { 0x8e, 0x1a }, { 0x8f, 0x8e }, { 0x90, 0x46 }, { 0x91, 0xd7 }, { 0x92, 0x58 },
+    // P4 = 7174, P5 = -93, P7 = 38, P6 = 30
+    { 0x94, 0x06 }, { 0x95, 0x1c }, { 0x96, 0xa3 }, { 0x97, 0xff }, { 0x98, 0x26 }, { 0x99, 0x1e },
+    // P8 = -1428, P9 = -3209, P10 = 30
+    { 0x9c, 0x6c }, { 0x9d, 0xfa }, { 0x9e, 0x77 }, { 0x9f, 0xf3 }, { 0xa0, 0x1e },
+    // H2 = 1019, H1 = 760
+    { 0xe1, 0x3f }, { 0xe2, 0xb8 }, { 0xe3, 0x2f },
+    // H3 = 0, H4 = 45, H5 = 20, H6 = 120, H7 = -100
+    { 0xe4, 0x00 }, { 0xe5, 0x2d }, { 0xe6, 0x14 }, { 0xe7, 0x78 }, { 0xe8, 0x9c },
+    // T1 = 26208
+    { 0xe9, 0x60 }, { 0xea, 0x66 },
+    // GH2 = -11906, GH1 = -30, GH3 = 18
+    { 0xeb, 0x7e }, { 0xec, 0xd1 }, { 0xed, 0xe2 }, { 0xee, 0x12 },
+    // res_heat_val = 44, res_heat_range = 1, range_sw_err = 0
+    { REG_RES_HEAT_VAL, 0x2c }, { REG_RES_HEAT_RANGE, 0x10 }, { REG_RANGE_SW_ERR, 0x00 },
+};
+
+static void reset(sim_bme680_t *s)
+{
+    memset(s->regs, 0, sizeof(s->regs));
+    for (size_t i = 0; i < sizeof(calib) / sizeof(calib[0]); i++)
+        s->regs[calib[i].reg] = calib[i].val;
+    s->regs[REG_ID] = CHIP_ID;
+    s->measuring = false;
+}
+
+static bool writable(uint8_t reg)
+{
+    return (reg >= 0x50 && reg <= 0x75) || reg == REG_RESET;
+}
+
+// Forced mode duration as computed by the vendor API
+static uint64_t duration_us(sim_bme680_t *s)
+{
+    static const uint8_t cycles[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+    uint8_t ctrl_meas = s->regs[REG_CTRL_MEAS];
+    uint32_t n = cycles[ctrl_meas >> 5] + cycles[(ctrl_meas >> 2) & 7] + cycles[s->regs[REG_CTRL_HUM] & 7];
+
+    uint64_t us = n * 1963 + 477 * 4 + 477 * 5 + 1000;
+    if (s->regs[REG_CTRL_GAS_1] & RUN_GAS)
+    {
+        static const uint8_t mult[4] = { 1, 4, 16, 64 };
+        uint8_t wait = s->regs[REG_GAS_WAIT + (s->regs[REG_CTRL_GAS_1] & 0x0f)];
+        us += (uint64_t)(wait & 0x3f) * mult[wait >> 6] * 1000;
+    }
+    return us;
+}
+
+static void put_20bit(uint8_t *r, uint32_t v)
+{
+    r[0] = v >> 12;
+    r[1] = v >> 4;
+    r[2] = (v & 0x0f) << 4;
+}
+
+static void update(sim_bme680_t *s)
+{
+    if (!s->measuring || i2c_mock_time_us() < s->ready_us)
+        return;
+
+    uint8_t *r = s->regs;
+    uint8_t ctrl_meas = r[REG_CTRL_MEAS];
+    bool gas = r[REG_CTRL_GAS_1] & RUN_GAS;
+
+    put_20bit(r + REG_TEMP, ctrl_meas >> 5 ? s->temp_adc : ADC_SKIPPED);
+    put_20bit(r + REG_PRESS, (ctrl_meas >> 2) & 7 ? s->press_adc : ADC_SKIPPED);
+    uint16_t hum = r[REG_CTRL_HUM] & 7 ? s->hum_adc : 0x8000;
+    r[REG_HUM] = hum >> 8;
+    r[REG_HUM + 1] = hum;
+    r[REG_GAS_R] = s->gas_adc >> 2;
+    r[REG_GAS_R + 1] = (s->gas_adc & 3) << 6 | (gas ? GAS_VALID | HEAT_STAB : 0) | s->gas_range;
+
+    r[REG_MEAS_STATUS] = STATUS_NEW_DATA | (r[REG_CTRL_GAS_1] & 0x0f);
+    r[REG_MEAS_INDEX]++;
+    r[REG_CTRL_MEAS] &= ~3;
+    s->measuring = false;
+}
+
+static void write_reg(sim_bme680_t *s, uint8_t reg, uint8_t val)
+{
+    if (!writable(reg))
+        return;
+
+    if (reg == REG_RESET)
+    {
+        if (val == RESET_CMD)
+            reset(s);
+        return;
+    }
+
+    s->regs[reg] = val;
+    if (reg == REG_CTRL_MEAS && (val & 3) == MODE_FORCED)
+    {
+        s->measuring = true;
+        s->ready_us = i2c_mock_time_us() + duration_us(s);
+        s->regs[REG_MEAS_STATUS] = STATUS_MEASURING;
+    }
+}
+
+static bool dev_start(i2c_mock_dev_t *dev, bool read)
+{
+    sim_bme680_t *s = (sim_bme680_t *)dev;
+    update(s);
+    s->ptr_next = !read;
+    return true;
+}
+
+static bool dev_write(i2c_mock_dev_t *dev, uint8_t data)
+{
+    sim_bme680_t *s = (sim_bme680_t *)dev;
+    if (s->ptr_next)
+    {
+        s->ptr = data;
+        s->ptr_next = false;
+    }
+    else
+        write_reg(s, s->ptr++, data);
+    return true;
+}
+
+static uint8_t dev_read(i2c_mock_dev_t *dev)
+{
+    sim_bme680_t *s = (sim_bme680_t *)dev;
+    return s->regs[s->ptr++];
+}
+
+static const i2c_mock_model_t model = {
+    .name = "bme680",
+    .start = dev_start,
+    .write = dev_write,
+    .read = dev_read,
+};
+
+void sim_bme680_init(sim_bme680_t *s, uint8_t addr)
+{
+    memset(s, 0, sizeof(sim_bme680_t));
+    s->dev.model = &model;
+    s->dev.addr = addr;
+    reset(s);
+    s->temp_adc = 498900;
+    s->press_adc = 351420;
+    s->hum_adc = 21716;
+    s->gas_adc = 512;
+    s->gas_range = 4;
+}
+
+void sim_bme680_set_adc(sim_bme680_t *s, uint32_t temp_adc, uint32_t press_adc, uint16_t hum_adc,
+        uint16_t gas_adc, uint8_t gas_range)
+{
+    i2c_mock_lock(&s->dev);
+    s->temp_adc = temp_adc & 0xfffff;
+    s->press_adc = press_adc & 0xfffff;
+    s->hum_adc = hum_adc;
+    s->gas_adc = gas_adc & 0x3ff;
+    s->gas_range = gas_range & 0x0f;
+    i2c_mock_unlock(&s->dev);
+}
@@ -0,0 +1,164 @@
+/**
+ * @file sim_mcp23017.c
+ *
+ * MCP23017 model for the simulated I2C bus
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "models.h"
+
+#define REG_IODIR   0x00
+#define REG_IPOL    0x02
+#define REG_GPINTEN 0x04
+#define REG_DEFVAL  0x06
+#define REG_INTCON  0x08
+#define REG_IOCON   0x0a
+#define REG_GPPU    0x0c
+#define REG_INTF    0x0e
+#define REG_INTCAP  0x10
+#define REG_GPIO    0x12
+#define REG_OLAT    0x14
+#define REG_COUNT   0x16
+
+#define IOCON_SEQOP 0x20
+
+static uint16_t get16(sim_mcp23017_t *s, uint8_t reg)
+{
+    return s->regs[reg] | s->regs[reg + 1] << 8;
+}
+
+static void set16(sim_mcp23017_t *s, uint8_t reg, uint16_t val)
+{
+    s->regs[reg] = val;
+    s->regs[reg + 1] = val >> 8;
+}
+
+// GPIO register as read by master
+static uint16_t gpio(sim_mcp23017_t *s)
+{
+    uint16_t dir = get16(s, REG_IODIR);
+    return ((s->inputs ^ get16(s, REG_IPOL)) & dir) | (get16(s, REG_OLAT) & ~dir);
+}
+
+static void write_reg(sim_mcp23017_t *s, uint8_t reg, uint8_t val)
+{
+    switch (reg)
+    {
+        case REG_IOCON:
+        case REG_IOCON + 1:
+            // Shared register, BANK is not supported
+            s->regs[REG_IOCON] = s->regs[REG_IOCON + 1] = val & ~0x81;
+            return;
+        case REG_INTF:
+        case REG_INTF + 1:
+        case REG_INTCAP:
+        case REG_INTCAP + 1:
+            return;
+        case REG_GPIO:
+        case REG_GPIO + 1:
+            reg += REG_OLAT - REG_GPIO;
+            break;
+    }
+    s->regs[reg] = val;
+}
+
+static uint8_t read_reg(sim_mcp23017_t *s, uint8_t reg)
+{
+    switch (reg)
+    {
+        case REG_GPIO:
+        case REG_GPIO + 1:
+            // Reading port clears its interrupt
+            s->regs[reg - REG_GPIO + REG_INTF] = 0;
+            return gpio(s) >> ((reg - REG_GPIO) * 8);
+        case REG_INTCAP:
+        case REG_INTCAP + 1:
+            s->regs[reg - REG_INTCAP + REG_INTF] = 0;
+            break;
+    }
+    return s->regs[reg];
+}
+
+static uint8_t next_reg(sim_mcp23017_t *s, uint8_t reg)
+{
+    if (s->regs[REG_IOCON] & IOCON_SEQOP)
+        return reg ^ 1;
+    return (reg + 1) % REG_COUNT;
+}
+
+static bool dev_start(i2c_mock_dev_t *dev, bool read)
+{
+    sim_mcp23017_t *s = (sim_mcp23017_t *)dev;
+    s->ptr_next = !read;
+    return true;
+}
+
+static bool dev_write(i2c_mock_dev_t *dev, uint8_t data)
+{
+    sim_mcp23017_t *s = (sim_mcp23017_t *)dev;
+    if (s->ptr_next)
+    {
+        s->ptr = data;
+        s->ptr_next = false;
+        return data < REG_COUNT;
+    }
+    write_reg(s, s->ptr, data);
+    s->ptr = next_reg(s, s->ptr);
+    return true;
+}
+
+static uint8_t dev_read(i2c_mock_dev_t *dev)
+{
+    sim_mcp23017_t *s = (sim_mcp23017_t *)dev;
+    uint8_t val = read_reg(s, s->ptr);
+    s->ptr = next_reg(s, s->ptr);
+    return val;
+}
+
+static const i2c_mock_model_t model = {
+    .name = "mcp23017",
+    .start = dev_start,
+    .write = dev_write,
+    .read = dev_read,
+};
+
+void sim_mcp23017_init(sim_mcp23017_t *s, uint8_t addr)
+{
+    memset(s, 0, sizeof(sim_mcp23017_t));
+    s->dev.model = &model;
+    s->dev.addr = addr;
+    set16(s, REG_IODIR, 0xffff);
+}
+
+void sim_mcp23017_set_inputs(sim_mcp23017_t *s, uint16_t levels)
+{
+    i2c_mock_lock(&s->dev);
+    uint16_t prev = s->inputs;
+    s->inputs = levels;
+
+    // Interrupt on change from previous value or from DEFVAL
+    uint16_t intcon = get16(s, REG_INTCON);
+    uint16_t changed = ((levels ^ prev) & ~intcon) | ((levels ^ get16(s, REG_DEFVAL)) & intcon);
+    uint16_t intf = get16(s, REG_INTF);
+    uint16_t fired = changed & get16(s, REG_GPINTEN) & get16(s, REG_IODIR) & ~intf;
+    for (int port = 0; port < 2; port++)
+    {
+        // INTCAP is captured by the first interrupt of the port only
+        uint8_t f = fired >> (port * 8);
+        if (!f || s->regs[REG_INTF + port])
+            continue;
+        s->regs[REG_INTF + port] = f;
+        s->regs[REG_INTCAP + port] = gpio(s) >> (port * 8);
+    }
+    i2c_mock_unlock(&s->dev);
+}
+
+uint16_t sim_mcp23017_get_outputs(sim_mcp23017_t *s)
+{
+    i2c_mock_lock(&s->dev);
+    uint16_t out = get16(s, REG_OLAT) & ~get16(s, REG_IODIR);
+    i2c_mock_unlock(&s->dev);
+
+    return out;
+}
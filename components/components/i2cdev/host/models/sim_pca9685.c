@@ -0,0 +1,142 @@
+/**
+ * @file sim_pca9685.c
+ *
+ * PCA9685 model for the simulated I2C bus
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "models.h"
+
+#define REG_MODE1     0x00
+#define REG_MODE2     0x01
+#define REG_LEDX      0x06
+#define REG_LED_LAST  0x45
+#define REG_ALL_LED   0xfa
+#define REG_PRE_SCALE 0xfe
+
+#define MODE1_RESTART 0x80
+#define MODE1_AI      0x20
+#define MODE1_SLEEP   0x10
+
+#define LED_FULL 0x10
+
+#define OSC_HZ 25000000
+
+static void write_reg(sim_pca9685_t *s, uint8_t reg, uint8_t val)
+{
+    uint8_t *r = s->regs;
+    switch (reg)
+    {
+        case REG_MODE1:
+            // RESTART is cleared by writing 1, set when PWM is stopped by sleep
+            if (!(r[REG_MODE1] & MODE1_SLEEP) && (val & MODE1_SLEEP))
+                val |= MODE1_RESTART;
+            else if (val & MODE1_RESTART)
+                val &= ~MODE1_RESTART;
+            else
+                val |= r[REG_MODE1] & MODE1_RESTART;
+            r[REG_MODE1] = val;
+            return;
+        case REG_PRE_SCALE:
+            if (r[REG_MODE1] & MODE1_SLEEP)
+                r[REG_PRE_SCALE] = val < 3 ? 3 : val;
+            return;
+        case REG_ALL_LED ... REG_ALL_LED + 3:
+            for (int ch = 0; ch < 16; ch++)
+                r[REG_LEDX + ch * 4 + reg - REG_ALL_LED] = val;
+            return;
+    }
+    if (reg <= REG_LED_LAST)
+        r[reg] = val;
+}
+
+static uint8_t next_reg(sim_pca9685_t *s, uint8_t reg)
+{
+    if (!(s->regs[REG_MODE1] & MODE1_AI))
+        return reg;
+    return reg == REG_LED_LAST || reg == 0xff ? 0 : reg + 1;
+}
+
+static bool dev_start(i2c_mock_dev_t *dev, bool read)
+{
+    sim_pca9685_t *s = (sim_pca9685_t *)dev;
+    s->ptr_next = !read;
+    return true;
+}
+
+static bool dev_write(i2c_mock_dev_t *dev, uint8_t data)
+{
+    sim_pca9685_t *s = (sim_pca9685_t *)dev;
+    if (s->ptr_next)
+    {
+        s->ptr = data;
+        s->ptr_next = false;
+        return true;
+    }
+    write_reg(s, s->ptr, data);
+    s->ptr = next_reg(s, s->ptr);
+    return true;
+}
+
+static uint8_t dev_read(i2c_mock_dev_t *dev)
+{
+    sim_pca9685_t *s = (sim_pca9685_t *)dev;
+    // ALL_LED registers read as zeros
+    uint8_t val = s->ptr >= REG_ALL_LED && s->ptr < REG_PRE_SCALE ? 0 : s->regs[s->ptr];
+    s->ptr = next_reg(s, s->ptr);
+    return val;
+}
+
+static const i2c_mock_model_t model = {
+    .name = "pca9685",
+    .start = dev_start,
+    .write = dev_write,
+    .read = dev_read,
+};
+
+void sim_pca9685_init(sim_pca9685_t *s, uint8_t addr)
+{
+    memset(s, 0, sizeof(sim_pca9685_t));
+    s->dev.model = &model;
+    s->dev.addr = addr;
+    s->regs[REG_MODE1] = 0x11;
+    s->regs[REG_MODE2] = 0x04;
+    s->regs[0x02] = 0xe2;
+    s->regs[0x03] = 0xe4;
+    s->regs[0x04] = 0xe8;
+    s->regs[0x05] = 0xe0;
+    for (int ch = 0; ch < 16; ch++)
+        s->regs[REG_LEDX + ch * 4 + 3] = LED_FULL;
+    s->regs[REG_PRE_SCALE] = 0x1e;
+}
+
+uint16_t sim_pca9685_duty(sim_pca9685_t *s, uint8_t channel)
+{
+    if (channel > 15)
+        return 0;
+
+    i2c_mock_lock(&s->dev);
+    const uint8_t *led = s->regs + REG_LEDX + channel * 4;
+    uint16_t on = (led[1] & 0x0f) << 8 | led[0];
+    uint16_t off = (led[3] & 0x0f) << 8 | led[2];
+    uint16_t duty;
+    if (led[3] & LED_FULL)
+        duty = 0;
+    else if (led[1] & LED_FULL)
+        duty = 4096;
+    else
+        duty = (off - on) & 0x0fff;
+    i2c_mock_unlock(&s->dev);
+
+    return duty;
+}
+
+uint32_t sim_pca9685_freq(sim_pca9685_t *s)
+{
+    i2c_mock_lock(&s->dev);
+    uint32_t prescale = s->regs[REG_PRE_SCALE];
+    i2c_mock_unlock(&s->dev);
+
+    return OSC_HZ / (4096 * (prescale + 1));
+}
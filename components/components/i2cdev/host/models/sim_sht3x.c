@@ -0,0 +1,216 @@
+/**
+ * @file sim_sht3x.c
+ *
+ * SHT3x model for the simulated I2C bus
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "models.h"
+
+#define CMD_STATUS       0xf32d
+#define CMD_CLEAR_STATUS 0x3041
+#define CMD_RESET        0x30a2
+#define CMD_FETCH        0xe000
+#define CMD_STOP         0x3093
+#define CMD_HEATER_ON    0x306d
+#define CMD_HEATER_OFF   0x3066
+#define CMD_ART          0x2b32
+
+#define STATUS_ALERT    0x8000
+#define STATUS_HEATER   0x2000
+#define STATUS_RH_ALERT 0x0800
+#define STATUS_T_ALERT  0x0400
+#define STATUS_RESET    0x0010
+#define STATUS_CMD      0x0002
+
+// Maximum measurement durations, high, medium and low repeatability
+static const uint32_t meas_us[3] = { 15000, 6000, 4000 };
+
+static uint8_t crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0xff;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+static void put_word(sim_sht3x_t *s, uint16_t w)
+{
+    uint8_t *p = s->out + s->out_len;
+    p[0] = w >> 8;
+    p[1] = w;
+    p[2] = crc8(p, 2);
+    s->out_len += 3;
+}
+
+static void reset(sim_sht3x_t *s)
+{
+    s->status = STATUS_ALERT | STATUS_RESET;
+    s->periodic = false;
+    s->measuring = false;
+    s->has_data = false;
+    s->out_len = s->out_pos = 0;
+}
+
+static void update(sim_sht3x_t *s)
+{
+    uint64_t now = i2c_mock_time_us();
+    if (s->measuring && now >= s->start_us + s->meas_us)
+    {
+        s->measuring = false;
+        s->has_data = true;
+    }
+    if (s->periodic && now >= s->start_us + s->meas_us)
+    {
+        s->has_data = true;
+        s->start_us += (now - s->start_us - s->meas_us) / s->period_us * s->period_us + s->period_us;
+    }
+}
+
+// Repeatability from the low byte of measurement commands
+static int repeatability(uint16_t cmd)
+{
+    switch (cmd)
+    {
+        case 0x2400: case 0x2032: case 0x2130: case 0x2236: case 0x2334: case 0x2737:
+        case 0x2c06:
+            return 0;
+        case 0x240b: case 0x2024: case 0x2126: case 0x2220: case 0x2322: case 0x2721:
+        case 0x2c0d:
+            return 1;
+        case 0x2416: case 0x202f: case 0x212d: case 0x222b: case 0x2329: case 0x272a:
+        case 0x2c10:
+            return 2;
+    }
+    return -1;
+}
+
+static bool command(sim_sht3x_t *s, uint16_t cmd)
+{
+    s->out_len = s->out_pos = 0;
+
+    switch (cmd)
+    {
+        case CMD_FETCH:
+            if (s->has_data)
+            {
+                put_word(s, s->temp_raw);
+                put_word(s, s->hum_raw);
+                s->has_data = false;
+            }
+            return true;
+        case CMD_STOP:
+            s->periodic = false;
+            s->has_data = false;
+            return true;
+        case CMD_RESET:
+            reset(s);
+            return true;
+        case CMD_STATUS:
+            put_word(s, s->status);
+            return true;
+        case CMD_CLEAR_STATUS:
+            s->status &= ~(STATUS_ALERT | STATUS_RH_ALERT | STATUS_T_ALERT | STATUS_RESET);
+            return true;
+        case CMD_HEATER_ON:
+            s->status |= STATUS_HEATER;
+            return true;
+        case CMD_HEATER_OFF:
+            s->status &= ~STATUS_HEATER;
+            return true;
+    }
+
+    int rep = repeatability(cmd);
+    // Only stop command is accepted in periodic mode
+    if (rep < 0 || s->periodic)
+    {
+        s->status |= STATUS_CMD;
+        return false;
+    }
+    s->status &= ~STATUS_CMD;
+    s->meas_us = meas_us[rep];
+    s->start_us = i2c_mock_time_us();
+    s->has_data = false;
+    if ((cmd >> 8) == 0x24 || (cmd >> 8) == 0x2c)
+    {
+        s->measuring = true;
+        return true;
+    }
+    static const uint32_t periods_ms[8] = { 2000, 1000, 500, 250, 0, 0, 0, 100 };
+    s->period_us = periods_ms[(cmd >> 8) - 0x20] * 1000;
+    s->periodic = true;
+    return true;
+}
+
+static bool dev_start(i2c_mock_dev_t *dev, bool read)
+{
+    sim_sht3x_t *s = (sim_sht3x_t *)dev;
+    update(s);
+    if (s->measuring)
+        return false;
+    if (read)
+        return s->out_len > 0;
+    s->cmd_len = 0;
+    return true;
+}
+
+static bool dev_write(i2c_mock_dev_t *dev, uint8_t data)
+{
+    sim_sht3x_t *s = (sim_sht3x_t *)dev;
+    if (s->cmd_len == 2)
+        return false;
+    s->cmd[s->cmd_len++] = data;
+    if (s->cmd_len < 2)
+        return true;
+    return command(s, s->cmd[0] << 8 | s->cmd[1]);
+}
+
+static uint8_t dev_read(i2c_mock_dev_t *dev)
+{
+    sim_sht3x_t *s = (sim_sht3x_t *)dev;
+    return s->out_pos < s->out_len ? s->out[s->out_pos++] : 0xff;
+}
+
+static void dev_stop(i2c_mock_dev_t *dev)
+{
+    sim_sht3x_t *s = (sim_sht3x_t *)dev;
+    // Response is read only once
+    if (s->out_pos)
+        s->out_len = s->out_pos = 0;
+}
+
+static const i2c_mock_model_t model = {
+    .name = "sht3x",
+    .start = dev_start,
+    .write = dev_write,
+    .read = dev_read,
+    .stop = dev_stop,
+};
+
+void sim_sht3x_init(sim_sht3x_t *s, uint8_t addr)
+{
+    memset(s, 0, sizeof(sim_sht3x_t));
+    s->dev.model = &model;
+    s->dev.addr = addr;
+    reset(s);
+    s->temp_raw = 0x6666;   // 25 °C
+    s->hum_raw = 0x8000;    // 50 %
+}
+
+static uint16_t to_raw(float v)
+{
+    return v <= 0 ? 0 : v >= 65535 ? 65535 : (uint16_t)(v + 0.5f);
+}
+
+void sim_sht3x_set(sim_sht3x_t *s, float temperature, float humidity)
+{
+    i2c_mock_lock(&s->dev);
+    s->temp_raw = to_raw((temperature + 45) * 65535 / 175);
+    s->hum_raw = to_raw(humidity * 65535 / 100);
+    i2c_mock_unlock(&s->dev);
+}
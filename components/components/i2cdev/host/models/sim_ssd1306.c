@@ -0,0 +1,169 @@
+/**
+ * @file sim_ssd1306.c
+ *
+ * SSD1306 model for the simulated I2C bus
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "models.h"
+
+#define CONTROL_CO 0x80
+#define CONTROL_DC 0x40
+
+#define MODE_HORIZONTAL 0
+#define MODE_VERTICAL   1
+#define MODE_PAGE       2
+
+// Number of parameter bytes following command
+static uint8_t params(uint8_t cmd)
+{
+    switch (cmd)
+    {
+        case 0x20: case 0x81: case 0x8d: case 0xa8: case 0xd3:
+        case 0xd5: case 0xd9: case 0xda: case 0xdb:
+            return 1;
+        case 0x21: case 0x22: case 0xa3:
+            return 2;
+        case 0x29: case 0x2a:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+    }
+    return 0;
+}
+
+static void command(sim_ssd1306_t *s)
+{
+    uint8_t *c = s->cmd;
+    switch (c[0])
+    {
+        case 0x00 ... 0x0f:
+            s->col = (s->col & 0xf0) | (c[0] & 0x0f);
+            return;
+        case 0x10 ... 0x1f:
+            s->col = ((c[0] & 0x07) << 4) | (s->col & 0x0f);
+            return;
+        case 0x20:
+            s->addr_mode = c[1] & 3;
+            return;
+        case 0x21:
+            s->col = s->col_start = c[1] & 0x7f;
+            s->col_end = c[2] & 0x7f;
+            return;
+        case 0x22:
+            s->page = s->page_start = c[1] & 7;
+            s->page_end = c[2] & 7;
+            return;
+        case 0x81:
+            s->contrast = c[1];
+            return;
+        case 0xae:
+        case 0xaf:
+            s->on = c[0] & 1;
+            return;
+        case 0xb0 ... 0xb7:
+            s->page = c[0] & 7;
+            return;
+    }
+}
+
+static void data(sim_ssd1306_t *s, uint8_t b)
+{
+    s->ram[s->page][s->col] = b;
+    s->data_bytes++;
+
+    switch (s->addr_mode)
+    {
+        case MODE_HORIZONTAL:
+            if (s->col++ < s->col_end)
+                return;
+            s->col = s->col_start;
+            s->page = s->page < s->page_end ? s->page + 1 : s->page_start;
+            return;
+        case MODE_VERTICAL:
+            if (s->page++ < s->page_end)
+                return;
+            s->page = s->page_start;
+            s->col = s->col < s->col_end ? s->col + 1 : s->col_start;
+            return;
+        default:
+            // Page mode wraps within the page
+            s->col = (s->col + 1) % SIM_SSD1306_WIDTH;
+            return;
+    }
+}
+
+static bool dev_start(i2c_mock_dev_t *dev, bool read)
+{
+    sim_ssd1306_t *s = (sim_ssd1306_t *)dev;
+    s->control_next = true;
+    // Status read is not used by drivers
+    return !read;
+}
+
+static bool dev_write(i2c_mock_dev_t *dev, uint8_t b)
+{
+    sim_ssd1306_t *s = (sim_ssd1306_t *)dev;
+    if (s->control_next)
+    {
+        s->single = b & CONTROL_CO;
+        s->data = b & CONTROL_DC;
+        s->control_next = false;
+        return true;
+    }
+
+    if (s->data)
+        data(s, b);
+    else
+    {
+        if (!s->cmd_len)
+            s->cmd_need = params(b) + 1;
+        s->cmd[s->cmd_len++] = b;
+        if (s->cmd_len == s->cmd_need)
+        {
+            command(s);
+            s->cmd_len = 0;
+        }
+    }
+    if (s->single)
+        s->control_next = true;
+
+    return true;
+}
+
+static uint8_t dev_read(i2c_mock_dev_t *dev)
+{
+    (void)dev;
+    return 0xff;
+}
+
+static const i2c_mock_model_t model = {
+    .name = "ssd1306",
+    .start = dev_start,
+    .write = dev_write,
+    .read = dev_read,
+};
+
+void sim_ssd1306_init(sim_ssd1306_t *s, uint8_t addr)
+{
+    memset(s, 0, sizeof(sim_ssd1306_t));
+    s->dev.model = &model;
+    s->dev.addr = addr;
+    s->addr_mode = MODE_PAGE;
+    s->col_end = SIM_SSD1306_WIDTH - 1;
+    s->page_end = SIM_SSD1306_PAGES - 1;
+    s->contrast = 0x7f;
+}
+
+bool sim_ssd1306_pixel(sim_ssd1306_t *s, uint8_t x, uint8_t y)
+{
+    if (x >= SIM_SSD1306_WIDTH || y >= SIM_SSD1306_PAGES * 8)
+        return false;
+
+    i2c_mock_lock(&s->dev);
+    bool on = s->ram[y / 8][x] & (1 << (y % 8));
+    i2c_mock_unlock(&s->dev);
+
+    return on;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file spi_stub.c
+ *
+ * SPI master for host builds of drivers
+ *
+ * Just enough for drivers to link and run their I2C variants, there is no
+ * bus and everything fails.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <driver/spi_master.h>
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, int dma_chan)
+{
+    (void)host_id;
+    (void)bus_config;
+    (void)dma_chan;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id)
+{
+    (void)host_id;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config,
+        spi_device_handle_t *handle)
+{
+    (void)host_id;
+    (void)dev_config;
+    if (handle)
+        *handle = NULL;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    (void)handle;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    (void)handle;
+    (void)trans_desc;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    return spi_device_transmit(handle, trans_desc);
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    return spi_device_transmit(handle, trans_desc);
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, TickType_t ticks_to_wait)
+{
+    (void)handle;
+    (void)trans_desc;
+    (void)ticks_to_wait;
+    return ESP_ERR_NOT_SUPPORTED;
+}
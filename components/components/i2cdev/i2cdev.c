@@ -31,17 +31,83 @@
  * MIT Licensed as described in the file LICENSE
  */
 #include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include "i2cdev.h"
 
 static const char *TAG = "i2cdev";
 
+#if HELPER_TARGET_IS_ESP32 && (defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S2))
+// SCL of these chips is derived from APB clock by timing registers only,
+// so switching bus speed is just restoring saved timings
+#define SWITCH_TIMINGS 1
+#define TIMINGS_CACHE_SIZE 4
+
+typedef struct {
+    uint32_t clk_speed;
+    int high_period, low_period;
+    int start_setup, start_hold;
+    int stop_setup, stop_hold;
+    int sample_time, hold_time;
+} i2c_timings_t;
+#else
+#define SWITCH_TIMINGS 0
+#endif
+
+// Request to asynchronous worker, NULL device stops it
+typedef struct {
+    const i2c_dev_t *dev;
+    i2c_dev_op_t op;
+    i2c_dev_cb_t cb;
+    void *ctx;
+    int64_t submitted;          // Times are esp_timer microseconds
+    int64_t due;                // Valid when not blocked
+    bool blocked;               // Waits for earlier operation of the same device
+} async_req_t;
+
+// Completion time of the last operation of a device
+typedef struct {
+    const i2c_dev_t *dev;
+    int64_t us;
+} async_done_t;
+
+// Asynchronous worker state, allocated on heap to keep worker stack small
+typedef struct {
+    async_req_t pending[CONFIG_I2CDEV_ASYNC_QUEUE_SIZE];  // Received requests in order of submission
+    size_t pending_count;
+    async_done_t done[CONFIG_I2CDEV_ASYNC_QUEUE_SIZE];    // Recently completed devices
+    size_t done_count;
+    int64_t evicted;            // Latest completion forgotten by done[]
+} async_worker_t;
+
+struct i2c_dev_regcache {
+    size_t reg_size;
+    uint8_t cacheable[32];      // Bitmaps of 256 registers
+    uint8_t valid[32];
+    i2c_dev_regcache_stats_t stats;
+    size_t first;               // Shadowed registers, cacheable ones are always among them
+    size_t count;
+    uint8_t *data;              // Shadows, count * reg_size bytes
+};
+
 typedef struct {
     SemaphoreHandle_t lock;
     i2c_config_t config;
     bool installed;
+    QueueHandle_t async_queue;
+    SemaphoreHandle_t async_done;
+    async_worker_t *async_worker;
+    volatile bool async_running;
+#if SWITCH_TIMINGS
+    i2c_timings_t timings[TIMINGS_CACHE_SIZE];
+    uint8_t timings_count;
+    uint8_t timings_next;
+#endif
 } i2c_port_state_t;
 
 static i2c_port_state_t states[I2C_NUM_MAX];
@@ -89,10 +155,14 @@ esp_err_t i2cdev_init()
     return ESP_OK;
 }
 
+static void async_stop(i2c_port_t port);
+
 esp_err_t i2cdev_done()
 {
     for (int i = 0; i < I2C_NUM_MAX; i++)
     {
+        async_stop(i);
+
         if (!states[i].lock) continue;
 
         if (states[i].installed)
@@ -100,6 +170,9 @@ esp_err_t i2cdev_done()
             SEMAPHORE_TAKE(i);
             i2c_driver_delete(i);
             states[i].installed = false;
+#if SWITCH_TIMINGS
+            states[i].timings_count = 0;
+#endif
             SEMAPHORE_GIVE(i);
         }
 #if !CONFIG_I2CDEV_NOLOCK
@@ -112,9 +185,12 @@ esp_err_t i2cdev_done()
 
 esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev)
 {
-#if !CONFIG_I2CDEV_NOLOCK
     if (!dev) return ESP_ERR_INVALID_ARG;
 
+    // Drivers fill descriptors field by field, so pointer may be garbage
+    dev->regcache = NULL;
+
+#if !CONFIG_I2CDEV_NOLOCK
     ESP_LOGV(TAG, "[0x%02x at %d] creating mutex", dev->addr, dev->port);
 
     dev->mutex = xSemaphoreCreateMutex();
@@ -172,51 +248,129 @@ esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev)
     return ESP_OK;
 }
 
-inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
+// Bus parameters which need reconfiguration of pins
+inline static bool pins_equal(const i2c_config_t *a, const i2c_config_t *b)
 {
     return a->scl_io_num == b->scl_io_num
         && a->sda_io_num == b->sda_io_num
-#if HELPER_TARGET_IS_ESP32
-        && a->master.clk_speed == b->master.clk_speed
-#elif HELPER_TARGET_IS_ESP8266
+#if HELPER_TARGET_IS_ESP8266
         && a->clk_stretch_tick == b->clk_stretch_tick
 #endif
         && a->scl_pullup_en == b->scl_pullup_en
         && a->sda_pullup_en == b->sda_pullup_en;
 }
 
+inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
+{
+    return pins_equal(a, b)
+#if HELPER_TARGET_IS_ESP32
+        && a->master.clk_speed == b->master.clk_speed
+#endif
+        ;
+}
+
+#if SWITCH_TIMINGS
+
+static esp_err_t save_timings(i2c_port_t port, uint32_t clk_speed)
+{
+    i2c_port_state_t *state = &states[port];
+    for (uint8_t i = 0; i < state->timings_count; i++)
+        if (state->timings[i].clk_speed == clk_speed)
+            return ESP_OK;
+
+    i2c_timings_t *t = &state->timings[state->timings_next];
+    esp_err_t res;
+    if ((res = i2c_get_period(port, &t->high_period, &t->low_period)) != ESP_OK
+            || (res = i2c_get_start_timing(port, &t->start_setup, &t->start_hold)) != ESP_OK
+            || (res = i2c_get_stop_timing(port, &t->stop_setup, &t->stop_hold)) != ESP_OK
+            || (res = i2c_get_data_timing(port, &t->sample_time, &t->hold_time)) != ESP_OK)
+        return res;
+    t->clk_speed = clk_speed;
+
+    state->timings_next = (state->timings_next + 1) % TIMINGS_CACHE_SIZE;
+    if (state->timings_count < TIMINGS_CACHE_SIZE)
+        state->timings_count++;
+
+    return ESP_OK;
+}
+
+static const i2c_timings_t *find_timings(i2c_port_t port, uint32_t clk_speed)
+{
+    i2c_port_state_t *state = &states[port];
+    for (uint8_t i = 0; i < state->timings_count; i++)
+        if (state->timings[i].clk_speed == clk_speed)
+            return &state->timings[i];
+    return NULL;
+}
+
+static esp_err_t restore_timings(i2c_port_t port, const i2c_timings_t *t)
+{
+    esp_err_t res;
+    if ((res = i2c_set_period(port, t->high_period, t->low_period)) != ESP_OK
+            || (res = i2c_set_start_timing(port, t->start_setup, t->start_hold)) != ESP_OK
+            || (res = i2c_set_stop_timing(port, t->stop_setup, t->stop_hold)) != ESP_OK
+            || (res = i2c_set_data_timing(port, t->sample_time, t->hold_time)) != ESP_OK)
+        return res;
+    return ESP_OK;
+}
+
+#endif /* SWITCH_TIMINGS */
+
 static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
 {
     if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
 
     esp_err_t res;
-    if (!cfg_equal(&dev->cfg, &states[dev->port].config))
+    i2c_port_state_t *state = &states[dev->port];
+    if (!state->installed || !cfg_equal(&dev->cfg, &state->config))
     {
-        ESP_LOGD(TAG, "Reconfiguring I2C driver on port %d", dev->port);
         i2c_config_t temp;
         memcpy(&temp, &dev->cfg, sizeof(i2c_config_t));
         temp.mode = I2C_MODE_MASTER;
 
-        // Driver reinstallation
-        if (states[dev->port].installed)
-            i2c_driver_delete(dev->port);
+        // Driver is installed once per port, devices with different
+        // pins or speed only change its configuration
 #if HELPER_TARGET_IS_ESP32
-        if ((res = i2c_param_config(dev->port, &temp)) != ESP_OK)
-            return res;
-        if ((res = i2c_driver_install(dev->port, temp.mode, 0, 0, 0)) != ESP_OK)
-            return res;
+        if (state->installed && pins_equal(&temp, &state->config))
+        {
+            ESP_LOGD(TAG, "Switching clock speed on port %d to %" PRIu32 " Hz", dev->port, temp.master.clk_speed);
+#if SWITCH_TIMINGS
+            const i2c_timings_t *t = find_timings(dev->port, temp.master.clk_speed);
+            if (t)
+                res = restore_timings(dev->port, t);
+            else if ((res = i2c_param_config(dev->port, &temp)) == ESP_OK)
+                res = save_timings(dev->port, temp.master.clk_speed);
+#else
+            res = i2c_param_config(dev->port, &temp);
+#endif
+            if (res != ESP_OK)
+                return res;
+        }
+        else
+        {
+            ESP_LOGD(TAG, "Reconfiguring I2C driver on port %d", dev->port);
+            if ((res = i2c_param_config(dev->port, &temp)) != ESP_OK)
+                return res;
+            if (!state->installed && (res = i2c_driver_install(dev->port, temp.mode, 0, 0, 0)) != ESP_OK)
+                return res;
+#if SWITCH_TIMINGS
+            if ((res = save_timings(dev->port, temp.master.clk_speed)) != ESP_OK)
+                return res;
+#endif
+        }
 #endif
 #if HELPER_TARGET_IS_ESP8266
+        ESP_LOGD(TAG, "Reconfiguring I2C driver on port %d", dev->port);
         // Clock Stretch time, depending on CPU frequency
         temp.clk_stretch_tick = dev->timeout_ticks ? dev->timeout_ticks : I2CDEV_MAX_STRETCH_TIME;
-        if ((res = i2c_driver_install(dev->port, temp.mode)) != ESP_OK)
+        if (!state->installed && (res = i2c_driver_install(dev->port, temp.mode)) != ESP_OK)
             return res;
         if ((res = i2c_param_config(dev->port, &temp)) != ESP_OK)
             return res;
 #endif
-        states[dev->port].installed = true;
+        state->installed = true;
 
-        memcpy(&states[dev->port].config, &temp, sizeof(i2c_config_t));
+        memcpy(&state->config, &temp, sizeof(i2c_config_t));
         ESP_LOGD(TAG, "I2C driver successfully reconfigured on port %d", dev->port);
     }
 #if HELPER_TARGET_IS_ESP32
@@ -257,25 +411,235 @@ esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
     return res;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Register cache
+
+#define REG_BIT(map, reg) ((map)[(reg) >> 3] & (1 << ((reg) & 7)))
+#define REG_SET(map, reg) ((map)[(reg) >> 3] |= 1 << ((reg) & 7))
+#define REG_CLR(map, reg) ((map)[(reg) >> 3] &= ~(1 << ((reg) & 7)))
+
+// Transfer at one-byte register address, returns number of registers it
+// covers or 0 if it doesn't go through the cache
+static size_t regcache_span(const i2c_dev_t *dev, const void *reg, size_t reg_size, size_t size)
+{
+    i2c_dev_regcache_t *c = dev->regcache;
+    if (!c || !reg || reg_size != 1 || !size || size % c->reg_size)
+        return 0;
+    size_t count = size / c->reg_size;
+    return *(const uint8_t *)reg + count <= 256 ? count : 0;
+}
+
+// Called with port mutex taken
+static bool regcache_read(const i2c_dev_t *dev, uint8_t first, size_t count, void *data)
+{
+    i2c_dev_regcache_t *c = dev->regcache;
+    bool any = false, all = true;
+    for (size_t r = first; r < first + count; r++)
+    {
+        if (!REG_BIT(c->cacheable, r))
+            all = false;
+        else
+        {
+            any = true;
+            if (!REG_BIT(c->valid, r))
+                all = false;
+        }
+    }
+    if (all)
+    {
+        memcpy(data, c->data + (first - c->first) * c->reg_size, count * c->reg_size);
+        c->stats.saved++;
+    }
+    else if (any)
+        c->stats.misses++;
+
+    return all;
+}
+
+// Update shadows after successful transfer or invalidate them after failed one
+static void regcache_update(const i2c_dev_t *dev, uint8_t first, size_t count, const void *data, bool ok)
+{
+    i2c_dev_regcache_t *c = dev->regcache;
+    for (size_t r = first; r < first + count; r++)
+    {
+        if (!REG_BIT(c->cacheable, r))
+            continue;
+        if (ok)
+        {
+            memcpy(c->data + (r - c->first) * c->reg_size, (const uint8_t *)data + (r - first) * c->reg_size,
+                    c->reg_size);
+            REG_SET(c->valid, r);
+        }
+        else
+            REG_CLR(c->valid, r);
+    }
+}
+
+esp_err_t i2c_dev_create_regcache(i2c_dev_t *dev, size_t reg_size)
+{
+    if (!dev || !reg_size || reg_size > 4) return ESP_ERR_INVALID_ARG;
+
+    i2c_dev_delete_regcache(dev);
+
+    ESP_LOGV(TAG, "[0x%02x at %d] creating register cache", dev->addr, dev->port);
+
+    // Shadows are allocated when registers are marked cacheable
+    i2c_dev_regcache_t *c = calloc(1, sizeof(i2c_dev_regcache_t));
+    if (!c)
+    {
+        ESP_LOGE(TAG, "[0x%02x at %d] Could not create register cache", dev->addr, dev->port);
+        return ESP_ERR_NO_MEM;
+    }
+    c->reg_size = reg_size;
+    dev->regcache = c;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_delete_regcache(i2c_dev_t *dev)
+{
+    if (!dev) return ESP_ERR_INVALID_ARG;
+    if (!dev->regcache) return ESP_OK;
+
+    ESP_LOGD(TAG, "[0x%02x at %d] deleting register cache, %" PRIu32 " transactions saved",
+            dev->addr, dev->port, dev->regcache->stats.saved);
+
+    free(dev->regcache->data);
+    free(dev->regcache);
+    dev->regcache = NULL;
+
+    return ESP_OK;
+}
+
+// Extend shadows to cover registers, called with port mutex taken
+static esp_err_t regcache_extend(i2c_dev_regcache_t *c, size_t first, size_t count)
+{
+    size_t lo = first, hi = first + count;
+    if (c->count)
+    {
+        if (lo >= c->first && hi <= c->first + c->count)
+            return ESP_OK;
+        if (c->first < lo)
+            lo = c->first;
+        if (c->first + c->count > hi)
+            hi = c->first + c->count;
+    }
+
+    uint8_t *data = calloc(hi - lo, c->reg_size);
+    if (!data)
+        return ESP_ERR_NO_MEM;
+    if (c->count)
+        memcpy(data + (c->first - lo) * c->reg_size, c->data, c->count * c->reg_size);
+    free(c->data);
+    c->data = data;
+    c->first = lo;
+    c->count = hi - lo;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_regcache_mark(i2c_dev_t *dev, uint8_t first, size_t count, bool cacheable)
+{
+    if (!dev || !dev->regcache || first + count > 256) return ESP_ERR_INVALID_ARG;
+    if (!count) return ESP_OK;
+
+    i2c_dev_regcache_t *c = dev->regcache;
+
+    SEMAPHORE_TAKE(dev->port);
+    if (cacheable && regcache_extend(c, first, count) != ESP_OK)
+    {
+        SEMAPHORE_GIVE(dev->port);
+        ESP_LOGE(TAG, "[0x%02x at %d] Could not allocate register shadows", dev->addr, dev->port);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t r = first; r < first + count; r++)
+    {
+        if (cacheable)
+            REG_SET(c->cacheable, r);
+        else
+            REG_CLR(c->cacheable, r);
+        REG_CLR(c->valid, r);
+    }
+    SEMAPHORE_GIVE(dev->port);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_regcache_invalidate(const i2c_dev_t *dev, uint8_t first, size_t count)
+{
+    if (!dev || first + count > 256) return ESP_ERR_INVALID_ARG;
+    if (!dev->regcache) return ESP_OK;
+
+    SEMAPHORE_TAKE(dev->port);
+    for (size_t r = first; r < first + count; r++)
+        REG_CLR(dev->regcache->valid, r);
+    SEMAPHORE_GIVE(dev->port);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_regcache_get_stats(const i2c_dev_t *dev, i2c_dev_regcache_stats_t *stats, bool reset)
+{
+    if (!dev || !dev->regcache || !stats) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(dev->port);
+    *stats = dev->regcache->stats;
+    stats->shadow_size = dev->regcache->count * dev->regcache->reg_size;
+    if (reset)
+        memset(&dev->regcache->stats, 0, sizeof(i2c_dev_regcache_stats_t));
+    SEMAPHORE_GIVE(dev->port);
+
+    return ESP_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Command sequences without STOP, so that several of them can be
+// chained with repeated START in one command link
+
+static void cmd_read(i2c_cmd_handle_t cmd, const i2c_dev_t *dev, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size)
+{
+    if (out_data && out_size)
+    {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, dev->addr << 1, true);
+        i2c_master_write(cmd, (void *)out_data, out_size, true);
+    }
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (dev->addr << 1) | 1, true);
+    i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
+}
+
+static void cmd_write(i2c_cmd_handle_t cmd, const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size,
+        const void *out_data, size_t out_size)
+{
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, dev->addr << 1, true);
+    if (out_reg && out_reg_size)
+        i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
+    i2c_master_write(cmd, (void *)out_data, out_size, true);
+}
+
 esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
 {
     if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
 
+    size_t cached = regcache_span(dev, out_data, out_size, in_size);
+
     SEMAPHORE_TAKE(dev->port);
 
+    if (cached && regcache_read(dev, *(const uint8_t *)out_data, cached, in_data))
+    {
+        SEMAPHORE_GIVE(dev->port);
+        return ESP_OK;
+    }
+
     esp_err_t res = i2c_setup_port(dev);
     if (res == ESP_OK)
     {
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        if (out_data && out_size)
-        {
-            i2c_master_start(cmd);
-            i2c_master_write_byte(cmd, dev->addr << 1, true);
-            i2c_master_write(cmd, (void *)out_data, out_size, true);
-        }
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (dev->addr << 1) | 1, true);
-        i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
+        cmd_read(cmd, dev, out_data, out_size, in_data, in_size);
         i2c_master_stop(cmd);
 
         res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
@@ -284,6 +648,8 @@ esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_si
 
         i2c_cmd_link_delete(cmd);
     }
+    if (cached)
+        regcache_update(dev, *(const uint8_t *)out_data, cached, in_data, res == ESP_OK);
 
     SEMAPHORE_GIVE(dev->port);
     return res;
@@ -293,23 +659,23 @@ esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_re
 {
     if (!dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
 
+    size_t cached = regcache_span(dev, out_reg, out_reg_size, out_size);
+
     SEMAPHORE_TAKE(dev->port);
 
     esp_err_t res = i2c_setup_port(dev);
     if (res == ESP_OK)
     {
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, dev->addr << 1, true);
-        if (out_reg && out_reg_size)
-            i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
-        i2c_master_write(cmd, (void *)out_data, out_size, true);
+        cmd_write(cmd, dev, out_reg, out_reg_size, out_data, out_size);
         i2c_master_stop(cmd);
         res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
         if (res != ESP_OK)
             ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
         i2c_cmd_link_delete(cmd);
     }
+    if (cached)
+        regcache_update(dev, *(const uint8_t *)out_reg, cached, out_data, res == ESP_OK);
 
     SEMAPHORE_GIVE(dev->port);
     return res;
@@ -324,3 +690,415 @@ esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_d
 {
     return i2c_dev_write(dev, &reg, 1, out_data, out_size);
 }
+
+esp_err_t i2c_dev_batch_init(i2c_dev_batch_t *batch, i2c_port_t port, i2c_dev_segment_t *segments, size_t capacity)
+{
+    if (!batch || port >= I2C_NUM_MAX || !segments || !capacity) return ESP_ERR_INVALID_ARG;
+
+    batch->port = port;
+    batch->segments = segments;
+    batch->capacity = capacity;
+    batch->count = 0;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_batch_clear(i2c_dev_batch_t *batch)
+{
+    if (!batch) return ESP_ERR_INVALID_ARG;
+
+    batch->count = 0;
+
+    return ESP_OK;
+}
+
+static esp_err_t batch_add(i2c_dev_batch_t *batch, const i2c_dev_t *dev, i2c_dev_type_t type,
+        const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size)
+{
+    if (dev->port != batch->port) return ESP_ERR_INVALID_ARG;
+    if (batch->count >= batch->capacity) return ESP_ERR_NO_MEM;
+
+    i2c_dev_segment_t *seg = &batch->segments[batch->count++];
+    seg->dev = dev;
+    seg->type = type;
+    seg->out_reg = out_reg;
+    seg->out_reg_size = out_reg_size;
+    seg->out_data = out_data;
+    seg->out_size = out_size;
+    seg->in_data = in_data;
+    seg->in_size = in_size;
+    seg->result = ESP_ERR_INVALID_STATE;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_batch_read(i2c_dev_batch_t *batch, const i2c_dev_t *dev, const void *out_data,
+        size_t out_size, void *in_data, size_t in_size)
+{
+    if (!batch || !dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
+
+    return batch_add(batch, dev, I2C_DEV_READ, NULL, 0, out_data, out_size, in_data, in_size);
+}
+
+esp_err_t i2c_dev_batch_write(i2c_dev_batch_t *batch, const i2c_dev_t *dev, const void *out_reg,
+        size_t out_reg_size, const void *out_data, size_t out_size)
+{
+    if (!batch || !dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
+
+    return batch_add(batch, dev, I2C_DEV_WRITE, out_reg, out_reg_size, out_data, out_size, NULL, 0);
+}
+
+// Register address is kept in the segment itself, so it may be a temporary
+
+esp_err_t i2c_dev_batch_read_reg(i2c_dev_batch_t *batch, const i2c_dev_t *dev, uint8_t reg,
+        void *in_data, size_t in_size)
+{
+    esp_err_t res = i2c_dev_batch_read(batch, dev, NULL, 0, in_data, in_size);
+    if (res != ESP_OK) return res;
+
+    i2c_dev_segment_t *seg = &batch->segments[batch->count - 1];
+    seg->reg = reg;
+    seg->out_data = &seg->reg;
+    seg->out_size = 1;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_batch_write_reg(i2c_dev_batch_t *batch, const i2c_dev_t *dev, uint8_t reg,
+        const void *out_data, size_t out_size)
+{
+    esp_err_t res = i2c_dev_batch_write(batch, dev, NULL, 0, out_data, out_size);
+    if (res != ESP_OK) return res;
+
+    i2c_dev_segment_t *seg = &batch->segments[batch->count - 1];
+    seg->reg = reg;
+    seg->out_reg = &seg->reg;
+    seg->out_reg_size = 1;
+
+    return ESP_OK;
+}
+
+// Segments [first, last) share bus configuration, run them as one command link
+static esp_err_t batch_submit(i2c_dev_batch_t *batch, size_t first, size_t last)
+{
+    i2c_dev_segment_t *seg = batch->segments;
+
+    esp_err_t res = i2c_setup_port(seg[first].dev);
+    if (res == ESP_OK)
+    {
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+        for (size_t i = first; i < last; i++)
+        {
+            if (seg[i].type == I2C_DEV_READ)
+                cmd_read(cmd, seg[i].dev, seg[i].out_data, seg[i].out_size, seg[i].in_data, seg[i].in_size);
+            else
+                cmd_write(cmd, seg[i].dev, seg[i].out_reg, seg[i].out_reg_size, seg[i].out_data, seg[i].out_size);
+        }
+        i2c_master_stop(cmd);
+
+        res = i2c_master_cmd_begin(batch->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        if (res != ESP_OK)
+            ESP_LOGE(TAG, "Could not run %d segments from device [0x%02x at %d]: %d (%s)", (int)(last - first),
+                    seg[first].dev->addr, batch->port, res, esp_err_to_name(res));
+
+        i2c_cmd_link_delete(cmd);
+    }
+
+    for (size_t i = first; i < last; i++)
+    {
+        seg[i].result = res;
+
+        // Segments always go to the bus but keep register cache coherent
+        size_t cached;
+        if (seg[i].type == I2C_DEV_READ)
+        {
+            if ((cached = regcache_span(seg[i].dev, seg[i].out_data, seg[i].out_size, seg[i].in_size)))
+                regcache_update(seg[i].dev, *(const uint8_t *)seg[i].out_data, cached, seg[i].in_data, res == ESP_OK);
+        }
+        else if ((cached = regcache_span(seg[i].dev, seg[i].out_reg, seg[i].out_reg_size, seg[i].out_size)))
+            regcache_update(seg[i].dev, *(const uint8_t *)seg[i].out_reg, cached, seg[i].out_data, res == ESP_OK);
+    }
+
+    return res;
+}
+
+esp_err_t i2c_dev_batch_run(i2c_dev_batch_t *batch)
+{
+    if (!batch) return ESP_ERR_INVALID_ARG;
+    if (!batch->count) return ESP_OK;
+
+    i2c_dev_segment_t *seg = batch->segments;
+    esp_err_t res = ESP_OK;
+
+    SEMAPHORE_TAKE(batch->port);
+
+    size_t first = 0;
+    while (first < batch->count)
+    {
+        // Consecutive segments of devices with the same bus settings go to one submission.
+        // Devices commit writes on STOP, so a write ends the submission
+        size_t last = first + 1;
+        while (last < batch->count
+                && seg[last - 1].type != I2C_DEV_WRITE
+                && cfg_equal(&seg[last].dev->cfg, &seg[first].dev->cfg)
+                && seg[last].dev->timeout_ticks == seg[first].dev->timeout_ticks)
+            last++;
+
+        esp_err_t r = batch_submit(batch, first, last);
+        if (r != ESP_OK && res == ESP_OK)
+            res = r;
+
+        first = last;
+    }
+
+    SEMAPHORE_GIVE(batch->port);
+
+    return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Asynchronous operations
+
+static void async_run(async_req_t *req)
+{
+    const i2c_dev_op_t *op = &req->op;
+    esp_err_t res = op->type == I2C_DEV_READ
+        ? i2c_dev_read(req->dev, op->out_data, op->out_size, op->in_data, op->in_size)
+        : i2c_dev_write(req->dev, op->out_reg, op->out_reg_size, op->out_data, op->out_size);
+    if (req->cb)
+        req->cb(req->dev, res, req->ctx);
+}
+
+static inline int64_t time_max(int64_t a, int64_t b)
+{
+    return a > b ? a : b;
+}
+
+// Delay of an operation counts from completion of the previous operation of its device
+static void async_set_due(async_req_t *req, int64_t prev_done)
+{
+    req->due = time_max(req->submitted, prev_done) + (int64_t)req->op.delay_ms * 1000;
+    req->blocked = false;
+}
+
+// Ticks to block until time is reached, rounded up. Blocking ends on a
+// tick boundary and may end up to a tick early, the worker checks time again
+static TickType_t ticks_until(int64_t due, int64_t now)
+{
+    int64_t tick_us = 1000000 / configTICK_RATE_HZ;
+    return (TickType_t)((due - now + tick_us - 1) / tick_us);
+}
+
+static void async_received(async_worker_t *w, async_req_t *req)
+{
+    for (size_t i = 0; i < w->pending_count; i++)
+        if (w->pending[i].dev == req->dev)
+        {
+            req->blocked = true;
+            w->pending[w->pending_count++] = *req;
+            return;
+        }
+
+    // Devices missing in done[] completed no later than the evicted ones
+    int64_t prev_done = w->evicted;
+    for (size_t i = 0; i < w->done_count; i++)
+        if (w->done[i].dev == req->dev)
+            prev_done = w->done[i].us;
+    async_set_due(req, prev_done);
+    w->pending[w->pending_count++] = *req;
+}
+
+static void async_completed(async_worker_t *w, const i2c_dev_t *dev, int64_t now)
+{
+    // Next operation of the device, if it is already received
+    for (size_t i = 0; i < w->pending_count; i++)
+        if (w->pending[i].dev == dev)
+        {
+            async_set_due(&w->pending[i], now);
+            break;
+        }
+
+    // Remember completion for operations still in the queue, replace the oldest one if full
+    size_t slot = w->done_count;
+    for (size_t i = 0; i < w->done_count; i++)
+        if (w->done[i].dev == dev)
+        {
+            slot = i;
+            break;
+        }
+    if (slot == CONFIG_I2CDEV_ASYNC_QUEUE_SIZE)
+    {
+        slot = 0;
+        for (size_t i = 1; i < w->done_count; i++)
+            if (w->done[i].us < w->done[slot].us)
+                slot = i;
+        w->evicted = time_max(w->evicted, w->done[slot].us);
+    }
+    else if (slot == w->done_count)
+        w->done_count++;
+    w->done[slot].dev = dev;
+    w->done[slot].us = now;
+}
+
+static void async_worker(void *arg)
+{
+    i2c_port_state_t *state = &states[(intptr_t)arg];
+    async_worker_t *w = state->async_worker;
+    async_req_t req;
+
+    while (true)
+    {
+        // Run due requests, earliest first, and find when the next one is due
+        TickType_t wait;
+        while (true)
+        {
+            int64_t now = esp_timer_get_time();
+            size_t next = w->pending_count;
+            for (size_t i = 0; i < w->pending_count; i++)
+                if (!w->pending[i].blocked
+                        && (next == w->pending_count || w->pending[i].due < w->pending[next].due))
+                    next = i;
+            if (next == w->pending_count)
+            {
+                wait = portMAX_DELAY;
+                break;
+            }
+            if (w->pending[next].due > now)
+            {
+                wait = ticks_until(w->pending[next].due, now);
+                break;
+            }
+            // Keep order of submission, it decides which operation of a device is next
+            req = w->pending[next];
+            w->pending_count--;
+            memmove(&w->pending[next], &w->pending[next + 1], (w->pending_count - next) * sizeof(async_req_t));
+            async_run(&req);
+            async_completed(w, req.dev, esp_timer_get_time());
+        }
+
+        if (w->pending_count == CONFIG_I2CDEV_ASYNC_QUEUE_SIZE)
+        {
+            // No room for new requests until some pending ones are done
+            vTaskDelay(wait);
+            continue;
+        }
+
+        if (xQueueReceive(state->async_queue, &req, wait) != pdTRUE)
+            continue;
+        if (!req.dev)
+            break;
+        async_received(w, &req);
+    }
+
+    for (size_t i = 0; i < w->pending_count; i++)
+        if (w->pending[i].cb)
+            w->pending[i].cb(w->pending[i].dev, ESP_ERR_INVALID_STATE, w->pending[i].ctx);
+
+    xSemaphoreGive(state->async_done);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t async_start(i2c_port_t port)
+{
+    i2c_port_state_t *state = &states[port];
+
+    if (!state->async_queue)
+    {
+        state->async_queue = xQueueCreate(CONFIG_I2CDEV_ASYNC_QUEUE_SIZE, sizeof(async_req_t));
+        if (!state->async_queue)
+        {
+            ESP_LOGE(TAG, "Could not create async queue on port %d", port);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (!state->async_done)
+    {
+        state->async_done = xSemaphoreCreateBinary();
+        if (!state->async_done)
+        {
+            ESP_LOGE(TAG, "Could not create async semaphore on port %d", port);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // Previous worker is stopped, its state is reused
+    if (!state->async_worker)
+    {
+        state->async_worker = malloc(sizeof(async_worker_t));
+        if (!state->async_worker)
+        {
+            ESP_LOGE(TAG, "Could not allocate async worker on port %d", port);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    memset(state->async_worker, 0, sizeof(async_worker_t));
+    state->async_worker->evicted = esp_timer_get_time();
+
+    state->async_running = true;
+    if (xTaskCreate(async_worker, "i2cdev_async", CONFIG_I2CDEV_ASYNC_STACK_SIZE, (void *)(intptr_t)port,
+            CONFIG_I2CDEV_ASYNC_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Could not create async worker on port %d", port);
+        state->async_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+static void async_stop(i2c_port_t port)
+{
+    i2c_port_state_t *state = &states[port];
+
+    if (state->async_running)
+    {
+        async_req_t req = { 0 };
+        xQueueSend(state->async_queue, &req, portMAX_DELAY);
+        xSemaphoreTake(state->async_done, portMAX_DELAY);
+        state->async_running = false;
+    }
+    if (state->async_queue)
+    {
+        vQueueDelete(state->async_queue);
+        state->async_queue = NULL;
+    }
+    if (state->async_done)
+    {
+        vSemaphoreDelete(state->async_done);
+        state->async_done = NULL;
+    }
+    free(state->async_worker);
+    state->async_worker = NULL;
+}
+
+esp_err_t i2c_dev_submit(const i2c_dev_t *dev, const i2c_dev_op_t *op, i2c_dev_cb_t cb, void *ctx)
+{
+    if (!dev || !op || dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    if (op->type == I2C_DEV_READ && (!op->in_data || !op->in_size)) return ESP_ERR_INVALID_ARG;
+    if (op->type == I2C_DEV_WRITE && (!op->out_data || !op->out_size)) return ESP_ERR_INVALID_ARG;
+
+    // Worker is started under port lock, so it is started once
+    i2c_port_state_t *state = &states[dev->port];
+    SEMAPHORE_TAKE(dev->port);
+    esp_err_t res = state->async_running ? ESP_OK : async_start(dev->port);
+    SEMAPHORE_GIVE(dev->port);
+    if (res != ESP_OK)
+        return res;
+
+    async_req_t req = {
+        .dev = dev,
+        .op = *op,
+        .cb = cb,
+        .ctx = ctx,
+        .submitted = esp_timer_get_time(),
+    };
+    if (xQueueSend(state->async_queue, &req, 0) != pdTRUE)
+    {
+        ESP_LOGW(TAG, "[0x%02x at %d] Async queue is full", dev->addr, dev->port);
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
@@ -28,6 +28,11 @@
  *
  * ESP-IDF I2C master thread-safe functions for communication with I2C slave
  *
+ * I2C driver is installed once per port. Devices on the same port may use
+ * different clock speeds: when the speed changes, only bus timing is
+ * switched (ESP32 and ESP32-S2 restore cached timing registers, other
+ * targets reconfigure the port), driver is never reinstalled.
+ *
  * Copyright (c) 2018 Ruslan V. Uss <unclerus@gmail.com>
  *
  * MIT Licensed as described in the file LICENSE
@@ -35,6 +40,7 @@
 #ifndef __I2CDEV_H__
 #define __I2CDEV_H__
 
+#include <stdbool.h>
 #include <driver/i2c.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
@@ -62,6 +68,11 @@ extern "C" {
 
 #endif /* HELPER_TARGET_IS_ESP8266 */
 
+/**
+ * Register cache, see ::i2c_dev_create_regcache()
+ */
+typedef struct i2c_dev_regcache i2c_dev_regcache_t;
+
 /**
  * I2C device descriptor
  */
@@ -74,6 +85,7 @@ typedef struct
     uint32_t timeout_ticks;  /*!< HW I2C bus timeout (stretch time), in ticks. 80MHz APB clock
                                   ticks for ESP-IDF, CPU ticks for ESP8266.
                                   When this value is 0, I2CDEV_MAX_STRETCH_TIME will be used */
+    i2c_dev_regcache_t *regcache; //!< Register cache, NULL if not used
 } i2c_dev_t;
 
 /**
@@ -97,7 +109,7 @@ esp_err_t i2cdev_init();
 /**
  * @brief Finish work with library
  *
- * Uninstall i2c drivers.
+ * Stop asynchronous workers and uninstall i2c drivers.
  *
  * @return ESP_OK on success
  */
@@ -106,7 +118,9 @@ esp_err_t i2cdev_done();
 /**
  * @brief Create mutex for device descriptor
  *
- * This function does nothing if option CONFIG_I2CDEV_NOLOCK is enabled.
+ * Also clears register cache pointer of the descriptor, so it must be
+ * called before ::i2c_dev_create_regcache(). Mutex is not created if
+ * option CONFIG_I2CDEV_NOLOCK is enabled.
  *
  * @param dev Device descriptor
  * @return ESP_OK on success
@@ -215,6 +229,289 @@ esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg,
 esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg,
         const void *out_data, size_t out_size);
 
+/**
+ * Register cache statistics
+ */
+typedef struct
+{
+    uint32_t saved;          //!< Reads served from cache, i.e. bus transactions saved
+    uint32_t misses;         //!< Reads of cacheable registers which went to the bus
+    uint32_t shadow_size;    //!< Bytes of register shadows, not reset
+} i2c_dev_regcache_stats_t;
+
+/**
+ * @brief Create register cache for device descriptor
+ *
+ * Cache keeps shadow copies of registers with 8-bit addresses, from the
+ * lowest to the highest register ever marked cacheable. Reads
+ * of cacheable registers with a valid shadow are served from cache
+ * without bus transaction, writes go to the device and update shadows
+ * (write-through). All registers are volatile, i.e. not cached, until
+ * marked with ::i2c_dev_regcache_mark().
+ *
+ * Only ::i2c_dev_read() and ::i2c_dev_write() with a one-byte register
+ * address (and thus *_reg() shortcuts and asynchronous operations) use
+ * the cache. Batch segments always go to the bus, but update shadows.
+ * Transfers of several registers assume address auto-increment.
+ * Call it after ::i2c_dev_create_mutex(). Existing cache of the
+ * descriptor is deleted first.
+ *
+ * Cache is meant for configuration registers of drivers doing
+ * read-modify-write, it must not be used for registers changed by the
+ * device itself.
+ *
+ * @param dev Device descriptor
+ * @param reg_size Register size in bytes, 1..4
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_create_regcache(i2c_dev_t *dev, size_t reg_size);
+
+/**
+ * @brief Delete register cache of device descriptor
+ *
+ * Does nothing if device has no cache.
+ *
+ * @param dev Device descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_delete_regcache(i2c_dev_t *dev);
+
+/**
+ * @brief Mark registers cacheable or volatile
+ *
+ * Shadows of marked registers are invalidated, so the next read of a
+ * cacheable register goes to the bus. Marking registers cacheable
+ * extends shadows to cover them, keep cacheable registers close.
+ *
+ * @param dev Device descriptor with register cache
+ * @param first First register address
+ * @param count Number of registers
+ * @param cacheable true to cache registers, false to mark them volatile
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if shadows could not be extended
+ */
+esp_err_t i2c_dev_regcache_mark(i2c_dev_t *dev, uint8_t first, size_t count, bool cacheable);
+
+/**
+ * @brief Invalidate register shadows
+ *
+ * Call it when device changed registers by itself, e.g. after reset or
+ * for reading a status bit of a cacheable register. Does nothing if
+ * device has no cache.
+ *
+ * @param dev Device descriptor
+ * @param first First register address
+ * @param count Number of registers
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_regcache_invalidate(const i2c_dev_t *dev, uint8_t first, size_t count);
+
+/**
+ * @brief Get register cache statistics
+ *
+ * @param dev Device descriptor with register cache
+ * @param[out] stats Statistics
+ * @param reset Reset statistics after reading
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_regcache_get_stats(const i2c_dev_t *dev, i2c_dev_regcache_stats_t *stats, bool reset);
+
+/**
+ * Segment of batch transaction, filled by ::i2c_dev_batch_read() and
+ * ::i2c_dev_batch_write() and friends
+ */
+typedef struct
+{
+    const i2c_dev_t *dev;    //!< Device descriptor
+    i2c_dev_type_t type;     //!< Segment type
+    const void *out_reg;     //!< Register address to send before write data, may be NULL
+    size_t out_reg_size;     //!< Size of register address
+    const void *out_data;    //!< Data to send, may be NULL for reads
+    size_t out_size;         //!< Size of data to send
+    void *in_data;           //!< Input buffer for reads
+    size_t in_size;          //!< Number of bytes to read
+    uint8_t reg;             //!< Storage of register address for *_reg() functions
+    esp_err_t result;        //!< Result of the submission this segment was part of
+} i2c_dev_segment_t;
+
+/**
+ * Batch transaction: list of read and write segments of devices on one port
+ *
+ * Segments are stored in caller-provided array. Batch may be run any
+ * number of times, e.g. to poll the same set of sensors periodically.
+ */
+typedef struct
+{
+    i2c_port_t port;             //!< I2C port number
+    i2c_dev_segment_t *segments; //!< Segments array
+    size_t capacity;             //!< Size of segments array
+    size_t count;                //!< Number of segments in batch
+} i2c_dev_batch_t;
+
+/**
+ * @brief Init empty batch transaction
+ *
+ * @param batch Batch descriptor
+ * @param port I2C port number, all devices in batch must be on this port
+ * @param segments Array for segments, must live as long as the batch
+ * @param capacity Size of segments array
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_batch_init(i2c_dev_batch_t *batch, i2c_port_t port, i2c_dev_segment_t *segments, size_t capacity);
+
+/**
+ * @brief Remove all segments from batch transaction
+ *
+ * @param batch Batch descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_batch_clear(i2c_dev_batch_t *batch);
+
+/**
+ * @brief Add read segment to batch transaction
+ *
+ * Same as ::i2c_dev_read(), but nothing is sent until ::i2c_dev_batch_run().
+ * Unlike a write, the segment may end with repeated START of the next read
+ * segment instead of STOP.
+ * Buffers must stay valid until then.
+ *
+ * @param batch Batch descriptor
+ * @param dev Device descriptor
+ * @param out_data Pointer to data to send if non-null
+ * @param out_size Size of data to send
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if batch is full
+ */
+esp_err_t i2c_dev_batch_read(i2c_dev_batch_t *batch, const i2c_dev_t *dev, const void *out_data,
+        size_t out_size, void *in_data, size_t in_size);
+
+/**
+ * @brief Add write segment to batch transaction
+ *
+ * Same as ::i2c_dev_write(), but nothing is sent until ::i2c_dev_batch_run().
+ * Buffers must stay valid until then.
+ *
+ * @param batch Batch descriptor
+ * @param dev Device descriptor
+ * @param out_reg Pointer to register address to send if non-null
+ * @param out_reg_size Size of register address
+ * @param out_data Pointer to data to send
+ * @param out_size Size of data to send
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if batch is full
+ */
+esp_err_t i2c_dev_batch_write(i2c_dev_batch_t *batch, const i2c_dev_t *dev, const void *out_reg,
+        size_t out_reg_size, const void *out_data, size_t out_size);
+
+/**
+ * @brief Add read from register with an 8-bit address to batch transaction
+ *
+ * Shortcut to ::i2c_dev_batch_read(), register address is stored in segment.
+ *
+ * @param batch Batch descriptor
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if batch is full
+ */
+esp_err_t i2c_dev_batch_read_reg(i2c_dev_batch_t *batch, const i2c_dev_t *dev, uint8_t reg,
+        void *in_data, size_t in_size);
+
+/**
+ * @brief Add write to register with an 8-bit address to batch transaction
+ *
+ * Shortcut to ::i2c_dev_batch_write(), register address is stored in segment.
+ *
+ * @param batch Batch descriptor
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param out_data Pointer to data to send
+ * @param out_size Size of data to send
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if batch is full
+ */
+esp_err_t i2c_dev_batch_write_reg(i2c_dev_batch_t *batch, const i2c_dev_t *dev, uint8_t reg,
+        const void *out_data, size_t out_size);
+
+/**
+ * @brief Run batch transaction
+ *
+ * Port mutex is taken once for the whole batch. Consecutive segments of
+ * devices with the same bus configuration are chained with repeated
+ * START into one command link and submitted to the driver at once, with
+ * a single STOP at the end. A write segment ends its submission with
+ * STOP like ::i2c_dev_write(), as devices commit writes on STOP (EEPROM
+ * write cycles, measurement commands), so only reads are chained after
+ * each other. Device changing bus configuration starts a new submission.
+ *
+ * Result of every submission is stored in ::i2c_dev_segment_t::result
+ * of its segments, so when a submission fails (e.g. one of devices
+ * doesn't acknowledge), all its segments report the error. Put segments
+ * whose failures must be told apart into separate batches.
+ *
+ * Device mutexes are not taken.
+ *
+ * @param batch Batch descriptor
+ * @return ESP_OK if all segments succeeded, first error otherwise
+ */
+esp_err_t i2c_dev_batch_run(i2c_dev_batch_t *batch);
+
+/**
+ * Asynchronous operation, see ::i2c_dev_submit()
+ */
+typedef struct
+{
+    i2c_dev_type_t type;     //!< Operation type
+    const void *out_reg;     //!< Register address to send before write data, may be NULL
+    size_t out_reg_size;     //!< Size of register address
+    const void *out_data;    //!< Data to send, for reads it is sent before reading and may be NULL
+    size_t out_size;         //!< Size of data to send
+    void *in_data;           //!< Input buffer for reads
+    size_t in_size;          //!< Number of bytes to read
+    uint32_t delay_ms;       //!< Don't start operation earlier than this after submission and after
+                             //!< completion of the previous operation of the device
+} i2c_dev_op_t;
+
+/**
+ * Completion callback of asynchronous operation
+ *
+ * Called from the port worker task. It should return quickly, other
+ * operations on the port wait for it. It may submit new operations.
+ *
+ * @param dev Device descriptor
+ * @param res Result of operation, ESP_ERR_INVALID_STATE if it was
+ *            cancelled by ::i2cdev_done()
+ * @param ctx Context passed to ::i2c_dev_submit()
+ */
+typedef void (*i2c_dev_cb_t)(const i2c_dev_t *dev, esp_err_t res, void *ctx);
+
+/**
+ * @brief Submit asynchronous operation
+ *
+ * Operation is queued and the function returns immediately. Each port
+ * has a worker task (created on first submission) which runs queued
+ * operations in order with ::i2c_dev_read() or ::i2c_dev_write() and
+ * calls \p cb on completion. Operations of a device run in order of
+ * submission. Operations with a delay, e.g. reading results after a
+ * sensor conversion time, wait without blocking operations of other
+ * devices on the port; the delay counts from completion of the previous
+ * operation of the same device, so a measurement command and a delayed
+ * read may be submitted together. Delays are timed with esp_timer, not
+ * rounded to ticks: an operation never starts early and starts at most
+ * about one tick period late.
+ *
+ * Operation descriptor is copied, data buffers must stay valid until
+ * the callback is called.
+ *
+ * Queue length, worker priority and stack size are set in menuconfig.
+ *
+ * @param dev Device descriptor
+ * @param op Operation
+ * @param cb Completion callback, may be NULL
+ * @param ctx Callback context
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if queue is full
+ */
+esp_err_t i2c_dev_submit(const i2c_dev_t *dev, const i2c_dev_op_t *op, i2c_dev_cb_t cb, void *ctx);
+
 #define I2C_DEV_TAKE_MUTEX(dev) do { \
         esp_err_t __ = i2c_dev_take_mutex(dev); \
         if (__ != ESP_OK) return __;\
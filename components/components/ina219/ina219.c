@@ -130,13 +130,28 @@ esp_err_t ina219_init_desc(ina219_t *dev, uint8_t addr, i2c_port_t port, gpio_nu
     dev->i2c_dev.cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
 
-    return i2c_dev_create_mutex(&dev->i2c_dev);
+    CHECK(i2c_dev_create_mutex(&dev->i2c_dev));
+
+    // Measurement registers are volatile
+    esp_err_t res = i2c_dev_create_regcache(&dev->i2c_dev, 2);
+    if (res == ESP_OK)
+        res = i2c_dev_regcache_mark(&dev->i2c_dev, REG_CONFIG, 1, true);
+    if (res == ESP_OK)
+        res = i2c_dev_regcache_mark(&dev->i2c_dev, REG_CALIBRATION, 1, true);
+    if (res != ESP_OK)
+    {
+        i2c_dev_delete_regcache(&dev->i2c_dev);
+        i2c_dev_delete_mutex(&dev->i2c_dev);
+    }
+
+    return res;
 }
 
 esp_err_t ina219_free_desc(ina219_t *dev)
 {
     CHECK_ARG(dev);
 
+    CHECK(i2c_dev_delete_regcache(&dev->i2c_dev));
     return i2c_dev_delete_mutex(&dev->i2c_dev);
 }
 
@@ -155,6 +170,8 @@ esp_err_t ina219_reset(ina219_t *dev)
 {
     CHECK_ARG(dev);
     CHECK(write_reg_16(dev, REG_CONFIG, 1 << BIT_RST));
+    // Reset bit clears itself and registers get their defaults
+    CHECK(i2c_dev_regcache_invalidate(&dev->i2c_dev, 0, 256));
 
     dev->config = DEF_CONFIG;
 
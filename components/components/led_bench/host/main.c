@@ -0,0 +1,20 @@
+/**
+ * @file main.c
+ *
+ * Host runner of led_bench
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <led_bench.h>
+
+int main(int argc, char **argv)
+{
+    uint32_t repeat = argc > 1 ? strtoul(argv[1], NULL, 0) : 20;
+
+    esp_err_t res = led_bench_verify();
+    led_bench_run(repeat, NULL, NULL);
+
+    return res == ESP_OK ? 0 : 1;
+}
@@ -0,0 +1,694 @@
+/**
+ * @file led_bench.c
+ *
+ * Microbenchmarks and equivalence checks of lib8tion and color
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <lib8tion.h>
+#include <color.h>
+#include <noise.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "led_bench.h"
+#include "led_bench_priv.h"
+
+const char *const led_bench_unit = LED_BENCH_UNIT;
+
+static volatile uint32_t sink;
+
+uint32_t lcg_state = 1;
+
+static inline uint32_t hsv_to_code(hsv_t c)
+{
+    return ((uint32_t)c.h << 16) | ((uint32_t)c.s << 8) | c.v;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmarks
+
+// Sweep of 2^16 calls, inputs are i (16 bit), a (high byte) and b (low byte).
+// Every result goes to volatile sink, so compiler can neither drop calls nor
+// merge them into a vectorized or closed form sum.
+#define SWEEP(NAME, EXPR) \
+    static uint32_t NAME(void) \
+    { \
+        for (uint32_t i = 0; i < SWEEP_CALLS; i++) \
+        { \
+            uint8_t a = i >> 8, b = i; \
+            (void)a; (void)b; \
+            sink = (EXPR); \
+        } \
+        return 0; \
+    }
+
+SWEEP(b_base, a ^ b)
+SWEEP(b_scale8, scale8(a, b))
+SWEEP(b_scale8_video, scale8_video(a, b))
+SWEEP(b_scale16, scale16(i, i * 7))
+SWEEP(b_qadd8, qadd8(a, b))
+SWEEP(b_qsub8, qsub8(a, b))
+SWEEP(b_avg8, avg8(a, b))
+SWEEP(b_blend8, blend8(a, b, a ^ b))
+SWEEP(b_lerp8by8, lerp8by8(a, b, a ^ b))
+SWEEP(b_lerp16by16, lerp16by16(i, ~i, i * 13))
+SWEEP(b_map8, map8(a ^ b, 10, 200))
+SWEEP(b_dim8_video, dim8_video(a ^ b))
+SWEEP(b_ease8InOutCubic, ease8InOutCubic(a ^ b))
+SWEEP(b_cubicwave8, cubicwave8(a ^ b))
+SWEEP(b_sin8, sin8(a ^ b))
+SWEEP(b_cos8, cos8(a ^ b))
+SWEEP(b_sin16, sin16(i))
+SWEEP(b_sqrt16, sqrt16(i))
+SWEEP(b_random8, random8())
+SWEEP(b_random16, random16())
+SWEEP(b_rgb_blend, rgb_to_code(rgb_blend(rgb_from_values(a, b, a), rgb_from_values(b, a, b), a ^ b)))
+SWEEP(b_hsv2rgb_rainbow, rgb_to_code(hsv2rgb_rainbow(hsv_from_values(a, b, a ^ b))))
+SWEEP(b_hsv2rgb_spectrum, rgb_to_code(hsv2rgb_spectrum(hsv_from_values(a, b, a ^ b))))
+SWEEP(b_hsv2rgb_raw, rgb_to_code(hsv2rgb_raw(hsv_from_values(a, b, a ^ b))))
+SWEEP(b_apply_gamma2rgb, rgb_to_code(apply_gamma2rgb(rgb_from_values(a, b, a ^ b), 2.2f)))
+SWEEP(b_rgb2hsv_approximate, hsv_to_code(rgb2hsv_approximate(rgb_from_values(a, b, a ^ b))))
+SWEEP(b_rgb2hsv_rainbow, hsv_to_code(rgb2hsv_rainbow(rgb_from_values(a, b, a ^ b))))
+
+const rgb_t bench_palette[16] = {
+    { .r = 0x00, .g = 0x00, .b = 0x00 }, { .r = 0x80, .g = 0x00, .b = 0x00 },
+    { .r = 0xff, .g = 0x00, .b = 0x00 }, { .r = 0xff, .g = 0x80, .b = 0x00 },
+    { .r = 0xff, .g = 0xff, .b = 0x00 }, { .r = 0x80, .g = 0xff, .b = 0x00 },
+    { .r = 0x00, .g = 0xff, .b = 0x00 }, { .r = 0x00, .g = 0xff, .b = 0x80 },
+    { .r = 0x00, .g = 0xff, .b = 0xff }, { .r = 0x00, .g = 0x80, .b = 0xff },
+    { .r = 0x00, .g = 0x00, .b = 0xff }, { .r = 0x80, .g = 0x00, .b = 0xff },
+    { .r = 0xff, .g = 0x00, .b = 0xff }, { .r = 0xff, .g = 0x00, .b = 0x80 },
+    { .r = 0xff, .g = 0xff, .b = 0xff }, { .r = 0x40, .g = 0x40, .b = 0x40 },
+};
+static color_palette_rgb_t bench_expanded;
+
+SWEEP(b_color_from_palette_rgb, rgb_to_code(color_from_palette_rgb(bench_palette, 16, a ^ b, 200, true)))
+SWEEP(b_color_palette_rgb_get, rgb_to_code(color_palette_rgb_get(&bench_expanded, a ^ b)))
+
+static hsv_t hsv_buf[BUF_SIZE];
+static rgb_t rgb_buf[BUF_SIZE];
+static rgb_t rainbow_buf[BUF_SIZE]; // hsv2rgb_rainbow() output
+
+// Row-major matrix with stride MATRIX_W
+static size_t xy_rows(void *ctx, size_t x, size_t y)
+{
+    (void)ctx;
+    return y * MATRIX_W + x;
+}
+
+// Batch primitives, cost is per pixel
+static uint32_t b_hsv2rgb_rainbow_n(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        hsv2rgb_rainbow_n(hsv_buf, rgb_buf, BUF_SIZE);
+    return rgb_buf[0].r;
+}
+
+static uint32_t b_apply_gamma2rgb_n(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        apply_gamma2rgb_n(rgb_buf, rgb_buf, BUF_SIZE, 2.2f);
+    return rgb_buf[0].r;
+}
+
+static uint32_t b_rgb2hsv_rainbow_n(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        rgb2hsv_rainbow_n(rainbow_buf, hsv_buf, BUF_SIZE);
+    return hsv_buf[0].h;
+}
+
+static uint32_t b_rgb_shift_hue_n(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        rgb_shift_hue_n(rainbow_buf, rainbow_buf, BUF_SIZE, 1);
+    return rainbow_buf[0].r;
+}
+
+static uint32_t b_blur1d(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        blur1d(rgb_buf, BUF_SIZE, 64);
+    return rgb_buf[0].r;
+}
+
+static uint32_t b_blur2d(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        blur2d(rgb_buf, MATRIX_W, MATRIX_H, 64, xy_rows, NULL);
+    return rgb_buf[0].r;
+}
+
+static uint32_t b_blur2d_linear(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        blur2d_linear(rgb_buf, MATRIX_W, MATRIX_H, MATRIX_W, 64);
+    return rgb_buf[0].r;
+}
+
+// Callback and linear blur of matrices from 16x16 to 128x64, the frame
+// is allocated by led_bench_run()
+#define BLUR_MAX_W 128
+#define BLUR_MAX_H 64
+
+static rgb_t *blur_buf;
+
+static size_t xy_stride(void *ctx, size_t x, size_t y)
+{
+    return y * (size_t)ctx + x;
+}
+
+static uint32_t blur_sized(size_t w, size_t h, bool linear)
+{
+    if (!blur_buf)
+        return 0;
+    for (size_t i = 0; i < SWEEP_CALLS / (w * h); i++)
+        if (linear)
+            blur2d_linear(blur_buf, w, h, w, 64);
+        else
+            blur2d(blur_buf, w, h, 64, xy_stride, (void *)w);
+    return blur_buf[0].r;
+}
+
+#define BLUR_SIZE(W, H) \
+    static uint32_t b_blur2d_##W##x##H(void) { return blur_sized(W, H, false); } \
+    static uint32_t b_blur2d_linear_##W##x##H(void) { return blur_sized(W, H, true); }
+
+BLUR_SIZE(16, 16)
+BLUR_SIZE(32, 32)
+BLUR_SIZE(64, 32)
+BLUR_SIZE(64, 64)
+BLUR_SIZE(128, 64)
+
+#define NOISE_W 64
+#define NOISE_H 64
+
+static uint8_t noise8_buf[NOISE_W * NOISE_H];
+static uint16_t noise16_buf[NOISE_W * NOISE_H];
+
+// Noise grids, per point calls vs grid fills, cost is per point
+static uint32_t b_inoise8_2d_grid(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / (NOISE_W * NOISE_H); n++)
+        for (size_t j = 0; j < NOISE_H; j++)
+            for (size_t i = 0; i < NOISE_W; i++)
+                noise8_buf[j * NOISE_W + i] = inoise8_2d(n * 1000 + i * 30, j * 30);
+    return noise8_buf[0];
+}
+
+static uint32_t b_fill_noise8_2d(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / (NOISE_W * NOISE_H); n++)
+        fill_noise8_2d(noise8_buf, NOISE_W, NOISE_H, 1, NOISE_W, n * 1000, 30, 0, 30);
+    return noise8_buf[0];
+}
+
+static uint32_t b_inoise16_3d_grid(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / (NOISE_W * NOISE_H); n++)
+        for (size_t j = 0; j < NOISE_H; j++)
+            for (size_t i = 0; i < NOISE_W; i++)
+                noise16_buf[j * NOISE_W + i] = inoise16_3d(i * 0x1e00, j * 0x1e00, n * 0x3000);
+    return noise16_buf[0];
+}
+
+static uint32_t b_fill_noise16_3d(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / (NOISE_W * NOISE_H); n++)
+        fill_noise16_3d(noise16_buf, NOISE_W, NOISE_H, 1, NOISE_W, 0, 0x1e00, 0, 0x1e00, n * 0x3000);
+    return noise16_buf[0];
+}
+
+static const bench_t benchmarks[] = {
+    { "scale8", b_scale8, SWEEP_CALLS },
+    { "scale8_video", b_scale8_video, SWEEP_CALLS },
+    { "scale16", b_scale16, SWEEP_CALLS },
+    { "qadd8", b_qadd8, SWEEP_CALLS },
+    { "qsub8", b_qsub8, SWEEP_CALLS },
+    { "avg8", b_avg8, SWEEP_CALLS },
+    { "blend8", b_blend8, SWEEP_CALLS },
+    { "lerp8by8", b_lerp8by8, SWEEP_CALLS },
+    { "lerp16by16", b_lerp16by16, SWEEP_CALLS },
+    { "map8", b_map8, SWEEP_CALLS },
+    { "dim8_video", b_dim8_video, SWEEP_CALLS },
+    { "ease8InOutCubic", b_ease8InOutCubic, SWEEP_CALLS },
+    { "cubicwave8", b_cubicwave8, SWEEP_CALLS },
+    { "sin8", b_sin8, SWEEP_CALLS },
+    { "cos8", b_cos8, SWEEP_CALLS },
+    { "sin16", b_sin16, SWEEP_CALLS },
+    { "sqrt16", b_sqrt16, SWEEP_CALLS },
+    { "random8", b_random8, SWEEP_CALLS },
+    { "random16", b_random16, SWEEP_CALLS },
+    { "rgb_blend", b_rgb_blend, SWEEP_CALLS },
+    { "hsv2rgb_rainbow", b_hsv2rgb_rainbow, SWEEP_CALLS },
+    { "hsv2rgb_rainbow_n/px", b_hsv2rgb_rainbow_n, SWEEP_CALLS, true },
+    { "hsv2rgb_spectrum", b_hsv2rgb_spectrum, SWEEP_CALLS },
+    { "hsv2rgb_raw", b_hsv2rgb_raw, SWEEP_CALLS },
+    { "apply_gamma2rgb", b_apply_gamma2rgb, SWEEP_CALLS },
+    { "apply_gamma2rgb_n/px", b_apply_gamma2rgb_n, SWEEP_CALLS, true },
+    { "rgb2hsv_approximate", b_rgb2hsv_approximate, SWEEP_CALLS },
+    { "rgb2hsv_rainbow", b_rgb2hsv_rainbow, SWEEP_CALLS },
+    { "rgb2hsv_rainbow_n/px", b_rgb2hsv_rainbow_n, SWEEP_CALLS, true },
+    { "rgb_shift_hue_n/px", b_rgb_shift_hue_n, SWEEP_CALLS, true },
+    { "color_from_palette_rgb", b_color_from_palette_rgb, SWEEP_CALLS },
+    { "color_palette_rgb_get", b_color_palette_rgb_get, SWEEP_CALLS },
+    { "blur1d/px", b_blur1d, SWEEP_CALLS, true },
+    { "blur2d/px", b_blur2d, SWEEP_CALLS, true },
+    { "blur2d_linear/px", b_blur2d_linear, SWEEP_CALLS, true },
+    { "blur2d 16x16/px", b_blur2d_16x16, SWEEP_CALLS, true },
+    { "blur2d_linear 16x16/px", b_blur2d_linear_16x16, SWEEP_CALLS, true },
+    { "blur2d 32x32/px", b_blur2d_32x32, SWEEP_CALLS, true },
+    { "blur2d_linear 32x32/px", b_blur2d_linear_32x32, SWEEP_CALLS, true },
+    { "blur2d 64x32/px", b_blur2d_64x32, SWEEP_CALLS, true },
+    { "blur2d_linear 64x32/px", b_blur2d_linear_64x32, SWEEP_CALLS, true },
+    { "blur2d 64x64/px", b_blur2d_64x64, SWEEP_CALLS, true },
+    { "blur2d_linear 64x64/px", b_blur2d_linear_64x64, SWEEP_CALLS, true },
+    { "blur2d 128x64/px", b_blur2d_128x64, SWEEP_CALLS, true },
+    { "blur2d_linear 128x64/px", b_blur2d_linear_128x64, SWEEP_CALLS, true },
+    { "inoise8_2d grid/px", b_inoise8_2d_grid, SWEEP_CALLS, true },
+    { "fill_noise8_2d/px", b_fill_noise8_2d, SWEEP_CALLS, true },
+    { "inoise16_3d grid/px", b_inoise16_3d_grid, SWEEP_CALLS, true },
+    { "fill_noise16_3d/px", b_fill_noise16_3d, SWEEP_CALLS, true },
+};
+
+#define BENCH_COUNT (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+// Whole frames of effects, cost is per frame, reported as frames/s too
+#define FRAME_PIXELS 512
+#define FRAME_COUNT 64
+
+static rgb_t frame_buf[FRAME_PIXELS];
+static color_palette_rgb_t frame_lazy;
+
+// Palette gradient moving along the strip, at brightness 200
+static uint32_t f_palette_rgb(void)
+{
+    for (size_t f = 0; f < FRAME_COUNT; f++)
+        for (size_t i = 0; i < FRAME_PIXELS; i++)
+            frame_buf[i] = color_from_palette_rgb(bench_palette, 16, i * 3 + f, 200, true);
+    return frame_buf[0].r;
+}
+
+static uint32_t f_palette_expanded(void)
+{
+    for (size_t f = 0; f < FRAME_COUNT; f++)
+        for (size_t i = 0; i < FRAME_PIXELS; i++)
+            frame_buf[i] = color_palette_rgb_get(&bench_expanded, i * 3 + f);
+    return frame_buf[0].r;
+}
+
+// Expanded on first frame of every sweep
+static uint32_t f_palette_lazy(void)
+{
+    color_palette_rgb_init(&frame_lazy, bench_palette, 16, 200, true, true);
+    for (size_t f = 0; f < FRAME_COUNT; f++)
+        for (size_t i = 0; i < FRAME_PIXELS; i++)
+            frame_buf[i] = color_palette_rgb_get(&frame_lazy, i * 3 + f);
+    return frame_buf[0].r;
+}
+
+static const bench_t frames[] = {
+    { "palette 512px rgb", f_palette_rgb, FRAME_COUNT, true },
+    { "palette 512px expanded", f_palette_expanded, FRAME_COUNT, true },
+    { "palette 512px lazy", f_palette_lazy, FRAME_COUNT, true },
+};
+
+#define FRAMES_COUNT (sizeof(frames) / sizeof(frames[0]))
+
+static uint32_t best_time(uint32_t (*run)(void), uint32_t repeat)
+{
+    uint32_t best = UINT32_MAX;
+    for (uint32_t r = 0; r < repeat; r++)
+    {
+        timestamp_t start = now();
+        sink += run();
+        uint32_t t = now() - start;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+esp_err_t led_bench_run(uint32_t repeat, led_bench_result_t *results, size_t *count)
+{
+    if (!repeat || (results && !count))
+        return ESP_ERR_INVALID_ARG;
+
+    for (size_t i = 0; i < BUF_SIZE; i++)
+    {
+        uint32_t r = lcg();
+        hsv_buf[i] = hsv_from_values(r, r >> 8, r >> 16);
+        rgb_buf[i] = rgb_from_code(lcg());
+    }
+    hsv2rgb_rainbow_n(hsv_buf, rainbow_buf, BUF_SIZE);
+    color_palette_rgb_init(&bench_expanded, bench_palette, 16, 200, true, false);
+    fb_bench_init();
+    blur_buf = malloc(BLUR_MAX_W * BLUR_MAX_H * sizeof(rgb_t));
+    if (blur_buf)
+        for (size_t i = 0; i < BLUR_MAX_W * BLUR_MAX_H; i++)
+            blur_buf[i] = rgb_from_code(lcg());
+    else
+        LOGE("No memory for %dx%d blur", BLUR_MAX_W, BLUR_MAX_H);
+
+    // Loop overhead is subtracted from per-call results
+    uint32_t base = best_time(b_base, repeat);
+
+    LOG("%-24s %10s", "primitive", led_bench_unit);
+    size_t n = 0;
+    for (size_t i = 0; i < BENCH_COUNT + fb_benchmark_count; i++)
+    {
+        const bench_t *b = i < BENCH_COUNT ? &benchmarks[i] : &fb_benchmarks[i - BENCH_COUNT];
+        uint32_t t = best_time(b->run, repeat);
+        uint32_t overhead = b->batch ? 0 : base;
+        float per_call = t > overhead ? (float)(t - overhead) / b->calls : 0;
+        LOG("%-24s %10.2f", b->name, per_call);
+        if (results && n < *count)
+        {
+            results[n].name = b->name;
+            results[n].calls = b->calls;
+            results[n].per_call = per_call;
+            n++;
+        }
+        YIELD();
+    }
+
+    LOG("%-24s %10s %10s", "effect", led_bench_unit, "frames/s");
+    for (size_t i = 0; i < FRAMES_COUNT; i++)
+    {
+        const bench_t *b = &frames[i];
+        float per_frame = (float)best_time(b->run, repeat) / b->calls;
+        LOG("%-24s %10.0f %10.0f", b->name, per_frame, per_frame > 0 ? LED_BENCH_UNITS_PER_SECOND / per_frame : 0);
+        if (results && n < *count)
+        {
+            results[n].name = b->name;
+            results[n].calls = b->calls;
+            results[n].per_call = per_frame;
+            n++;
+        }
+        YIELD();
+    }
+
+    free(blur_buf);
+    blur_buf = NULL;
+
+    if (count)
+        *count = n;
+
+    return ESP_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Equivalence checks
+
+static inline bool rgb_equal(rgb_t a, rgb_t b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static bool check_math8(void)
+{
+    for (uint32_t i = 0; i < SWEEP_CALLS; i++)
+    {
+        uint8_t a = i >> 8, b = i;
+        EXPECT(scale8(a, b) == (a * (b + 1)) >> 8, "scale8(%u, %u) = %u", a, b, scale8(a, b));
+        EXPECT(scale8_video(a, b) == ((a * b) >> 8) + (a && b), "scale8_video(%u, %u) = %u", a, b, scale8_video(a, b));
+        EXPECT(qadd8(a, b) == (a + b > 255 ? 255 : a + b), "qadd8(%u, %u) = %u", a, b, qadd8(a, b));
+        EXPECT(qsub8(a, b) == (a > b ? a - b : 0), "qsub8(%u, %u) = %u", a, b, qsub8(a, b));
+        uint8_t s = sqrt16(i);
+        EXPECT((uint32_t)s * s <= i && (s == 255 || (uint32_t)(s + 1) * (s + 1) > i), "sqrt16(%u) = %u", i, s);
+    }
+    return true;
+}
+
+static bool check_hsv2rgb_rainbow_n(void)
+{
+    static hsv_t src[256];
+    static rgb_t dst[256];
+
+    for (uint32_t hs = 0; hs < 65536; hs++)
+    {
+        for (uint32_t v = 0; v < 256; v++)
+            src[v] = hsv_from_values(hs >> 8, hs, v);
+        hsv2rgb_rainbow_n(src, dst, 256);
+        for (uint32_t v = 0; v < 256; v++)
+            EXPECT(rgb_equal(dst[v], hsv2rgb_rainbow(src[v])), "hsv2rgb_rainbow_n(%u, %u, %u) differs",
+                    src[v].h, src[v].s, src[v].v);
+        if ((hs & 0xfff) == 0xfff)
+            YIELD();
+    }
+    return true;
+}
+
+static bool check_palette_expanded(void)
+{
+    static const uint8_t sizes[] = { 2, 3, 5, 16 };
+    static color_palette_rgb_t pal;
+
+    for (size_t s = 0; s < sizeof(sizes); s++)
+        for (int blend = 0; blend < 2; blend++)
+            for (int lazy = 0; lazy < 2; lazy++)
+                for (uint32_t br = 0; br < 256; br++)
+                {
+                    if (br == 0)
+                        color_palette_rgb_init(&pal, bench_palette, sizes[s], br, blend, lazy);
+                    else
+                        color_palette_rgb_set_brightness(&pal, br, lazy);
+                    for (uint32_t idx = 0; idx < 256; idx++)
+                        EXPECT(rgb_equal(color_palette_rgb_get(&pal, idx),
+                                color_from_palette_rgb(bench_palette, sizes[s], idx, br, blend)),
+                                "color_palette_rgb_get() differs: size %u, blend %d, lazy %d, brightness %u, index %u",
+                                sizes[s], blend, lazy, br, idx);
+                }
+    return true;
+}
+
+static bool check_blur2d_linear(void)
+{
+    static rgb_t a[BUF_SIZE], b[BUF_SIZE];
+
+    for (size_t w = 1; w <= MATRIX_W; w++)
+        for (size_t h = 1; h <= MATRIX_H; h++)
+        {
+            for (size_t i = 0; i < BUF_SIZE; i++)
+                a[i] = b[i] = rgb_from_code(lcg());
+            fract8 amount = lcg();
+            blur2d(a, w, h, amount, xy_rows, NULL);
+            blur2d_linear(b, w, h, MATRIX_W, amount);
+            for (size_t y = 0; y < h; y++)
+                for (size_t x = 0; x < w; x++)
+                    EXPECT(rgb_equal(a[y * MATRIX_W + x], b[y * MATRIX_W + x]),
+                            "blur2d_linear() differs: %ux%u, amount %u, at %u,%u",
+                            (unsigned)w, (unsigned)h, amount, (unsigned)x, (unsigned)y);
+        }
+    return true;
+}
+
+// Single precision reference of gamma tables
+static uint8_t gamma_powf(uint8_t brightness, float gamma)
+{
+    uint8_t res = (uint8_t)(powf((float)brightness / 255.0, gamma) * 255.0);
+    return brightness && !res ? 1 : res;
+}
+
+static bool check_gamma(void)
+{
+    static const float gammas[] = { 1.8f, 2.0f, 2.2f, 2.5f, 2.8f, 0.45f, 1.0f, 2.3f, 2.4f, 2.6f, 3.0f };
+
+    // Cycle through more gammas than cache holds twice to exercise eviction
+    for (int pass = 0; pass < 2; pass++)
+        for (size_t g = 0; g < sizeof(gammas) / sizeof(gammas[0]); g++)
+        {
+            uint8_t lut[256];
+            color_gamma_table(gammas[g], lut);
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                int diff = lut[i] - gamma_powf(i, gammas[g]);
+                EXPECT(diff >= -1 && diff <= 1, "gamma %.2f: table[%u] = %u, powf gives %u",
+                        gammas[g], i, lut[i], gamma_powf(i, gammas[g]));
+            }
+
+            // Other gamma functions use the same tables, cached or not
+            uint8_t seq[256], out[256];
+            for (uint32_t i = 0; i < 256; i++)
+                seq[i] = i;
+            apply_gamma2brightness_n(seq, out, 256, gammas[g]);
+            EXPECT(!memcmp(out, lut, 256), "apply_gamma2brightness_n(%.2f) differs from table", gammas[g]);
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                rgb_t c = apply_gamma2rgb(rgb_from_values(i, 255 - i, i ^ 0x5a), gammas[g]);
+                EXPECT(apply_gamma2brightness(i, gammas[g]) == lut[i] && c.r == lut[i] && c.g == lut[255 - i]
+                        && c.b == lut[i ^ 0x5a], "gamma %.2f: apply_gamma2rgb() differs from table at %u", gammas[g], i);
+            }
+        }
+    return true;
+}
+
+#define GAMMA_TASKS 3
+#define GAMMA_ROUNDS 2000
+
+static const float gamma_stress[] = { 1.8f, 0.45f, 1.0f, 2.3f, 2.4f, 2.2f, 2.6f, 3.0f, 1.5f, 0.8f };
+#define GAMMA_STRESS_COUNT (sizeof(gamma_stress) / sizeof(gamma_stress[0]))
+
+static uint8_t gamma_expected[GAMMA_STRESS_COUNT][256];
+static volatile uint32_t gamma_errors;
+static SemaphoreHandle_t gamma_done;
+
+// Tasks request more gammas than cache holds, so tables are evicted while others copy them
+static void gamma_task(void *arg)
+{
+    size_t offset = (size_t)arg;
+    for (uint32_t r = 0; r < GAMMA_ROUNDS; r++)
+    {
+        size_t g = (r * 3 + offset) % GAMMA_STRESS_COUNT;
+        uint8_t lut[256];
+        color_gamma_table(gamma_stress[g], lut);
+        uint8_t v = apply_gamma2brightness(r, gamma_stress[g]);
+        if (memcmp(lut, gamma_expected[g], 256) || v != gamma_expected[g][r & 0xff])
+            gamma_errors++;
+        if ((r & 0xff) == 0xff)
+            YIELD();
+    }
+    xSemaphoreGive(gamma_done);
+    vTaskDelete(NULL);
+}
+
+static bool check_gamma_tasks(void)
+{
+    for (size_t g = 0; g < GAMMA_STRESS_COUNT; g++)
+        for (uint32_t i = 0; i < 256; i++)
+            gamma_expected[g][i] = gamma_powf(i, gamma_stress[g]);
+
+    gamma_errors = 0;
+    gamma_done = xSemaphoreCreateCounting(GAMMA_TASKS, 0);
+    EXPECT(gamma_done, "No memory for semaphore");
+    size_t started = 0;
+    for (; started < GAMMA_TASKS; started++)
+        if (xTaskCreate(gamma_task, "gamma", 4096, (void *)started, tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+            break;
+    for (size_t i = 0; i < started; i++)
+        xSemaphoreTake(gamma_done, portMAX_DELAY);
+    vSemaphoreDelete(gamma_done);
+
+    EXPECT(started == GAMMA_TASKS, "Could not start gamma tasks");
+    EXPECT(!gamma_errors, "%u of %u concurrent gamma lookups returned wrong tables", gamma_errors,
+            GAMMA_TASKS * GAMMA_ROUNDS);
+    return true;
+}
+
+// Share of colors which must survive hsv2rgb_rainbow() -> rgb2hsv_rainbow() -> hsv2rgb_rainbow()
+#define RGB2HSV_MIN_EXACT 0.998f
+
+static bool check_rgb2hsv_rainbow(void)
+{
+    static hsv_t src[256], back[256];
+    static rgb_t rgb[256];
+    uint32_t exact = 0;
+
+    for (uint32_t hs = 0; hs < 65536; hs++)
+    {
+        for (uint32_t v = 0; v < 256; v++)
+            src[v] = hsv_from_values(hs >> 8, hs, v);
+        hsv2rgb_rainbow_n(src, rgb, 256);
+        rgb2hsv_rainbow_n(rgb, back, 256);
+        for (uint32_t v = 0; v < 256; v++)
+        {
+            EXPECT(hsv_to_code(back[v]) == hsv_to_code(rgb2hsv_rainbow(rgb[v])), "rgb2hsv_rainbow_n(%u, %u, %u) differs",
+                    rgb[v].r, rgb[v].g, rgb[v].b);
+            if (rgb_equal(hsv2rgb_rainbow(back[v]), rgb[v]))
+                exact++;
+        }
+        if ((hs & 0xfff) == 0xfff)
+            YIELD();
+    }
+    LOG("rgb2hsv_rainbow: %u of %u colors round-trip exactly", exact, 1u << 24);
+    EXPECT(exact >= RGB2HSV_MIN_EXACT * (1u << 24), "rgb2hsv_rainbow: too few exact round trips");
+
+    // Hue shift leaves gray colors gray
+    for (uint32_t v = 0; v < 256; v++)
+    {
+        rgb_t gray = rgb_from_values(v, v, v), shifted;
+        rgb_shift_hue_n(&gray, &shifted, 1, 100);
+        EXPECT(shifted.r == shifted.g && shifted.g == shifted.b, "rgb_shift_hue_n(): gray %u became %u, %u, %u",
+                v, shifted.r, shifted.g, shifted.b);
+    }
+    return true;
+}
+
+// Grid fills must match per point calls bit for bit, including scales crossing
+// several cells per point, wrap around of coordinates and strided output
+static bool check_noise_grid(void)
+{
+    static const uint16_t scales8[] = { 0, 1, 30, 255, 256, 700, 0xfff0 };
+    static const uint32_t scales16[] = { 0, 1, 0x1e00, 0xffff, 0x10000, 0x2c000, 0xfffff000 };
+    static uint8_t grid8[3 * NOISE_W * NOISE_H];
+    static uint16_t grid16[3 * NOISE_W * NOISE_H];
+    const size_t step = 3, stride = 3 * NOISE_W;
+
+    for (size_t s = 0; s < sizeof(scales8) / sizeof(scales8[0]); s++)
+        for (int pass = 0; pass < 4; pass++)
+        {
+            uint16_t x = lcg(), y = lcg(), sx = scales8[s], sy = scales8[(s + pass) % 7];
+            fill_noise8_2d(grid8, NOISE_W, NOISE_H, step, stride, x, sx, y, sy);
+            for (size_t j = 0; j < NOISE_H; j++)
+                for (size_t i = 0; i < NOISE_W; i++)
+                {
+                    uint8_t ref = inoise8_2d(x + i * sx, y + j * sy);
+                    EXPECT(grid8[j * stride + i * step] == ref, "fill_noise8_2d(x=%u, %u, y=%u, %u)[%u, %u] = %u, inoise8_2d() gives %u",
+                            x, sx, y, sy, (unsigned)i, (unsigned)j, grid8[j * stride + i * step], ref);
+                }
+        }
+
+    for (size_t s = 0; s < sizeof(scales16) / sizeof(scales16[0]); s++)
+        for (int pass = 0; pass < 4; pass++)
+        {
+            uint32_t x = lcg() << 8, y = lcg() << 8, z = lcg() << 8;
+            uint32_t sx = scales16[s], sy = scales16[(s + pass) % 7];
+            fill_noise16_3d(grid16, NOISE_W, NOISE_H, step, stride, x, sx, y, sy, z);
+            for (size_t j = 0; j < NOISE_H; j++)
+                for (size_t i = 0; i < NOISE_W; i++)
+                {
+                    uint16_t ref = inoise16_3d(x + i * sx, y + j * sy, z);
+                    EXPECT(grid16[j * stride + i * step] == ref, "fill_noise16_3d(x=%u, %u, y=%u, %u, z=%u)[%u, %u] = %u, inoise16_3d() gives %u",
+                            x, sx, y, sy, z, (unsigned)i, (unsigned)j, grid16[j * stride + i * step], ref);
+                }
+            YIELD();
+        }
+
+    // Points between rows are left untouched
+    for (size_t i = 0; i < sizeof(grid8); i++)
+        EXPECT(i % step == 0 || grid8[i] == 0, "fill_noise8_2d() wrote between points at %u", (unsigned)i);
+    return true;
+}
+
+static const check_t checks[] = {
+    { "math8", check_math8 },
+    { "hsv2rgb_rainbow_n", check_hsv2rgb_rainbow_n },
+    { "color_palette_rgb", check_palette_expanded },
+    { "blur2d_linear", check_blur2d_linear },
+    { "gamma tables", check_gamma },
+    { "gamma tables, tasks", check_gamma_tasks },
+    { "rgb2hsv_rainbow", check_rgb2hsv_rainbow },
+    { "noise grid fills", check_noise_grid },
+};
+
+esp_err_t led_bench_verify(void)
+{
+    esp_err_t res = ESP_OK;
+
+    size_t count = sizeof(checks) / sizeof(checks[0]);
+    for (size_t i = 0; i < count + fb_check_count; i++)
+    {
+        const check_t *c = i < count ? &checks[i] : &fb_checks[i - count];
+        bool ok = c->check();
+        LOG("%-24s %s", c->name, ok ? "OK" : "FAILED");
+        if (!ok)
+            res = ESP_FAIL;
+        YIELD();
+    }
+
+    return res;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file led_bench.h
+ * @defgroup led_bench led_bench
+ * @{
+ *
+ * Microbenchmarks and equivalence checks of lib8tion and color
+ *
+ * Builds as ESP-IDF component and as Linux host program, see README.md.
+ * On ESP32 cost is measured in CPU cycles, on host in nanoseconds.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __LED_BENCH_H__
+#define __LED_BENCH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Benchmark result
+ */
+typedef struct
+{
+    const char *name;      ///< Primitive name
+    uint32_t calls;        ///< Calls per sweep, frames for effects
+    float per_call;        ///< Best cost of a call or effect frame over all sweeps, see ::led_bench_unit
+} led_bench_result_t;
+
+/**
+ * Unit of ::led_bench_result_t::per_call, "cycles" or "ns"
+ */
+extern const char *const led_bench_unit;
+
+/**
+ * @brief Check optimized variants against reference implementations
+ *
+ * Checks are exhaustive over all inputs where it's feasible, so this may
+ * take several seconds on target. Mismatches are logged.
+ *
+ * @return          ESP_OK if all variants match, ESP_FAIL otherwise
+ */
+esp_err_t led_bench_verify(void);
+
+/**
+ * @brief Run all benchmarks and log results
+ *
+ * @param repeat        Number of sweeps of each benchmark, best one counts
+ * @param[out] results  Array of results, may be NULL
+ * @param[in,out] count Size of array in, number of results out, may be NULL
+ * @return              ESP_OK on success
+ */
+esp_err_t led_bench_run(uint32_t repeat, led_bench_result_t *results, size_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __LED_BENCH_H__ */
@@ -0,0 +1,1026 @@
+/**
+ * @file led_bench_fb.c
+ *
+ * Benchmarks and checks of framebuffer
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <framebuffer.h>
+#include <fbsprite.h>
+#include <fbscheduler.h>
+#include <fblayers.h>
+#include <fbxymap.h>
+#include "led_bench_priv.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmarks
+
+static rgb_t blit_buf[BUF_SIZE];
+static rgb_t blit_rgb[BUF_SIZE];
+static uint8_t blit_index[BUF_SIZE];
+static uint8_t blit_mask[BUF_SIZE / 8];
+static framebuffer_t blit_fb = { .data = blit_buf, .width = MATRIX_W, .height = MATRIX_H };
+
+// Whole MATRIX_W x MATRIX_H sprites, cost is per pixel
+static uint32_t blit(fb_sprite_format_t format, const void *data, uint8_t flags, fract8 alpha)
+{
+    fb_sprite_t sprite = {
+        .width = MATRIX_W,
+        .height = MATRIX_H,
+        .format = format,
+        .data = data,
+        .palette = bench_palette,
+        .color = { .r = 0xff, .g = 0x80, .b = 0x40 },
+    };
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+        fb_blit(&blit_fb, &sprite, 0, 0, flags, alpha);
+    return blit_buf[0].r;
+}
+
+static uint32_t b_blit_rgb(void)
+{
+    return blit(FB_SPRITE_RGB, blit_rgb, FB_BLIT_COPY, 255);
+}
+
+static uint32_t b_blit_rgb_key(void)
+{
+    return blit(FB_SPRITE_RGB, blit_rgb, FB_BLIT_KEY, 255);
+}
+
+static uint32_t b_blit_rgb_alpha(void)
+{
+    return blit(FB_SPRITE_RGB, blit_rgb, FB_BLIT_ALPHA, 128);
+}
+
+static uint32_t b_blit_palette_key(void)
+{
+    return blit(FB_SPRITE_PALETTE, blit_index, FB_BLIT_KEY, 255);
+}
+
+static uint32_t b_blit_mask_key(void)
+{
+    return blit(FB_SPRITE_MASK, blit_mask, FB_BLIT_KEY, 255);
+}
+
+// Layer composition, every run composes base layer (opaque replace, dirty
+// everywhere) and the layer in test over it. Cost of a layer is the
+// difference to base alone
+static rgb_t layer_out_buf[BUF_SIZE], layer_base_buf[BUF_SIZE], layer_full_buf[BUF_SIZE], layer_sparse_buf[BUF_SIZE];
+static framebuffer_t layer_out = { .data = layer_out_buf, .width = MATRIX_W, .height = MATRIX_H };
+static framebuffer_t layer_base = { .data = layer_base_buf, .width = MATRIX_W, .height = MATRIX_H };
+static framebuffer_t layer_full = { .data = layer_full_buf, .width = MATRIX_W, .height = MATRIX_H };
+static framebuffer_t layer_sparse = { .data = layer_sparse_buf, .width = MATRIX_W, .height = MATRIX_H };
+
+static uint32_t compose(framebuffer_t *layer, fb_blend_mode_t mode, fract8 opacity)
+{
+    fb_layers_t stack;
+    fb_layers_init(&stack, &layer_out);
+    fb_layers_add(&stack, &layer_base, FB_BLEND_REPLACE, 255);
+    if (layer)
+    {
+        // Adding marks whole layer, content is still where it was
+        fb_rect_t bounds = layer->bounds;
+        fb_layers_add(&stack, layer, mode, opacity);
+        layer->dirty_count = 0;
+        layer->bounds = bounds;
+    }
+    for (size_t i = 0; i < SWEEP_CALLS / BUF_SIZE; i++)
+    {
+        fb_mark_dirty(&layer_base, 0, 0, MATRIX_W, MATRIX_H);
+        fb_layers_compose(&stack);
+    }
+    layer_out.dirty_count = 0;
+    return layer_out_buf[0].r;
+}
+
+static uint32_t b_layers_base(void)
+{
+    return compose(NULL, FB_BLEND_REPLACE, 255);
+}
+
+static uint32_t b_layers_replace_alpha(void)
+{
+    return compose(&layer_full, FB_BLEND_REPLACE, 128);
+}
+
+static uint32_t b_layers_add(void)
+{
+    return compose(&layer_full, FB_BLEND_ADD, 255);
+}
+
+static uint32_t b_layers_add_alpha(void)
+{
+    return compose(&layer_full, FB_BLEND_ADD, 128);
+}
+
+static uint32_t b_layers_add_sparse(void)
+{
+    return compose(&layer_sparse, FB_BLEND_ADD, 255);
+}
+
+static uint32_t b_layers_multiply(void)
+{
+    return compose(&layer_full, FB_BLEND_MULTIPLY, 255);
+}
+
+static uint32_t b_layers_screen(void)
+{
+    return compose(&layer_full, FB_BLEND_SCREEN, 255);
+}
+
+// Subpixel points and lines, float against Q8.8 coordinates. Lines are
+// horizontal-ish across the matrix, cost is per pixel column
+static rgb_t sub_buf[BUF_SIZE];
+static framebuffer_t sub_fb = { .data = sub_buf, .width = MATRIX_W, .height = MATRIX_H };
+static fb_q8_t sub_qx[BUF_SIZE], sub_qy[BUF_SIZE];
+static float sub_fx[BUF_SIZE], sub_fy[BUF_SIZE];
+static const rgb_t sub_color = { .r = 0x40, .g = 0x20, .b = 0x10 };
+
+static uint32_t b_set_pixelf(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / BUF_SIZE; n++)
+        for (size_t i = 0; i < BUF_SIZE; i++)
+            fb_set_pixelf_rgb(&sub_fb, sub_fx[i], sub_fy[i], sub_color);
+    sub_fb.dirty_count = 0;
+    return sub_buf[0].r;
+}
+
+static uint32_t b_set_pixelq(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / BUF_SIZE; n++)
+        for (size_t i = 0; i < BUF_SIZE; i++)
+            fb_set_pixelq_rgb(&sub_fb, sub_qx[i], sub_qy[i], sub_color);
+    sub_fb.dirty_count = 0;
+    return sub_buf[0].r;
+}
+
+// Line drawn point by point, one fb_set_pixelf_rgb() per column
+static uint32_t b_linef(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / MATRIX_W; i++)
+    {
+        float y0 = sub_fy[i % BUF_SIZE], y1 = sub_fy[(i + 1) % BUF_SIZE];
+        float gradient = (y1 - y0) / (MATRIX_W - 1);
+        for (size_t x = 0; x < MATRIX_W; x++)
+            fb_set_pixelf_rgb(&sub_fb, x, y0 + gradient * x, sub_color);
+    }
+    sub_fb.dirty_count = 0;
+    return sub_buf[0].r;
+}
+
+static uint32_t b_lineq(void)
+{
+    for (size_t i = 0; i < SWEEP_CALLS / MATRIX_W; i++)
+        fb_draw_lineq_rgb(&sub_fb, 0, sub_qy[i % BUF_SIZE], FB_Q8(MATRIX_W - 1), sub_qy[(i + 1) % BUF_SIZE], sub_color);
+    sub_fb.dirty_count = 0;
+    return sub_buf[0].r;
+}
+
+// Copy of framebuffer to LED buffer in physical order, matrix of 8x8
+// serpentine panels, cost is per pixel
+#define XY_TILE 8
+static rgb_t xy_dst[BUF_SIZE];
+static fb_xymap_t xy_map;
+
+// Arithmetic mapping, the way effects map without table
+static size_t xy_tiled(void *ctx, size_t x, size_t y)
+{
+    (void)ctx;
+    size_t tx = x / XY_TILE, ty = y / XY_TILE;
+    size_t lx = x % XY_TILE, ly = y % XY_TILE;
+    if (ty & 1)
+        tx = MATRIX_W / XY_TILE - 1 - tx;
+    if (ly & 1)
+        lx = XY_TILE - 1 - lx;
+    return (ty * (MATRIX_W / XY_TILE) + tx) * XY_TILE * XY_TILE + ly * XY_TILE + lx;
+}
+
+// Volatile, so calls through it can't be inlined
+static xy_to_offs_cb volatile xy_cb;
+static void *volatile xy_ctx;
+
+static uint32_t xy_copy(xy_to_offs_cb cb, void *ctx)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / BUF_SIZE; n++)
+        for (size_t y = 0; y < MATRIX_H; y++)
+            for (size_t x = 0; x < MATRIX_W; x++)
+                xy_dst[cb(ctx, x, y)] = blit_buf[y * MATRIX_W + x];
+    return xy_dst[0].r;
+}
+
+static uint32_t b_xy_callback(void)
+{
+    xy_cb = xy_tiled;
+    return xy_copy(xy_cb, xy_ctx);
+}
+
+static uint32_t b_xymap_cb(void)
+{
+    xy_cb = fb_xymap_cb;
+    xy_ctx = &xy_map;
+    return xy_copy(xy_cb, xy_ctx);
+}
+
+static uint32_t b_xymap_offs(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / BUF_SIZE; n++)
+        for (size_t y = 0; y < MATRIX_H; y++)
+            for (size_t x = 0; x < MATRIX_W; x++)
+                xy_dst[fb_xymap_offs(&xy_map, x, y)] = blit_buf[y * MATRIX_W + x];
+    return xy_dst[0].r;
+}
+
+static uint32_t b_xymap_blit(void)
+{
+    for (size_t n = 0; n < SWEEP_CALLS / BUF_SIZE; n++)
+        fb_xymap_blit(&xy_map, &blit_fb, xy_dst);
+    return xy_dst[0].r;
+}
+
+void fb_bench_init(void)
+{
+    for (size_t i = 0; i < BUF_SIZE; i++)
+    {
+        blit_rgb[i] = hsv2rgb_rainbow(hsv_from_values(lcg(), 255, 255));
+        blit_index[i] = lcg() & 15;
+        blit_mask[i / 8] = lcg();
+        layer_base_buf[i] = rgb_from_code(lcg());
+        layer_full_buf[i] = rgb_from_code(lcg());
+        // Points inside, so float and Q8.8 plot the same pixels
+        sub_qx[i] = lcg() % FB_Q8(MATRIX_W - 1);
+        sub_qy[i] = lcg() % FB_Q8(MATRIX_H - 1);
+        sub_fx[i] = sub_qx[i] / 256.0f;
+        sub_fy[i] = sub_qy[i] / 256.0f;
+    }
+    fb_mark_dirty(&layer_full, 0, 0, MATRIX_W, MATRIX_H);
+    // 4x4 pixels of content, bounds are that small
+    for (size_t y = 10; y < 14; y++)
+        for (size_t x = 10; x < 14; x++)
+            layer_sparse_buf[y * MATRIX_W + x] = rgb_from_code(lcg());
+    fb_mark_dirty(&layer_sparse, 10, 10, 4, 4);
+
+    const fb_layout_t layout = {
+        .width = MATRIX_W,
+        .height = MATRIX_H,
+        .tile_width = XY_TILE,
+        .tile_height = XY_TILE,
+        .serpentine = true,
+        .tiles_serpentine = true,
+    };
+    if (!xy_map.table && fb_xymap_init(&xy_map, &layout) != ESP_OK)
+        LOGE("fb_xymap_init() failed");
+}
+
+const bench_t fb_benchmarks[] = {
+    { "fb_blit rgb/px", b_blit_rgb, SWEEP_CALLS, true },
+    { "fb_blit rgb key/px", b_blit_rgb_key, SWEEP_CALLS, true },
+    { "fb_blit rgb alpha/px", b_blit_rgb_alpha, SWEEP_CALLS, true },
+    { "fb_blit palette key/px", b_blit_palette_key, SWEEP_CALLS, true },
+    { "fb_blit mask key/px", b_blit_mask_key, SWEEP_CALLS, true },
+    { "fb_layers base/px", b_layers_base, SWEEP_CALLS, true },
+    { "+replace 50%/px", b_layers_replace_alpha, SWEEP_CALLS, true },
+    { "+add/px", b_layers_add, SWEEP_CALLS, true },
+    { "+add 50%/px", b_layers_add_alpha, SWEEP_CALLS, true },
+    { "+add 4x4 bounds/px", b_layers_add_sparse, SWEEP_CALLS, true },
+    { "+multiply/px", b_layers_multiply, SWEEP_CALLS, true },
+    { "+screen/px", b_layers_screen, SWEEP_CALLS, true },
+    { "fb_set_pixelf_rgb", b_set_pixelf, SWEEP_CALLS, true },
+    { "fb_set_pixelq_rgb", b_set_pixelq, SWEEP_CALLS, true },
+    { "fb_set_pixelf line/px", b_linef, SWEEP_CALLS / MATRIX_W * MATRIX_W, true },
+    { "fb_draw_lineq_rgb/px", b_lineq, SWEEP_CALLS / MATRIX_W * MATRIX_W, true },
+    { "xy callback copy/px", b_xy_callback, SWEEP_CALLS, true },
+    { "fb_xymap_cb copy/px", b_xymap_cb, SWEEP_CALLS, true },
+    { "fb_xymap_offs copy/px", b_xymap_offs, SWEEP_CALLS, true },
+    { "fb_xymap_blit/px", b_xymap_blit, SWEEP_CALLS, true },
+};
+
+const size_t fb_benchmark_count = sizeof(fb_benchmarks) / sizeof(fb_benchmarks[0]);
+
+////////////////////////////////////////////////////////////////////////////////
+// Checks
+
+#define BLIT_FB_W 40
+#define BLIT_FB_H 24
+#define BLIT_SPRITE_W 23
+#define BLIT_SPRITE_H 17
+#define BLIT_STRIDE 29
+
+// Pixel by pixel reference of fb_blit_rect()
+static void blit_reference(rgb_t *fb, const fb_sprite_t *sprite, size_t sx, size_t sy, size_t w, size_t h,
+        int x, int y, uint8_t flags, fract8 alpha)
+{
+    if ((flags & FB_BLIT_ALPHA) && !alpha)
+        return;
+    for (size_t j = 0; j < h; j++)
+        for (size_t i = 0; i < w; i++)
+        {
+            size_t px = sx + i, py = sy + j;
+            long dx = x + (long)i, dy = y + (long)j;
+            if (px >= sprite->width || py >= sprite->height || dx < 0 || dy < 0 || dx >= BLIT_FB_W || dy >= BLIT_FB_H)
+                continue;
+
+            rgb_t c;
+            bool transparent;
+            if (sprite->format == FB_SPRITE_RGB)
+            {
+                c = ((const rgb_t *)sprite->data)[py * BLIT_STRIDE + px];
+                transparent = rgb_to_code(c) == rgb_to_code(sprite->key);
+            }
+            else if (sprite->format == FB_SPRITE_PALETTE)
+            {
+                uint8_t idx = ((const uint8_t *)sprite->data)[py * BLIT_STRIDE + px];
+                c = sprite->palette[idx];
+                transparent = idx == sprite->key_index;
+            }
+            else
+            {
+                const uint8_t *row = (const uint8_t *)sprite->data + py * ((BLIT_STRIDE + 7) / 8);
+                transparent = !(row[px / 8] & (0x80 >> (px % 8)));
+                c = transparent ? rgb_from_code(0) : sprite->color;
+            }
+            if ((flags & FB_BLIT_KEY) && transparent)
+                continue;
+
+            rgb_t *dst = fb + dy * BLIT_FB_W + dx;
+            *dst = (flags & FB_BLIT_ALPHA) && alpha != 255 ? rgb_blend(*dst, c, alpha) : c;
+        }
+}
+
+static bool check_blit(void)
+{
+    static rgb_t fb_buf[BLIT_FB_W * BLIT_FB_H], ref[BLIT_FB_W * BLIT_FB_H];
+    static rgb_t pixels[BLIT_SPRITE_H * BLIT_STRIDE];
+    static uint8_t indices[BLIT_SPRITE_H * BLIT_STRIDE];
+    static uint8_t bits[BLIT_SPRITE_H * ((BLIT_STRIDE + 7) / 8)];
+    static const fract8 alphas[] = { 0, 1, 128, 254, 255 };
+    framebuffer_t fb = { .data = fb_buf, .width = BLIT_FB_W, .height = BLIT_FB_H };
+
+    // Palette colors make RGB key hits frequent
+    for (size_t i = 0; i < BLIT_SPRITE_H * BLIT_STRIDE; i++)
+    {
+        indices[i] = lcg() & 15;
+        pixels[i] = bench_palette[lcg() & 15];
+    }
+    // Masks skip empty bytes at once, so make plenty of them
+    for (size_t i = 0; i < sizeof(bits); i++)
+        bits[i] = lcg() % 3 ? lcg() : 0;
+
+    fb_sprite_t sprites[] = {
+        { .width = BLIT_SPRITE_W, .height = BLIT_SPRITE_H, .stride = BLIT_STRIDE, .format = FB_SPRITE_RGB,
+          .data = pixels, .key = bench_palette[0] },
+        { .width = BLIT_SPRITE_W, .height = BLIT_SPRITE_H, .stride = BLIT_STRIDE, .format = FB_SPRITE_PALETTE,
+          .data = indices, .palette = bench_palette, .key_index = 3 },
+        { .width = BLIT_SPRITE_W, .height = BLIT_SPRITE_H, .stride = BLIT_STRIDE, .format = FB_SPRITE_MASK,
+          .data = bits, .color = { .r = 0xff, .g = 0x80, .b = 0x40 } },
+    };
+
+    for (size_t s = 0; s < sizeof(sprites) / sizeof(sprites[0]); s++)
+        for (uint8_t flags = 0; flags <= (FB_BLIT_KEY | FB_BLIT_ALPHA); flags++)
+            for (int n = 0; n < 2000; n++)
+            {
+                for (size_t i = 0; i < BLIT_FB_W * BLIT_FB_H; i++)
+                    fb_buf[i] = ref[i] = rgb_from_code(lcg());
+                size_t sx = lcg() % (BLIT_SPRITE_W + 4), sy = lcg() % (BLIT_SPRITE_H + 4);
+                size_t w = lcg() % (BLIT_SPRITE_W + 8), h = lcg() % (BLIT_SPRITE_H + 8);
+                int x = (int)(lcg() % (BLIT_FB_W + 40)) - 30, y = (int)(lcg() % (BLIT_FB_H + 30)) - 20;
+                fract8 alpha = alphas[lcg() % 5];
+
+                EXPECT(fb_blit_rect(&fb, &sprites[s], sx, sy, w, h, x, y, flags, alpha) == ESP_OK,
+                        "fb_blit_rect() failed");
+                blit_reference(ref, &sprites[s], sx, sy, w, h, x, y, flags, alpha);
+                for (size_t i = 0; i < BLIT_FB_W * BLIT_FB_H; i++)
+                    EXPECT(rgb_to_code(fb_buf[i]) == rgb_to_code(ref[i]),
+                            "fb_blit_rect(format %d, %u, %u, %ux%u, %d, %d, flags %u, alpha %u): pixel %u, %u differs",
+                            sprites[s].format, (unsigned)sx, (unsigned)sy, (unsigned)w, (unsigned)h, x, y, flags, alpha,
+                            (unsigned)(i % BLIT_FB_W), (unsigned)(i / BLIT_FB_W));
+            }
+
+    framebuffer_t empty = { .data = NULL, .width = BLIT_FB_W, .height = BLIT_FB_H };
+    EXPECT(fb_blit(&empty, &sprites[0], 0, 0, FB_BLIT_COPY, 255) == ESP_ERR_INVALID_ARG,
+            "fb_blit() accepted framebuffer without data");
+    return true;
+}
+
+#define BOUNDS_W 24
+#define BOUNDS_H 12
+#define BOUNDS_OPS 3000
+
+static esp_err_t render_nothing(framebuffer_t *fb, void *arg)
+{
+    (void)fb;
+    (void)arg;
+    return ESP_OK;
+}
+
+// Whole frame reference of fb_shift()
+static void shift_reference(rgb_t *ref, size_t offs, fb_shift_direction_t dir)
+{
+    size_t w = BOUNDS_W, h = BOUNDS_H;
+    if (((dir == FB_SHIFT_LEFT || dir == FB_SHIFT_RIGHT) && offs >= w)
+            || ((dir == FB_SHIFT_UP || dir == FB_SHIFT_DOWN) && offs >= h))
+        return;
+    for (size_t row = 0; row < h; row++)
+        if (dir == FB_SHIFT_LEFT)
+            memmove(ref + row * w, ref + row * w + offs, sizeof(rgb_t) * (w - offs));
+        else if (dir == FB_SHIFT_RIGHT)
+            memmove(ref + row * w + offs, ref + row * w, sizeof(rgb_t) * (w - offs));
+    if (dir == FB_SHIFT_UP)
+        memmove(ref + offs * w, ref, sizeof(rgb_t) * (h - offs) * w);
+    else if (dir == FB_SHIFT_DOWN)
+        memmove(ref, ref + offs * w, sizeof(rgb_t) * (h - offs) * w);
+}
+
+// Operations limited to fb->bounds against the same ones on whole frame.
+// Direct writes are marked with fb_mark_dirty() or, with direct_writes,
+// by fb_begin() of every operation
+static bool check_bounds_mode(bool direct)
+{
+    static const char *const ops[] = { "fb_set_pixel_rgb", "direct write", "fb_fade", "fb_blur2d", "fb_clear", "fb_shift" };
+    static rgb_t ref[BOUNDS_W * BOUNDS_H];
+    framebuffer_t fb;
+
+    EXPECT(fb_init(&fb, BOUNDS_W, BOUNDS_H, render_nothing) == ESP_OK, "fb_init() failed");
+    fb.direct_writes = direct;
+    memset(ref, 0, sizeof(ref));
+    bool ok = true;
+
+    for (int n = 0; n < BOUNDS_OPS && ok; n++)
+    {
+        size_t x = lcg() % BOUNDS_W, y = lcg() % BOUNDS_H;
+        size_t op = lcg() % 6;
+        rgb_t c = rgb_from_code(lcg());
+
+        fb_begin(&fb);
+        switch (op)
+        {
+            case 0:
+                fb_set_pixel_rgb(&fb, x, y, c);
+                ref[y * BOUNDS_W + x] = c;
+                break;
+            case 1:
+            {
+                size_t w = 1 + lcg() % 4, h = 1 + lcg() % 3;
+                for (size_t j = y; j < y + h && j < BOUNDS_H; j++)
+                    for (size_t i = x; i < x + w && i < BOUNDS_W; i++)
+                        fb.data[j * BOUNDS_W + i] = ref[j * BOUNDS_W + i] = c;
+                if (!direct)
+                    fb_mark_dirty(&fb, x, y, w, h);
+                break;
+            }
+            case 2:
+            {
+                uint8_t scale = lcg();
+                fb_fade(&fb, scale);
+                for (size_t i = 0; i < BOUNDS_W * BOUNDS_H; i++)
+                    ref[i] = rgb_fade(ref[i], scale);
+                break;
+            }
+            case 3:
+            {
+                fract8 amount = lcg();
+                fb_blur2d(&fb, amount);
+                blur2d_linear(ref, BOUNDS_W, BOUNDS_H, BOUNDS_W, amount);
+                break;
+            }
+            case 4:
+                // Rarely, so frame fills up between clears
+                if (lcg() % 4)
+                    break;
+                fb_clear(&fb);
+                memset(ref, 0, sizeof(ref));
+                break;
+            default:
+            {
+                size_t offs = 1 + lcg() % 3;
+                fb_shift_direction_t dir = lcg() % 4;
+                fb_shift(&fb, offs, dir);
+                shift_reference(ref, offs, dir);
+                break;
+            }
+        }
+        fb_end(&fb);
+
+        for (size_t i = 0; i < BOUNDS_W * BOUNDS_H && ok; i++)
+            if (rgb_to_code(fb.data[i]) != rgb_to_code(ref[i]))
+            {
+                LOGE("%s%s, op %d: pixel %u, %u is %06x, expected %06x", ops[op], direct ? ", direct_writes" : "", n,
+                        (unsigned)(i % BOUNDS_W), (unsigned)(i / BOUNDS_W), (unsigned)rgb_to_code(fb.data[i]),
+                        (unsigned)rgb_to_code(ref[i]));
+                ok = false;
+            }
+    }
+
+    fb_free(&fb);
+    return ok;
+}
+
+static bool check_bounds(void)
+{
+    return check_bounds_mode(false) && check_bounds_mode(true);
+}
+
+#define LAYERS_W 20
+#define LAYERS_H 10
+#define LAYERS_COUNT 4
+#define LAYERS_ROUNDS 1000
+
+// Per channel reference of layer blending
+static uint8_t blend_reference(uint8_t d, uint8_t s, fb_blend_mode_t mode, fract8 a)
+{
+    uint8_t v = s;
+    if (!a)
+        return d;
+    switch (mode)
+    {
+        case FB_BLEND_REPLACE:
+            v = s;
+            break;
+        case FB_BLEND_ADD:
+            return qadd8(d, scale8(s, a));
+        case FB_BLEND_MULTIPLY:
+            v = scale8(d, s);
+            break;
+        case FB_BLEND_SCREEN:
+            v = 255 - scale8(255 - d, 255 - s);
+            break;
+    }
+    return a == 255 ? v : blend8(d, v, a);
+}
+
+// Incremental composition of dirty areas against whole output composed
+// pixel by pixel. Top layer is written without marking, with direct_writes
+static bool check_layers(void)
+{
+    static framebuffer_t out, fbs[LAYERS_COUNT];
+    static rgb_t ref[LAYERS_W * LAYERS_H];
+    fb_layers_t stack;
+    size_t ready = 0;
+    bool ok = false;
+
+    if (fb_init(&out, LAYERS_W, LAYERS_H, render_nothing) != ESP_OK)
+    {
+        LOGE("fb_init() failed");
+        return false;
+    }
+    for (; ready < LAYERS_COUNT; ready++)
+        if (fb_init(&fbs[ready], LAYERS_W, LAYERS_H, render_nothing) != ESP_OK)
+            break;
+    fbs[LAYERS_COUNT - 1].direct_writes = true;
+
+    do
+    {
+        if (ready < LAYERS_COUNT || fb_layers_init(&stack, &out) != ESP_OK)
+        {
+            LOGE("Could not create layers");
+            break;
+        }
+        for (size_t i = 0; i < LAYERS_COUNT; i++)
+            fb_layers_add(&stack, &fbs[i], i ? lcg() % 4 : FB_BLEND_REPLACE, i ? lcg() : 255);
+
+        int n = 0;
+        for (; n < LAYERS_ROUNDS; n++)
+        {
+            // Change a few pixels or rects of random layers, now and then
+            // also mode, opacity or whole layer
+            for (int k = lcg() % 4; k >= 0; k--)
+            {
+                size_t l = lcg() % LAYERS_COUNT;
+                framebuffer_t *fb = &fbs[l];
+                size_t x = lcg() % LAYERS_W, y = lcg() % LAYERS_H;
+                rgb_t c = lcg() % 4 ? rgb_from_code(lcg()) : rgb_from_code(0);
+                switch (lcg() % 8)
+                {
+                    case 0:
+                        fb_layers_set(&stack, l, lcg() % 4, lcg() % 3 ? lcg() : 255 * (lcg() % 2));
+                        break;
+                    case 1:
+                        fb_clear(fb);
+                        break;
+                    case 2:
+                        fb_fade(fb, lcg());
+                        break;
+                    case 3:
+                    {
+                        size_t w = 1 + lcg() % 5, h = 1 + lcg() % 3;
+                        for (size_t j = y; j < y + h && j < LAYERS_H; j++)
+                            for (size_t i = x; i < x + w && i < LAYERS_W; i++)
+                                fb->data[j * LAYERS_W + i] = c;
+                        if (!fb->direct_writes)
+                            fb_mark_dirty(fb, x, y, w, h);
+                        break;
+                    }
+                    default:
+                        if (fb->direct_writes)
+                            fb->data[y * LAYERS_W + x] = c;
+                        else
+                            fb_set_pixel_rgb(fb, x, y, c);
+                        break;
+                }
+            }
+            if (fb_layers_compose(&stack) != ESP_OK)
+            {
+                LOGE("fb_layers_compose() failed");
+                break;
+            }
+
+            memset(ref, 0, sizeof(ref));
+            for (size_t l = 0; l < LAYERS_COUNT; l++)
+                for (size_t i = 0; i < LAYERS_W * LAYERS_H; i++)
+                {
+                    fb_layer_t *layer = &stack.layers[l];
+                    rgb_t s = layer->fb->data[i];
+                    ref[i].r = blend_reference(ref[i].r, s.r, layer->mode, layer->opacity);
+                    ref[i].g = blend_reference(ref[i].g, s.g, layer->mode, layer->opacity);
+                    ref[i].b = blend_reference(ref[i].b, s.b, layer->mode, layer->opacity);
+                }
+            size_t i = 0;
+            while (i < LAYERS_W * LAYERS_H && rgb_to_code(out.data[i]) == rgb_to_code(ref[i]))
+                i++;
+            if (i < LAYERS_W * LAYERS_H)
+            {
+                LOGE("Round %d: pixel %u, %u is %06x, expected %06x", n, (unsigned)(i % LAYERS_W),
+                        (unsigned)(i / LAYERS_W), (unsigned)rgb_to_code(out.data[i]), (unsigned)rgb_to_code(ref[i]));
+                break;
+            }
+        }
+        ok = n == LAYERS_ROUNDS;
+    } while (0);
+
+    for (size_t i = 0; i < ready; i++)
+        fb_free(&fbs[i]);
+    fb_free(&out);
+    return ok;
+}
+
+#define SUB_W 16
+#define SUB_H 12
+#define SUB_ROUNDS 3000
+#define SUB_TOLERANCE 2
+
+// Saturating add of color scaled by weight, skipped outside
+static void plot_reference(framebuffer_t *fb, int x, int y, rgb_t color, uint8_t weight)
+{
+    if (x < 0 || y < 0 || x >= (int)fb->width || y >= (int)fb->height)
+        return;
+    rgb_t *p = fb->data + y * fb->width + x;
+    p->r = qadd8(p->r, (color.r * weight) >> 8);
+    p->g = qadd8(p->g, (color.g * weight) >> 8);
+    p->b = qadd8(p->b, (color.b * weight) >> 8);
+}
+
+// Wu line in float, sampled like fb_draw_lineq_rgb(): one step per pixel
+// of major axis between rounded ends
+static void line_reference(framebuffer_t *fb, fb_q8_t qx0, fb_q8_t qy0, fb_q8_t qx1, fb_q8_t qy1, rgb_t color)
+{
+    bool steep = abs(qy1 - qy0) > abs(qx1 - qx0);
+    float x0 = (steep ? qy0 : qx0) / 256.0f, y0 = (steep ? qx0 : qy0) / 256.0f;
+    float x1 = (steep ? qy1 : qx1) / 256.0f, y1 = (steep ? qx1 : qy1) / 256.0f;
+    if (x0 > x1)
+    {
+        float t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    float gradient = x1 > x0 ? (y1 - y0) / (x1 - x0) : 0;
+    for (int x = (int)floorf(x0 + 0.5f); x <= (int)floorf(x1 + 0.5f); x++)
+    {
+        float y = y0 + gradient * (x - x0);
+        int py = (int)floorf(y);
+        int f = (int)((y - py) * 256);
+        if (f > 255)
+            f = 255;
+        if (steep)
+        {
+            plot_reference(fb, py, x, color, 255 - f);
+            plot_reference(fb, py + 1, x, color, f);
+        }
+        else
+        {
+            plot_reference(fb, x, py, color, 255 - f);
+            plot_reference(fb, x, py + 1, color, f);
+        }
+    }
+}
+
+// Every channel within SUB_TOLERANCE of reference if any, every lit pixel in bounds
+static bool subpixel_match(const framebuffer_t *fb, const framebuffer_t *ref, const char *what, int n)
+{
+    fb_rect_t b = fb->bounds;
+    for (size_t y = 0; y < SUB_H; y++)
+        for (size_t x = 0; x < SUB_W; x++)
+        {
+            rgb_t c = fb->data[y * SUB_W + x], r = ref ? ref->data[y * SUB_W + x] : c;
+            EXPECT(abs(c.r - r.r) <= SUB_TOLERANCE && abs(c.g - r.g) <= SUB_TOLERANCE
+                    && abs(c.b - r.b) <= SUB_TOLERANCE,
+                    "%s, round %d: pixel %u, %u is %06x, expected %06x", what, n,
+                    (unsigned)x, (unsigned)y, (unsigned)rgb_to_code(c), (unsigned)rgb_to_code(r));
+            EXPECT(!rgb_to_code(c) || (x >= b.x && x < (size_t)b.x + b.w && y >= b.y && y < (size_t)b.y + b.h),
+                    "%s, round %d: pixel %u, %u is outside of bounds", what, n, (unsigned)x, (unsigned)y);
+        }
+    return true;
+}
+
+// Q8.8 points against fb_set_pixelf_rgb() and lines against float Wu
+// line, both crossing framebuffer edges. Circles only have to stay in bounds
+static bool check_subpixel(void)
+{
+    framebuffer_t fb, ref;
+    bool ok = false;
+
+    if (fb_init(&fb, SUB_W, SUB_H, render_nothing) != ESP_OK)
+    {
+        LOGE("fb_init() failed");
+        return false;
+    }
+    if (fb_init(&ref, SUB_W, SUB_H, render_nothing) != ESP_OK)
+    {
+        LOGE("fb_init() failed");
+        fb_free(&fb);
+        return false;
+    }
+
+    int n = 0;
+    for (; n < SUB_ROUNDS; n++)
+    {
+        rgb_t c = rgb_from_code(lcg());
+        fb_clear(&fb);
+        memset(ref.data, 0, sizeof(rgb_t) * SUB_W * SUB_H);
+
+        // fb_set_pixelf_rgb() truncates toward zero, so points are compared
+        // at positive coordinates only, up to the far edges
+        fb_q8_t x = lcg() % FB_Q8(SUB_W), y = lcg() % FB_Q8(SUB_H);
+        fb_set_pixelq_rgb(&fb, x, y, c);
+        fb_set_pixelf_rgb(&ref, x / 256.0f, y / 256.0f, c);
+        if (!subpixel_match(&fb, &ref, "fb_set_pixelq_rgb", n))
+            break;
+
+        fb_clear(&fb);
+        memset(ref.data, 0, sizeof(rgb_t) * SUB_W * SUB_H);
+        fb_q8_t x0 = lcg() % FB_Q8(SUB_W + 16) - FB_Q8(8), y0 = lcg() % FB_Q8(SUB_H + 16) - FB_Q8(8);
+        fb_q8_t x1 = lcg() % FB_Q8(SUB_W + 16) - FB_Q8(8), y1 = lcg() % FB_Q8(SUB_H + 16) - FB_Q8(8);
+        fb_draw_lineq_rgb(&fb, x0, y0, x1, y1, c);
+        line_reference(&ref, x0, y0, x1, y1, c);
+        if (!subpixel_match(&fb, &ref, "fb_draw_lineq_rgb", n))
+            break;
+
+        fb_clear(&fb);
+        fb_draw_circleq_rgb(&fb, x0, y0, 128 + lcg() % FB_Q8(8), c);
+        if (!subpixel_match(&fb, NULL, "fb_draw_circleq_rgb", n))
+            break;
+    }
+    ok = n == SUB_ROUNDS;
+
+    fb_free(&ref);
+    fb_free(&fb);
+    return ok;
+}
+
+// Physical coordinates of LED at chain offset, panels and LEDs in them
+// follow each other row by row
+static void chain_position(const fb_layout_t *l, size_t offs, size_t *px, size_t *py)
+{
+    size_t tw = l->tile_width ? l->tile_width : l->width;
+    size_t th = l->tile_height ? l->tile_height : l->height;
+    size_t tiles_x = l->width / tw;
+    size_t tile = offs / (tw * th), led = offs % (tw * th);
+    size_t tx = tile % tiles_x, ty = tile / tiles_x;
+    size_t lx = led % tw, ly = led / tw;
+
+    if (l->tiles_serpentine && (ty & 1))
+        tx = tiles_x - 1 - tx;
+    if (l->serpentine && (ly & 1))
+        lx = tw - 1 - lx;
+    *px = tx * tw + lx;
+    *py = ty * th + ly;
+}
+
+// Walks the LED chain of every layout and checks that the table sends
+// rotated logical coordinates of each LED to its offset
+static bool check_xymap_layout(const fb_layout_t *l)
+{
+    fb_xymap_t map;
+    EXPECT(fb_xymap_init(&map, l) == ESP_OK, "fb_xymap_init() failed");
+
+    bool swap = l->rotation == FB_ROTATE_90 || l->rotation == FB_ROTATE_270;
+    bool ok = map.width == (swap ? l->height : l->width) && map.height == (swap ? l->width : l->height);
+    if (!ok)
+        LOGE("%ux%u rotation %d: mapping is %ux%u", (unsigned)l->width, (unsigned)l->height, l->rotation,
+                (unsigned)map.width, (unsigned)map.height);
+
+    for (size_t offs = 0; ok && offs < l->width * l->height; offs++)
+    {
+        size_t px, py, x, y;
+        chain_position(l, offs, &px, &py);
+        // Clockwise rotation, top left corner of logical frame is
+        // bottom left LED when rotated by 90
+        switch (l->rotation)
+        {
+            case FB_ROTATE_90:
+                x = l->height - 1 - py;
+                y = px;
+                break;
+            case FB_ROTATE_180:
+                x = l->width - 1 - px;
+                y = l->height - 1 - py;
+                break;
+            case FB_ROTATE_270:
+                x = py;
+                y = l->width - 1 - px;
+                break;
+            default:
+                x = px;
+                y = py;
+        }
+        ok = fb_xymap_offs(&map, x, y) == offs && fb_xymap_cb(&map, x, y) == offs;
+        if (!ok)
+            LOGE("%ux%u tiles %ux%u serpentine %d/%d rotation %d: %u, %u maps to %u, expected %u",
+                    (unsigned)l->width, (unsigned)l->height, (unsigned)l->tile_width, (unsigned)l->tile_height,
+                    l->serpentine, l->tiles_serpentine, l->rotation, (unsigned)x, (unsigned)y,
+                    (unsigned)fb_xymap_offs(&map, x, y), (unsigned)offs);
+    }
+
+    // Blit puts every logical pixel to its LED
+    if (ok)
+    {
+        framebuffer_t fb = { .data = blit_buf, .width = map.width, .height = map.height };
+        static rgb_t leds[BUF_SIZE];
+        fb_xymap_blit(&map, &fb, leds);
+        for (size_t i = 0; ok && i < map.width * map.height; i++)
+            ok = rgb_to_code(leds[map.table[i]]) == rgb_to_code(blit_buf[i]);
+        if (!ok)
+            LOGE("fb_xymap_blit() misplaced pixels");
+    }
+
+    fb_xymap_free(&map);
+    return ok;
+}
+
+static bool check_xymap(void)
+{
+    static const size_t sizes[][4] = {
+        // width, height, tile width, tile height
+        { 1, 1, 0, 0 }, { 5, 3, 0, 0 }, { 16, 16, 0, 0 }, { 32, 8, 8, 8 },
+        { 24, 12, 8, 4 }, { 12, 24, 4, 8 }, { 6, 9, 2, 3 }, { 32, 32, 16, 8 },
+    };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        for (int flags = 0; flags < 4; flags++)
+            for (int rot = FB_ROTATE_0; rot <= FB_ROTATE_270; rot++)
+            {
+                fb_layout_t l = {
+                    .width = sizes[s][0],
+                    .height = sizes[s][1],
+                    .tile_width = sizes[s][2],
+                    .tile_height = sizes[s][3],
+                    .serpentine = flags & 1,
+                    .tiles_serpentine = flags & 2,
+                    .rotation = rot,
+                };
+                if (!check_xymap_layout(&l))
+                    return false;
+            }
+
+    // A few offsets by hand: 4x2 serpentine, and 3x2 rotated by 90,
+    // which is 2 wide and 3 high
+    fb_xymap_t map;
+    fb_layout_t l = { .width = 4, .height = 2, .serpentine = true };
+    EXPECT(fb_xymap_init(&map, &l) == ESP_OK, "fb_xymap_init() failed");
+    bool ok = fb_xymap_offs(&map, 0, 1) == 7 && fb_xymap_offs(&map, 3, 1) == 4;
+    fb_xymap_free(&map);
+    EXPECT(ok, "Serpentine row is not reversed");
+
+    l = (fb_layout_t){ .width = 3, .height = 2, .rotation = FB_ROTATE_90 };
+    EXPECT(fb_xymap_init(&map, &l) == ESP_OK, "fb_xymap_init() failed");
+    ok = fb_xymap_offs(&map, 0, 0) == 3 && fb_xymap_offs(&map, 1, 0) == 0 && fb_xymap_offs(&map, 0, 2) == 5;
+    fb_xymap_free(&map);
+    EXPECT(ok, "Rotation by 90 is not clockwise");
+
+    // Panels must tile the matrix, table offsets must fit
+    l = (fb_layout_t){ .width = 10, .height = 8, .tile_width = 4, .tile_height = 4 };
+    EXPECT(fb_xymap_init(&map, &l) == ESP_ERR_INVALID_ARG, "Partial panels accepted");
+    l = (fb_layout_t){ .width = 512, .height = 129 };
+    EXPECT(fb_xymap_init(&map, &l) == ESP_ERR_INVALID_ARG, "Too large matrix accepted");
+
+    return true;
+}
+
+#define SCHED_FPS 50
+#define SCHED_RUN_MS 500
+// Frames expected in SCHED_RUN_MS, pacing may be off by 20%
+#define SCHED_FRAMES (SCHED_RUN_MS * SCHED_FPS / 1000)
+#define SCHED_FRAMES_OK(n) ((n) >= SCHED_FRAMES * 4 / 5 && (n) <= SCHED_FRAMES * 6 / 5 + 1)
+// Other tasks (and host processes) may delay a frame past its period now and then
+#define SCHED_JITTER_SKIPS (SCHED_FRAMES / 10)
+
+typedef struct
+{
+    fb_scheduler_t *sched;
+    volatile bool complete;   // Transfer completes right away, otherwise never
+} sched_ctx_t;
+
+static volatile uint32_t sched_draw_ms;
+
+static esp_err_t sched_draw(framebuffer_t *fb)
+{
+    if (sched_draw_ms)
+        vTaskDelay(pdMS_TO_TICKS(sched_draw_ms));
+    return fb_set_pixel_rgb(fb, fb->frame_num % fb->width, 0, rgb_from_code(0xffffff));
+}
+
+static esp_err_t sched_render(framebuffer_t *fb, void *arg)
+{
+    sched_ctx_t *ctx = (sched_ctx_t *)arg;
+    (void)fb;
+    if (ctx->complete)
+        fb_scheduler_tx_done(ctx->sched);
+    return ESP_OK;
+}
+
+static bool sched_run(fb_scheduler_t *sched, sched_ctx_t *ctx, fb_scheduler_stats_t *st)
+{
+    EXPECT(fb_scheduler_start(sched, SCHED_FPS, sched_draw, ctx) == ESP_OK, "fb_scheduler_start() failed");
+    vTaskDelay(pdMS_TO_TICKS(SCHED_RUN_MS));
+    EXPECT(fb_scheduler_stop(sched) == ESP_OK, "fb_scheduler_stop() failed");
+    EXPECT(fb_scheduler_get_stats(sched, st, true) == ESP_OK, "fb_scheduler_get_stats() failed");
+    return true;
+}
+
+static bool check_scheduler(void)
+{
+    static framebuffer_t fb;
+    static fb_scheduler_t sched;
+    sched_ctx_t ctx = { .sched = &sched, .complete = true };
+    fb_scheduler_stats_t st, zero = { 0 };
+    bool ok = false;
+
+    EXPECT(fb_init(&fb, 16, 16, sched_render) == ESP_OK, "fb_init() failed");
+    if (fb_scheduler_init(&sched, &fb, true) != ESP_OK)
+    {
+        LOGE("fb_scheduler_init() failed");
+        fb_free(&fb);
+        return false;
+    }
+
+    do
+    {
+        // Light frames are paced, neither skipped nor queued
+        sched_draw_ms = 0;
+        if (!sched_run(&sched, &ctx, &st))
+            break;
+        if (!SCHED_FRAMES_OK(st.frames + st.skipped) || st.skipped > SCHED_JITTER_SKIPS || st.errors || st.timeouts)
+        {
+            LOGE("Light load: %u frames, %u skipped, %u errors, %u timeouts, expected %u frames",
+                    st.frames, st.skipped, st.errors, st.timeouts, SCHED_FRAMES);
+            break;
+        }
+
+        // Statistics were reset by previous read
+        fb_scheduler_get_stats(&sched, &st, false);
+        if (memcmp(&st, &zero, sizeof(st)))
+        {
+            LOGE("Statistics not reset: %u frames, draw max %u us", st.frames, st.draw_us_max);
+            break;
+        }
+
+        // Drawing takes over two periods, missed frames are skipped
+        sched_draw_ms = 50;
+        if (!sched_run(&sched, &ctx, &st))
+            break;
+        if (!SCHED_FRAMES_OK(st.frames + st.skipped) || st.skipped < st.frames || st.timeouts)
+        {
+            LOGE("Overload: %u frames, %u skipped, %u timeouts, expected %u frames and skipped in total",
+                    st.frames, st.skipped, st.timeouts, SCHED_FRAMES);
+            break;
+        }
+
+        // Transfer never completes, scheduler goes on after timeout
+        sched_draw_ms = 0;
+        ctx.complete = false;
+        sched.tx_timeout_ms = 30;
+        if (!sched_run(&sched, &ctx, &st))
+            break;
+        // Last transfer is waited for by stop, not counted
+        if (st.frames < SCHED_FRAMES / 4 || st.timeouts + 1 != st.frames || st.errors)
+        {
+            LOGE("Transfer timeout: %u frames, %u timeouts, %u errors", st.frames, st.timeouts, st.errors);
+            break;
+        }
+        ok = true;
+    } while (0);
+
+    fb_scheduler_free(&sched);
+    fb_free(&fb);
+    return ok;
+}
+
+const check_t fb_checks[] = {
+    { "fb_blit_rect", check_blit },
+    { "fb bounds", check_bounds },
+    { "fb_layers_compose", check_layers },
+    { "fb subpixel", check_subpixel },
+    { "fb_xymap", check_xymap },
+    { "fb_scheduler", check_scheduler },
+};
+
+const size_t fb_check_count = sizeof(fb_checks) / sizeof(fb_checks[0]);
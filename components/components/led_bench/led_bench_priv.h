@@ -0,0 +1,113 @@
+/**
+ * @file led_bench_priv.h
+ *
+ * Internals shared by led_bench.c and led_bench_fb.c
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __LED_BENCH_PRIV_H__
+#define __LED_BENCH_PRIV_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <color.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#ifdef ESP_PLATFORM
+
+#include <esp_log.h>
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+
+static const char *TAG = "led_bench";
+
+#define LOG(fmt, ...) ESP_LOGI(TAG, fmt, ##__VA_ARGS__)
+#define LOGE(fmt, ...) ESP_LOGE(TAG, fmt, ##__VA_ARGS__)
+
+// Let idle task feed the watchdog during long checks
+#define YIELD() vTaskDelay(1)
+
+#define LED_BENCH_UNIT "cycles"
+#define LED_BENCH_UNITS_PER_SECOND (esp_rom_get_cpu_ticks_per_us() * 1000000.0f)
+
+// Cycle counter wraps in seconds, but differences of sweeps fit
+typedef uint32_t timestamp_t;
+
+static inline timestamp_t now(void)
+{
+    return esp_cpu_get_ccount();
+}
+
+#else
+
+#include <stdio.h>
+#include <time.h>
+
+#define LOG(fmt, ...) printf(fmt "\n", ##__VA_ARGS__)
+#define LOGE(fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#define YIELD() do {} while (0)
+
+#define LED_BENCH_UNIT "ns"
+#define LED_BENCH_UNITS_PER_SECOND 1e9f
+
+// 32 bits of nanoseconds wrap every 4.3 seconds
+typedef uint64_t timestamp_t;
+
+static inline timestamp_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#endif
+
+#define SWEEP_CALLS 65536
+
+#define BUF_SIZE 1024
+#define MATRIX_W 32
+#define MATRIX_H (BUF_SIZE / MATRIX_W)
+
+extern uint32_t lcg_state;
+
+static inline uint32_t lcg(void)
+{
+    lcg_state = lcg_state * 1664525 + 1013904223;
+    return lcg_state >> 8;
+}
+
+extern const rgb_t bench_palette[16];
+
+typedef struct
+{
+    const char *name;
+    uint32_t (*run)(void);
+    uint32_t calls;
+    bool batch;         // Batch primitive with its own loop, sweep overhead isn't subtracted
+} bench_t;
+
+typedef struct
+{
+    const char *name;
+    bool (*check)(void);
+} check_t;
+
+#define EXPECT(COND, fmt, ...) \
+    do { \
+        if (!(COND)) \
+        { \
+            LOGE(fmt, ##__VA_ARGS__); \
+            return false; \
+        } \
+    } while (0)
+
+// Framebuffer benchmarks and checks, led_bench_fb.c
+void fb_bench_init(void);
+extern const bench_t fb_benchmarks[];
+extern const size_t fb_benchmark_count;
+extern const check_t fb_checks[];
+extern const size_t fb_check_count;
+
+#endif /* __LED_BENCH_PRIV_H__ */
@@ -0,0 +1,145 @@
+/**
+ * @file bench_translate.c
+ *
+ * Correctness and cost of the RMT translator of led_strip on simulated RMT
+ *
+ * Strips of every LED type are flushed with random pixels at full and at
+ * reduced brightness. Every transmitted item is checked against the bit
+ * timing of the LED type, then the translator is timed over rounds of
+ * flushes, the best round counts. Cost per byte is what the refill
+ * interrupt spends on target, scaled by the speed of the CPU.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <led_strip.h>
+#include "rmt_sim.h"
+
+#define LEDS    1000
+#define FLUSHES 20
+#define ROUNDS  20
+
+#ifdef CONFIG_LED_STRIP_RMT_LUT
+#define TRANSLATOR "lookup table"
+#else
+#define TRANSLATOR "bit loop"
+#endif
+
+// Bit timing of LED types in ns: high and low time of 0, high and low time of 1
+static const uint32_t timing[LED_STRIP_TYPE_MAX][4] = {
+    [LED_STRIP_WS2812]  = { 400, 1000, 1000, 400 },
+    [LED_STRIP_SK6812]  = { 300, 900, 600, 600 },
+    [LED_STRIP_APA106]  = { 350, 1360, 1360, 350 },
+    [LED_STRIP_SM16703] = { 300, 900, 1360, 350 },
+};
+
+static const char *const names[LED_STRIP_TYPE_MAX] = { "WS2812", "SK6812", "APA106", "SM16703" };
+
+// RMT ticks of ns at APB clock divided by 2
+static uint32_t ticks(uint32_t ns)
+{
+    return (uint32_t)((float)APB_CLK_FREQ / 2 / 1e09f * ns);
+}
+
+static bool check_items(const led_strip_t *strip)
+{
+    size_t count;
+    const rmt_item32_t *items = rmt_sim_items(strip->channel, &count);
+    const uint32_t *t = timing[strip->type];
+    size_t size = strip->length * (strip->is_rgbw ? 4 : 3);
+
+    if (count != size * 8)
+    {
+        printf("%s: %u items, expected %u\n", names[strip->type], (unsigned)count, (unsigned)size * 8);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t b = strip->buf[i / 8];
+        if (strip->brightness != 255)
+            b = scale8_video(b, strip->brightness);
+        bool one = b & (0x80 >> (i % 8));
+        const rmt_item32_t *it = &items[i];
+        if (it->level0 != 1 || it->level1 != 0
+                || it->duration0 != ticks(one ? t[2] : t[0]) || it->duration1 != ticks(one ? t[3] : t[1]))
+        {
+            printf("%s, brightness %u: item %u of byte 0x%02x is %u/%u %u/%u\n", names[strip->type],
+                    strip->brightness, (unsigned)i, b, it->level0, it->duration0, it->level1, it->duration1);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void fill(led_strip_t *strip)
+{
+    for (size_t i = 0; i < strip->length; i++)
+        led_strip_set_pixel(strip, i, rgb_from_code(rand()));
+}
+
+int main(void)
+{
+    static const uint8_t levels[] = { 255, 100 };
+    bool ok = true;
+
+    led_strip_install();
+    printf("translator: %s\n\n", TRANSLATOR);
+
+    for (led_strip_type_t type = 0; type < LED_STRIP_TYPE_MAX; type++)
+    {
+        led_strip_t strip = {
+            .type = type,
+            .length = LEDS,
+            .gpio = 0,
+            .channel = RMT_CHANNEL_0 + type,
+            .brightness = 255,
+        };
+        if (led_strip_init(&strip) != ESP_OK)
+            return 1;
+        fill(&strip);
+        for (size_t l = 0; l < sizeof(levels); l++)
+        {
+            strip.brightness = levels[l];
+            bool valid = led_strip_flush(&strip) == ESP_OK && check_items(&strip);
+            printf("%-8s brightness %3u: %s\n", names[type], levels[l], valid ? "ok" : "FAIL");
+            ok = ok && valid;
+        }
+        led_strip_free(&strip);
+    }
+
+    led_strip_t strip = {
+        .type = LED_STRIP_WS2812,
+        .length = LEDS,
+        .gpio = 0,
+        .channel = RMT_CHANNEL_0,
+    };
+    if (led_strip_init(&strip) != ESP_OK)
+        return 1;
+    fill(&strip);
+
+    printf("\n%d LEDs, best of %d rounds of %d flushes\n", LEDS, ROUNDS, FLUSHES);
+    printf("brightness  ns/byte  ns/refill  refills/flush\n");
+    for (size_t l = 0; l < sizeof(levels); l++)
+    {
+        strip.brightness = levels[l];
+        // First flush rebuilds brightness table
+        led_strip_flush(&strip);
+        rmt_sim_stats_t best = { .translate_ns = UINT64_MAX };
+        for (int r = 0; r < ROUNDS; r++)
+        {
+            rmt_sim_stats_t s;
+            rmt_sim_reset_stats();
+            for (int f = 0; f < FLUSHES; f++)
+                led_strip_flush(&strip);
+            rmt_sim_stats(&s);
+            if (s.translate_ns < best.translate_ns)
+                best = s;
+        }
+        printf("%10u  %7.2f  %9.1f  %13u\n", levels[l], (float)best.translate_ns / best.bytes,
+                (float)best.translate_ns / best.refills, best.refills / FLUSHES);
+    }
+    led_strip_free(&strip);
+
+    return ok ? 0 : 1;
+}
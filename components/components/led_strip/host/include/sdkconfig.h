@@ -0,0 +1,21 @@
+/*
+ * sdkconfig.h replacement for host builds of led_strip
+ *
+ * Replaces the one of the host shim. bench_translate_bits is built with
+ * HOST_RMT_NO_LUT to time the translator without lookup table.
+ */
+#ifndef __SDKCONFIG_H__
+#define __SDKCONFIG_H__
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_IDF_TARGET "esp32"
+
+#define CONFIG_FREERTOS_HZ 1000
+
+#define CONFIG_LED_STRIP_FLUSH_TIMEOUT 1000
+#define CONFIG_LED_STRIP_PAUSE_LENGTH 0
+#ifndef HOST_RMT_NO_LUT
+#define CONFIG_LED_STRIP_RMT_LUT 1
+#endif
+
+#endif /* __SDKCONFIG_H__ */
@@ -0,0 +1,163 @@
+/**
+ * @file rmt_sim.c
+ *
+ * RMT transmit driver on simulated peripheral for host builds of led_strip
+ *
+ * rmt_write_sample() calls the translator the way the ESP-IDF 4.x driver
+ * does: once for a whole memory block of items when transmission starts,
+ * then for half a block at a time, as the refill interrupt would. Items
+ * are kept, so they can be checked, and time spent in the translator is
+ * summed up. Transmission itself takes no time.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include "rmt_sim.h"
+
+// Items in memory block of a channel
+#define BLOCK_ITEMS 64
+
+typedef struct
+{
+    bool installed;
+    sample_to_rmt_t translator;
+    void *context;
+    size_t item_num;        // Passed to translator, locates the channel for rmt_translator_get_context()
+    rmt_item32_t *items;
+    size_t count, capacity;
+} channel_t;
+
+static channel_t channels[RMT_CHANNEL_MAX];
+static rmt_sim_stats_t stats;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+esp_err_t rmt_config(const rmt_config_t *rmt_param)
+{
+    if (!rmt_param || rmt_param->channel >= RMT_CHANNEL_MAX || rmt_param->rmt_mode != RMT_MODE_TX)
+        return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags)
+{
+    (void)rx_buf_size;
+    (void)intr_alloc_flags;
+    if (channel >= RMT_CHANNEL_MAX)
+        return ESP_ERR_INVALID_ARG;
+    if (channels[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    channels[channel].installed = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+    if (channel >= RMT_CHANNEL_MAX || !channels[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    free(channels[channel].items);
+    channels[channel] = (channel_t){ 0 };
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn)
+{
+    if (channel >= RMT_CHANNEL_MAX || !fn)
+        return ESP_ERR_INVALID_ARG;
+    if (!channels[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    channels[channel].translator = fn;
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context)
+{
+    if (channel >= RMT_CHANNEL_MAX || !channels[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    channels[channel].context = context;
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_get_context(const size_t *item_num, void **context)
+{
+    if (!item_num || !context)
+        return ESP_ERR_INVALID_ARG;
+    const channel_t *ch = (const channel_t *)((const char *)item_num - offsetof(channel_t, item_num));
+    *context = ch->context;
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done)
+{
+    (void)wait_tx_done;
+    if (channel >= RMT_CHANNEL_MAX || !src)
+        return ESP_ERR_INVALID_ARG;
+    channel_t *ch = &channels[channel];
+    if (!ch->installed || !ch->translator)
+        return ESP_ERR_INVALID_STATE;
+
+    // Translator may write a whole byte past the wanted number
+    size_t needed = src_size * 8 + BLOCK_ITEMS;
+    if (needed > ch->capacity)
+    {
+        rmt_item32_t *items = realloc(ch->items, needed * sizeof(rmt_item32_t));
+        if (!items)
+            return ESP_ERR_NO_MEM;
+        ch->items = items;
+        ch->capacity = needed;
+    }
+
+    size_t pos = 0, count = 0, wanted = BLOCK_ITEMS;
+    uint32_t refills = 0;
+    uint64_t start = now_ns();
+    while (pos < src_size)
+    {
+        size_t translated = 0;
+        ch->item_num = 0;
+        ch->translator(src + pos, ch->items + count, src_size - pos, wanted, &translated, &ch->item_num);
+        refills++;
+        if (!translated)
+            break;
+        pos += translated;
+        count += ch->item_num;
+        wanted = BLOCK_ITEMS / 2;
+    }
+    stats.translate_ns += now_ns() - start;
+    stats.refills += refills;
+    stats.bytes += pos;
+    stats.items += count;
+    ch->count = count;
+
+    return pos == src_size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time)
+{
+    (void)wait_time;
+    if (channel >= RMT_CHANNEL_MAX || !channels[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    return ESP_OK;
+}
+
+void rmt_sim_stats(rmt_sim_stats_t *s)
+{
+    *s = stats;
+}
+
+void rmt_sim_reset_stats(void)
+{
+    stats = (rmt_sim_stats_t){ 0 };
+}
+
+const rmt_item32_t *rmt_sim_items(rmt_channel_t channel, size_t *count)
+{
+    *count = channels[channel].count;
+    return channels[channel].items;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file rmt_sim.h
+ *
+ * Transmitted items and translator statistics of simulated RMT
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __RMT_SIM_H__
+#define __RMT_SIM_H__
+
+#include <stdint.h>
+#include <driver/rmt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    uint32_t refills;       ///< Translator calls, one per refill interrupt on target
+    uint32_t bytes;         ///< Translated bytes
+    uint32_t items;         ///< Produced RMT items
+    uint64_t translate_ns;  ///< Total time spent in translator
+} rmt_sim_stats_t;
+
+void rmt_sim_stats(rmt_sim_stats_t *stats);
+
+void rmt_sim_reset_stats(void);
+
+/**
+ * Items of the last rmt_write_sample() on channel
+ */
+const rmt_item32_t *rmt_sim_items(rmt_channel_t channel, size_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RMT_SIM_H__ */
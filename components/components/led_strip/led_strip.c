@@ -34,6 +34,7 @@
 #include <esp_log.h>
 #include <esp_attr.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ets_sys.h>
 #include <esp_idf_lib_helpers.h>
 
@@ -70,9 +71,76 @@ static const char *TAG = "led_strip";
 
 #define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
 
+typedef struct {
+    rmt_item32_t bit0, bit1;
+} led_rmt_t;
+
+static led_rmt_t rmt_items[LED_STRIP_TYPE_MAX] = { 0 };
+
+#ifdef CONFIG_LED_STRIP_RMT_LUT
+
+// RMT items for every possible nibble value, MSB first. Built by led_strip_install()
+static DRAM_ATTR rmt_item32_t nibble_items[LED_STRIP_TYPE_MAX][16][4];
+
+#ifdef LED_STRIP_BRIGHTNESS
+// Per-channel brightness tables, rebuilt by led_strip_flush() when brightness changes
+static DRAM_ATTR uint8_t brightness_lut[RMT_CHANNEL_MAX][256];
+static uint8_t brightness_lut_val[RMT_CHANNEL_MAX];
+#endif
+
 static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
                                    size_t wanted_num, size_t *translated_size, size_t *item_num,
-                                   const rmt_item32_t *bit0, const rmt_item32_t *bit1)
+                                   led_strip_type_t type)
+{
+    if (!src || !dest)
+    {
+        *translated_size = 0;
+        *item_num = 0;
+        return;
+    }
+    size_t size = 0;
+    size_t num = 0;
+    const uint8_t *psrc = (const uint8_t *)src;
+    rmt_item32_t *pdest = dest;
+    const rmt_item32_t (*items)[4] = nibble_items[type];
+#ifdef LED_STRIP_BRIGHTNESS
+    led_strip_t *strip;
+    esp_err_t r = rmt_translator_get_context(item_num, (void **)&strip);
+    const uint8_t *scale = r == ESP_OK && strip->brightness != 255 ? brightness_lut[strip->channel] : NULL;
+    if (scale)
+    {
+        while (size < src_size && num < wanted_num)
+        {
+            uint8_t b = scale[*psrc++];
+            memcpy(pdest, items[b >> 4], sizeof(items[0]));
+            memcpy(pdest + 4, items[b & 15], sizeof(items[0]));
+            pdest += 8;
+            num += 8;
+            size++;
+        }
+    }
+    else
+#endif
+    {
+        while (size < src_size && num < wanted_num)
+        {
+            uint8_t b = *psrc++;
+            memcpy(pdest, items[b >> 4], sizeof(items[0]));
+            memcpy(pdest + 4, items[b & 15], sizeof(items[0]));
+            pdest += 8;
+            num += 8;
+            size++;
+        }
+    }
+    *translated_size = size;
+    *item_num = num;
+}
+
+#else /* CONFIG_LED_STRIP_RMT_LUT */
+
+static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
+                                   size_t wanted_num, size_t *translated_size, size_t *item_num,
+                                   led_strip_type_t type)
 {
     if (!src || !dest)
     {
@@ -84,6 +152,8 @@ static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t s
     size_t num = 0;
     uint8_t *psrc = (uint8_t *)src;
     rmt_item32_t *pdest = dest;
+    const rmt_item32_t *bit0 = &rmt_items[type].bit0;
+    const rmt_item32_t *bit1 = &rmt_items[type].bit1;
 #ifdef LED_STRIP_BRIGHTNESS
     led_strip_t *strip;
     esp_err_t r = rmt_translator_get_context(item_num, (void **)&strip);
@@ -110,34 +180,30 @@ static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t s
     *item_num = num;
 }
 
-typedef struct {
-    rmt_item32_t bit0, bit1;
-} led_rmt_t;
-
-static led_rmt_t rmt_items[LED_STRIP_TYPE_MAX] = { 0 };
+#endif /* CONFIG_LED_STRIP_RMT_LUT */
 
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_WS2812].bit0, &rmt_items[LED_STRIP_WS2812].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, LED_STRIP_WS2812);
 }
 
 static void IRAM_ATTR sk6812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_SK6812].bit0, &rmt_items[LED_STRIP_SK6812].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, LED_STRIP_SK6812);
 }
 
 static void IRAM_ATTR apa106_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_APA106].bit0, &rmt_items[LED_STRIP_APA106].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, LED_STRIP_APA106);
 }
 
 static void IRAM_ATTR sm16703_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
                                          size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_SM16703].bit0, &rmt_items[LED_STRIP_SM16703].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, LED_STRIP_SM16703);
 }
 
 typedef enum {
@@ -176,6 +242,12 @@ void led_strip_install()
         rmt_items[i].bit1.level0 = 1;
         rmt_items[i].bit1.duration1 = (uint32_t)(ratio * led_params[i].t1l);
         rmt_items[i].bit1.level1 = 0;
+#ifdef CONFIG_LED_STRIP_RMT_LUT
+        for (size_t n = 0; n < 16; n++)
+            for (size_t bit = 0; bit < 4; bit++)
+                // MSB first
+                nibble_items[i][n][bit] = n & (8 >> bit) ? rmt_items[i].bit1 : rmt_items[i].bit0;
+#endif
     }
 }
 
@@ -220,6 +292,15 @@ esp_err_t led_strip_flush(led_strip_t *strip)
     CHECK_ARG(strip && strip->buf);
 
     CHECK(rmt_wait_tx_done(strip->channel, pdMS_TO_TICKS(CONFIG_LED_STRIP_FLUSH_TIMEOUT)));
+#if defined(CONFIG_LED_STRIP_RMT_LUT) && defined(LED_STRIP_BRIGHTNESS)
+    // Translator is idle now, safe to rebuild its brightness table
+    if (strip->brightness != brightness_lut_val[strip->channel])
+    {
+        for (size_t i = 0; i < 256; i++)
+            brightness_lut[strip->channel][i] = scale8_video(i, strip->brightness);
+        brightness_lut_val[strip->channel] = strip->brightness;
+    }
+#endif
     ets_delay_us(CONFIG_LED_STRIP_PAUSE_LENGTH);
     return rmt_write_sample(strip->channel, strip->buf,
                             strip->length * COLOR_SIZE(strip), false);
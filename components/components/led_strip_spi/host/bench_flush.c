@@ -0,0 +1,163 @@
+/**
+ * @file bench_flush.c
+ *
+ * Frame rate of blocking and double-buffered asynchronous flush of
+ * led_strip_spi on simulated SPI bus
+ *
+ * A frame is rendered by setting every pixel and then spinning for the
+ * rest of the render time, which is given relative to the time the SPI
+ * transfer of the frame takes. Blocking flush pays render and transfer
+ * time one after another, asynchronous flush overlaps them, so the frame
+ * takes as long as the longer of the two plus the copy of the buffer.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <led_strip_spi.h>
+#include "spi_sim.h"
+
+#define LEDS   300
+#define CLOCK  (4 * 1000 * 1000)
+#define FRAMES 200
+
+static volatile uint32_t callbacks;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void flush_cb(void *ctx)
+{
+    (void)ctx;
+    callbacks++;
+}
+
+static uint32_t transfer_us(void)
+{
+    return (uint64_t)LED_STRIP_SPI_BUFFER_SIZE(LEDS) * 8 * 1000000 / CLOCK;
+}
+
+static esp_err_t strip_init(led_strip_spi_t *strip, bool double_buffer)
+{
+    led_strip_spi_t s = LED_STRIP_SPI_DEFAULT();
+    s.length = LEDS;
+    s.clock_speed_hz = CLOCK;
+    s.max_transfer_sz = LED_STRIP_SPI_BUFFER_SIZE(LEDS);
+    s.double_buffer = double_buffer;
+    s.flush_cb = flush_cb;
+    *strip = s;
+    return led_strip_spi_init(strip);
+}
+
+static void strip_free(led_strip_spi_t *strip)
+{
+    led_strip_spi_free(strip);
+    spi_bus_remove_device(strip->device_handle);
+    spi_bus_free(strip->host_device);
+}
+
+static void render(led_strip_spi_t *strip, uint32_t frame, uint32_t us)
+{
+    uint64_t start = now_us();
+    for (int i = 0; i < LEDS; i++)
+        led_strip_spi_set_pixel(strip, i, rgb_from_values(frame + i, frame * 3, i));
+    // Yield, so simulated DMA is not starved on hosts with a single CPU
+    while (now_us() - start < us)
+        sched_yield();
+}
+
+// Returns frames per second
+static float run(bool async, uint32_t render_us, spi_sim_stats_t *stats)
+{
+    led_strip_spi_t strip;
+    if (strip_init(&strip, async) != ESP_OK)
+        return 0;
+
+    spi_sim_reset_stats();
+    callbacks = 0;
+    uint64_t start = now_us();
+    for (uint32_t f = 0; f < FRAMES; f++)
+    {
+        render(&strip, f, render_us);
+        if (async)
+            led_strip_spi_flush_async(&strip);
+        else
+            led_strip_spi_flush(&strip);
+    }
+    led_strip_spi_wait(&strip, portMAX_DELAY);
+    uint64_t elapsed = now_us() - start;
+    spi_sim_stats(stats);
+
+    strip_free(&strip);
+    return FRAMES * 1000000.0f / elapsed;
+}
+
+// Failed flush must leave the drawn frame in strip->buf
+static bool check_failed_flush(void)
+{
+    led_strip_spi_t strip;
+    if (strip_init(&strip, true) != ESP_OK)
+        return false;
+
+    size_t size = LED_STRIP_SPI_BUFFER_SIZE(LEDS);
+    uint8_t frame[size];
+    render(&strip, 1, 0);
+    led_strip_spi_flush_async(&strip);
+    render(&strip, 2, 0);
+    memcpy(frame, strip.buf, size);
+    void *buf = strip.buf, *dma_buf = strip.dma_buf;
+
+    spi_sim_fail_next(ESP_ERR_INVALID_STATE);
+    bool ok = led_strip_spi_flush_async(&strip) == ESP_ERR_INVALID_STATE
+        && strip.buf == buf && strip.dma_buf == dma_buf
+        && !memcmp(strip.buf, frame, size);
+    // Retry sends the same frame
+    ok = ok && led_strip_spi_flush_async(&strip) == ESP_OK
+        && led_strip_spi_wait(&strip, portMAX_DELAY) == ESP_OK
+        && !memcmp(strip.dma_buf, frame, size);
+
+    strip_free(&strip);
+    return ok;
+}
+
+int main(void)
+{
+    static const float ratios[] = { 0.25f, 0.5f, 1.0f, 2.0f };
+    bool ok = true;
+
+    if (led_strip_spi_install() != ESP_OK)
+        return 1;
+
+    bool failed = check_failed_flush();
+    printf("failed queueing keeps frame: %s\n\n", failed ? "ok" : "FAIL");
+    ok = ok && failed;
+
+    uint32_t xfer = transfer_us();
+    printf("%d LEDs, %u bytes at %d MHz: transfer %u us, %d frames\n\n", LEDS,
+            (unsigned)LED_STRIP_SPI_BUFFER_SIZE(LEDS), CLOCK / 1000000, xfer, FRAMES);
+    printf("render/xfer  render us  sync FPS  async FPS  speedup  tears  callbacks\n");
+
+    for (size_t i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++)
+    {
+        uint32_t render_us = xfer * ratios[i];
+        spi_sim_stats_t s_sync, s_async;
+        float sync = run(false, render_us, &s_sync);
+        uint32_t cb_sync = callbacks;
+        float async = run(true, render_us, &s_async);
+        uint32_t cb_async = callbacks;
+
+        printf("%11.2f  %9u  %8.1f  %9.1f  %6.2fx  %5u  %9s\n", ratios[i], render_us, sync, async,
+                async / sync, s_sync.tears + s_async.tears,
+                cb_sync == FRAMES && cb_async == FRAMES ? "ok" : "MISSING");
+        ok = ok && !s_sync.tears && !s_async.tears && cb_sync == FRAMES && cb_async == FRAMES
+            && s_sync.transfers == FRAMES && s_async.transfers == FRAMES;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+/*
+ * sdkconfig.h replacement for host builds of led_strip_spi
+ *
+ * Replaces the one of the host shim. Host behaves like ESP32 driving SK9822
+ * strip.
+ */
+#ifndef __SDKCONFIG_H__
+#define __SDKCONFIG_H__
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_IDF_TARGET "esp32"
+
+#define CONFIG_FREERTOS_HZ 1000
+
+#define CONFIG_LED_STRIP_SPI_USING_SK9822 1
+#define CONFIG_LED_STRIP_SPI_MUTEX_TIMEOUT_MS 1
+
+#endif /* __SDKCONFIG_H__ */
@@ -0,0 +1,205 @@
+/**
+ * @file spi_sim.c
+ *
+ * SPI master driver on simulated bus for host builds of led_strip_spi
+ *
+ * Every device has a task that plays DMA: it takes queued transactions,
+ * keeps the bus busy for as long as the transfer takes at configured clock,
+ * calls `post_cb` and passes the transaction to
+ * spi_device_get_trans_result(). Transmit buffer is hashed when transfer
+ * starts and when it ends, a mismatch means the frame was modified while
+ * it was being sent and is counted as a tear.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <driver/spi_master.h>
+#include "spi_sim.h"
+
+#define HOSTS 3
+
+struct spi_device_t
+{
+    spi_device_interface_config_t cfg;
+    QueueHandle_t queue;
+    QueueHandle_t done;
+};
+
+static bool bus_used[HOSTS];
+static atomic_uint tears, transfers;
+static atomic_ullong busy_ns;
+static esp_err_t fail_next = ESP_OK;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t ns)
+{
+    struct timespec ts = { .tv_sec = ns / 1000000000, .tv_nsec = ns % 1000000000 };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+// FNV-1a
+static uint32_t hash(const spi_transaction_t *t)
+{
+    const uint8_t *p = t->flags & SPI_TRANS_USE_TXDATA ? t->tx_data : t->tx_buffer;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < t->length / 8; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static void dma_task(void *arg)
+{
+    spi_device_handle_t dev = arg;
+    spi_transaction_t *t;
+
+    while (xQueueReceive(dev->queue, &t, portMAX_DELAY) == pdTRUE && t)
+    {
+        uint64_t start = now_ns();
+        uint64_t ns = (uint64_t)t->length * 1000000000 / dev->cfg.clock_speed_hz;
+        uint32_t h = hash(t);
+        sleep_until(start + ns);
+        if (hash(t) != h)
+            tears++;
+        transfers++;
+        busy_ns += ns;
+
+        if (dev->cfg.post_cb)
+            dev->cfg.post_cb(t);
+        xQueueSend(dev->done, &t, portMAX_DELAY);
+    }
+    xQueueSend(dev->done, &t, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, int dma_chan)
+{
+    (void)bus_config;
+    (void)dma_chan;
+    if (host_id >= HOSTS)
+        return ESP_ERR_INVALID_ARG;
+    if (bus_used[host_id])
+        return ESP_ERR_INVALID_STATE;
+    bus_used[host_id] = true;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id)
+{
+    if (host_id >= HOSTS)
+        return ESP_ERR_INVALID_ARG;
+    bus_used[host_id] = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config,
+        spi_device_handle_t *handle)
+{
+    if (host_id >= HOSTS || !dev_config || !handle || dev_config->clock_speed_hz <= 0)
+        return ESP_ERR_INVALID_ARG;
+    if (!bus_used[host_id])
+        return ESP_ERR_INVALID_STATE;
+
+    spi_device_handle_t dev = calloc(1, sizeof(struct spi_device_t));
+    if (!dev)
+        return ESP_ERR_NO_MEM;
+    dev->cfg = *dev_config;
+    int len = dev_config->queue_size > 0 ? dev_config->queue_size : 1;
+    dev->queue = xQueueCreate(len, sizeof(spi_transaction_t *));
+    dev->done = xQueueCreate(len + 1, sizeof(spi_transaction_t *));
+    if (!dev->queue || !dev->done || xTaskCreate(dma_task, "spi_dma", 2048, dev, 10, NULL) != pdPASS)
+    {
+        if (dev->queue)
+            vQueueDelete(dev->queue);
+        if (dev->done)
+            vQueueDelete(dev->done);
+        free(dev);
+        return ESP_ERR_NO_MEM;
+    }
+    *handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    if (!handle)
+        return ESP_ERR_INVALID_ARG;
+    if (uxQueueMessagesWaiting(handle->queue) || uxQueueMessagesWaiting(handle->done))
+        return ESP_ERR_INVALID_STATE;
+
+    // Stop DMA task and wait until it exits
+    spi_transaction_t *t = NULL;
+    xQueueSend(handle->queue, &t, portMAX_DELAY);
+    xQueueReceive(handle->done, &t, portMAX_DELAY);
+    vQueueDelete(handle->queue);
+    vQueueDelete(handle->done);
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait)
+{
+    if (!handle || !trans_desc || !trans_desc->length)
+        return ESP_ERR_INVALID_ARG;
+    if (fail_next != ESP_OK)
+    {
+        esp_err_t err = fail_next;
+        fail_next = ESP_OK;
+        return err;
+    }
+    return xQueueSend(handle->queue, &trans_desc, ticks_to_wait) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, TickType_t ticks_to_wait)
+{
+    if (!handle || !trans_desc)
+        return ESP_ERR_INVALID_ARG;
+    return xQueueReceive(handle->done, trans_desc, ticks_to_wait) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    esp_err_t err = spi_device_queue_trans(handle, trans_desc, portMAX_DELAY);
+    if (err != ESP_OK)
+        return err;
+    spi_transaction_t *t;
+    return spi_device_get_trans_result(handle, &t, portMAX_DELAY);
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    return spi_device_transmit(handle, trans_desc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void spi_sim_stats(spi_sim_stats_t *stats)
+{
+    stats->transfers = transfers;
+    stats->tears = tears;
+    stats->busy_us = busy_ns / 1000;
+}
+
+void spi_sim_reset_stats(void)
+{
+    transfers = 0;
+    tears = 0;
+    busy_ns = 0;
+}
+
+void spi_sim_fail_next(esp_err_t err)
+{
+    fail_next = err;
+}
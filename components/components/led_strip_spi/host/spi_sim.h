@@ -0,0 +1,38 @@
+/**
+ * @file spi_sim.h
+ *
+ * Statistics of simulated SPI bus
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __SPI_SIM_H__
+#define __SPI_SIM_H__
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    uint32_t transfers;     ///< Completed transfers
+    uint32_t tears;         ///< Transfers which buffer was modified while being sent
+    uint64_t busy_us;       ///< Total time bus was transferring
+} spi_sim_stats_t;
+
+void spi_sim_stats(spi_sim_stats_t *stats);
+
+void spi_sim_reset_stats(void);
+
+/**
+ * Make next spi_device_queue_trans() fail with given error
+ */
+void spi_sim_fail_next(esp_err_t err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPI_SIM_H__ */
@@ -72,6 +72,13 @@ fail:
 }
 
 #if HELPER_TARGET_IS_ESP32
+static void IRAM_ATTR post_transaction_cb(spi_transaction_t *t)
+{
+    led_strip_spi_t *strip = (led_strip_spi_t *)t->user;
+    if (strip && strip->flush_cb)
+        strip->flush_cb(strip->flush_cb_ctx);
+}
+
 static esp_err_t led_strip_spi_init_esp32(led_strip_spi_t *strip)
 {
     CHECK_ARG(strip);
@@ -99,6 +106,7 @@ static esp_err_t led_strip_spi_init_esp32(led_strip_spi_t *strip)
         .command_bits = 0,
         .address_bits = 0,
         .dummy_bits = 0,
+        .post_cb = post_transaction_cb,
     };
 
     if (xSemaphoreTake(mutex, MUTEX_TIMEOUT) != pdTRUE) {
@@ -117,6 +125,9 @@ static esp_err_t led_strip_spi_init_esp32(led_strip_spi_t *strip)
 
     /* XXX length is in bit */
     strip->transaction.length = LED_STRIP_SPI_BUFFER_SIZE(strip->length) * 8;
+    strip->transaction.user = strip;
+    strip->busy = false;
+    strip->dma_buf = NULL;
 
     /* type-specific initialization  */
 #if CONFIG_LED_STRIP_SPI_USING_SK9822
@@ -126,6 +137,15 @@ static esp_err_t led_strip_spi_init_esp32(led_strip_spi_t *strip)
         goto fail;
     }
 #endif
+    if (strip->double_buffer) {
+        strip->dma_buf = heap_caps_malloc(LED_STRIP_SPI_BUFFER_SIZE(strip->length), MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
+        if (strip->dma_buf == NULL) {
+            ESP_LOGE(TAG, "heap_caps_malloc()");
+            err = ESP_ERR_NO_MEM;
+            goto fail;
+        }
+        memcpy(strip->dma_buf, strip->buf, LED_STRIP_SPI_BUFFER_SIZE(strip->length));
+    }
     ESP_LOGD(TAG, "SPI buffer initialized");
 
     err = spi_bus_initialize(strip->host_device, &bus_config, strip->dma_chan);
@@ -228,34 +248,73 @@ esp_err_t led_strip_spi_free(led_strip_spi_t *strip)
 {
     CHECK_ARG(strip);
 
+#if HELPER_TARGET_IS_ESP32
+    CHECK(led_strip_spi_wait(strip, portMAX_DELAY));
+    free(strip->dma_buf);
+    strip->dma_buf = NULL;
+#endif
     free(strip->buf);
     return ESP_OK;
 }
 
 #if HELPER_TARGET_IS_ESP32
-static esp_err_t led_strip_spi_flush_esp32(led_strip_spi_t *strip)
+static esp_err_t led_strip_spi_wait_esp32(led_strip_spi_t *strip, TickType_t timeout)
 {
-    esp_err_t err = ESP_FAIL;
+    esp_err_t err;
     spi_transaction_t* t;
 
     CHECK_ARG(strip);
-    if (!strip->transaction.tx_buffer) {
+    if (!strip->busy) {
+        return ESP_OK;
+    }
+    err = spi_device_get_trans_result(strip->device_handle, &t, timeout);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_TIMEOUT) {
+            ESP_LOGE(TAG, "spi_device_get_trans_result(): %s", esp_err_to_name(err));
+        }
+        return err;
+    }
+    strip->busy = false;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_flush_async_esp32(led_strip_spi_t *strip)
+{
+    esp_err_t err;
+
+    CHECK_ARG(strip);
+    CHECK(led_strip_spi_wait_esp32(strip, portMAX_DELAY));
+
+    if (strip->double_buffer) {
+        /* DMA owns the frame just drawn, the renderer continues on a copy of it */
+        void *front = strip->buf;
+        strip->buf = strip->dma_buf;
+        strip->dma_buf = front;
+        strip->transaction.tx_buffer = front;
+    } else {
         strip->transaction.tx_buffer = strip->buf;
     }
-    strip->transaction.tx_buffer = strip->buf;
     err = spi_device_queue_trans(strip->device_handle, &strip->transaction, portMAX_DELAY);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "spi_device_queue_trans(): %s", esp_err_to_name(err));
-        goto fail;
+        if (strip->double_buffer) {
+            /* Frame was not sent, give it back to the renderer */
+            strip->dma_buf = strip->buf;
+            strip->buf = (void *)strip->transaction.tx_buffer;
+        }
+        return err;
     }
-    err = spi_device_get_trans_result(strip->device_handle, &t, portMAX_DELAY);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "spi_device_get_trans_result(): %s", esp_err_to_name(err));
-        goto fail;
+    strip->busy = true;
+    if (strip->double_buffer) {
+        memcpy(strip->buf, strip->dma_buf, LED_STRIP_SPI_BUFFER_SIZE(strip->length));
     }
-    err = ESP_OK;
-fail:
-    return err;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_flush_esp32(led_strip_spi_t *strip)
+{
+    CHECK(led_strip_spi_flush_async_esp32(strip));
+    return led_strip_spi_wait_esp32(strip, portMAX_DELAY);
 }
 #endif
 
@@ -321,6 +380,29 @@ esp_err_t led_strip_spi_flush(led_strip_spi_t*strip)
 #endif
 }
 
+esp_err_t led_strip_spi_flush_async(led_strip_spi_t *strip)
+{
+#if HELPER_TARGET_IS_ESP32
+    return led_strip_spi_flush_async_esp32(strip);
+#elif HELPER_TARGET_IS_ESP8266
+    return led_strip_spi_flush_esp8266(strip);
+#else
+#error "Unknown target"
+#endif
+}
+
+esp_err_t led_strip_spi_wait(led_strip_spi_t *strip, TickType_t timeout)
+{
+#if HELPER_TARGET_IS_ESP32
+    return led_strip_spi_wait_esp32(strip, timeout);
+#elif HELPER_TARGET_IS_ESP8266
+    CHECK_ARG(strip);
+    return ESP_OK;
+#else
+#error "Unknown target"
+#endif
+}
+
 esp_err_t led_strip_spi_set_pixel(led_strip_spi_t *strip, const int index, const rgb_t color)
 {
     return led_strip_spi_set_pixel_brightness(strip, index, color, LED_STRIP_SPI_MAX_BRIGHTNESS);
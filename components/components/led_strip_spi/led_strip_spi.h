@@ -104,6 +104,34 @@ esp_err_t led_strip_spi_free(led_strip_spi_t *strip);
  */
 esp_err_t led_strip_spi_flush(led_strip_spi_t*strip);
 
+/**
+ * @brief Start sending strip buffer to LEDs and return immediately
+ *
+ * If the previous frame is still being sent, waits for it first.
+ *
+ * When `double_buffer` is set in descriptor, front and back buffers are
+ * swapped: DMA sends the frame just drawn while `strip->buf` points to a copy
+ * of it that can be modified right away. Otherwise `strip->buf` must not be
+ * modified until ::led_strip_spi_wait() returns.
+ *
+ * `flush_cb`, if set, is called from ISR when the frame has been sent.
+ *
+ * On ESP8266 this is the same as ::led_strip_spi_flush().
+ *
+ * @param strip Descriptor of LED strip
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_spi_flush_async(led_strip_spi_t *strip);
+
+/**
+ * @brief Wait until frame started by ::led_strip_spi_flush_async() is sent
+ *
+ * @param strip Descriptor of LED strip
+ * @param timeout Timeout in RTOS ticks
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if frame is still being sent
+ */
+esp_err_t led_strip_spi_wait(led_strip_spi_t *strip, TickType_t timeout);
+
 /**
  * @brief Set color of single LED in strip.
  *
@@ -49,6 +49,13 @@
 #define LED_STRIP_SPI_DEFAULT_SCLK_IO_NUM   (14) ///< GPIO pin number of `LED_STRIP_SPI_DEFAULT_HOST_DEVICE`'s SCLK (default is 14 for ESP32, 6 for ESP32C3)
 #endif
 
+/**
+ * Flush completion callback prototype, see ::led_strip_spi_flush_async().
+ *
+ * Called from the SPI interrupt, so it must be short and placed in IRAM.
+ */
+typedef void (*led_strip_spi_flush_cb_t)(void *ctx);
+
 /**
  * LED strip descriptor for ESP32-family.
  */
@@ -65,6 +72,11 @@ typedef struct
     spi_device_handle_t device_handle;  ///< Device handle assigned by the driver. The caller must provdie this.
     int dma_chan;                       ///< DMA channed to use. Either 1 or 2.
     spi_transaction_t transaction;      ///< SPI transaction used internally by the driver.
+    bool double_buffer;                 ///< Allocate second DMA buffer, so next frame can be drawn while previous one is sent.
+    led_strip_spi_flush_cb_t flush_cb;  ///< Optional callback, called from ISR when frame has been sent.
+    void *flush_cb_ctx;                 ///< Argument to pass to `flush_cb`.
+    void *dma_buf;                      ///< Buffer being sent by DMA in double-buffered mode. Managed by the driver.
+    bool busy;                          ///< true while frame is being sent. Managed by the driver.
 } led_strip_spi_esp32_t;
 
 /**
@@ -88,7 +100,9 @@ typedef struct
  * `clock_speed_hz`: 1000000,
  * `queue_size`: 1,
  * `device_handle`: `NULL`,
- * `dma_chan`: 1
+ * `dma_chan`: 1,
+ * `double_buffer`: `false`,
+ * `flush_cb`: `NULL`
  */
 #define LED_STRIP_SPI_DEFAULT_ESP32() \
 { \
@@ -102,6 +116,9 @@ typedef struct
     .queue_size = 1,                                  \
     .device_handle = NULL,                            \
     .dma_chan = LED_STRIP_SPI_DEFAULT_DMA_CHAN,       \
+    .double_buffer = false,                           \
+    .flush_cb = NULL,                                 \
+    .flush_cb_ctx = NULL,                             \
 }
 
 /** @} */
@@ -215,13 +215,14 @@ ALWAYS_INLINE int8_t lerp7by8(int8_t a, int8_t b, fract8 frac)
     return result;
 }
 
-int16_t inoise16_3d_raw(uint32_t x, uint32_t y, uint32_t z)
+// Hashes of the corners of a 3D lattice cell
+typedef struct
 {
-    // Find the unit cube containing the point
-    uint8_t X = (x >> 16) & 0xFF;
-    uint8_t Y = (y >> 16) & 0xFF;
-    uint8_t Z = (z >> 16) & 0xFF;
+    uint8_t aa, ba, ab, bb, aa1, ba1, ab1, bb1;
+} cell3d_t;
 
+ALWAYS_INLINE void cell16_3d(uint8_t X, uint8_t Y, uint8_t Z, cell3d_t *c)
+{
     // Hash cube corner coordinates
     uint8_t A  = P(X) + Y;
     uint8_t AA = P(A) + Z;
@@ -230,27 +231,32 @@ int16_t inoise16_3d_raw(uint32_t x, uint32_t y, uint32_t z)
     uint8_t BA = P(B) + Z;
     uint8_t BB = P(B + 1) + Z;
 
-    // Get the relative position of the point in the cube
-    uint16_t u = x & 0xFFFF;
-    uint16_t v = y & 0xFFFF;
-    uint16_t w = z & 0xFFFF;
+    c->aa = P(AA);
+    c->ba = P(BA);
+    c->ab = P(AB);
+    c->bb = P(BB);
+    c->aa1 = P(AA + 1);
+    c->ba1 = P(BA + 1);
+    c->ab1 = P(AB + 1);
+    c->bb1 = P(BB + 1);
+}
 
+// Noise at relative position in the cell. yy, zz are signed positions,
+// v, w are eased positions for y and z
+ALWAYS_INLINE int16_t noise16_3d_cell(const cell3d_t *c, uint16_t u, int16_t yy, uint16_t v, int16_t zz, uint16_t w)
+{
     // Get a signed version of the above for the grad function
     int16_t xx = (u >> 1) & 0x7FFF;
-    int16_t yy = (v >> 1) & 0x7FFF;
-    int16_t zz = (w >> 1) & 0x7FFF;
     uint16_t N = 0x8000L;
 
     u = ease16InOutQuad(u);
-    v = ease16InOutQuad(v);
-    w = ease16InOutQuad(w);
 
     // skip the log fade adjustment for the moment, otherwise here we would
     // adjust fade values for u,v,w
-    int16_t X1 = lerp15by16(grad16_3d(P(AA), xx, yy, zz), grad16_3d(P(BA), xx - N, yy, zz), u);
-    int16_t X2 = lerp15by16(grad16_3d(P(AB), xx, yy - N, zz), grad16_3d(P(BB), xx - N, yy - N, zz), u);
-    int16_t X3 = lerp15by16(grad16_3d(P(AA + 1), xx, yy, zz - N), grad16_3d(P(BA + 1), xx - N, yy, zz - N), u);
-    int16_t X4 = lerp15by16(grad16_3d(P(AB + 1), xx, yy - N, zz - N), grad16_3d(P(BB + 1), xx - N, yy - N, zz - N), u);
+    int16_t X1 = lerp15by16(grad16_3d(c->aa, xx, yy, zz), grad16_3d(c->ba, xx - N, yy, zz), u);
+    int16_t X2 = lerp15by16(grad16_3d(c->ab, xx, yy - N, zz), grad16_3d(c->bb, xx - N, yy - N, zz), u);
+    int16_t X3 = lerp15by16(grad16_3d(c->aa1, xx, yy, zz - N), grad16_3d(c->ba1, xx - N, yy, zz - N), u);
+    int16_t X4 = lerp15by16(grad16_3d(c->ab1, xx, yy - N, zz - N), grad16_3d(c->bb1, xx - N, yy - N, zz - N), u);
 
     int16_t Y1 = lerp15by16(X1, X2, v);
     int16_t Y2 = lerp15by16(X3, X4, v);
@@ -258,15 +264,34 @@ int16_t inoise16_3d_raw(uint32_t x, uint32_t y, uint32_t z)
     return lerp15by16(Y1, Y2, w);
 }
 
-uint16_t inoise16_3d(uint32_t x, uint32_t y, uint32_t z)
+ALWAYS_INLINE uint16_t noise16_3d_scale(int16_t raw)
 {
-    int32_t ans = inoise16_3d_raw(x, y, z);
+    int32_t ans = raw;
     ans = ans + 19052L;
     uint32_t pan = ans;
     pan *= 440L;
     return pan >> 8;
 }
 
+int16_t inoise16_3d_raw(uint32_t x, uint32_t y, uint32_t z)
+{
+    // Find the unit cube containing the point
+    cell3d_t c;
+    cell16_3d((x >> 16) & 0xFF, (y >> 16) & 0xFF, (z >> 16) & 0xFF, &c);
+
+    // Get the relative position of the point in the cube
+    uint16_t v = y & 0xFFFF;
+    uint16_t w = z & 0xFFFF;
+
+    return noise16_3d_cell(&c, x & 0xFFFF, (v >> 1) & 0x7FFF, ease16InOutQuad(v),
+            (w >> 1) & 0x7FFF, ease16InOutQuad(w));
+}
+
+uint16_t inoise16_3d(uint32_t x, uint32_t y, uint32_t z)
+{
+    return noise16_3d_scale(inoise16_3d_raw(x, y, z));
+}
+
 int16_t inoise16_2d_raw(uint32_t x, uint32_t y)
 {
     // Find the unit cube containing the point
@@ -384,12 +409,14 @@ uint8_t inoise8_3d(uint16_t x, uint16_t y, uint16_t z)
     return qadd8(n, n);                  //   0..255
 }
 
-int8_t inoise8_2d_raw(uint16_t x, uint16_t y)
+// Hashes of the corners of a 2D lattice cell
+typedef struct
 {
-    // Find the unit cube containing the point
-    uint8_t X = x >> 8;
-    uint8_t Y = y >> 8;
+    uint8_t aa, ba, ab, bb;
+} cell2d_t;
 
+ALWAYS_INLINE void cell8_2d(uint8_t X, uint8_t Y, cell2d_t *c)
+{
     // Hash cube corner coordinates
     uint8_t A  = P(X)+Y;
     uint8_t AA = P(A);
@@ -398,29 +425,46 @@ int8_t inoise8_2d_raw(uint16_t x, uint16_t y)
     uint8_t BA = P(B);
     uint8_t BB = P(B + 1);
 
-    // Get the relative position of the point in the cube
-    uint8_t u = x;
-    uint8_t v = y;
+    c->aa = P(AA);
+    c->ba = P(BA);
+    c->ab = P(AB);
+    c->bb = P(BB);
+}
 
+// Noise at relative position in the cell. yy is signed position,
+// v is eased position for y
+ALWAYS_INLINE int8_t noise8_2d_cell(const cell2d_t *c, uint8_t u, int8_t yy, uint8_t v)
+{
     // Get a signed version of the above for the grad function
-    int8_t xx = ((uint8_t)x >> 1) & 0x7F;
-    int8_t yy = ((uint8_t)y >> 1) & 0x7F;
+    int8_t xx = (u >> 1) & 0x7F;
     uint8_t N = 0x80;
 
     u = ease8InOutQuad(u);
-    v = ease8InOutQuad(v);
 
-    int8_t X1 = lerp7by8(grad8_2d(P(AA), xx, yy), grad8_2d(P(BA), xx - N, yy), u);
-    int8_t X2 = lerp7by8(grad8_2d(P(AB), xx, yy - N), grad8_2d(P(BB), xx - N, yy - N), u);
+    int8_t X1 = lerp7by8(grad8_2d(c->aa, xx, yy), grad8_2d(c->ba, xx - N, yy), u);
+    int8_t X2 = lerp7by8(grad8_2d(c->ab, xx, yy - N), grad8_2d(c->bb, xx - N, yy - N), u);
 
     return lerp7by8(X1, X2, v);
 }
 
+ALWAYS_INLINE uint8_t noise8_scale(int8_t n)
+{
+    n += 64;            // -64..+64 -> 0..128
+    return qadd8(n, n); //   0..255
+}
+
+int8_t inoise8_2d_raw(uint16_t x, uint16_t y)
+{
+    // Find the unit cube containing the point
+    cell2d_t c;
+    cell8_2d(x >> 8, y >> 8, &c);
+
+    return noise8_2d_cell(&c, x, ((uint8_t)y >> 1) & 0x7F, ease8InOutQuad(y));
+}
+
 uint8_t inoise8_2d(uint16_t x, uint16_t y)
 {
-    int8_t n = inoise8_2d_raw(x, y);  // -64..+64
-    n += 64;                          //   0..128
-    return qadd8(n, n);               //   0..255
+    return noise8_scale(inoise8_2d_raw(x, y));
 }
 
 // output range = -64 .. +64
@@ -489,3 +533,65 @@ void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves,
         scx <<= 1;
     }
 }
+
+void fill_noise8_2d(uint8_t *data, size_t width, size_t height, size_t step, size_t stride,
+        uint16_t x, uint16_t scale_x, uint16_t y, uint16_t scale_y)
+{
+    for (size_t j = 0; j < height; j++, y += scale_y)
+    {
+        // Row values
+        int8_t yy = ((uint8_t)y >> 1) & 0x7F;
+        uint8_t v = ease8InOutQuad(y);
+        uint8_t *row = data + j * stride;
+
+        // Hashes are reused while points stay in the same cell
+        cell2d_t c;
+        cell8_2d(x >> 8, y >> 8, &c);
+        uint8_t X = x >> 8;
+
+        uint16_t xx = x;
+        for (size_t i = 0; i < width; i++, xx += scale_x)
+        {
+            if ((xx >> 8) != X)
+            {
+                X = xx >> 8;
+                cell8_2d(X, y >> 8, &c);
+            }
+            row[i * step] = noise8_scale(noise8_2d_cell(&c, xx, yy, v));
+        }
+    }
+}
+
+void fill_noise16_3d(uint16_t *data, size_t width, size_t height, size_t step, size_t stride,
+        uint32_t x, uint32_t scale_x, uint32_t y, uint32_t scale_y, uint32_t z)
+{
+    // Plane values
+    uint16_t w = z & 0xFFFF;
+    int16_t zz = (w >> 1) & 0x7FFF;
+    w = ease16InOutQuad(w);
+
+    for (size_t j = 0; j < height; j++, y += scale_y)
+    {
+        // Row values
+        uint16_t v = y & 0xFFFF;
+        int16_t yy = (v >> 1) & 0x7FFF;
+        v = ease16InOutQuad(v);
+        uint16_t *row = data + j * stride;
+
+        // Hashes are reused while points stay in the same cell
+        cell3d_t c;
+        uint8_t X = (x >> 16) & 0xFF;
+        cell16_3d(X, (y >> 16) & 0xFF, (z >> 16) & 0xFF, &c);
+
+        uint32_t xx = x;
+        for (size_t i = 0; i < width; i++, xx += scale_x)
+        {
+            if (((xx >> 16) & 0xFF) != X)
+            {
+                X = (xx >> 16) & 0xFF;
+                cell16_3d(X, (y >> 16) & 0xFF, (z >> 16) & 0xFF, &c);
+            }
+            row[i * step] = noise16_3d_scale(noise16_3d_cell(&c, xx & 0xFFFF, yy, v, zz, w));
+        }
+    }
+}
@@ -24,6 +24,7 @@
 #ifndef __NOISE_H__
 #define __NOISE_H__
 
+#include <stddef.h>
 #include <lib8tion.h>
 
 ///@file noise.h
@@ -87,6 +88,29 @@ int8_t inoise8_1d_raw(uint16_t x);
 void fill_raw_noise8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint16_t x, int scale, uint16_t time);
 void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint32_t x, int scale, uint32_t time);
 ///@}
+
+///@name grid fill functions
+///@{
+/// Fill a 2d grid with noise, same values as calling inoise8_2d() / inoise16_3d() for every point,
+/// but lattice hashes are computed once per row and cell instead of once per point.
+/// Point (i, j) is written to data[j * stride + i * step], so a single channel of an RGB
+/// framebuffer can be filled directly, e.g. with `(uint8_t *)fb->data`, step 3, stride 3 * width.
+/// Mark the filled area with fb_mark_dirty() then, or framebuffer won't clear and fade it.
+///@param data the grid to write into
+///@param width the number of points in a row
+///@param height the number of rows
+///@param step the distance between points in a row, in elements
+///@param stride the distance between rows, in elements
+///@param x the x position in the noise field of the first point
+///@param scale_x the distance between x points
+///@param y the y position in the noise field of the first row
+///@param scale_y the distance between rows
+///@param z the z position in the noise field for 3d functions
+void fill_noise8_2d(uint8_t *data, size_t width, size_t height, size_t step, size_t stride,
+        uint16_t x, uint16_t scale_x, uint16_t y, uint16_t scale_y);
+void fill_noise16_3d(uint16_t *data, size_t width, size_t height, size_t step, size_t stride,
+        uint32_t x, uint32_t scale_x, uint32_t y, uint32_t scale_y, uint32_t z);
+///@}
 ///@}
 
 #endif /* __NOISE_H__ */
@@ -0,0 +1,169 @@
+/**
+ * @file esp_timer.c
+ *
+ * esp_timer for host builds: time is monotonic or virtual clock of the
+ * shim, callbacks run in a dispatcher task started by the first
+ * esp_timer_create()
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "sched.h"
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    bool armed;
+    int64_t alarm;
+    uint64_t period;  // 0 for one-shot
+    struct esp_timer *next;
+};
+
+// Guarded by host_lock(), the dispatcher blocks on the list
+static struct esp_timer *timers;
+static bool dispatcher_started;
+
+int64_t esp_timer_get_time(void)
+{
+    return host_now_us();
+}
+
+static void dispatcher(void *arg)
+{
+    (void)arg;
+
+    host_lock();
+    while (true)
+    {
+        struct esp_timer *due = NULL;
+        for (struct esp_timer *t = timers; t; t = t->next)
+            if (t->armed && (!due || t->alarm < due->alarm))
+                due = t;
+        if (!due)
+        {
+            host_block(&timers, HOST_FOREVER);
+            continue;
+        }
+        if (due->alarm > esp_timer_get_time())
+        {
+            host_block(&timers, due->alarm);
+            continue;
+        }
+
+        // Like the target, a late periodic timer doesn't catch up
+        if (due->period)
+        {
+            due->alarm += due->period;
+            int64_t now = esp_timer_get_time();
+            if (due->alarm < now)
+                due->alarm = now;
+        }
+        else
+            due->armed = false;
+
+        // Timer may be deleted while callback runs
+        esp_timer_cb_t cb = due->callback;
+        void *cb_arg = due->arg;
+        host_unlock();
+        cb(cb_arg);
+        host_lock();
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle)
+        return ESP_ERR_INVALID_ARG;
+
+    struct esp_timer *timer = calloc(1, sizeof(struct esp_timer));
+    if (!timer)
+        return ESP_ERR_NO_MEM;
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+
+    host_lock();
+    bool start = !dispatcher_started;
+    dispatcher_started = true;
+    timer->next = timers;
+    timers = timer;
+    host_unlock();
+
+    if (start && xTaskCreate(dispatcher, "esp_timer", 4096, NULL, configMAX_PRIORITIES - 3, NULL) != pdPASS)
+        abort();
+
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t us, uint64_t period)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res = ESP_ERR_INVALID_STATE;
+    host_lock();
+    if (!timer->armed)
+    {
+        timer->armed = true;
+        timer->alarm = esp_timer_get_time() + (int64_t)us;
+        timer->period = period;
+        host_wake(&timers);
+        res = ESP_OK;
+    }
+    host_unlock();
+
+    return res;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res = ESP_ERR_INVALID_STATE;
+    host_lock();
+    if (timer->armed)
+    {
+        timer->armed = false;
+        res = ESP_OK;
+    }
+    host_unlock();
+
+    return res;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+
+    host_lock();
+    if (timer->armed)
+    {
+        host_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    struct esp_timer **p = &timers;
+    while (*p && *p != timer)
+        p = &(*p)->next;
+    if (*p)
+        *p = timer->next;
+    host_unlock();
+    free(timer);
+
+    return ESP_OK;
+}
@@ -0,0 +1,521 @@
+/**
+ * @file freertos.c
+ *
+ * FreeRTOS tasks, notifications, semaphores and queues on POSIX threads
+ * for host builds, in real or virtual time
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
+#include <host_time.h>
+#include "sched.h"
+
+struct host_sem
+{
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+struct host_queue
+{
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct host_task
+{
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+    pthread_cond_t cond;
+    const void *blocked_on;  // Object the task waits for, NULL if running
+    int64_t deadline;
+    bool woken;
+    bool deleted;            // Deleted by other task, exits when it blocks
+    uint32_t ready;          // Virtual time: order of becoming ready to run, 0 if not
+    uint32_t notify;
+    struct host_task *next;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+// All tasks, including threads not created by xTaskCreate() once they block
+static struct host_task *tasks;
+static __thread struct host_task *current;
+
+// Virtual time, the running task holds the CPU until it blocks
+static bool virtual_time;
+static int64_t virtual_us;
+static struct host_task *running;
+static uint32_t ready_seq;
+
+void host_lock(void)
+{
+    pthread_mutex_lock(&lock);
+}
+
+void host_unlock(void)
+{
+    pthread_mutex_unlock(&lock);
+}
+
+int64_t host_now_us(void)
+{
+    // Only the running task reads or advances virtual time
+    if (virtual_time)
+        return virtual_us;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void host_spin_us(uint32_t us)
+{
+    if (virtual_time)
+    {
+        virtual_us += us;
+        return;
+    }
+    int64_t end = host_now_us() + us;
+    while (host_now_us() < end)
+        ;
+}
+
+static int64_t deadline(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+        return HOST_FOREVER;
+    return host_now_us() + (int64_t)ticks * 1000000 / configTICK_RATE_HZ;
+}
+
+static struct host_task *new_task(const char *name)
+{
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+    if (!task)
+        return NULL;
+    if (name)
+        strncpy(task->name, name, sizeof(task->name) - 1);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&task->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return task;
+}
+
+static void free_task(struct host_task *task)
+{
+    pthread_cond_destroy(&task->cond);
+    free(task);
+}
+
+// Remove task from the list, false if it was already removed. Called with lock held
+static bool unlink_task(struct host_task *task)
+{
+    struct host_task **p = &tasks;
+    while (*p && *p != task)
+        p = &(*p)->next;
+    if (!*p)
+        return false;
+    *p = task->next;
+    return true;
+}
+
+// Task of calling thread, threads not created by xTaskCreate() get one
+// on first use. Called with lock held
+static struct host_task *self(void)
+{
+    if (!current)
+    {
+        current = new_task(NULL);
+        if (!current)
+            abort();
+        current->thread = pthread_self();
+        current->next = tasks;
+        tasks = current;
+    }
+    return current;
+}
+
+static void make_ready(struct host_task *task)
+{
+    if (!task->ready)
+        task->ready = ++ready_seq;
+}
+
+// Hand CPU to the task which became ready first, tasks past their deadline
+// are ready too. When none is, time jumps to the earliest deadline. Called
+// with lock held
+static void dispatch(void)
+{
+    struct host_task *next = NULL;
+    for (struct host_task *t = tasks; t; t = t->next)
+        if (t->blocked_on && t->deadline <= virtual_us)
+            make_ready(t);
+    for (struct host_task *t = tasks; t; t = t->next)
+        if (t->ready && (!next || t->ready < next->ready))
+            next = t;
+    if (!next)
+    {
+        for (struct host_task *t = tasks; t; t = t->next)
+            if (t->blocked_on && t->deadline != HOST_FOREVER && (!next || t->deadline < next->deadline))
+                next = t;
+        if (!next)
+        {
+            fprintf(stderr, "host: all tasks are blocked forever\n");
+            abort();
+        }
+        if (next->deadline > virtual_us)
+            virtual_us = next->deadline;
+    }
+    next->ready = 0;
+    running = next;
+    pthread_cond_signal(&next->cond);
+}
+
+static void exit_task(void)
+{
+    struct host_task *task = current;
+    current = NULL;
+    unlink_task(task);
+    if (virtual_time)
+        dispatch();
+    pthread_mutex_unlock(&lock);
+    free_task(task);
+    pthread_exit(NULL);
+}
+
+bool host_block(const void *obj, int64_t deadline_us)
+{
+    struct host_task *task = self();
+    if (task->deleted)
+        exit_task();
+    task->blocked_on = obj;
+    task->deadline = deadline_us;
+    task->woken = false;
+    if (virtual_time)
+    {
+        dispatch();
+        while (running != task)
+            pthread_cond_wait(&task->cond, &lock);
+    }
+    else while (!task->woken)
+    {
+        if (deadline_us == HOST_FOREVER)
+            pthread_cond_wait(&task->cond, &lock);
+        else
+        {
+            struct timespec ts = {
+                .tv_sec = deadline_us / 1000000,
+                .tv_nsec = deadline_us % 1000000 * 1000,
+            };
+            if (pthread_cond_timedwait(&task->cond, &lock, &ts) == ETIMEDOUT)
+                break;
+        }
+    }
+    task->blocked_on = NULL;
+    if (task->deleted)
+        exit_task();
+    return task->woken;
+}
+
+void host_wake(const void *obj)
+{
+    for (struct host_task *task = tasks; task; task = task->next)
+        if (task->blocked_on == obj && !task->woken)
+        {
+            task->woken = true;
+            if (virtual_time)
+                make_ready(task);
+            else
+                pthread_cond_signal(&task->cond);
+        }
+}
+
+void host_time_virtual(void)
+{
+    pthread_mutex_lock(&lock);
+    virtual_time = true;
+    virtual_us = 0;
+    running = self();
+    pthread_mutex_unlock(&lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tasks
+
+static void *task_start(void *arg)
+{
+    current = arg;
+    pthread_mutex_lock(&lock);
+    while (virtual_time && running != current)
+        pthread_cond_wait(&current->cond, &lock);
+    if (current->deleted)
+        exit_task();
+    pthread_mutex_unlock(&lock);
+    current->fn(current->arg);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+        UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)stack_depth;
+    (void)priority;
+
+    struct host_task *task = new_task(name);
+    if (!task)
+        return pdFAIL;
+    task->fn = fn;
+    task->arg = arg;
+
+    pthread_mutex_lock(&lock);
+    task->next = tasks;
+    tasks = task;
+    if (virtual_time)
+        make_ready(task);
+    if (pthread_create(&task->thread, NULL, task_start, task))
+    {
+        tasks = task->next;
+        pthread_mutex_unlock(&lock);
+        free_task(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    pthread_mutex_unlock(&lock);
+    if (handle)
+        *handle = task;
+
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    pthread_mutex_lock(&lock);
+    if (!task || task == current)
+        exit_task();
+
+    // Task stays in the list until it exits, when it blocks next time or
+    // right away if it is blocked now
+    task->deleted = true;
+    if (task->blocked_on && !task->woken)
+    {
+        task->woken = true;
+        if (virtual_time)
+            make_ready(task);
+        else
+            pthread_cond_signal(&task->cond);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+TaskHandle_t xTaskGetHandle(const char *name)
+{
+    pthread_mutex_lock(&lock);
+    struct host_task *task = tasks;
+    while (task && (!task->fn || task->deleted || strncmp(task->name, name, sizeof(task->name) - 1)))
+        task = task->next;
+    pthread_mutex_unlock(&lock);
+    return task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    pthread_mutex_lock(&lock);
+    struct host_task *task = self();
+    pthread_mutex_unlock(&lock);
+    return task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    pthread_mutex_lock(&lock);
+    struct host_task *task = self();
+    // Nothing wakes the task on its own address, only deletion
+    host_block(task, deadline(ticks));
+    pthread_mutex_unlock(&lock);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)((uint64_t)host_now_us() * configTICK_RATE_HZ / 1000000);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Notifications, used as counting semaphores
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&lock);
+    task->notify++;
+    host_wake(&task->notify);
+    pthread_mutex_unlock(&lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken)
+        *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    int64_t until = deadline(ticks);
+
+    pthread_mutex_lock(&lock);
+    struct host_task *task = self();
+    while (!task->notify && ticks)
+        if (!host_block(&task->notify, until))
+            break;
+    uint32_t res = task->notify;
+    if (res)
+        task->notify = clear ? 0 : res - 1;
+    pthread_mutex_unlock(&lock);
+
+    return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Semaphores
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(struct host_sem));
+    if (!sem)
+        return NULL;
+    sem->count = initial;
+    sem->max = max;
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    int64_t until = deadline(ticks);
+
+    pthread_mutex_lock(&lock);
+    while (!sem->count && ticks)
+        if (!host_block(sem, until))
+            break;
+    BaseType_t res = pdFALSE;
+    if (sem->count)
+    {
+        sem->count--;
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return res;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&lock);
+    BaseType_t res = pdFALSE;
+    if (sem->count < sem->max)
+    {
+        sem->count++;
+        host_wake(sem);
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return res;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Queues
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t q = calloc(1, sizeof(struct host_queue));
+    if (!q)
+        return NULL;
+    q->items = malloc((size_t)length * item_size);
+    if (!q->items)
+    {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    int64_t until = deadline(ticks);
+
+    pthread_mutex_lock(&lock);
+    while (q->count == q->length && ticks)
+        if (!host_block(q, until))
+            break;
+    BaseType_t res = pdFALSE;
+    if (q->count < q->length)
+    {
+        memcpy(q->items + (size_t)((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+        q->count++;
+        host_wake(q);
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return res;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    int64_t until = deadline(ticks);
+
+    pthread_mutex_lock(&lock);
+    while (!q->count && ticks)
+        if (!host_block(q, until))
+            break;
+    BaseType_t res = pdFALSE;
+    if (q->count)
+    {
+        memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        host_wake(q);
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return res;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&lock);
+    UBaseType_t res = q->count;
+    pthread_mutex_unlock(&lock);
+    return res;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (!q)
+        return;
+    free(q->items);
+    free(q);
+}
@@ -0,0 +1,15 @@
+/*
+ * esp_attr.h replacement for host builds
+ *
+ * Code and data placement attributes have no meaning on host.
+ */
+#ifndef __ESP_ATTR_H__
+#define __ESP_ATTR_H__
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#endif /* __ESP_ATTR_H__ */
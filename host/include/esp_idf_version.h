@@ -0,0 +1,14 @@
+/*
+ * esp_idf_version.h replacement for host builds
+ */
+#ifndef __ESP_IDF_VERSION_H__
+#define __ESP_IDF_VERSION_H__
+
+#define ESP_IDF_VERSION_MAJOR 4
+#define ESP_IDF_VERSION_MINOR 4
+#define ESP_IDF_VERSION_PATCH 0
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(ESP_IDF_VERSION_MAJOR, ESP_IDF_VERSION_MINOR, ESP_IDF_VERSION_PATCH)
+
+#endif /* __ESP_IDF_VERSION_H__ */
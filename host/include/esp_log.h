@@ -0,0 +1,38 @@
+/*
+ * esp_log.h replacement for host builds
+ *
+ * Errors and warnings go to stderr, info to stdout, debug and verbose
+ * output is dropped unless HOST_LOG_DEBUG is defined.
+ */
+#ifndef __ESP_LOG_H__
+#define __ESP_LOG_H__
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+// Levels are fixed at compile time
+#define esp_log_level_set(tag, level) do { (void)(tag); (void)(level); } while (0)
+
+#define HOST_LOG(stream, letter, tag, fmt, ...) fprintf(stream, letter " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define HOST_LOG_NONE(tag, fmt, ...) do { if (0) fprintf(stdout, fmt, ##__VA_ARGS__); (void)(tag); } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(stderr, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(stderr, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(stdout, "I", tag, fmt, ##__VA_ARGS__)
+#ifdef HOST_LOG_DEBUG
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG(stdout, "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) HOST_LOG(stdout, "V", tag, fmt, ##__VA_ARGS__)
+#else
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG_NONE(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) HOST_LOG_NONE(tag, fmt, ##__VA_ARGS__)
+#endif
+
+#endif /* __ESP_LOG_H__ */
@@ -0,0 +1,10 @@
+/*
+ * esp_system.h replacement for host builds
+ */
+#ifndef __ESP_SYSTEM_H__
+#define __ESP_SYSTEM_H__
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#endif /* __ESP_SYSTEM_H__ */
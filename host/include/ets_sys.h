@@ -0,0 +1,19 @@
+/*
+ * ets_sys.h replacement for host builds, implemented by periph.c
+ */
+#ifndef __ETS_SYS_H__
+#define __ETS_SYS_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ets_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ETS_SYS_H__ */
@@ -0,0 +1,52 @@
+/*
+ * FreeRTOS replacement for host builds, tasks are POSIX threads
+ *
+ * Critical sections lock a mutex per spinlock. Like the ESP32 port, this
+ * header also brings in placement attributes and ROM delay.
+ */
+#ifndef __HOST_FREERTOS_H__
+#define __HOST_FREERTOS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "sdkconfig.h"
+#include <esp_attr.h>
+#include <ets_sys.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffff)
+#define pdMS_TO_TICKS(ms) ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+#define configMAX_PRIORITIES 25
+
+#define xPortGetCoreID() 0
+// There are no interrupts, ISR callbacks of the shim run in tasks
+#define xPortInIsrContext() 0
+#define portYIELD_FROM_ISR(...) do { } while (0)
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  pdFALSE
+#define pdPASS  pdTRUE
+
+typedef struct {
+    pthread_mutex_t lock;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { .lock = PTHREAD_MUTEX_INITIALIZER }
+#define portMUX_INITIALIZE(mux) pthread_mutex_init(&(mux)->lock, NULL)
+
+#define portENTER_CRITICAL(mux)     pthread_mutex_lock(&(mux)->lock)
+#define portEXIT_CRITICAL(mux)      pthread_mutex_unlock(&(mux)->lock)
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)  portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL(mux)     portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)      portEXIT_CRITICAL(mux)
+
+#endif /* __HOST_FREERTOS_H__ */
@@ -0,0 +1,19 @@
+/*
+ * FreeRTOS queues for host builds
+ */
+#ifndef __HOST_FREERTOS_QUEUE_H__
+#define __HOST_FREERTOS_QUEUE_H__
+
+#include "FreeRTOS.h"
+
+typedef struct host_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
+
+#define xQueueSendToBack xQueueSend
+
+#endif /* __HOST_FREERTOS_QUEUE_H__ */
@@ -0,0 +1,22 @@
+/*
+ * FreeRTOS semaphores for host builds
+ *
+ * Mutexes are binary semaphores, without ownership or priority inheritance.
+ */
+#ifndef __HOST_FREERTOS_SEMPHR_H__
+#define __HOST_FREERTOS_SEMPHR_H__
+
+#include "FreeRTOS.h"
+
+typedef struct host_sem *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateMutex() xSemaphoreCreateCounting(1, 1)
+#define xSemaphoreCreateBinary() xSemaphoreCreateCounting(1, 0)
+#define xSemaphoreGiveFromISR(sem, woken) xSemaphoreGive(sem)
+
+#endif /* __HOST_FREERTOS_SEMPHR_H__ */
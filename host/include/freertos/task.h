@@ -0,0 +1,31 @@
+/*
+ * FreeRTOS tasks for host builds
+ */
+#ifndef __HOST_FREERTOS_TASK_H__
+#define __HOST_FREERTOS_TASK_H__
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef struct host_task *TaskHandle_t;
+
+// Priorities are ignored, tasks are threads of default policy
+#define tskIDLE_PRIORITY 0
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+        UBaseType_t priority, TaskHandle_t *handle);
+void vTaskDelete(TaskHandle_t task);
+TaskHandle_t xTaskGetHandle(const char *name);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+// Notifications only count, like xTaskNotifyGive() on the target
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+#define xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, core) \
+    xTaskCreate(fn, name, stack, arg, prio, handle)
+
+#endif /* __HOST_FREERTOS_TASK_H__ */
@@ -0,0 +1,27 @@
+/*
+ * Virtual time of the host shim, host builds only
+ *
+ * Tasks run one at a time and the clock advances only when all of them
+ * block, or when the running one busy waits in ets_delay_us(). A run is
+ * deterministic and takes as long as its computation, not the delays.
+ * Priorities are ignored and tasks are not preempted: a task polling a
+ * variable without blocking hangs the program.
+ */
+#ifndef __HOST_TIME_H__
+#define __HOST_TIME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Switch to virtual time starting at 0, call first thing in main()
+ * before creating tasks or timers
+ */
+void host_time_virtual(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOST_TIME_H__ */
@@ -0,0 +1,15 @@
+/*
+ * sdkconfig.h replacement for host builds
+ *
+ * Defaults of ESP-IDF for ESP32. Host builds with options of their own
+ * put a sdkconfig.h in front of this one on the include path.
+ */
+#ifndef __SDKCONFIG_H__
+#define __SDKCONFIG_H__
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_IDF_TARGET "esp32"
+
+#define CONFIG_FREERTOS_HZ 100
+
+#endif /* __SDKCONFIG_H__ */
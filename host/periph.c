@@ -0,0 +1,65 @@
+/**
+ * @file periph.c
+ *
+ * GPIO and ROM functions for host builds
+ *
+ * GPIO keeps output levels in memory.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdatomic.h>
+#include <driver/gpio.h>
+#include <ets_sys.h>
+#include "sched.h"
+
+static atomic_uint gpio_levels[GPIO_NUM_MAX];
+
+#define CHECK_GPIO(n) do { if ((n) < 0 || (n) >= GPIO_NUM_MAX) return ESP_ERR_INVALID_ARG; } while (0)
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    CHECK_GPIO(gpio_num);
+    gpio_levels[gpio_num] = 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    (void)mode;
+    CHECK_GPIO(gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    CHECK_GPIO(gpio_num);
+    gpio_levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX)
+        return 0;
+    return gpio_levels[gpio_num];
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    if (!config || config->pin_bit_mask >> GPIO_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+void gpio_pad_select_gpio(uint8_t gpio_num)
+{
+    (void)gpio_num;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ets_delay_us(uint32_t us)
+{
+    // Busy wait like ROM function
+    host_spin_us(us);
+}
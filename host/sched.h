@@ -0,0 +1,36 @@
+/*
+ * Blocking and wakeup of host tasks, shared by freertos.c and esp_timer.c
+ *
+ * All FreeRTOS objects and timers of the shim are guarded by one lock.
+ * A task blocks on an object (any address) until another task wakes the
+ * object or the deadline passes. Deadlines are esp_timer_get_time()
+ * microseconds.
+ *
+ * In virtual time (see host_time.h) only one task runs at a time and
+ * blocking hands the CPU to the next ready task. When none is ready, the
+ * clock jumps to the earliest deadline.
+ */
+#ifndef __HOST_SCHED_H__
+#define __HOST_SCHED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_FOREVER INT64_MAX
+
+// Monotonic or virtual time in microseconds
+int64_t host_now_us(void);
+
+// Busy wait, in virtual time the running task just advances the clock
+void host_spin_us(uint32_t us);
+
+void host_lock(void);
+void host_unlock(void);
+
+// Block current task on object, called with lock held. False on timeout
+bool host_block(const void *obj, int64_t deadline_us);
+
+// Wake all tasks blocked on object, called with lock held
+void host_wake(const void *obj);
+
+#endif /* __HOST_SCHED_H__ */
@@ -12,8 +12,10 @@
 #include "gb_leds.h"
 #include <stdio.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "obe_led.h"
 
 #define LOG_LEVEL_LOCAL ESP_LOG_ERROR
@@ -21,12 +23,21 @@ static const char *TAG = "gb_leds";
 
 static bool is_led_init = false;
 
+// Wakes led_wait_until(), which times flushes finer than a tick
+static esp_timer_handle_t refresh_timer = NULL;
+static SemaphoreHandle_t refresh_done = NULL;
+
 static led_strip_t strip_A = {
     .type = 0,
     .length = 4,
     .gpio = 39,
     .buf = NULL,
     .brightness = 255,
+    .power = {
+        .ma_per_channel = LED_MA_PER_CHANNEL,
+        .budget_ma = LED_POWER_BUDGET_MA,
+    },
+    .dither = LED_DITHER,
 };
 
 
@@ -157,6 +168,125 @@ void led_color_roll(rgb_t *roll_colors, size_t color_cnt, uint16_t delay)
   }
 }
 
+/**
+ * @brief Block until esp_timer time, finer than a tick
+ *
+ * @param deadline Time in Microseconds, see esp_timer_get_time()
+ */
+static void led_wait_until(int64_t deadline)
+{
+  int64_t wait = deadline - esp_timer_get_time();
+  if (wait > 0)
+  {
+    ESP_ERROR_CHECK(esp_timer_start_once(refresh_timer, wait));
+    xSemaphoreTake(refresh_done, portMAX_DELAY);
+  }
+}
+
+/**
+ * @brief Show timeline on the targets at the given time
+ *
+ * @param tl Timeline, targets past TARGET_PADS are not shown
+ * @param t Time in 1/256 units
+ */
+static void led_show_timeline(const led_timeline_t *tl, uint32_t t)
+{
+  rgb_t frame[TARGET_PADS];
+  uint8_t targets = led_timeline_render(tl, t, frame, TARGET_PADS);
+  for (uint8_t n = 0; n < targets && n * LEDS_PER_TARGET < strip_A.length; n++)
+    ESP_ERROR_CHECK(led_strip_fill(&strip_A, n * LEDS_PER_TARGET, LEDS_PER_TARGET, frame[n]));
+  ESP_ERROR_CHECK(led_strip_flush(&strip_A));
+}
+
+/**
+ * @brief Play timeline on the targets, blocking until it ends
+ *
+ * Frames are rendered at the time actually elapsed, so a slow flush drops
+ * frames instead of stretching the timeline.
+ *
+ * @param tl Timeline, targets past TARGET_PADS are not shown
+ * @param unit_ms Length of a timeline unit in Milliseconds
+ * @param frame_ms Time in Milliseconds between frames
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_ARG` for zero unit or frame
+ *         time, `ESP_ERR_INVALID_STATE` before LEDs are initialized
+ */
+esp_err_t led_play_timeline(const led_timeline_t *tl, uint16_t unit_ms, uint16_t frame_ms)
+{
+  if (!tl || !unit_ms || !frame_ms)
+    return ESP_ERR_INVALID_ARG;
+  if (!refresh_timer)
+    return ESP_ERR_INVALID_STATE;
+
+  int64_t unit_us = (int64_t)unit_ms * 1000;
+  int64_t duration = tl->length * unit_us;
+  int64_t start = esp_timer_get_time();
+  int64_t next = 0;
+
+  for (int64_t elapsed = 0; elapsed < duration; elapsed = esp_timer_get_time() - start)
+  {
+    led_show_timeline(tl, elapsed * 256 / unit_us);
+    // Next frame time after now, late frames are skipped
+    do
+      next += frame_ms * 1000;
+    while (next <= elapsed);
+    led_wait_until(start + next);
+  }
+  return ESP_OK;
+}
+
+// Color roll: every LED in turn takes the next color, one LED per unit
+static const led_keyframe_t roll_keys[] = {
+    {.at = 0 * CONFIG_LED_STRIP_LEN},
+    {.at = 1 * CONFIG_LED_STRIP_LEN},
+    {.at = 2 * CONFIG_LED_STRIP_LEN},
+    {.at = 3 * CONFIG_LED_STRIP_LEN},
+    {.at = 4 * CONFIG_LED_STRIP_LEN},
+    {.at = 5 * CONFIG_LED_STRIP_LEN},
+    {.at = 6 * CONFIG_LED_STRIP_LEN},
+    {.at = 7 * CONFIG_LED_STRIP_LEN},
+};
+
+static const rgb_t roll_rgb_colors[] = {
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0x2f, .g = 0x00, .b = 0x00},
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0x00, .g = 0x2f, .b = 0x00},
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0x00, .g = 0x00, .b = 0x2f},
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0xff, .g = 0xff, .b = 0x00},
+};
+
+static const led_timeline_t roll_rgb = {
+    .keys = roll_keys,
+    .colors = roll_rgb_colors,
+    .count = 8,
+    .targets = CONFIG_LED_STRIP_LEN,
+    .shared = true,
+    .stagger = 1,
+    .length = 8 * CONFIG_LED_STRIP_LEN,
+};
+
+static const rgb_t roll_startup_colors[] = {
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0x00, .g = 0x00, .b = 0xff}, // IDX_CMD_BLUE
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0xff, .g = 0x00, .b = 0xff}, // IDX_CMD_MAGENTA
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0x00, .g = 0xff, .b = 0xff}, // IDX_CMD_CYAN
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+};
+
+static const led_timeline_t roll_startup = {
+    .keys = roll_keys,
+    .colors = roll_startup_colors,
+    .count = 7,
+    .targets = CONFIG_LED_STRIP_LEN,
+    .shared = true,
+    .stagger = 1,
+    .length = 7 * CONFIG_LED_STRIP_LEN,
+};
+
 /**
  * @brief LED RGB color roll animation
  *
@@ -164,18 +294,7 @@ void led_color_roll(rgb_t *roll_colors, size_t color_cnt, uint16_t delay)
  */
 void led_roll_rgb(uint16_t delay)
 {
-  rgb_t colors[] = {
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-      {.r = 0x2f, .g = 0x00, .b = 0x00},
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-      {.r = 0x00, .g = 0x2f, .b = 0x00},
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-      {.r = 0x00, .g = 0x00, .b = 0x2f},
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-      {.r = 0xff, .g = 0xff, .b = 0x00},
-  };
-
-  led_color_roll(colors, (sizeof(colors) / sizeof(rgb_t)), delay);
+  led_play_timeline(&roll_rgb, delay, delay);
 }
 
 /**
@@ -185,17 +304,7 @@ void led_roll_rgb(uint16_t delay)
  */
 void led_roll_startup(uint16_t delay)
 {
-  rgb_t colors[] = {
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-      led_cmd_table[IDX_CMD_BLUE],
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-      led_cmd_table[IDX_CMD_MAGENTA],
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-      led_cmd_table[IDX_CMD_CYAN],
-      {.r = 0x00, .g = 0x00, .b = 0x00},
-  };
-
-  led_color_roll(colors, (sizeof(colors) / sizeof(rgb_t)), delay);
+  led_play_timeline(&roll_startup, delay, delay);
 }
 
 /**
@@ -231,24 +340,33 @@ void led_color_flash(rgb_t color, size_t start, uint8_t f_count, uint16_t delay)
   led_target_color(color, start * LEDS_PER_TARGET);
 }
 
+// Still logo, one keyframe with a color per target
+static const led_keyframe_t logo_keys[] = {
+    {.at = 0},
+};
+
+static const rgb_t ra_logo_colors[TARGET_PADS] = {
+    {.r = 0x00, .g = 0xff, .b = 0x00}, // IDX_CMD_GREEN
+    {.r = 0xff, .g = 0xff, .b = 0x00}, // IDX_CMD_YELLOW
+    {.r = 0x00, .g = 0xff, .b = 0xff}, // IDX_CMD_CYAN
+    {.r = 0xff, .g = 0x00, .b = 0xff}, // IDX_CMD_MAGENTA
+    {.r = 0x00, .g = 0x00, .b = 0xff}, // IDX_CMD_BLUE
+};
+
+static const led_timeline_t ra_logo = {
+    .keys = logo_keys,
+    .colors = ra_logo_colors,
+    .count = 1,
+    .targets = TARGET_PADS,
+};
+
 /**
  * @brief Radio Active ON - Target ON not connected
  */
 void radio_active_on(void)
 {
-  rgb_t ra_logo[TARGET_PADS] = {
-      led_cmd_table[IDX_CMD_GREEN],
-      led_cmd_table[IDX_CMD_YELLOW],
-      led_cmd_table[IDX_CMD_CYAN],
-      led_cmd_table[IDX_CMD_MAGENTA],
-      led_cmd_table[IDX_CMD_BLUE],
-  };
-
-  // for (int i = 0; i < TARGET_PADS; i++)
-  // {
-  //   led_target_color(ra_logo[i], i * LEDS_PER_TARGET);
-  // }
-  set_target_pattern(&ra_logo[0]);
+  if (is_led_init)
+    led_show_timeline(&ra_logo, 0);
 }
 
 /**
@@ -296,12 +414,34 @@ static led_strip_t * strips[7];
 /**
  * @brief Initialize the LED strip
  */
+static void refresh_timer_cb(void *arg)
+{
+  xSemaphoreGive(refresh_done);
+}
+
+/**
+ * @brief Create the timer of led_refresh_for(), once
+ */
+static void led_refresh_timer_init(void)
+{
+  if (refresh_timer)
+    return;
+
+  const esp_timer_create_args_t args = {
+      .callback = refresh_timer_cb,
+      .name = "led_refresh",
+  };
+  refresh_done = xSemaphoreCreateBinary();
+  ESP_ERROR_CHECK(esp_timer_create(&args, &refresh_timer));
+}
+
 void gb_led_init(void)
 {
   uint8_t core = xPortGetCoreID();
   ESP_LOGI(TAG, "LED Running on core %d", core);
   led_strip_install();
   ESP_ERROR_CHECK(led_strip_init(&strip_A));
+  led_refresh_timer_init();
   //ESP_ERROR_CHECK(led_strip_init(&strip_B));
   strips[0] = &strip_A;
   led_set_brightness(255);
@@ -318,6 +458,7 @@ void gb_led_mesh_init_task(void *pvParameters)
   ESP_LOGI(TAG, "LED Running on core %d", core);
   led_strip_install();
   ESP_ERROR_CHECK(led_strip_init(&strip_A));
+  led_refresh_timer_init();
   led_set_brightness(255);
   is_led_init = true;
   vTaskDelete(xTaskGetHandle("led_init_task"));
@@ -344,7 +485,8 @@ void set_target_pattern(rgb_t *pattern)
 {
   if (is_led_init)
   {
-    for (int i = 0; i < TARGET_PADS; i++)
+    // Strip may be shorter than the number of pads
+    for (int i = 0; i < TARGET_PADS && i * LEDS_PER_TARGET < strip_A.length; i++)
     {
       // ESP_LOGI("LED_set_target_pattern", "Setting target %d to %d %d %d", i, pattern[i].r, pattern[i].g, pattern[i].b);
       ESP_ERROR_CHECK(led_strip_set_pixel(&strip_A, (i * LEDS_PER_TARGET), pattern[i]));
@@ -449,6 +591,12 @@ void led_flash_winner(uint8_t cmd_idx)
   ESP_ERROR_CHECK(led_strip_flush(&strip_A));
 }
 
+void led_set_tx(led_strip_tx_cb_t tx, void *ctx)
+{
+  strip_A.tx = tx;
+  strip_A.tx_ctx = ctx;
+}
+
 bool get_is_led_init(void)
 {
   return is_led_init;
@@ -459,15 +607,8 @@ bool get_is_led_init(void)
  */
 void led_rainbow(void)
 {
-  rgb_t ra_logo[TARGET_PADS] = {
-      led_cmd_table[IDX_CMD_GREEN],
-      led_cmd_table[IDX_CMD_YELLOW],
-      led_cmd_table[IDX_CMD_CYAN],
-      led_cmd_table[IDX_CMD_MAGENTA],
-      led_cmd_table[IDX_CMD_BLUE],
-  };
-
-  set_target_pattern(&ra_logo[0]);
+  if (is_led_init)
+    led_show_timeline(&ra_logo, 0);
 }
 
 /**
@@ -491,6 +632,26 @@ void led_set_brightness(uint8_t brightness)
   memcpy(&strip_A.brightness, &brightness, sizeof(brightness));
 }
 
+/**
+ * @brief Show the strip for a while. With dithering, the strip is flushed
+ * once per frame of the dithering cycle, spread over the delay, so the
+ * cycle completes while the step is shown. Flushes are timed by esp_timer,
+ * as the delay between them is shorter than a tick at the default tick rate
+ *
+ * @param delay Time in Milliseconds
+ */
+static void led_refresh_for(uint16_t delay)
+{
+  int frames = strip_A.dither ? LED_STRIP_DITHER_FRAMES : 1;
+  int64_t start = esp_timer_get_time();
+
+  for (int i = 0; i < frames; i++)
+  {
+    ESP_ERROR_CHECK(led_strip_flush(&strip_A));
+    led_wait_until(start + (int64_t)delay * 1000 * (i + 1) / frames);
+  }
+}
+
 void led_pulse_pattern(uint8_t *cmd_pattern)
 {
   if (is_led_init)
@@ -503,17 +664,19 @@ void led_pulse_pattern(uint8_t *cmd_pattern)
         led_cmd_table[cmd_pattern[4]],
     };
 
+    // Pixels are written once, brightness is applied on flush
+    led_set_brightness(0);
+    set_target_pattern(&target_pattern[0]);
+
     for (uint8_t x = 0; x < 200; x += 4)
     {
       led_set_brightness(x);
-      set_target_pattern(&target_pattern[0]);
-      vTaskDelay(pdMS_TO_TICKS(20));
+      led_refresh_for(LED_PULSE_STEP_MS);
     }
     for (uint8_t x = 200; x > 0; x -= 4)
     {
       led_set_brightness(x);
-      set_target_pattern(&target_pattern[0]);
-      vTaskDelay(pdMS_TO_TICKS(30));
+      led_refresh_for(30);
     }
   }
 }
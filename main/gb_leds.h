@@ -13,6 +13,7 @@
 #include <stdint.h>
 // #include <led_strip.h>
 #include "obe_led.h"
+#include "led_timeline.h"
 
 #define LED_TYPE LED_STRIP_WS2812
 #if CONFIG_IDF_TARGET_ESP32S3
@@ -25,6 +26,15 @@
 #define LEDS_PER_TARGET 1
 #define TARGET_PADS 5
 
+// Power limiter, tune for the board and battery
+#define LED_MA_PER_CHANNEL 20
+#define LED_POWER_BUDGET_MA 200
+
+// Temporal dithering. Refreshes within a pulse step are timed by esp_timer,
+// so a whole dithering cycle fits into the shortest step at any tick rate
+#define LED_PULSE_STEP_MS 20
+#define LED_DITHER 1
+
 enum
 {
   IDX_CMD_OFF,
@@ -61,7 +71,9 @@ void run_led_debug(void);
 void led_flash_winner(uint8_t cmd_idx);
 void led_rainbow(void);
 void led_app_connected(void);
+void led_roll_rgb(uint16_t delay);
 void led_roll_startup(uint16_t delay);
+esp_err_t led_play_timeline(const led_timeline_t *tl, uint16_t unit_ms, uint16_t frame_ms);
 bool get_is_led_init(void);
 
 void led_pulse_pattern(uint8_t *cmd_pattern);
@@ -74,3 +86,10 @@ void color_flicker_by_index(uint8_t cmd, uint8_t idx);
 void color_flicker_target(uint8_t idx, uint8_t cmd);
 void color_flicker_panel(uint8_t panel_idx, uint8_t cmd);
 void init_leds(void);
+
+/**
+ * @brief Send frames to a transmit callback instead of the GPIO, e.g. ::led_sim_tx
+ *
+ * Must be called before the strip is initialized.
+ */
+void led_set_tx(led_strip_tx_cb_t tx, void *ctx);
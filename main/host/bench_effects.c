@@ -0,0 +1,188 @@
+/**
+ * @file bench_effects.c
+ *
+ * Runs the effects of gb_leds on the host shim in virtual time with the
+ * LED simulator as transmit backend, reports frames, flushes and FPS of
+ * each effect and checks them against the expected ones.
+ *
+ *     ./bench_effects [frames.bin [frames.ppm]]
+ *
+ * With arguments, all latched frames are logged and converted to a PPM
+ * image, one row per frame.
+ *
+ * Virtual time makes every run the same, so any change of output is
+ * caught: of frame rate by counts and span, of the frames themselves by
+ * the hash. When an effect is changed on purpose, take the new values
+ * from the report.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "host_time.h"
+#include "gb_leds.h"
+#include "led_sim.h"
+
+static const char *TAG = "bench_effects";
+
+static uint8_t pattern[TARGET_PADS] = {IDX_CMD_RED, IDX_CMD_GREEN, IDX_CMD_BLUE, IDX_CMD_YELLOW, IDX_CMD_CYAN};
+static uint8_t flash_cmd = IDX_CMD_MAGENTA;
+
+static void roll_startup(void)
+{
+  led_roll_startup(100);
+}
+
+static void roll_rgb(void)
+{
+  led_roll_rgb(50);
+}
+
+static void pulse(void)
+{
+  led_pulse_pattern(pattern);
+}
+
+static void color_flash(void)
+{
+  led_color_flash(rgb_from_values(0xff, 0x26, 0), 0, 3, 100);
+}
+
+static void flash_winner(void)
+{
+  led_flash_winner(IDX_CMD_GREEN);
+}
+
+static void flicker(void)
+{
+  for (uint8_t i = 0; i < CONFIG_LED_STRIP_LEN; i++)
+    color_flicker_by_index(IDX_CMD_RED, i);
+}
+
+static void rapid_flash(void)
+{
+  run_rapid_flash_task(&flash_cmd);
+  vTaskDelay(pdMS_TO_TICKS(1000));
+  stop_rapid_flash_task();
+}
+
+// More targets than pads, the extra ones must not be rendered
+static const led_keyframe_t wide_keys[] = {
+    {.at = 0, .ease = LED_EASE_IN_OUT},
+    {.at = 4},
+};
+
+static const rgb_t wide_colors[] = {
+    {.r = 0x00, .g = 0x00, .b = 0x00},
+    {.r = 0xff, .g = 0x80, .b = 0x00},
+};
+
+static const led_timeline_t wide = {
+    .keys = wide_keys,
+    .colors = wide_colors,
+    .count = 2,
+    .targets = 2 * TARGET_PADS,
+    .shared = true,
+    .stagger = 1,
+    .length = 4 + 2 * TARGET_PADS,
+};
+
+static void wide_timeline(void)
+{
+  led_play_timeline(&wide, 50, 20);
+}
+
+static void radio_states(void)
+{
+  radio_active_on();
+  vTaskDelay(pdMS_TO_TICKS(200));
+  radio_active_connected();
+  vTaskDelay(pdMS_TO_TICKS(200));
+  radio_active_updating();
+  vTaskDelay(pdMS_TO_TICKS(200));
+}
+
+static const struct
+{
+  const char *name;
+  void (*run)(void);
+  uint32_t flushes;
+  uint32_t frames;
+  uint32_t span_ms;
+  uint32_t hash;
+} effects[] = {
+    {"roll_startup", roll_startup, 28, 25, 2700, 0xf66a9602},
+    {"roll_rgb", roll_rgb, 32, 29, 1550, 0x0f9fa92c},
+    {"pulse_pattern", pulse, 404, 100, 2502, 0x31171fb2},
+    {"color_flash", color_flash, 7, 7, 600, 0x79bcd788},
+    {"flash_winner", flash_winner, 9, 9, 400, 0x79538e2e},
+    {"flicker", flicker, 16, 16, 450, 0x142d6c8a},
+    {"rapid_flash", rapid_flash, 11, 1, 1000, 0x1e9e3dc5},
+    {"wide_timeline", wide_timeline, 35, 14, 680, 0x9ca89752},
+    {"radio_states", radio_states, 9, 8, 410, 0xbff30bb9},
+};
+
+int main(int argc, char **argv)
+{
+  host_time_virtual();
+
+  FILE *log = NULL;
+  if (argc > 1 && !(log = fopen(argv[1], "w+b")))
+  {
+    ESP_LOGE(TAG, "Could not create %s", argv[1]);
+    return 1;
+  }
+
+  led_sim_t sim;
+  ESP_ERROR_CHECK(led_sim_init(&sim, CONFIG_LED_STRIP_LEN, log));
+  led_set_tx(led_sim_tx, &sim);
+
+  // Same task name gb_leds looks up to delete the init task
+  xTaskCreate(gb_led_init_task, "led_init_task", 4096, NULL, 5, NULL);
+  while (!get_is_led_init())
+    vTaskDelay(1);
+
+  int failed = 0;
+
+  // Zero frame or unit time would never advance
+  led_sim_reset_stats(&sim);
+  if (led_play_timeline(&wide, 50, 0) != ESP_ERR_INVALID_ARG || led_play_timeline(&wide, 0, 20) != ESP_ERR_INVALID_ARG ||
+      sim.flushes)
+  {
+    ESP_LOGE(TAG, "led_play_timeline: zero frame or unit time not rejected");
+    failed++;
+  }
+
+  for (size_t i = 0; i < sizeof(effects) / sizeof(effects[0]); i++)
+  {
+    led_sim_reset_stats(&sim);
+    effects[i].run();
+    led_sim_report(&sim, effects[i].name);
+    uint32_t span = sim.last_ms - sim.first_ms;
+    if (!sim.frames || sim.overflows || sim.flushes != effects[i].flushes || sim.frames != effects[i].frames ||
+        span != effects[i].span_ms || sim.hash != effects[i].hash)
+    {
+      ESP_LOGE(TAG, "%s: expected %u flushes, %u frames in %u ms, hash %08x", effects[i].name,
+               (unsigned)effects[i].flushes, (unsigned)effects[i].frames, (unsigned)effects[i].span_ms,
+               (unsigned)effects[i].hash);
+      failed++;
+    }
+  }
+
+  if (log && argc > 2)
+  {
+    FILE *ppm = fopen(argv[2], "wb");
+    rewind(log);
+    if (!ppm || led_sim_log_to_ppm(log, ppm) != ESP_OK)
+    {
+      ESP_LOGE(TAG, "Could not convert log to %s", argv[2]);
+      failed++;
+    }
+    if (ppm)
+      fclose(ppm);
+  }
+  if (log)
+    fclose(log);
+  led_sim_free(&sim);
+
+  return failed ? 1 : 0;
+}
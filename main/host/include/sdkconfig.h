@@ -0,0 +1,15 @@
+/*
+ * sdkconfig.h replacement for host builds of LED code
+ *
+ * Replaces the one of the host shim. Tick rate is the ESP-IDF default,
+ * so effects are timed like on target.
+ */
+#ifndef __SDKCONFIG_H__
+#define __SDKCONFIG_H__
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_IDF_TARGET "esp32"
+
+#define CONFIG_FREERTOS_HZ 100
+
+#endif /* __SDKCONFIG_H__ */
@@ -0,0 +1,207 @@
+/**
+ * @file led_sim.c
+ * @brief GEL BLASTER - LED simulator
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "led_sim.h"
+
+static const char *TAG = "led_sim";
+
+#define LOG_MAGIC "LEDS"
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+#define CHECK_ARG(VAL)            \
+  do                              \
+  {                               \
+    if (!(VAL))                   \
+      return ESP_ERR_INVALID_ARG; \
+  } while (0)
+
+static inline uint32_t now_ms(void)
+{
+  return esp_timer_get_time() / 1000;
+}
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ data[i]) * FNV_PRIME;
+  return hash;
+}
+
+static void write_u16(FILE *f, uint16_t v)
+{
+  uint8_t b[2] = {v & 0xff, v >> 8};
+  fwrite(b, 1, sizeof(b), f);
+}
+
+static void write_u32(FILE *f, uint32_t v)
+{
+  uint8_t b[4] = {v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, v >> 24};
+  fwrite(b, 1, sizeof(b), f);
+}
+
+esp_err_t led_sim_init(led_sim_t *sim, size_t length, FILE *log)
+{
+  CHECK_ARG(sim && length > 0 && length <= UINT16_MAX);
+
+  memset(sim, 0, sizeof(led_sim_t));
+  sim->length = length;
+  sim->hash = FNV_OFFSET;
+  sim->log = log;
+  sim->frame = calloc(length * 3, 1);
+  sim->prev = calloc(length * 3, 1);
+  if (!sim->frame || !sim->prev)
+  {
+    free(sim->frame);
+    free(sim->prev);
+    ESP_LOGE(TAG, "Not enough memory");
+    return ESP_ERR_NO_MEM;
+  }
+
+  if (log)
+  {
+    fwrite(LOG_MAGIC, 1, 4, log);
+    write_u16(log, length);
+  }
+
+  return ESP_OK;
+}
+
+esp_err_t led_sim_free(led_sim_t *sim)
+{
+  CHECK_ARG(sim);
+
+  free(sim->frame);
+  free(sim->prev);
+  sim->frame = sim->prev = NULL;
+
+  return ESP_OK;
+}
+
+static void latch(led_sim_t *sim)
+{
+  size_t size = sim->length * 3;
+  uint32_t ts = now_ms();
+
+  if (sim->pos > size)
+    sim->overflows++;
+  sim->pos = 0;
+
+  if (!sim->flushes)
+    sim->first_ms = ts;
+  sim->last_ms = ts;
+
+  // First frame is always recorded
+  if (sim->flushes++ && !memcmp(sim->frame, sim->prev, size))
+    return;
+
+  sim->frames++;
+  memcpy(sim->prev, sim->frame, size);
+  uint32_t rel = ts - sim->first_ms;
+  sim->hash = fnv1a(sim->hash, (const uint8_t *)&rel, sizeof(rel));
+  sim->hash = fnv1a(sim->hash, sim->frame, size);
+  if (sim->log)
+  {
+    write_u32(sim->log, ts);
+    fwrite(sim->frame, 1, size, sim->log);
+  }
+}
+
+void led_sim_tx(void *ctx, const uint8_t *data, size_t len)
+{
+  led_sim_t *sim = (led_sim_t *)ctx;
+  size_t size = sim->length * 3;
+
+  if (!len)
+  {
+    latch(sim);
+    return;
+  }
+
+  // Extra bytes would go to LEDs past the end of the strip
+  if (sim->pos < size)
+    memcpy(sim->frame + sim->pos, data, len < size - sim->pos ? len : size - sim->pos);
+  sim->pos += len;
+}
+
+void led_sim_reset_stats(led_sim_t *sim)
+{
+  sim->flushes = 0;
+  sim->frames = 0;
+  sim->overflows = 0;
+  sim->first_ms = sim->last_ms = 0;
+  sim->hash = FNV_OFFSET;
+}
+
+void led_sim_report(const led_sim_t *sim, const char *name)
+{
+  uint32_t span = sim->last_ms - sim->first_ms;
+
+  ESP_LOGI(TAG, "%s: %u flushes, %u frames in %u ms, %u.%u FPS (%u.%u flushes/s), hash %08x%s",
+           name, (unsigned)sim->flushes, (unsigned)sim->frames, (unsigned)span,
+           span ? (unsigned)(sim->frames * 1000 / span) : 0,
+           span ? (unsigned)(sim->frames * 10000 / span % 10) : 0,
+           span ? (unsigned)(sim->flushes * 1000 / span) : 0,
+           span ? (unsigned)(sim->flushes * 10000 / span % 10) : 0,
+           (unsigned)sim->hash, sim->overflows ? ", frame overflow" : "");
+}
+
+esp_err_t led_sim_log_to_ppm(FILE *log, FILE *ppm)
+{
+  CHECK_ARG(log && ppm);
+
+  uint8_t hdr[6];
+  if (fread(hdr, 1, sizeof(hdr), log) != sizeof(hdr) || memcmp(hdr, LOG_MAGIC, 4))
+    return ESP_ERR_INVALID_RESPONSE;
+  size_t length = hdr[4] | (hdr[5] << 8);
+  size_t record = 4 + length * 3;
+  size_t row = length * 3;
+
+  // Rows are collected first, a log cut short by a crash ends with a
+  // partial record which is not counted
+  uint8_t *rec = malloc(record);
+  uint8_t *rows = NULL;
+  size_t count = 0, cap = 0;
+  if (!rec)
+    return ESP_ERR_NO_MEM;
+  while (fread(rec, 1, record, log) == record)
+  {
+    if (count == cap)
+    {
+      cap = cap ? cap * 2 : 64;
+      uint8_t *p = realloc(rows, cap * row);
+      if (!p)
+      {
+        free(rows);
+        free(rec);
+        return ESP_ERR_NO_MEM;
+      }
+      rows = p;
+    }
+    // GRB to RGB
+    for (size_t i = 0; i < length; i++)
+    {
+      uint8_t *src = rec + 4 + i * 3;
+      uint8_t *dst = rows + count * row + i * 3;
+      dst[0] = src[1];
+      dst[1] = src[0];
+      dst[2] = src[2];
+    }
+    count++;
+  }
+  free(rec);
+
+  fprintf(ppm, "P6\n%u %u\n255\n", (unsigned)length, (unsigned)count);
+  if (count)
+    fwrite(rows, row, count, ppm);
+  free(rows);
+
+  return ESP_OK;
+}
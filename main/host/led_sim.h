@@ -0,0 +1,97 @@
+/**
+ * @file led_sim.h
+ * @brief GEL BLASTER - LED simulator
+ *
+ * Transmit backend for ::led_strip_t which records flushed frames instead
+ * of driving a GPIO. Lets the effects in gb_leds.c run on the host shim
+ * and reports their frame rate. Frames are stamped with esp_timer time,
+ * so with host_time_virtual() the output of an effect is the same on
+ * every run.
+ *
+ * Usage:
+ *
+ *     host_time_virtual();
+ *     led_sim_t sim;
+ *     led_sim_init(&sim, CONFIG_LED_STRIP_LEN, fopen("frames.bin", "wb"));
+ *     led_set_tx(led_sim_tx, &sim);
+ *     gb_led_init();
+ *     led_roll_startup(100);
+ *     led_sim_report(&sim, "roll_startup");
+ *
+ * Log format, little endian:
+ * - header: "LEDS", uint16_t number of LEDs
+ * - one record per latched frame which differs from the previous one:
+ *   uint32_t timestamp in ms, then 3 bytes (G, R, B) per LED
+ */
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+typedef struct
+{
+  size_t length;      ///< Number of LEDs
+  FILE *log;          ///< Binary frame log, NULL to collect statistics only
+  uint8_t *frame;     ///< Frame being received
+  uint8_t *prev;      ///< Last latched frame
+  size_t pos;         ///< Bytes of the current frame received
+  uint32_t flushes;   ///< Latched frames
+  uint32_t frames;    ///< Latched frames which differ from the previous one
+  uint32_t overflows; ///< Latched frames longer than `length` LEDs
+  uint32_t first_ms;  ///< Timestamp of the first latch
+  uint32_t last_ms;   ///< Timestamp of the last latch
+  uint32_t hash;      ///< FNV-1a of recorded frames and their times since the first latch
+} led_sim_t;
+
+/**
+ * @brief Initialize simulator
+ *
+ * @param sim Simulator descriptor
+ * @param length Number of LEDs
+ * @param log Binary frame log opened for writing, NULL to disable
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_sim_init(led_sim_t *sim, size_t length, FILE *log);
+
+/**
+ * @brief Free simulator, does not close the log
+ *
+ * @param sim Simulator descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_sim_free(led_sim_t *sim);
+
+/**
+ * @brief Transmit callback, see ::led_strip_tx_cb_t
+ *
+ * @param ctx Simulator descriptor
+ */
+void led_sim_tx(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Reset frame counters, e.g. before running the next effect
+ *
+ * @param sim Simulator descriptor
+ */
+void led_sim_reset_stats(led_sim_t *sim);
+
+/**
+ * @brief Log number of frames, flushes and effective FPS
+ *
+ * @param sim Simulator descriptor
+ * @param name Name of the effect
+ */
+void led_sim_report(const led_sim_t *sim, const char *name);
+
+/**
+ * @brief Convert binary frame log to a PPM image, one row per frame
+ *
+ * @param log Binary frame log opened for reading
+ * @param ppm Output file opened for writing
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_RESPONSE` if log is malformed
+ */
+esp_err_t led_sim_log_to_ppm(FILE *log, FILE *ppm);
@@ -0,0 +1,334 @@
+/**
+ * @file test_obe_led.c
+ *
+ * Checks of obe_led on host: the power limiter against the current of the
+ * frames actually sent, for synthetic worst-case frames, its running sums
+ * against a recount, and the average of dithered output over a dithering
+ * cycle. Also times the GPIO flush.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <esp_timer.h>
+#include "obe_led.h"
+
+#define LEDS        300
+#define MA          20
+#define BUDGET_MA   2000
+#define FLUSHES     16
+
+typedef struct
+{
+  uint64_t sum;   ///< Sum of channel values of the frame being sent
+  uint64_t max;   ///< Maximum sum of latched frames
+} tx_stats_t;
+
+static void tx(void *ctx, const uint8_t *data, size_t len)
+{
+  tx_stats_t *s = (tx_stats_t *)ctx;
+  if (!len)
+  {
+    if (s->sum > s->max)
+      s->max = s->sum;
+    s->sum = 0;
+    return;
+  }
+  for (size_t i = 0; i < len; i++)
+    s->sum += data[i];
+}
+
+typedef void (*frame_fn_t)(led_strip_t *strip);
+
+static void white(led_strip_t *strip)
+{
+  led_strip_fill(strip, 0, LEDS, rgb_from_code(0xffffff));
+}
+
+static void red(led_strip_t *strip)
+{
+  led_strip_fill(strip, 0, LEDS, rgb_from_code(0xff0000));
+}
+
+static void grey(led_strip_t *strip)
+{
+  led_strip_fill(strip, 0, LEDS, rgb_from_code(0x404040));
+}
+
+static void dim(led_strip_t *strip)
+{
+  led_strip_fill(strip, 0, LEDS, rgb_from_code(0x020202));
+}
+
+static void ramp(led_strip_t *strip)
+{
+  for (size_t i = 0; i < LEDS; i++)
+  {
+    uint8_t v = i * 255 / (LEDS - 1);
+    led_strip_set_pixel(strip, i, rgb_from_values(v, v, v));
+  }
+}
+
+static void noise(led_strip_t *strip)
+{
+  srand(1);
+  for (size_t i = 0; i < LEDS; i++)
+    led_strip_set_pixel(strip, i, rgb_from_code(rand() & 0xffffff));
+}
+
+static void single(led_strip_t *strip)
+{
+  led_strip_fill(strip, 0, LEDS, rgb_from_code(0));
+  led_strip_set_pixel(strip, LEDS / 2, rgb_from_code(0xffffff));
+}
+
+// Written around led_strip_set_pixel(), limiter sees it after recount
+static void direct(led_strip_t *strip)
+{
+  memset(strip->buf, 0xff, LEDS * 3);
+  led_strip_recount_power(strip);
+}
+
+static const struct
+{
+  const char *name;
+  frame_fn_t fn;
+} frames[] = {
+  {"white", white},
+  {"red", red},
+  {"grey 0x40", grey},
+  {"dim 0x02", dim},
+  {"ramp", ramp},
+  {"noise", noise},
+  {"single", single},
+  {"direct buf", direct},
+};
+
+static const struct
+{
+  float gamma;
+  uint32_t white_point;
+} corrections[] = {
+  {1.0f, 0xffffff},
+  {2.2f, 0xffffff},
+  {0.45f, 0xffffff},
+  {0.45f, 0xffc896},
+};
+
+static int check_power(void)
+{
+  int failed = 0;
+
+  printf("%-10s %5s %8s %6s %10s %11s %9s\n", "frame", "gamma", "white", "dither", "brightness",
+         "actual mA", "estimate");
+  for (size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); f++)
+    for (size_t c = 0; c < sizeof(corrections) / sizeof(corrections[0]); c++)
+      for (int dither = 0; dither < 2; dither++)
+        for (int b = 0; b < 2; b++)
+        {
+          tx_stats_t stats = {0};
+          led_strip_t strip = {
+              .length = LEDS,
+              .brightness = b ? 128 : 255,
+              .dither = dither,
+              .tx = tx,
+              .tx_ctx = &stats,
+          };
+          if (led_strip_init(&strip) != ESP_OK)
+            return 1;
+          led_strip_set_correction(&strip, corrections[c].gamma, rgb_from_code(corrections[c].white_point));
+          led_strip_set_power_limit(&strip, MA, BUDGET_MA);
+          frames[f].fn(&strip);
+
+          // Dithering rounds differently in every frame
+          uint32_t estimate = 0;
+          for (int i = 0; i < FLUSHES; i++)
+          {
+            led_strip_flush(&strip);
+            if (strip.power.estimate_ma > estimate)
+              estimate = strip.power.estimate_ma;
+          }
+          float actual = (float)stats.max * MA / 255;
+          bool ok = actual <= estimate && actual <= BUDGET_MA && estimate <= BUDGET_MA;
+          failed += !ok;
+
+          printf("%-10s %5.2f %8.6x %6s %10u %11.1f %9u%s\n", frames[f].name, corrections[c].gamma,
+                 (unsigned)corrections[c].white_point, dither ? "yes" : "no", strip.brightness,
+                 actual, (unsigned)estimate, ok ? "" : "  FAIL");
+          led_strip_free(&strip);
+        }
+
+  return failed;
+}
+
+// Running sums after random writes and corrections must match a recount
+static int check_power_sums(void)
+{
+  led_strip_t strip = {
+      .length = LEDS,
+      .brightness = 255,
+      .tx = tx,
+  };
+  if (led_strip_init(&strip) != ESP_OK)
+    return 1;
+
+  srand(2);
+  int failed = 0;
+  for (int n = 0; n < 5000 && !failed; n++)
+  {
+    size_t i = rand() % LEDS;
+    switch (rand() % 8)
+    {
+      case 0:
+        led_strip_fill(&strip, i, 1 + rand() % (LEDS - i), rgb_from_code(rand() % 2 ? rand() : 0));
+        break;
+      case 1:
+        led_strip_set_correction(&strip, corrections[rand() % 4].gamma, rgb_from_code(corrections[rand() % 4].white_point));
+        break;
+      default:
+        led_strip_set_pixel(&strip, i, rgb_from_code(rand() % 4 ? rand() : 0));
+        break;
+    }
+    led_strip_power_t running = strip.power;
+    led_strip_recount_power(&strip);
+    failed = memcmp(running.sum, strip.power.sum, sizeof(running.sum)) || running.lit != strip.power.lit;
+  }
+  printf("power sums kept by pixel writes: %s\n", failed ? "FAIL" : "ok");
+
+  led_strip_free(&strip);
+  return failed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+  uint8_t frames[2 * LED_STRIP_DITHER_FRAMES][256 * 3];
+  size_t frame;
+  size_t pos;
+} capture_t;
+
+static void capture_tx(void *ctx, const uint8_t *data, size_t len)
+{
+  capture_t *c = (capture_t *)ctx;
+  if (!len)
+  {
+    c->frame++;
+    c->pos = 0;
+    return;
+  }
+  memcpy(c->frames[c->frame] + c->pos, data, len);
+  c->pos += len;
+}
+
+// Every window of LED_STRIP_DITHER_FRAMES flushes must average to the
+// 8.8 corrected value within half of the cycle resolution
+static int check_dither(void)
+{
+  static capture_t cap;
+  float max_err = 0;
+
+  for (int b = 0; b < 256; b++)
+  {
+    led_strip_t strip = {
+        .length = 256,
+        .brightness = b,
+        .dither = true,
+        .tx = capture_tx,
+        .tx_ctx = &cap,
+    };
+    if (led_strip_init(&strip) != ESP_OK)
+      return 1;
+    led_strip_set_correction(&strip, 2.2f, rgb_from_code(0xffc896));
+    for (int i = 0; i < 256; i++)
+      led_strip_set_pixel(&strip, i, rgb_from_values(i, i, i));
+
+    cap.frame = cap.pos = 0;
+    for (int f = 0; f < 2 * LED_STRIP_DITHER_FRAMES - 1; f++)
+      led_strip_flush(&strip);
+
+    for (int start = 0; start < LED_STRIP_DITHER_FRAMES; start++)
+      for (int i = 0; i < 256; i++)
+        for (int c = 0; c < 3; c++)
+        {
+          unsigned sum = 0;
+          for (int f = start; f < start + LED_STRIP_DITHER_FRAMES; f++)
+            sum += cap.frames[f][i * 3 + c];
+          // Wire order is GRB
+          int ch = c == 0 ? 1 : c == 1 ? 0 : 2;
+          float err = fabsf((float)sum / LED_STRIP_DITHER_FRAMES - strip.correction.lut16[ch][i] / 256.0f);
+          if (err > max_err)
+            max_err = err;
+        }
+    led_strip_free(&strip);
+  }
+
+  // The former 256-frame cycle, in windows of 2 and 3 frames shown by a
+  // pulse step at 100 Hz tick
+  float max_err_256[2] = {0};
+  for (int w = 2; w <= 3; w++)
+    for (int start = 0; start < 256; start++)
+      for (unsigned v = 0; v <= 65280; v++)
+      {
+        unsigned sum = 0;
+        for (int f = start; f < start + w; f++)
+          sum += (v + color_dither_offset(f)) >> 8;
+        float err = fabsf((float)sum / w - v / 256.0f);
+        if (err > max_err_256[w - 2])
+          max_err_256[w - 2] = err;
+      }
+
+  float limit = 0.5f / LED_STRIP_DITHER_FRAMES;
+  bool ok = max_err <= limit + 1e-4f;
+  printf("dither: %d-frame cycle, max error of %d-frame average %.3f LSB (limit %.3f)%s\n",
+         LED_STRIP_DITHER_FRAMES, LED_STRIP_DITHER_FRAMES, max_err, limit, ok ? "" : "  FAIL");
+  printf("dither: 256-frame cycle, max error of 2-frame average %.3f LSB, 3-frame %.3f LSB\n",
+         max_err_256[0], max_err_256[1]);
+  return !ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Time of bit-banged flush of the strip of gb_leds. GPIO writes on host are
+// stores to memory, so this is the cost of correction and of the latch delay
+static void bench_flush(void)
+{
+  for (int dither = 0; dither < 2; dither++)
+  {
+    led_strip_t strip = {
+        .length = 4,
+        .gpio = GPIO_NUM_17,
+        .brightness = 100,
+        .dither = dither,
+    };
+    if (led_strip_init(&strip) != ESP_OK)
+      return;
+    led_strip_set_correction(&strip, 2.2f, rgb_from_code(0xffffff));
+    led_strip_fill(&strip, 0, 4, rgb_from_code(0x80ff40));
+
+    const int n = 2000;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < n; i++)
+      led_strip_flush(&strip);
+    float us = (float)(esp_timer_get_time() - start) / n;
+    // Pulse effect of gb_leds: 50 steps of 20 ms and 50 steps of 30 ms
+    int flushes = 100 * (dither ? LED_STRIP_DITHER_FRAMES : 1);
+    printf("flush: 4 LEDs on GPIO, dither %-3s %6.1f us, pulse: %3d flushes in 2500 ms, %.1f%% of time\n",
+           dither ? "on" : "off", us, flushes, flushes * us / 2500000 * 100);
+    led_strip_free(&strip);
+  }
+}
+
+int main(void)
+{
+  int failed = check_power();
+  printf("\n");
+  failed += check_power_sums();
+  printf("\n");
+  failed += check_dither();
+  printf("\n");
+  bench_flush();
+
+  printf("\n%s\n", failed ? "FAILED" : "all checks passed");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file led_timeline.c
+ * @brief GEL BLASTER - LED keyframe timelines
+ */
+
+#include "led_timeline.h"
+
+static inline fract8 ease(uint8_t type, fract8 f)
+{
+  switch (type)
+  {
+  case LED_EASE_IN:
+    return scale8(f, f);
+  case LED_EASE_OUT:
+    return 255 - scale8(255 - f, 255 - f);
+  case LED_EASE_IN_OUT:
+    return ease8InOutQuad(f);
+  default:
+    return f;
+  }
+}
+
+// Last keyframe at or before t (1/256 units), binary search
+static uint8_t search_key(const led_timeline_t *tl, uint32_t t)
+{
+  uint8_t lo = 0, hi = tl->count - 1;
+  while (lo < hi)
+  {
+    uint8_t mid = (lo + hi + 1) / 2;
+    if (((uint32_t)tl->keys[mid].at << 8) <= t)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return lo;
+}
+
+// Color of target n at time t (1/256 units), k is its keyframe
+static inline rgb_t sample(const led_timeline_t *tl, uint8_t n, uint8_t k, uint32_t t)
+{
+  size_t stride = tl->shared ? 1 : tl->targets;
+  const rgb_t *c = tl->colors + k * stride + (tl->shared ? 0 : n);
+
+  uint32_t start = (uint32_t)tl->keys[k].at << 8;
+  if (k + 1 >= tl->count || tl->keys[k].ease == LED_EASE_STEP || t <= start)
+    return c[0];
+
+  uint32_t span = ((uint32_t)tl->keys[k + 1].at << 8) - start;
+  fract8 f = (t - start) * 256 / span;
+  return rgb_lerp8(c[0], c[stride], ease(tl->keys[k].ease, f));
+}
+
+uint8_t led_timeline_render(const led_timeline_t *tl, uint32_t t, rgb_t *out, size_t len)
+{
+  uint8_t targets = tl->targets < len ? tl->targets : len;
+  if (!targets)
+    return 0;
+
+  // Time of targets only goes back with the stagger, so the keyframe of
+  // the first target is searched and the others step back from it
+  uint8_t k = search_key(tl, t);
+  for (uint8_t n = 0; n < targets; n++)
+  {
+    uint32_t delay = ((uint32_t)n * tl->stagger) << 8;
+    uint32_t tn = t > delay ? t - delay : 0;
+    while (k && ((uint32_t)tl->keys[k].at << 8) > tn)
+      k--;
+    out[n] = sample(tl, n, k, tn);
+  }
+  return targets;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file led_timeline.h
+ * @brief GEL BLASTER - LED keyframe timelines
+ *
+ * Effects are described by constant keyframe tables, which stay in flash.
+ * Each keyframe has a start time, one color per target (or one color for
+ * all targets) and an easing of the transition to the next keyframe.
+ * Targets can be staggered, so that rolls and chases need no extra keyframes.
+ *
+ * Example, all targets fade from black to blue and back, 1 unit = 1 ms:
+ *
+ *     static const led_keyframe_t keys[] = {
+ *         {.at = 0, .ease = LED_EASE_IN_OUT},
+ *         {.at = 500, .ease = LED_EASE_IN_OUT},
+ *         {.at = 1000},
+ *     };
+ *     static const rgb_t colors[] = {{0}, {.b = 0xff}, {0}};
+ *     static const led_timeline_t fade = {
+ *         .keys = keys, .colors = colors, .count = 3,
+ *         .targets = 5, .shared = true, .length = 1000,
+ *     };
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "color.h"
+
+/**
+ * Transition from a keyframe to the next one
+ */
+typedef enum
+{
+  LED_EASE_STEP = 0, ///< Hold color until the next keyframe
+  LED_EASE_LINEAR,
+  LED_EASE_IN,       ///< Quadratic, slow start
+  LED_EASE_OUT,      ///< Quadratic, slow end
+  LED_EASE_IN_OUT,   ///< Quadratic, slow start and end
+
+  LED_EASE_MAX
+} led_ease_t;
+
+typedef struct
+{
+  uint16_t at;  ///< Start time in units, strictly ascending, first keyframe must be at 0
+  uint8_t ease; ///< ::led_ease_t of the transition to the next keyframe
+} led_keyframe_t;
+
+typedef struct
+{
+  const led_keyframe_t *keys; ///< Keyframes
+  const rgb_t *colors;        ///< Colors, `targets` per keyframe or one per keyframe if `shared`
+  uint8_t count;              ///< Number of keyframes
+  uint8_t targets;            ///< Number of targets
+  bool shared;                ///< All targets use the same color
+  uint16_t stagger;           ///< Target n is delayed by n * stagger units
+  uint16_t length;            ///< Length of timeline in units
+} led_timeline_t;
+
+/**
+ * @brief Calculate colors of the targets at the given time
+ *
+ * Time before the first keyframe gives its colors, time after the last
+ * keyframe gives the colors of the last one. Keyframe of the first target
+ * is found by binary search, the staggered targets step back from it, so
+ * a frame costs about one keyframe lookup and one lerp per target.
+ *
+ * @param tl Timeline
+ * @param t Time in 1/256 units
+ * @param[out] out Colors of the first targets
+ * @param len Capacity of `out`, targets past it are not rendered
+ * @return Number of colors written, smaller of `tl->targets` and `len`
+ */
+uint8_t led_timeline_render(const led_timeline_t *tl, uint32_t t, rgb_t *out, size_t len);
@@ -33,8 +33,7 @@ static portMUX_TYPE my_mutex = portMUX_INITIALIZER_UNLOCKED;
   } while (0)
 
 #define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
-
-static rgb_t off;
+#define TX_CHUNK_LEDS 16
 
 // Write to strip
 static void IRAM_ATTR write_to_strip(led_strip_t *strip, long value)
@@ -86,6 +85,15 @@ esp_err_t led_strip_init(led_strip_t *strip)
     return ESP_ERR_NO_MEM;
   }
 
+  color_correction_init(&strip->correction, 1.0f, rgb_from_code(0xffffff));
+  // Buffer is black
+  memset(strip->power.sum, 0, sizeof(strip->power.sum));
+  strip->power.lit = 0;
+  strip->power.estimate_ma = 0;
+
+  if (strip->tx)
+    return ESP_OK;
+
   gpio_config_t io_conf = {};
 
   // disable interrupt
@@ -103,34 +111,175 @@ esp_err_t led_strip_init(led_strip_t *strip)
   return ESP_OK;
 }
 
+// Set color correction
+esp_err_t led_strip_set_correction(led_strip_t *strip, float gamma, rgb_t white_point)
+{
+  CHECK_ARG(strip);
+
+  color_correction_init(&strip->correction, gamma, white_point);
+
+  // Sums are of gamma corrected values
+  return strip->buf ? led_strip_recount_power(strip) : ESP_OK;
+}
+
+// Set power limit
+esp_err_t led_strip_set_power_limit(led_strip_t *strip, uint16_t ma_per_channel, uint32_t budget_ma)
+{
+  CHECK_ARG(strip);
+
+  strip->power.ma_per_channel = ma_per_channel;
+  strip->power.budget_ma = budget_ma;
+
+  return ESP_OK;
+}
+
+// Units of current used by the limiter, 1/(255 * 255 * 256) mA
+#define POWER_UNITS_PER_MA (255ULL * 255 * 256)
+
+// Gamma corrected channel value, 8.8 fixed point, the larger of the 8-bit
+// and dithering curves
+static inline uint16_t power_value(const color_correction_t *cc, uint8_t x)
+{
+  uint16_t v8 = cc->gamma_lut[x] << 8;
+  return v8 > cc->gamma_lut16[x] ? v8 : cc->gamma_lut16[x];
+}
+
+// Move running sums of channel c from old to new value
+static inline void power_update(led_strip_t *strip, size_t c, uint8_t from, uint8_t to)
+{
+  if (from == to)
+    return;
+  uint16_t a = power_value(&strip->correction, from);
+  uint16_t b = power_value(&strip->correction, to);
+  strip->power.sum[c] += b - a;
+  strip->power.lit = strip->power.lit + (b != 0) - (a != 0);
+}
+
+esp_err_t led_strip_recount_power(led_strip_t *strip)
+{
+  CHECK_ARG(strip && strip->buf);
+
+  led_strip_power_t *power = &strip->power;
+  memset(power->sum, 0, sizeof(power->sum));
+  power->lit = 0;
+  for (size_t i = 0; i < strip->length * 3; i += 3)
+    for (size_t c = 0; c < 3; c++)
+    {
+      uint16_t v = power_value(&strip->correction, strip->buf[i + c]);
+      power->sum[c] += v;
+      power->lit += v != 0;
+    }
+
+  return ESP_OK;
+}
+
+// Brightness to use for the next frame, scaled down to fit the power budget
+static uint8_t limit_brightness(led_strip_t *strip)
+{
+  led_strip_power_t *power = &strip->power;
+  const color_correction_t *cc = &strip->correction;
+
+  if (!power->budget_ma)
+  {
+    power->estimate_ma = 0;
+    return strip->brightness;
+  }
+
+  // Current at full brightness after white balance from the running sums.
+  // Scaling by brightness and white point rounds values up by less than one
+  // LSB per lit channel, which is the margin
+  uint64_t full = ((uint64_t)power->sum[0] * cc->white_point.r + (uint64_t)power->sum[1] * cc->white_point.g +
+                   (uint64_t)power->sum[2] * cc->white_point.b) * power->ma_per_channel;
+  uint64_t margin = (uint64_t)power->lit * power->ma_per_channel * 255 * 256;
+  uint64_t budget = power->budget_ma * POWER_UNITS_PER_MA;
+
+  uint8_t brightness = strip->brightness;
+  if (full * brightness / 255 + margin > budget)
+    brightness = margin >= budget ? 0 : (budget - margin) * 255 / full;
+  if (!brightness)
+    margin = 0;
+
+  power->estimate_ma = (full * brightness / 255 + margin + POWER_UNITS_PER_MA - 1) / POWER_UNITS_PER_MA;
+  return brightness;
+}
+
 // Set Pixle
 esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color)
 {
-  CHECK_ARG(strip && strip->buf && num <= strip->length);
+  CHECK_ARG(strip && strip->buf && num < strip->length);
   size_t idx = num * COLOR_SIZE(strip);
 
-  rgb_t scaled = strip->brightness != 0 ? rgb_scale_video(color, strip->brightness) : off;
-
-  strip->buf[idx] = scaled.r;
-  strip->buf[idx + 1] = scaled.g;
-  strip->buf[idx + 2] = scaled.b;
+  // Brightness is applied on flush
+  uint8_t *p = strip->buf + idx;
+  power_update(strip, 0, p[0], color.r);
+  power_update(strip, 1, p[1], color.g);
+  power_update(strip, 2, p[2], color.b);
+  p[0] = color.r;
+  p[1] = color.g;
+  p[2] = color.b;
   return ESP_OK;
 }
 
+// Corrected color of the pixel
+static inline rgb_t output_color(led_strip_t *strip, size_t num, uint8_t offset)
+{
+  size_t buf_idx = num * 3;
+  rgb_t c = rgb_from_values(strip->buf[buf_idx], strip->buf[buf_idx + 1], strip->buf[buf_idx + 2]);
+  if (strip->dither)
+    return color_correction_apply_dithered(&strip->correction, c, offset);
+  return color_correction_apply(&strip->correction, c);
+}
+
+// Send frame to transmit callback in chunks
+static void flush_to_tx(led_strip_t *strip, uint8_t offset)
+{
+  uint8_t chunk[TX_CHUNK_LEDS * 3];
+  size_t len = 0;
+
+  for (size_t i = 0; i < strip->length; i++)
+  {
+    rgb_t c = output_color(strip, i, offset);
+    chunk[len++] = c.g;
+    chunk[len++] = c.r;
+    chunk[len++] = c.b;
+    if (len == sizeof(chunk))
+    {
+      strip->tx(strip->tx_ctx, chunk, len);
+      len = 0;
+    }
+  }
+  if (len)
+    strip->tx(strip->tx_ctx, chunk, len);
+  strip->tx(strip->tx_ctx, NULL, 0);
+}
+
 // Flush strip
 esp_err_t led_strip_flush(led_strip_t *strip)
 {
   CHECK_ARG(strip && strip->buf);
+  uint8_t brightness = limit_brightness(strip);
+  if (strip->correction.brightness != brightness)
+    color_correction_set_brightness(&strip->correction, brightness);
+
+  uint8_t offset = color_dither_offset_cycle(strip->frame++, LED_STRIP_DITHER_BITS);
+
+  if (strip->tx)
+  {
+    flush_to_tx(strip, offset);
+    return ESP_OK;
+  }
+
   portENTER_CRITICAL(&my_mutex);
   // ets_delay_us(DEFAULT_LED_STRIP_PAUSE_LENGTH);
   for (size_t i = 0; i < strip->length; i++)
   {
-    uint8_t buf_idx = i * 3;
-    write_to_strip(strip, values_to_code(strip->buf[buf_idx], strip->buf[buf_idx + 1], strip->buf[buf_idx + 2]));
+    rgb_t c = output_color(strip, i, offset);
+    write_to_strip(strip, values_to_code(c.r, c.g, c.b));
   }
+  portEXIT_CRITICAL(&my_mutex);
 
+  // Line stays low, being interrupted only makes the latch longer
   ets_delay_us(DEFAULT_LED_STRIP_PAUSE_LENGTH);
-  portEXIT_CRITICAL(&my_mutex);
   return ESP_OK;
 }
 
@@ -154,7 +303,4 @@ esp_err_t led_strip_fill(led_strip_t *strip, size_t start, size_t len, rgb_t col
 
 void led_strip_install(void)
 {
-  off.r = 0;
-  off.g = 0;
-  off.b = 0;
 }
\ No newline at end of file
@@ -20,7 +20,7 @@
 #include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
-#include "rgb.h"
+#include "color.h"
 #include <driver/rmt.h>
 
 /**
@@ -48,6 +48,37 @@ typedef enum
   LED_STRIP_TYPE_MAX
 } led_strip_type_t;
 
+/**
+ * Power limiter settings and state
+ */
+typedef struct
+{
+  uint16_t ma_per_channel; ///< Current of one channel at full brightness, mA
+  uint32_t budget_ma;      ///< Maximum current for the whole strip, mA. 0 to disable limiter
+  uint32_t estimate_ma;    ///< Upper bound of current of the last flushed frame, mA. 0 when limiter is disabled
+  uint32_t sum[3];         ///< Running sums of gamma corrected R, G and B values of `buf`, 8.8 fixed point
+  uint32_t lit;            ///< Number of lit channels in `buf`
+} led_strip_power_t;
+
+/**
+ * Transmit callback, replaces the GPIO output when set.
+ *
+ * Called with the frame in wire order (GRB, 3 bytes per LED), possibly
+ * split into several chunks, then once with `len == 0` to latch it.
+ */
+typedef void (*led_strip_tx_cb_t)(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * Length of the temporal dithering cycle. Average output over the cycle
+ * matches the corrected color within 1/(2 * LED_STRIP_DITHER_FRAMES) LSB,
+ * so a dithered color should be flushed a multiple of this many times.
+ *
+ * Pixels in `buf` stay 8 bit. Dithering recovers the fraction that gamma,
+ * white point and brightness produce, from the 8.8 correction tables.
+ */
+#define LED_STRIP_DITHER_BITS 2
+#define LED_STRIP_DITHER_FRAMES (1 << LED_STRIP_DITHER_BITS)
+
 typedef struct
 {
   led_strip_type_t type; ///< LED type
@@ -57,6 +88,12 @@ typedef struct
   gpio_num_t gpio;       ///< Data GPIO pin
   rmt_channel_t channel; ///< RMT channel
   uint8_t *buf;
+  color_correction_t correction; ///< Applied on flush, see ::led_strip_set_correction()
+  led_strip_power_t power;       ///< Power limiter, see ::led_strip_set_power_limit()
+  bool dither;                   ///< Temporal dithering on flush, see ::LED_STRIP_DITHER_FRAMES
+  uint8_t frame;                 ///< Frame counter for dithering
+  led_strip_tx_cb_t tx;          ///< Transmit callback, NULL for GPIO output. Set before ::led_strip_init()
+  void *tx_ctx;                  ///< Context passed to transmit callback
 } led_strip_t;
 
 esp_err_t led_strip_init(led_strip_t *strip);
@@ -64,6 +101,48 @@ esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color);
 esp_err_t led_strip_flush(led_strip_t *strip);
 esp_err_t led_strip_free(led_strip_t *strip);
 
+/**
+ * @brief Set gamma and white balance applied to the strip on flush
+ *
+ * Colors stored in the strip buffer are not modified, so brightness,
+ * gamma and white balance can be changed without rewriting pixels.
+ *
+ * @param strip Descriptor of LED strip
+ * @param gamma Gamma value, 1.0 for none
+ * @param white_point Per-channel maximum, {255, 255, 255} for none
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_set_correction(led_strip_t *strip, float gamma, rgb_t white_point);
+
+/**
+ * @brief Limit estimated current draw of the strip
+ *
+ * On flush, current is estimated from the frame after gamma and white
+ * balance correction, including rounding of corrected values, so the
+ * estimate is an upper bound. If it exceeds the budget, brightness is
+ * scaled down for that frame. `strip->brightness` itself is not changed.
+ *
+ * The estimate comes from running sums which ::led_strip_set_pixel() keeps
+ * up to date, flush doesn't walk the pixels. Pixels written to `strip->buf`
+ * directly are not accounted for until ::led_strip_recount_power().
+ *
+ * @param strip Descriptor of LED strip
+ * @param ma_per_channel Current of one channel at full brightness, mA
+ * @param budget_ma Maximum current for the whole strip, mA. 0 to disable limiter
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_set_power_limit(led_strip_t *strip, uint16_t ma_per_channel, uint32_t budget_ma);
+
+/**
+ * @brief Recount power limiter sums from the whole buffer
+ *
+ * Call after writing `strip->buf` directly.
+ *
+ * @param strip Descriptor of LED strip
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_recount_power(led_strip_t *strip);
+
 /**
  * @brief Set multiple LEDs to the one color
  *